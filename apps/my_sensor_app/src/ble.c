@@ -28,7 +28,17 @@ static void ble_app_on_sync(void);
 static void ble_app_set_addr(void);
 static void ble_app_advertise(void);
 
+#if MYNEWT_VAL(FRAME_STATS_BLE)  //  If frame time stats are served over Bluetooth LE...
+static int frame_stats_init(void);
+static int ble_app_gap_event(struct ble_gap_event *event, void *arg);
+#endif  //  MYNEWT_VAL(FRAME_STATS_BLE)
+
 int start_ble(void) {
+#if MYNEWT_VAL(FRAME_STATS_BLE)
+    //  Register the frame time stats service.
+    int rc = frame_stats_init();
+    if (rc != 0) { return rc; }
+#endif  //  MYNEWT_VAL(FRAME_STATS_BLE)
     //  Set the callback for starting Bluetooth LE.
     ble_hs_cfg.sync_cb = ble_app_on_sync;
     return 0;
@@ -71,11 +81,84 @@ static void ble_app_advertise(void) {
 
     //  Begin advertising as an iBeacon.
     adv_params = (struct ble_gap_adv_params){ 0 };
+#if MYNEWT_VAL(FRAME_STATS_BLE)
+    //  Accept connections for reading the frame time stats.
+    adv_params.conn_mode = BLE_GAP_CONN_MODE_UND;
+    adv_params.disc_mode = BLE_GAP_DISC_MODE_GEN;
+    rc = ble_gap_adv_start(BLE_OWN_ADDR_RANDOM, NULL, BLE_HS_FOREVER,
+                           &adv_params, ble_app_gap_event, NULL);
+#else
     rc = ble_gap_adv_start(BLE_OWN_ADDR_RANDOM, NULL, BLE_HS_FOREVER,
                            &adv_params, NULL, NULL);
+#endif  //  MYNEWT_VAL(FRAME_STATS_BLE)
     assert(rc == 0);
 }
 
+#if MYNEWT_VAL(FRAME_STATS_BLE)
+//  Size of the frame time stats: frames, dropped, then median, 90th percentile and max of 7 stages, as uint32_t.
+//  Must match SUMMARY_SIZE in rust/mynewt/src/frame_time.rs
+#define FRAME_STATS_SIZE (8 + 7 * 3 * 4)
+
+//  Encode the frame time stats into the buffer. Returns the number of bytes written, or -1 if the buffer is too small.
+//  Defined in rust/mynewt/src/frame_probe.rs
+int frame_stats_read(uint8_t *buf, uint16_t len);
+
+//  UUIDs of the frame time stats service and characteristic
+static const ble_uuid128_t frame_stats_svc_uuid =
+    BLE_UUID128_INIT(0x6c, 0x3d, 0x0b, 0x1e, 0x4f, 0x7a, 0x52, 0x9a, 0x3b, 0x41, 0x6e, 0x1d, 0x00, 0x01, 0x7f, 0x5e);
+static const ble_uuid128_t frame_stats_chr_uuid =
+    BLE_UUID128_INIT(0x6c, 0x3d, 0x0b, 0x1e, 0x4f, 0x7a, 0x52, 0x9a, 0x3b, 0x41, 0x6e, 0x1d, 0x01, 0x01, 0x7f, 0x5e);
+
+static int frame_stats_access(uint16_t conn_handle, uint16_t attr_handle,
+                              struct ble_gatt_access_ctxt *ctxt, void *arg) {
+    //  Return the frame time stats when the characteristic is read.
+    uint8_t buf[FRAME_STATS_SIZE];
+    int len;
+    if (ctxt->op != BLE_GATT_ACCESS_OP_READ_CHR) { return BLE_ATT_ERR_UNLIKELY; }
+    len = frame_stats_read(buf, sizeof(buf));
+    if (len < 0) { return BLE_ATT_ERR_UNLIKELY; }
+    if (os_mbuf_append(ctxt->om, buf, len) != 0) { return BLE_ATT_ERR_INSUFFICIENT_RES; }
+    return 0;
+}
+
+static const struct ble_gatt_svc_def frame_stats_svcs[] = {
+    {
+        .type = BLE_GATT_SVC_TYPE_PRIMARY,
+        .uuid = &frame_stats_svc_uuid.u,
+        .characteristics = (struct ble_gatt_chr_def[]) { {
+            .uuid = &frame_stats_chr_uuid.u,
+            .access_cb = frame_stats_access,
+            .flags = BLE_GATT_CHR_F_READ,
+        }, {
+            0,  //  No more characteristics
+        } },
+    }, {
+        0,  //  No more services
+    },
+};
+
+static int frame_stats_init(void) {
+    //  Register the frame time stats service.  Return 0 if successful.
+    int rc = ble_gatts_count_cfg(frame_stats_svcs);
+    if (rc != 0) { return rc; }
+    return ble_gatts_add_svcs(frame_stats_svcs);
+}
+
+static int ble_app_gap_event(struct ble_gap_event *event, void *arg) {
+    //  Advertise again when the connection is closed or fails.
+    switch (event->type) {
+    case BLE_GAP_EVENT_CONNECT:
+        if (event->connect.status != 0) { ble_app_advertise(); }
+        break;
+    case BLE_GAP_EVENT_DISCONNECT:
+    case BLE_GAP_EVENT_ADV_COMPLETE:
+        ble_app_advertise();
+        break;
+    }
+    return 0;
+}
+#endif  //  MYNEWT_VAL(FRAME_STATS_BLE)
+
 #else //  If Bluetooth LE is disabled...
 
 int start_ble(void) {
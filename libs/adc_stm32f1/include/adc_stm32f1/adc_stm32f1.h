@@ -62,6 +62,9 @@ struct stm32f1_adc_dev_cfg {
     void *secondarybuf;
     int buflen;
     void *sac_adc_handle;  //  Actual type: ADC_HandleTypeDef *
+    void *sac_dma_handle;  //  Actual type: DMA_HandleTypeDef *.  Attached to the ADC only while sampling with DMA.
+    void *sac_trigger_timer;  //  Actual type: TIM_HandleTypeDef *.  Timer whose update event triggers each DMA conversion.
+    uint32_t sac_trigger_hz;  //  DMA conversions per second, set by stm32f1_adc_set_trigger_rate()
 };
 
 //  Create the STM32F1 ADC1 device.  Implemented in creator.c, function DEVICE_CREATE().
@@ -70,6 +73,9 @@ void stm32f1_adc_create(void);
 //  Initialise the STM32F1 ADC device with the configuration.
 int stm32f1_adc_dev_init(struct os_dev *dev, void *cfg);
 
+//  Set the number of DMA conversions per second.  Must be set before adc_sample() starts DMA.
+int stm32f1_adc_set_trigger_rate(struct adc_dev *dev, uint32_t hz);
+
 #ifdef __cplusplus
 }
 #endif
@@ -16,9 +16,10 @@
  * specific language governing permissions and limitations
  * under the License.
  */
-//  Based on adc_stm32f4. We currently support blocking reads, not interrupts (marked by #ifdef TODO).
-//  Tested OK with internal temparature sensor.
-//  ExternalTrigConv must be set to ADC_SOFTWARE_START for STM32F1.
+//  Based on adc_stm32f4. We support blocking reads and DMA reads into primary / secondary buffers.
+//  On STM32F1, ADC1 is hardwired to DMA1 Channel 1.  Tested OK with internal temparature sensor.
+//  Blocking reads use ADC_SOFTWARE_START.  DMA reads are triggered by TIM3 TRGO at the rate set by
+//  stm32f1_adc_set_trigger_rate(), so the DMA interrupt fires once per buffer at that rate.
 //  HAL should be called in this sequence:
 //    __HAL_RCC_ADC1_CLK_ENABLE();
 //    HAL_ADC_Init(hadc1);
@@ -38,6 +39,7 @@
 #include "stm32f1xx_hal_adc.h"
 #include "stm32f1xx_hal_rcc.h"
 #include "stm32f1xx_hal_cortex.h"
+#include "stm32f1xx_hal_tim.h"
 #include "stm32f1xx_hal.h"
 #include "adc_stm32f1/adc_stm32f1.h"
 #include "stm32f1xx_hal_dma.h"
@@ -47,12 +49,9 @@
 #include <adc/adc.h>
 #endif
 
-#ifdef TODO
-#define STM32F1_IS_DMA_ADC_CHANNEL(CHANNEL) ((CHANNEL) <= DMA_CHANNEL_2)
-
-static DMA_HandleTypeDef *dma_handle[5];
-static struct adc_dev *adc_dma[5];
-#endif  //  TODO
+//  Only ADC1 supports DMA on STM32F1 (DMA1 Channel 1), so we track a single DMA handle and ADC device.
+static DMA_HandleTypeDef *dma_handle;
+static struct adc_dev *adc_dma;
 
 struct stm32f1_adc_stats {
     uint16_t adc_events;
@@ -67,6 +66,9 @@ struct stm32f1_adc_stats {
 
 static struct stm32f1_adc_stats stm32f1_adc_stats;
 
+//  Default ADC init settings from the device config, restored when the ADC is opened without an argument.
+static ADC_InitTypeDef stm32f1_adc_default_init;
+
 /// Set to 1 if RTC has been configured. Defined in apps/my_sensor_app/src/rtc.c
 extern int rtc_configured;
 
@@ -263,89 +265,38 @@ done:
     return rc;
 }
 
-#ifdef TODO
 static IRQn_Type
 stm32f1_resolve_adc_dma_irq(DMA_HandleTypeDef *hdma)
 {
-    uintptr_t stream_addr = (uintptr_t)hdma->Instance;
-
-    assert(STM32F1_IS_DMA_ADC_CHANNEL(hdma->Init.Channel));
-
-    switch(stream_addr) {
-        /* DMA2 */
-        case (uintptr_t)DMA2_Stream0:
-            return DMA2_Stream0_IRQn;
-        case (uintptr_t)DMA2_Stream1:
-            return DMA2_Stream1_IRQn;
-        case (uintptr_t)DMA2_Stream2:
-            return DMA2_Stream2_IRQn;
-        case (uintptr_t)DMA2_Stream3:
-            return DMA2_Stream3_IRQn;
-        case (uintptr_t)DMA2_Stream4:
-            return DMA2_Stream4_IRQn;
+    uintptr_t channel_addr = (uintptr_t)hdma->Instance;
+
+    switch(channel_addr) {
+        /* DMA1 Channel 1 is the only DMA request line for ADC1 */
+        case (uintptr_t)DMA1_Channel1:
+            return DMA1_Channel1_IRQn;
         default:
             assert(0);
     }
 }
 
 static void
-dma2_stream0_irq_handler(void)
-{
-    HAL_DMA_IRQHandler(dma_handle[0]);
-}
-
-static void
-dma2_stream1_irq_handler(void)
-{
-    HAL_DMA_IRQHandler(dma_handle[1]);
-}
-
-static void
-dma2_stream2_irq_handler(void)
-{
-    HAL_DMA_IRQHandler(dma_handle[2]);
-}
-
-static void
-dma2_stream3_irq_handler(void)
+dma1_channel1_irq_handler(void)
 {
-    HAL_DMA_IRQHandler(dma_handle[3]);
-}
-
-static void
-dma2_stream4_irq_handler(void)
-{
-    HAL_DMA_IRQHandler(dma_handle[4]);
+    HAL_DMA_IRQHandler(dma_handle);
 }
 
 uint32_t
 stm32f1_resolve_adc_dma_irq_handler(DMA_HandleTypeDef *hdma)
 {
     switch((uintptr_t)hdma->Instance) {
-        /* DMA2 */
-        case (uintptr_t)DMA2_Stream0:
-            return (uint32_t)&dma2_stream0_irq_handler;
-        case (uintptr_t)DMA2_Stream1:
-            return (uint32_t)&dma2_stream1_irq_handler;
-        case (uintptr_t)DMA2_Stream2:
-            return (uint32_t)&dma2_stream2_irq_handler;
-        case (uintptr_t)DMA2_Stream3:
-            return (uint32_t)&dma2_stream3_irq_handler;
-        case (uintptr_t)DMA2_Stream4:
-            return (uint32_t)&dma2_stream4_irq_handler;
+        /* DMA1 */
+        case (uintptr_t)DMA1_Channel1:
+            return (uint32_t)&dma1_channel1_irq_handler;
         default:
             assert(0);
     }
 }
 
-static int
-stm32f1_resolve_dma_handle_idx(DMA_HandleTypeDef *hdma)
-{
-    uintptr_t stream_addr = (uintptr_t)hdma->Instance;
-    return ((stream_addr & 0xFF) - ((uintptr_t)DMA2_Stream0_BASE & 0xFF))/0x18;
-}
-#endif  //  TODO
-
 void
 HAL_ADC_ErrorCallback(ADC_HandleTypeDef *hadc)
 {
@@ -363,7 +314,6 @@ HAL_ADC_ErrorCallback(ADC_HandleTypeDef *hadc)
     }
 }
 
-#ifdef TODO
 /**
  * Callback that gets called by the HAL when ADC conversion is complete and
  * the DMA buffer is full. If a secondary buffer exists it will the buffers.
@@ -381,10 +331,12 @@ HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc)
 
     assert(hadc);
     hdma = hadc->DMA_Handle;
+    assert(hdma == dma_handle);
 
     ++stm32f1_adc_stats.adc_dma_xfer_complete;
 
-    adc = adc_dma[stm32f1_resolve_dma_handle_idx(hdma)];
+    adc = adc_dma;
+    assert(adc);
     cfg  = (struct stm32f1_adc_dev_cfg *)adc->ad_dev.od_init_arg;
 
     buf = cfg->primarybuf;
@@ -406,38 +358,114 @@ HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc)
         }
     }
 
-    rc = adc->ad_event_handler_func(adc, NULL, ADC_EVENT_RESULT, buf,
+    if (!adc->ad_event_handler_func) { return; }
+    rc = adc->ad_event_handler_func(adc, adc->ad_event_handler_arg,
+                                    ADC_EVENT_RESULT, buf,
                                     cfg->buflen);
 
     if (rc) {
         ++stm32f1_adc_stats.adc_error;
     }
 }
-#endif  //  TODO
 
-static void
-stm32f1_adc_dma_init(ADC_HandleTypeDef* hadc)
+//  Attach the DMA channel to the ADC and enable its interrupt.  Called only when DMA buffers are set,
+//  so the blocking reads never touch DMA1.
+static int
+stm32f1_adc_dma_init(struct adc_dev *dev)
 {
-#ifdef TODO
+    struct stm32f1_adc_dev_cfg *cfg;
     DMA_HandleTypeDef *hdma;
-#endif  //  TODO
-    assert(hadc);
-#ifdef TODO
-    hdma = hadc->DMA_Handle;
-#endif  //  TODO
-    stm32f1_adc_clk_enable(hadc);
-#ifdef TODO
-    __HAL_RCC_DMA2_CLK_ENABLE();
+    ADC_HandleTypeDef *hadc;
 
-    HAL_DMA_Init(hdma);
-    dma_handle[stm32f1_resolve_dma_handle_idx(hdma)] = hdma;
+    assert(dev);
+    cfg  = (struct stm32f1_adc_dev_cfg *)dev->ad_dev.od_init_arg;
+    hadc = cfg->sac_adc_handle;
+    hdma = cfg->sac_dma_handle;
+
+    if (hdma == NULL) { return OS_EINVAL; }
+    if (hadc->DMA_Handle) { return OS_OK; }  //  Already attached.
+
+    __HAL_RCC_DMA1_CLK_ENABLE();
+
+    if (HAL_DMA_Init(hdma) != HAL_OK) { return OS_EINVAL; }
+    hadc->DMA_Handle = hdma;
+    hdma->Parent = hadc;  //  Let the DMA completion callbacks find the ADC handle.
+    dma_handle = hdma;
+    adc_dma = dev;
 
     NVIC_SetPriority(stm32f1_resolve_adc_dma_irq(hdma),
-                     NVIC_EncodePriority(NVIC_GetPriorityGrouping(), 0, 0));
+                    NVIC_EncodePriority(NVIC_GetPriorityGrouping(), 0, 0));
     NVIC_SetVector(stm32f1_resolve_adc_dma_irq(hdma),
-                   stm32f1_resolve_adc_dma_irq_handler(hdma));
+                stm32f1_resolve_adc_dma_irq_handler(hdma));
     NVIC_EnableIRQ(stm32f1_resolve_adc_dma_irq(hdma));
-#endif  //  TODO
+    return OS_OK;
+}
+
+//  Detach the DMA channel from the ADC.  Only the channel is de-initialised: the DMA1 clock stays on
+//  because the other DMA1 channels may be used by SPI, I2C or UART.
+static void
+stm32f1_adc_dma_deinit(ADC_HandleTypeDef *hadc)
+{
+    DMA_HandleTypeDef *hdma;
+
+    hdma = hadc->DMA_Handle;
+    if (hdma == NULL) { return; }
+
+    NVIC_DisableIRQ(stm32f1_resolve_adc_dma_irq(hdma));
+    if (HAL_DMA_DeInit(hdma) != HAL_OK) {
+        assert(0);
+    }
+    hadc->DMA_Handle = NULL;
+    dma_handle = NULL;
+    adc_dma = NULL;
+}
+
+//  Start the timer whose TRGO update event triggers each conversion, at cfg->sac_trigger_hz.
+static int
+stm32f1_adc_trigger_start(struct stm32f1_adc_dev_cfg *cfg)
+{
+    TIM_MasterConfigTypeDef master = {
+        .MasterOutputTrigger = TIM_TRGO_UPDATE,
+        .MasterSlaveMode     = TIM_MASTERSLAVEMODE_DISABLE,
+    };
+    TIM_HandleTypeDef *htim;
+    uint32_t clk;
+    uint32_t ticks;
+    uint32_t prescaler;
+
+    htim = cfg->sac_trigger_timer;
+    if (htim == NULL || cfg->sac_trigger_hz == 0) { return OS_EINVAL; }
+    assert(htim->Instance == TIM3);  //  Must match ADC_EXTERNALTRIGCONV_T3_TRGO
+
+    //  APB1 timers run at twice the APB1 clock when APB1 is divided.
+    clk = HAL_RCC_GetPCLK1Freq();
+    if ((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_HCLK_DIV1) { clk *= 2; }
+
+    //  Split the timer ticks per conversion into a 16-bit prescaler and a 16-bit period.
+    ticks = clk / cfg->sac_trigger_hz;
+    if (ticks == 0) { return OS_EINVAL; }
+    prescaler = (ticks - 1) / 0x10000 + 1;
+    htim->Init.Prescaler = prescaler - 1;
+    htim->Init.Period = ticks / prescaler - 1;
+
+    __HAL_RCC_TIM3_CLK_ENABLE();
+    if (HAL_TIM_Base_Init(htim) != HAL_OK) { return OS_EINVAL; }
+    if (HAL_TIMEx_MasterConfigSynchronization(htim, &master) != HAL_OK) { return OS_EINVAL; }
+    if (HAL_TIM_Base_Start(htim) != HAL_OK) { return OS_EINVAL; }
+    return OS_OK;
+}
+
+//  Stop the trigger timer, if it was started.
+static void
+stm32f1_adc_trigger_stop(struct stm32f1_adc_dev_cfg *cfg)
+{
+    TIM_HandleTypeDef *htim;
+
+    htim = cfg->sac_trigger_timer;
+    if (htim == NULL || htim->State == HAL_TIM_STATE_RESET) { return; }
+    HAL_TIM_Base_Stop(htim);
+    HAL_TIM_Base_DeInit(htim);
+    __HAL_RCC_TIM3_CLK_DISABLE();
 }
 
 static void
@@ -451,7 +479,7 @@ stm32f1_adc_init(struct adc_dev *dev)
     adc_config = (struct stm32f1_adc_dev_cfg *)dev->ad_dev.od_init_arg;
     hadc = adc_config->sac_adc_handle;
 
-    stm32f1_adc_dma_init(hadc);
+    stm32f1_adc_clk_enable(hadc);
 
     if (HAL_ADC_Init(hadc) != HAL_OK) {
         assert(0);
@@ -462,7 +490,6 @@ static void
 stm32f1_adc_uninit(struct adc_dev *dev)
 {
     GPIO_InitTypeDef gpio_td;
-    ////  DMA_HandleTypeDef *hdma;
     ADC_HandleTypeDef *hadc;
     struct stm32f1_adc_dev_cfg *cfg;
     uint8_t cnum;
@@ -470,19 +497,15 @@ stm32f1_adc_uninit(struct adc_dev *dev)
     assert(dev);
     cfg  = (struct stm32f1_adc_dev_cfg *)dev->ad_dev.od_init_arg;
     hadc = cfg->sac_adc_handle;
-    ////  hdma = hadc->DMA_Handle;
     cnum = dev->ad_chans->c_cnum;
 
-#ifdef TODO
-    __HAL_RCC_DMA2_CLK_DISABLE();
-    if (HAL_DMA_DeInit(hdma) != HAL_OK) {
-        assert(0);
+    stm32f1_adc_trigger_stop(cfg);
+    if (hadc->DMA_Handle) {
+        HAL_ADC_Stop_DMA(hadc);
     }
-#endif  //  TODO
+    stm32f1_adc_dma_deinit(hadc);
     stm32f1_adc_clk_disable(hadc);
 
-    ////  NVIC_DisableIRQ(stm32f1_resolve_adc_dma_irq(hdma));
-
     //  Temperature and VREF channels don't use GPIO.  No need to deinit GPIO.
     if (cnum != ADC_CHANNEL_TEMPSENSOR && cnum != ADC_CHANNEL_VREFINT) {
         //  Deinit the GPIO.
@@ -507,18 +530,17 @@ err:
  * @param wait The time in MS to wait.  If 0 specified, returns immediately
  *             if resource unavailable.  If OS_WAIT_FOREVER specified, blocks
  *             until resource is available.
- * @param arg  Argument provided by higher layer to open.
+ * @param arg  Argument provided by higher layer to open.  If non-NULL,
+ *             an ADC_InitTypeDef that overrides the default ADC settings
+ *             until the device is closed.
  *
  * @return 0 on success, non-zero on failure.
  */
 static int
 stm32f1_adc_open(struct os_dev *odev, uint32_t wait, void *arg)
 {
-#ifdef TODO
-    DMA_HandleTypeDef *hdma;
     ADC_HandleTypeDef *hadc;
     struct stm32f1_adc_dev_cfg *cfg;
-#endif  //  TODO
     //  console_printf("open adc1\n");  ////
     struct adc_dev *dev;
     int rc;
@@ -540,15 +562,13 @@ stm32f1_adc_open(struct os_dev *odev, uint32_t wait, void *arg)
         goto err;
     }
 
-    stm32f1_adc_init(dev);
-
-#ifdef TODO    
+    //  If the caller passed an ADC_InitTypeDef (e.g. to enable scan mode for multiple channels), use it
+    //  for this session.  Otherwise restore the default settings.
     cfg  = (struct stm32f1_adc_dev_cfg *)dev->ad_dev.od_init_arg;
     hadc = cfg->sac_adc_handle;
-    hdma = hadc->DMA_Handle;
+    hadc->Init = arg ? *(ADC_InitTypeDef *)arg : stm32f1_adc_default_init;
 
-    adc_dma[stm32f1_resolve_dma_handle_idx(hdma)] = dev;
-#endif  //  TODO    
+    stm32f1_adc_init(dev);
 
     return (OS_OK);
 err:
@@ -637,12 +657,14 @@ err:
     return (rc);
 }
 
-#ifdef TODO
 /**
  * Set buffer to read data into.  Implementation of setbuffer handler.
- * Sets both the primary and secondary buffers for DMA.
+ * Sets both the primary and secondary buffers for DMA and attaches the
+ * DMA channel to the ADC.
  *
- * For our current implementation we are using DMA in circular mode
+ * DMA runs in normal mode.  When the primary buffer is full, the
+ * conversion complete callback swaps in the secondary buffer (if any)
+ * and restarts DMA between two timer triggers, so no conversion is lost.
  *
  */
 static int
@@ -659,6 +681,11 @@ stm32f1_adc_set_buffer(struct adc_dev *dev, void *buf1, void *buf2,
 
     cfg  = (struct stm32f1_adc_dev_cfg *)dev->ad_dev.od_init_arg;
 
+    rc = stm32f1_adc_dma_init(dev);
+    if (rc) {
+        return rc;
+    }
+
     cfg->primarybuf = buf1;
     cfg->secondarybuf = buf2;
     cfg->buflen = buflen;
@@ -676,27 +703,11 @@ stm32f1_adc_release_buffer(struct adc_dev *dev, void *buf, int buf_len)
     cfg  = (struct stm32f1_adc_dev_cfg *)dev->ad_dev.od_init_arg;
     hadc = cfg->sac_adc_handle;
 
+    stm32f1_adc_trigger_stop(cfg);
     HAL_ADC_Stop_DMA(hadc);
 
     return (0);
 }
-#else
-//  Catch calls to these functions
-static int
-stm32f1_adc_set_buffer(struct adc_dev *dev, void *buf1, void *buf2,
-        int buflen)
-{
-    assert(0);  //  Not implemented.
-    return (0);
-}
-
-static int
-stm32f1_adc_release_buffer(struct adc_dev *dev, void *buf, int buf_len)
-{
-    assert(0);  //  Not implemented.
-    return (0);
-}
-#endif  //  TODO
 
 /**
  * Trigger an ADC sample.
@@ -716,13 +727,31 @@ stm32f1_adc_sample(struct adc_dev *dev)
     hadc = cfg->sac_adc_handle;
 
     rc = OS_EINVAL;
+    if (hadc->DMA_Handle == NULL || cfg->primarybuf == NULL || cfg->sac_trigger_hz == 0) {
+        goto err;
+    }
+
+    //  Convert once per timer trigger instead of free-running.  HAL_ADC_Init() keeps the configured channels.
+    hadc->Init.ContinuousConvMode = DISABLE;
+    hadc->Init.ExternalTrigConv   = ADC_EXTERNALTRIGCONV_T3_TRGO;
+    if (HAL_ADC_Init(hadc) != HAL_OK) {
+        goto err;
+    }
+
+    //  Calibrate once before the DMA conversions start.  The ADC then stays calibrated until closed.
+    while (HAL_ADCEx_Calibration_Start(hadc) != HAL_OK);
 
     if (HAL_ADC_Start_DMA(hadc, cfg->primarybuf, cfg->buflen) != HAL_OK) {
         ++stm32f1_adc_stats.adc_dma_start_error;
         goto err;
     }
 
-    rc = OS_OK;
+    //  Conversions start at the first timer update.
+    rc = stm32f1_adc_trigger_start(cfg);
+    if (rc) {
+        HAL_ADC_Stop_DMA(hadc);
+        goto err;
+    }
 
 err:
     return rc;
@@ -822,6 +851,27 @@ stm32f1_adc_size_buffer(struct adc_dev *dev, int chans, int samples)
     return (sizeof(uint32_t) * chans * samples);
 }
 
+/**
+ * Set the number of DMA conversions per second.  Each conversion is
+ * triggered by the update event of the trigger timer (TIM3), so the
+ * DMA interrupt fires at hz / buffer length instead of free-running.
+ *
+ * @param dev ADC device structure
+ * @param hz Conversions per second
+ * @return OS_OK on success, OS_EINVAL if hz is 0
+ */
+int
+stm32f1_adc_set_trigger_rate(struct adc_dev *dev, uint32_t hz)
+{
+    struct stm32f1_adc_dev_cfg *cfg;
+
+    assert(dev);
+    if (hz == 0) { return OS_EINVAL; }
+    cfg = (struct stm32f1_adc_dev_cfg *)dev->ad_dev.od_init_arg;
+    cfg->sac_trigger_hz = hz;
+    return OS_OK;
+}
+
 /**
  * ADC device driver functions
  */
@@ -865,6 +915,8 @@ stm32f1_adc_dev_init(struct os_dev *odev, void *arg)
 
     dev->ad_funcs = &stm32f1_adc_funcs;
 
+    stm32f1_adc_default_init = ((ADC_HandleTypeDef *)sac->sac_adc_handle)->Init;
+
 #ifdef NOTUSED
     //  TODO: Move to stm32f1_adc_open
     __HAL_RCC_ADC1_CLK_ENABLE();  ////  TODO: Added enable ADC1
@@ -20,6 +20,7 @@
 #include <stm32f1xx_hal.h>
 #include <stm32f1xx_hal_dma.h>
 #include <stm32f1xx_hal_adc.h>
+#include <stm32f1xx_hal_tim.h>
 #include <adc_stm32f1/adc_stm32f1.h>
 #include <console/console.h>
 
@@ -40,12 +41,43 @@
     /* TODO: .DMAContinuousRequests = ENABLE */ \
 }
 
+/*****************ADC1 DMA Config ***************/
+//  ADC1 is hardwired to DMA1 Channel 1.  Each conversion is transferred as a 32-bit word,
+//  matching the uint32_t sample buffers passed to adc_buf_set().
+#define STM32F1_DEFAULT_ADC1_DMA_HANDLE {\
+    .Instance = DMA1_Channel1,\
+    .Init = {\
+        .Direction           = DMA_PERIPH_TO_MEMORY,\
+        .PeriphInc           = DMA_PINC_DISABLE,\
+        .MemInc              = DMA_MINC_ENABLE,\
+        .PeriphDataAlignment = DMA_PDATAALIGN_WORD,\
+        .MemDataAlignment    = DMA_MDATAALIGN_WORD,\
+        .Mode                = DMA_NORMAL,          /* Buffers are swapped and DMA restarted by the conversion complete callback */ \
+        .Priority            = DMA_PRIORITY_HIGH,\
+    },\
+}
+
+static DMA_HandleTypeDef adc1_dma_handle = STM32F1_DEFAULT_ADC1_DMA_HANDLE;
+
+/*****************ADC1 Trigger Timer Config ***************/
+//  TIM3 TRGO paces the DMA conversions (ADC_EXTERNALTRIGCONV_T3_TRGO).  TIM2 is the system timer on Blue Pill.
+//  Prescaler and period are computed from the rate set by stm32f1_adc_set_trigger_rate().
+#define STM32F1_DEFAULT_ADC1_TRIGGER_TIMER {\
+    .Instance = TIM3,\
+    .Init = {\
+        .CounterMode   = TIM_COUNTERMODE_UP,\
+        .ClockDivision = TIM_CLOCKDIVISION_DIV1,\
+    },\
+}
+
+static TIM_HandleTypeDef adc1_trigger_timer = STM32F1_DEFAULT_ADC1_TRIGGER_TIMER;
+
 /*****************ADC1 Config ***************/
 #define STM32F1_DEFAULT_ADC1_HANDLE {\
     .Init     = STM32F1_ADC_DEFAULT_INIT_TD,\
     .Instance = ADC1,\
     /* TODO: .NbrOfCurrentConversionRank = 0, */ \
-    .DMA_Handle = NULL, /* TODO: &adc1_dma00_handle, */ \
+    .DMA_Handle = NULL,  /* Set to sac_dma_handle when DMA buffers are used */ \
     .Lock       = HAL_UNLOCKED,\
     .State      = 0,\
     .ErrorCode  = 0\
@@ -58,6 +90,9 @@ static ADC_HandleTypeDef adc1_handle = STM32F1_DEFAULT_ADC1_HANDLE;
     .sac_chan_count = 18,\
     .sac_chans = (struct adc_chan_config [18]){{0},{0},{0},{0},{0},{0},{0},{0},{0},{0},/* TODO: STM32F1_ADC1_DEFAULT_SAC */ {0},{0},{0},{0},{0},{0},{0},{0} } ,\
     .sac_adc_handle = &adc1_handle,\
+    .sac_dma_handle = &adc1_dma_handle,\
+    .sac_trigger_timer = &adc1_trigger_timer,\
+    .sac_trigger_hz = 0,  /* No DMA conversions until the rate is set */ \
 }
 /*********************************************/
 
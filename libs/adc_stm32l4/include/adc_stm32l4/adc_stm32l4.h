@@ -86,6 +86,9 @@ struct stm32l4_adc_dev_cfg {
     void *secondarybuf;
     int buflen;
     ADC_HandleTypeDef *sac_adc_handle;
+    DMA_HandleTypeDef *sac_dma_handle;  //  Attached to the ADC only while sampling with DMA
+    void *sac_trigger_timer;  //  Actual type: TIM_HandleTypeDef *.  Timer whose update event triggers each DMA scan sequence.
+    uint32_t sac_trigger_hz;  //  DMA scan sequences per second, set by stm32l4_adc_set_trigger_rate()
 };
 
 //  Create the STM32L4 ADC1 device.  Implemented in creator.c, function DEVICE_CREATE().
@@ -94,6 +97,9 @@ void stm32l4_adc_create(void);
 //  Initialise the STM32L4 ADC device with the configuration.
 int stm32l4_adc_dev_init(struct os_dev *dev, void *cfg);
 
+//  Set the number of DMA scan sequences per second.  Must be set before adc_sample() starts DMA.
+int stm32l4_adc_set_trigger_rate(struct adc_dev *dev, uint32_t hz);
+
 #ifdef __cplusplus
 }
 #endif
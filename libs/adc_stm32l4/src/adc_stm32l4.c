@@ -26,6 +26,7 @@
 #include "stm32l4xx_hal_adc.h"
 #include "stm32l4xx_hal_rcc.h"
 #include "stm32l4xx_hal_cortex.h"
+#include "stm32l4xx_hal_tim.h"
 #include "stm32l4xx_hal.h"
 #include "adc_stm32l4/adc_stm32l4.h"
 #include "mcu/stm32l4xx_mynewt_hal.h"
@@ -36,8 +37,9 @@
 
 #define STM32L4_IS_DMA_ADC_CHANNEL(CHANNEL) ((CHANNEL) <= DMA_CHANNEL_2)
 
-static DMA_HandleTypeDef *dma_handle[5];
-static struct adc_dev *adc_dma[5];
+//  DMA handles and ADC devices, indexed by DMA2 channel number (1 to 7).
+static DMA_HandleTypeDef *dma_handle[8];
+static struct adc_dev *adc_dma[8];
 
 struct stm32l4_adc_stats {
     uint16_t adc_events;
@@ -52,6 +54,9 @@ struct stm32l4_adc_stats {
 
 static struct stm32l4_adc_stats stm32l4_adc_stats;
 
+//  Default ADC init settings from the device config, restored when the ADC is opened without an argument.
+static ADC_InitTypeDef stm32l4_adc_default_init;
+
 static void
 stm32l4_adc_clk_enable(ADC_HandleTypeDef *hadc)
 {
@@ -324,9 +329,19 @@ static int
 stm32l4_resolve_dma_handle_idx(DMA_HandleTypeDef *hdma)
 {
     assert(hdma);
-    uintptr_t stream_addr = (uintptr_t)hdma->Instance;
-    ////  TODO: Verify
-    return ((stream_addr & 0xFF) - ((uintptr_t)DMA2_Channel1_BASE & 0xFF))/0x18;
+    //  Return the DMA2 channel number, which matches the dma2_streamN_irq_handler() above.
+    switch((uintptr_t)hdma->Instance) {
+        case (uintptr_t)DMA2_Channel1: return 1;
+        case (uintptr_t)DMA2_Channel2: return 2;
+        case (uintptr_t)DMA2_Channel3: return 3;
+        case (uintptr_t)DMA2_Channel4: return 4;
+        case (uintptr_t)DMA2_Channel5: return 5;
+        case (uintptr_t)DMA2_Channel6: return 6;
+        case (uintptr_t)DMA2_Channel7: return 7;
+        default:
+            assert(0);
+            return 0;
+    }
 }
 
 void
@@ -347,29 +362,77 @@ HAL_ADC_ErrorCallback(ADC_HandleTypeDef *hadc)
     }
 }
 
+//  Return the ADC device that owns the DMA channel of the ADC handle.
+static struct adc_dev *
+stm32l4_adc_dma_dev(ADC_HandleTypeDef *hadc)
+{
+    DMA_HandleTypeDef *hdma;
+
+    assert(hadc);
+    hdma = hadc->DMA_Handle;
+    assert(hdma);
+    return adc_dma[stm32l4_resolve_dma_handle_idx(hdma)];
+}
+
+//  Pass the completed buffer to the ADC event handler.
+static void
+stm32l4_adc_dma_deliver(struct adc_dev *adc, void *buf, int buflen)
+{
+    int rc;
+
+    assert(adc);
+    if (!adc->ad_event_handler_func) { return; }
+    rc = adc->ad_event_handler_func(adc, adc->ad_event_handler_arg,
+                                    ADC_EVENT_RESULT, buf, buflen);
+    if (rc) {
+        ++stm32l4_adc_stats.adc_error;
+    }
+}
+
+/**
+ * Callback that gets called by the HAL when circular DMA has filled the
+ * first half of the buffer, i.e. the primary buffer.  DMA continues into
+ * the secondary buffer without stopping the ADC.
+ *
+ * @param ADC Handle
+ */
+void
+HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef *hadc)
+{
+    struct adc_dev *adc;
+    struct stm32l4_adc_dev_cfg *cfg;
+
+    adc = stm32l4_adc_dma_dev(hadc);
+    cfg = (struct stm32l4_adc_dev_cfg *)adc->ad_dev.od_init_arg;
+
+    ++stm32l4_adc_stats.adc_dma_xfer_complete;
+    stm32l4_adc_dma_deliver(adc, cfg->primarybuf, cfg->buflen);
+}
+
 /**
  * Callback that gets called by the HAL when ADC conversion is complete and
- * the DMA buffer is full. If a secondary buffer exists it will the buffers.
+ * the DMA buffer is full.  In circular mode the secondary buffer is full
+ * and DMA wraps around to the primary buffer.  Otherwise, if a secondary
+ * buffer exists, the buffers are swapped and DMA is restarted.
  *
  * @param ADC Handle
  */
 void
 HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc)
 {
-    int rc;
     struct adc_dev *adc;
-    DMA_HandleTypeDef *hdma;
     struct stm32l4_adc_dev_cfg *cfg;
     void *buf;
 
-    assert(hadc);
-    hdma = hadc->DMA_Handle;
-    assert(hdma);
+    adc = stm32l4_adc_dma_dev(hadc);
+    cfg = (struct stm32l4_adc_dev_cfg *)adc->ad_dev.od_init_arg;
 
     ++stm32l4_adc_stats.adc_dma_xfer_complete;
 
-    adc = adc_dma[stm32l4_resolve_dma_handle_idx(hdma)];
-    cfg  = (struct stm32l4_adc_dev_cfg *)adc->ad_dev.od_init_arg;
+    if (hadc->DMA_Handle->Init.Mode == DMA_CIRCULAR) {
+        stm32l4_adc_dma_deliver(adc, cfg->secondarybuf, cfg->buflen);
+        return;
+    }
 
     buf = cfg->primarybuf;
     /**
@@ -385,42 +448,120 @@ HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc)
         cfg->primarybuf = cfg->secondarybuf;
         cfg->secondarybuf = buf;
 
+        //  The L4 HAL refuses to start DMA while a conversion is ongoing.  Stop the conversions first.
+        HAL_ADC_Stop_DMA(hadc);
         if (HAL_ADC_Start_DMA(hadc, cfg->primarybuf, cfg->buflen) != HAL_OK) {
             ++stm32l4_adc_stats.adc_dma_start_error;
         }
     }
+    stm32l4_adc_dma_deliver(adc, buf, cfg->buflen);
+}
 
-    rc = adc->ad_event_handler_func(adc, NULL, ADC_EVENT_RESULT, buf,
-                                    cfg->buflen);
+//  Attach the DMA channel to the ADC and enable its interrupt.  Called only when DMA buffers are set,
+//  so the blocking reads never touch DMA2.  If the secondary buffer follows the primary buffer in memory,
+//  DMA runs in circular mode over both buffers.  Otherwise DMA is restarted on the other buffer when
+//  each buffer is full.
+static int
+stm32l4_adc_dma_init(struct adc_dev *dev)
+{
+    struct stm32l4_adc_dev_cfg *cfg;
+    DMA_HandleTypeDef *hdma;
+    ADC_HandleTypeDef *hadc;
 
-    if (rc) {
-        ++stm32l4_adc_stats.adc_error;
+    assert(dev);
+    cfg  = (struct stm32l4_adc_dev_cfg *)dev->ad_dev.od_init_arg;
+    hadc = cfg->sac_adc_handle;
+    hdma = cfg->sac_dma_handle;
+
+    if (hdma == NULL) { return OS_EINVAL; }
+    if (hadc->DMA_Handle) {
+        //  Buffers changed: Detach and attach again with the right DMA mode.
+        HAL_DMA_DeInit(hdma);
     }
+
+    __HAL_RCC_DMA2_CLK_ENABLE();
+
+    hdma->Init.Mode = (cfg->secondarybuf == (uint32_t *)cfg->primarybuf + cfg->buflen)
+        ? DMA_CIRCULAR : DMA_NORMAL;
+    if (HAL_DMA_Init(hdma) != HAL_OK) { return OS_EINVAL; }
+    hadc->DMA_Handle = hdma;
+    hdma->Parent = hadc;  //  Let the DMA completion callbacks find the ADC handle.
+    dma_handle[stm32l4_resolve_dma_handle_idx(hdma)] = hdma;
+    adc_dma[stm32l4_resolve_dma_handle_idx(hdma)] = dev;
+
+    NVIC_SetPriority(stm32l4_resolve_adc_dma_irq(hdma),
+                    NVIC_EncodePriority(NVIC_GetPriorityGrouping(), 0, 0));
+    NVIC_SetVector(stm32l4_resolve_adc_dma_irq(hdma),
+                stm32l4_resolve_adc_dma_irq_handler(hdma));
+    NVIC_EnableIRQ(stm32l4_resolve_adc_dma_irq(hdma));
+    return OS_OK;
 }
 
+//  Detach the DMA channel from the ADC.  Only the channel is de-initialised: the DMA2 clock stays on
+//  because the other DMA2 channels may be used by SPI, I2C or UART.
 static void
-stm32l4_adc_dma_init(ADC_HandleTypeDef* hadc)
+stm32l4_adc_dma_deinit(ADC_HandleTypeDef *hadc)
 {
-
     DMA_HandleTypeDef *hdma;
 
-    assert(hadc);
     hdma = hadc->DMA_Handle;
+    if (hdma == NULL) { return; }
 
-    stm32l4_adc_clk_enable(hadc);
+    NVIC_DisableIRQ(stm32l4_resolve_adc_dma_irq(hdma));
+    if (HAL_DMA_DeInit(hdma) != HAL_OK) {
+        assert(0);
+    }
+    dma_handle[stm32l4_resolve_dma_handle_idx(hdma)] = NULL;
+    adc_dma[stm32l4_resolve_dma_handle_idx(hdma)] = NULL;
+    hadc->DMA_Handle = NULL;
+}
 
-    if (hdma) {
-        __HAL_RCC_DMA2_CLK_ENABLE();
+//  Start the timer whose TRGO update event triggers each scan sequence, at cfg->sac_trigger_hz.
+static int
+stm32l4_adc_trigger_start(struct stm32l4_adc_dev_cfg *cfg)
+{
+    TIM_MasterConfigTypeDef master = {
+        .MasterOutputTrigger = TIM_TRGO_UPDATE,
+        .MasterSlaveMode     = TIM_MASTERSLAVEMODE_DISABLE,
+    };
+    TIM_HandleTypeDef *htim;
+    uint32_t clk;
+    uint32_t ticks;
+    uint32_t prescaler;
+
+    htim = cfg->sac_trigger_timer;
+    if (htim == NULL || cfg->sac_trigger_hz == 0) { return OS_EINVAL; }
+    assert(htim->Instance == TIM6);  //  Must match ADC_EXTERNALTRIG_T6_TRGO
+
+    //  APB1 timers run at twice the APB1 clock when APB1 is divided.
+    clk = HAL_RCC_GetPCLK1Freq();
+    if ((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_HCLK_DIV1) { clk *= 2; }
+
+    //  Split the timer ticks per scan into a 16-bit prescaler and a 16-bit period.
+    ticks = clk / cfg->sac_trigger_hz;
+    if (ticks == 0) { return OS_EINVAL; }
+    prescaler = (ticks - 1) / 0x10000 + 1;
+    htim->Init.Prescaler = prescaler - 1;
+    htim->Init.Period = ticks / prescaler - 1;
+
+    __HAL_RCC_TIM6_CLK_ENABLE();
+    if (HAL_TIM_Base_Init(htim) != HAL_OK) { return OS_EINVAL; }
+    if (HAL_TIMEx_MasterConfigSynchronization(htim, &master) != HAL_OK) { return OS_EINVAL; }
+    if (HAL_TIM_Base_Start(htim) != HAL_OK) { return OS_EINVAL; }
+    return OS_OK;
+}
 
-        HAL_DMA_Init(hdma);
-        dma_handle[stm32l4_resolve_dma_handle_idx(hdma)] = hdma;
+//  Stop the trigger timer, if it was started.
+static void
+stm32l4_adc_trigger_stop(struct stm32l4_adc_dev_cfg *cfg)
+{
+    TIM_HandleTypeDef *htim;
 
-        NVIC_SetPriority(stm32l4_resolve_adc_dma_irq(hdma),
-                        NVIC_EncodePriority(NVIC_GetPriorityGrouping(), 0, 0));
-        NVIC_SetVector(stm32l4_resolve_adc_dma_irq(hdma),
-                    stm32l4_resolve_adc_dma_irq_handler(hdma));
-        NVIC_EnableIRQ(stm32l4_resolve_adc_dma_irq(hdma));
-    }
+    htim = cfg->sac_trigger_timer;
+    if (htim == NULL || htim->State == HAL_TIM_STATE_RESET) { return; }
+    HAL_TIM_Base_Stop(htim);
+    HAL_TIM_Base_DeInit(htim);
+    __HAL_RCC_TIM6_CLK_DISABLE();
 }
 
 static void
@@ -434,7 +575,7 @@ stm32l4_adc_init(struct adc_dev *dev)
     adc_config = (struct stm32l4_adc_dev_cfg *)dev->ad_dev.od_init_arg;
     hadc = adc_config->sac_adc_handle;
 
-    stm32l4_adc_dma_init(hadc);
+    stm32l4_adc_clk_enable(hadc);
 
     if (HAL_ADC_Init(hadc) != HAL_OK) {
         assert(0);
@@ -445,7 +586,6 @@ static void
 stm32l4_adc_uninit(struct adc_dev *dev)
 {
     GPIO_InitTypeDef gpio_td;
-    DMA_HandleTypeDef *hdma;
     ADC_HandleTypeDef *hadc;
     struct stm32l4_adc_dev_cfg *cfg;
     uint8_t cnum;
@@ -453,21 +593,15 @@ stm32l4_adc_uninit(struct adc_dev *dev)
     assert(dev);
     cfg  = (struct stm32l4_adc_dev_cfg *)dev->ad_dev.od_init_arg;
     hadc = cfg->sac_adc_handle;
-    hdma = hadc->DMA_Handle;
     cnum = dev->ad_chans->c_cnum;
 
-    if (hdma) {
-        __HAL_RCC_DMA2_CLK_DISABLE();
-        if (HAL_DMA_DeInit(hdma) != HAL_OK) {
-            assert(0);
-        }
+    stm32l4_adc_trigger_stop(cfg);
+    if (hadc->DMA_Handle) {
+        HAL_ADC_Stop_DMA(hadc);
     }
+    stm32l4_adc_dma_deinit(hadc);
     stm32l4_adc_clk_disable(hadc);
 
-    if (hdma) {
-        NVIC_DisableIRQ(stm32l4_resolve_adc_dma_irq(hdma));
-    }
-
     //  Temperature, VREF and VBAT channels don't use GPIO.  No need to deinit GPIO.
     if (cnum != MYNEWT_ADC_CHANNEL_TEMPSENSOR && 
         cnum != MYNEWT_ADC_CHANNEL_VREFINT &&
@@ -493,14 +627,15 @@ err:
  * @param wait The time in MS to wait.  If 0 specified, returns immediately
  *             if resource unavailable.  If OS_WAIT_FOREVER specified, blocks
  *             until resource is available.
- * @param arg  Argument provided by higher layer to open.
+ * @param arg  Argument provided by higher layer to open.  If non-NULL,
+ *             an ADC_InitTypeDef that overrides the default ADC settings
+ *             until the device is closed.
  *
  * @return 0 on success, non-zero on failure.
  */
 static int
 stm32l4_adc_open(struct os_dev *odev, uint32_t wait, void *arg)
 {
-    DMA_HandleTypeDef *hdma;
     ADC_HandleTypeDef *hadc;
     struct stm32l4_adc_dev_cfg *cfg;
     struct adc_dev *dev;
@@ -523,15 +658,13 @@ stm32l4_adc_open(struct os_dev *odev, uint32_t wait, void *arg)
         goto err;
     }
 
-    stm32l4_adc_init(dev);
-
+    //  If the caller passed an ADC_InitTypeDef (e.g. to enable scan mode for multiple channels), use it
+    //  for this session.  Otherwise restore the default settings.
     cfg  = (struct stm32l4_adc_dev_cfg *)dev->ad_dev.od_init_arg;
     hadc = cfg->sac_adc_handle;
-    hdma = hadc->DMA_Handle;
+    hadc->Init = arg ? *(ADC_InitTypeDef *)arg : stm32l4_adc_default_init;
 
-    if (hdma) {
-        adc_dma[stm32l4_resolve_dma_handle_idx(hdma)] = dev;
-    }
+    stm32l4_adc_init(dev);
 
     return (OS_OK);
 err:
@@ -621,9 +754,13 @@ err:
 
 /**
  * Set buffer to read data into.  Implementation of setbuffer handler.
- * Sets both the primary and secondary buffers for DMA.
+ * Sets both the primary and secondary buffers for DMA and attaches the
+ * DMA channel to the ADC.
  *
- * For our current implementation we are using DMA in circular mode
+ * If the secondary buffer follows the primary buffer in memory, DMA runs
+ * in circular mode: the half complete callback delivers the primary buffer
+ * and the complete callback delivers the secondary buffer, while the ADC
+ * keeps converting without a gap.
  *
  */
 static int
@@ -644,6 +781,7 @@ stm32l4_adc_set_buffer(struct adc_dev *dev, void *buf1, void *buf2,
     cfg->secondarybuf = buf2;
     cfg->buflen = buflen;
 
+    rc = stm32l4_adc_dma_init(dev);
     return rc;
 }
 
@@ -657,6 +795,7 @@ stm32l4_adc_release_buffer(struct adc_dev *dev, void *buf, int buf_len)
     cfg  = (struct stm32l4_adc_dev_cfg *)dev->ad_dev.od_init_arg;
     hadc = cfg->sac_adc_handle;
 
+    stm32l4_adc_trigger_stop(cfg);
     HAL_ADC_Stop_DMA(hadc);
 
     return (0);
@@ -672,6 +811,7 @@ static int
 stm32l4_adc_sample(struct adc_dev *dev)
 {
     int rc;
+    int circular;
     ADC_HandleTypeDef *hadc;
     struct stm32l4_adc_dev_cfg *cfg;
 
@@ -680,13 +820,36 @@ stm32l4_adc_sample(struct adc_dev *dev)
     hadc = cfg->sac_adc_handle;
 
     rc = OS_EINVAL;
+    if (hadc->DMA_Handle == NULL || cfg->primarybuf == NULL || cfg->sac_trigger_hz == 0) {
+        goto err;
+    }
+    circular = (hadc->DMA_Handle->Init.Mode == DMA_CIRCULAR);
+
+    //  Convert one scan sequence per timer trigger instead of free-running.  Circular DMA needs a DMA
+    //  request after every conversion, not just until the first buffer is full.
+    hadc->Init.ContinuousConvMode    = DISABLE;
+    hadc->Init.ExternalTrigConv      = ADC_EXTERNALTRIG_T6_TRGO;
+    hadc->Init.ExternalTrigConvEdge  = ADC_EXTERNALTRIGCONVEDGE_RISING;
+    hadc->Init.DMAContinuousRequests = circular ? ENABLE : DISABLE;
+    if (HAL_ADC_Init(hadc) != HAL_OK) {
+        goto err;
+    }
+
+    //  Calibrate once before the DMA conversions start.
+    while (HAL_ADCEx_Calibration_Start(hadc, ADC_SINGLE_ENDED) != HAL_OK) {}
 
-    if (HAL_ADC_Start_DMA(hadc, cfg->primarybuf, cfg->buflen) != HAL_OK) {
+    //  In circular mode, DMA fills both buffers in turn and wraps around.
+    if (HAL_ADC_Start_DMA(hadc, cfg->primarybuf, circular ? 2 * cfg->buflen : cfg->buflen) != HAL_OK) {
         ++stm32l4_adc_stats.adc_dma_start_error;
         goto err;
     }
 
-    rc = OS_OK;
+    //  Conversions start at the first timer update.
+    rc = stm32l4_adc_trigger_start(cfg);
+    if (rc) {
+        HAL_ADC_Stop_DMA(hadc);
+        goto err;
+    }
 
 err:
     return rc;
@@ -764,6 +927,26 @@ stm32l4_adc_size_buffer(struct adc_dev *dev, int chans, int samples)
     return (sizeof(uint32_t) * chans * samples);
 }
 
+/**
+ * Set the number of DMA scan sequences per second.  Each scan sequence is
+ * triggered by the update event of the trigger timer (TIM6).
+ *
+ * @param dev ADC device structure
+ * @param hz Scan sequences per second
+ * @return OS_OK on success, OS_EINVAL if hz is 0
+ */
+int
+stm32l4_adc_set_trigger_rate(struct adc_dev *dev, uint32_t hz)
+{
+    struct stm32l4_adc_dev_cfg *cfg;
+
+    assert(dev);
+    if (hz == 0) { return OS_EINVAL; }
+    cfg = (struct stm32l4_adc_dev_cfg *)dev->ad_dev.od_init_arg;
+    cfg->sac_trigger_hz = hz;
+    return OS_OK;
+}
+
 /**
  * ADC device driver functions
  */
@@ -807,6 +990,8 @@ stm32l4_adc_dev_init(struct os_dev *odev, void *arg)
 
     dev->ad_funcs = &stm32l4_adc_funcs;
 
+    stm32l4_adc_default_init = ((ADC_HandleTypeDef *)sac->sac_adc_handle)->Init;
+
     return (OS_OK);
 }
 
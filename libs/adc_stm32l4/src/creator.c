@@ -20,6 +20,7 @@
 #include <stm32l4xx_hal.h>
 #include <stm32l4xx_hal_dma.h>
 #include <stm32l4xx_hal_adc.h>
+#include <stm32l4xx_hal_tim.h>
 #include <adc_stm32l4/adc_stm32l4.h>
 #include <console/console.h>
 
@@ -37,12 +38,44 @@
     .EOCSelection          = ADC_EOC_SEQ_CONV, \
 }
 
+/*****************ADC1 DMA Config ***************/
+//  ADC1 is mapped to DMA2 Channel 3, request 0.  Each conversion is transferred as a 32-bit word,
+//  matching the uint32_t sample buffers passed to adc_buf_set().
+#define STM32L4_DEFAULT_ADC1_DMA_HANDLE { \
+    .Instance = DMA2_Channel3, \
+    .Init = { \
+        .Request             = DMA_REQUEST_0, \
+        .Direction           = DMA_PERIPH_TO_MEMORY, \
+        .PeriphInc           = DMA_PINC_DISABLE, \
+        .MemInc              = DMA_MINC_ENABLE, \
+        .PeriphDataAlignment = DMA_PDATAALIGN_WORD, \
+        .MemDataAlignment    = DMA_MDATAALIGN_WORD, \
+        .Mode                = DMA_NORMAL,          /* Set to DMA_CIRCULAR by adc_buf_set() if the buffers are contiguous */ \
+        .Priority            = DMA_PRIORITY_HIGH, \
+    }, \
+}
+
+static DMA_HandleTypeDef adc1_dma_handle = STM32L4_DEFAULT_ADC1_DMA_HANDLE;
+
+/*****************ADC1 Trigger Timer Config ***************/
+//  TIM6 TRGO paces the DMA scan sequences (ADC_EXTERNALTRIG_T6_TRGO).  TIM6 is a basic timer with no pins.
+//  Prescaler and period are computed from the rate set by stm32l4_adc_set_trigger_rate().
+#define STM32L4_DEFAULT_ADC1_TRIGGER_TIMER { \
+    .Instance = TIM6, \
+    .Init = { \
+        .CounterMode   = TIM_COUNTERMODE_UP, \
+        .ClockDivision = TIM_CLOCKDIVISION_DIV1, \
+    }, \
+}
+
+static TIM_HandleTypeDef adc1_trigger_timer = STM32L4_DEFAULT_ADC1_TRIGGER_TIMER;
+
 /*****************ADC1 Config ***************/
 #define STM32L4_DEFAULT_ADC1_HANDLE { \
     .Init       = STM32L4_ADC_DEFAULT_INIT_TD, \
     .Instance   = ADC1, \
     /* TODO: .NbrOfCurrentConversionRank = 0, */ \
-    .DMA_Handle = NULL, /* TODO: &adc1_dma00_handle, */ \
+    .DMA_Handle = NULL,  /* Set to sac_dma_handle when DMA buffers are used */ \
     .Lock       = HAL_UNLOCKED, \
     .State      = 0, \
     .ErrorCode  = 0, \
@@ -60,6 +93,9 @@ static ADC_HandleTypeDef adc1_handle = STM32L4_DEFAULT_ADC1_HANDLE;
         {0},{0},{0},{0} \
     } ,\
     .sac_adc_handle = &adc1_handle,\
+    .sac_dma_handle = &adc1_dma_handle,\
+    .sac_trigger_timer = &adc1_trigger_timer,\
+    .sac_trigger_hz = 0,  /* No DMA conversions until the rate is set */ \
 }
 /*********************************************/
 
@@ -0,0 +1,117 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+//  Streaming ADC pipeline.  Samples one or more ADC channels via DMA double buffers at a timer-triggered rate,
+//  decimates each channel with a fixed-point filter and delivers the decimated blocks to sensor listeners as batches.
+//  Works with any ADC driver that supports DMA reads and a trigger rate, e.g. adc_stm32f1 and adc_stm32l4.
+#ifndef __ADC_STREAM_H__
+#define __ADC_STREAM_H__
+
+#include "os/mynewt.h"
+#include "sensor/sensor.h"
+#include "adc_stream/decimator.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ADC_STREAM_MAX_CHANNELS MYNEWT_VAL(ADC_STREAM_MAX_CHANNELS)  //  Max channels per scan sequence
+#define ADC_STREAM_BUF_SCANS    MYNEWT_VAL(ADC_STREAM_BUF_SCANS)     //  Max scan sequences per DMA buffer
+
+struct adc_dev;
+
+//  Configuration for an ADC stream
+struct adc_stream_cfg {
+    const char *dev_name;       //  Name of the stream's sensor device e.g. "adc_stream0"
+    const char *adc_dev_name;   //  Name of the ADC device e.g. "adc1"
+    void *adc_open_arg;         //  Passed to os_dev_open() when opening the ADC. For STM32: ADC_InitTypeDef with scan mode enabled
+                                //  and NbrOfConversion set to chan_count, if more than 1 channel.
+    uint8_t chan_count;         //  Number of channels in the scan sequence, 1 to ADC_STREAM_MAX_CHANNELS
+    const uint8_t *chans;       //  ADC channel numbers, in scan (rank) order
+    void * const *chan_cfgs;    //  Passed to adc_chan_config() for each channel. For STM32: ADC_ChannelConfTypeDef with the rank.
+    uint16_t scans_per_buf;     //  Number of scan sequences per DMA buffer, 1 to ADC_STREAM_BUF_SCANS. Sets the batch latency.
+    uint32_t scan_hz;           //  Scan sequences per second, triggered by the ADC driver's timer
+    int (*set_scan_rate)(struct adc_dev *adc, uint32_t hz);  //  ADC driver function that sets the trigger rate,
+                                //  e.g. stm32f1_adc_set_trigger_rate or stm32l4_adc_set_trigger_rate
+    uint8_t filter;             //  DECIMATOR_MOVING_AVERAGE or DECIMATOR_CIC
+    uint8_t filter_order;       //  Number of CIC stages
+    uint16_t decimation;        //  Decimation factor.  Output rate per channel = scan_hz / decimation.
+    sensor_type_t type;         //  Sensor type of the decimated values e.g. SENSOR_TYPE_VOLTAGE. Passed to listeners.
+};
+
+//  Batch of decimated values, passed as the sensor data to the listeners of the stream's sensor.  Values for channel c
+//  are at values[c * count] to values[c * count + count - 1], in the same units as the raw ADC samples.
+struct adc_stream_batch {
+    sensor_type_t type;         //  Sensor type from the stream config
+    uint8_t chan_count;         //  Number of channels
+    uint16_t count;             //  Number of decimated values per channel
+    const int32_t *values;      //  Decimated values, grouped by channel
+};
+
+//  State of an ADC stream.  The stream is a sensor device: listeners registered with sensor_register_listener()
+//  on the stream's sensor for the configured type receive each batch as a const struct adc_stream_batch *.
+struct adc_stream {
+    struct os_dev dev;                                      //  Sensor device, named dev_name.  Must be the first field.
+    struct sensor sensor;                                   //  Sensor that dispatches the batches to its listeners
+    struct adc_stream_cfg cfg;                              //  Stream configuration
+    struct adc_dev *adc;                                    //  ADC device, open while streaming
+    struct os_eventq *evq;                                  //  Event queue for processing completed DMA buffers
+    struct os_event ev;                                     //  Event posted by the ADC interrupt when a DMA buffer is complete
+    uint32_t *ready_buf;                                    //  DMA buffer most recently completed
+    uint16_t overruns;                                      //  Number of DMA buffers dropped because the previous one was still queued
+    struct decimator dec[ADC_STREAM_MAX_CHANNELS];          //  Decimation filter for each channel
+    uint32_t bufs[2 * ADC_STREAM_BUF_SCANS * ADC_STREAM_MAX_CHANNELS];  //  Primary and secondary DMA buffers, contiguous for circular DMA
+    int32_t out[ADC_STREAM_BUF_SCANS * ADC_STREAM_MAX_CHANNELS];       //  Decimated values for the batch
+    struct adc_stream_batch batch;                          //  Latest batch, returned by sensor_read()
+};
+
+/**
+ * Initialise the ADC stream and create its sensor device, registered with the Sensor Manager.  Does not open the ADC.
+ * Register listeners for the batches with sensor_register_listener(&stream->sensor, ...).
+ *
+ * @param stream The stream to be initialised
+ * @param cfg Stream configuration, copied into the stream
+ * @param evq Event queue for processing completed DMA buffers, e.g. os_eventq_dflt_get()
+ *
+ * @return 0 on success, and non-zero error code on failure
+ */
+int adc_stream_init(struct adc_stream *stream, const struct adc_stream_cfg *cfg, struct os_eventq *evq);
+
+/**
+ * Open and configure the ADC, and start sampling via DMA at scan_hz.  The ADC stays locked until adc_stream_stop().
+ *
+ * @param stream The stream
+ *
+ * @return 0 on success, and non-zero error code on failure
+ */
+int adc_stream_start(struct adc_stream *stream);
+
+/**
+ * Stop sampling and close the ADC.
+ *
+ * @param stream The stream
+ *
+ * @return 0 on success, and non-zero error code on failure
+ */
+int adc_stream_stop(struct adc_stream *stream);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  //  __ADC_STREAM_H__
@@ -0,0 +1,87 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+//  Fixed-point decimation filters for streaming ADC samples: moving average and CIC (Cascaded Integrator-Comb).
+//  This file has no Mynewt dependencies, so the filters may be tested on the host with synthetic signals.
+#ifndef __ADC_STREAM_DECIMATOR_H__
+#define __ADC_STREAM_DECIMATOR_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DECIMATOR_MAX_ORDER 4  //  Max number of CIC integrator / comb stages
+
+//  Decimation filter types
+#define DECIMATOR_MOVING_AVERAGE 0  //  Average each block of `factor` samples.  Cheapest, one add per sample.
+#define DECIMATOR_CIC            1  //  CIC filter with `order` stages.  Better alias rejection, `order` adds per sample.
+
+//  State of a decimation filter for one channel.  All arithmetic is done in unsigned 32-bit integers, which wrap
+//  around safely: the CIC output is exact as long as the gain (factor ^ order) times the input range fits in 32 bits.
+struct decimator {
+    uint8_t  kind;       //  DECIMATOR_MOVING_AVERAGE or DECIMATOR_CIC
+    uint8_t  order;      //  Number of CIC stages.  1 for moving average.
+    uint8_t  shift;      //  If gain is a power of 2: log2(gain), so we normalise with a shift.  Else 0xff.
+    uint16_t factor;     //  Decimation factor: Number of input samples per output sample
+    uint16_t phase;      //  Number of input samples since the last output sample
+    uint32_t gain;       //  Filter gain, i.e. factor ^ order
+    uint32_t integ[DECIMATOR_MAX_ORDER];  //  Integrator stages, running at input rate
+    uint32_t comb[DECIMATOR_MAX_ORDER];   //  Previous comb inputs, running at output rate
+};
+
+/**
+ * Initialise the decimation filter.
+ *
+ * @param d The decimator to be initialised
+ * @param kind DECIMATOR_MOVING_AVERAGE or DECIMATOR_CIC
+ * @param order Number of CIC stages, 1 to DECIMATOR_MAX_ORDER. Ignored for moving average.
+ * @param factor Decimation factor, 1 or more
+ *
+ * @return 0 on success, -1 if the parameters are invalid or the gain would overflow 20 bits
+ */
+int decimator_init(struct decimator *d, uint8_t kind, uint8_t order, uint16_t factor);
+
+/**
+ * Reset the filter state, keeping the parameters.
+ *
+ * @param d The decimator
+ */
+void decimator_reset(struct decimator *d);
+
+/**
+ * Feed input samples to the decimation filter and write the normalised output samples.
+ * Filter state is kept between calls, so a stream may be fed in blocks of any size.
+ *
+ * @param d The decimator
+ * @param in Input samples, e.g. 12-bit ADC values
+ * @param in_len Number of input samples to process
+ * @param in_stride Distance between successive input samples, e.g. number of channels in an interleaved ADC scan buffer
+ * @param out Output buffer for the decimated samples, in the same units as the input
+ * @param out_max Size of the output buffer.  Processing stops when the buffer is full.
+ *
+ * @return Number of output samples written
+ */
+int decimator_process(struct decimator *d, const uint32_t *in, int in_len, int in_stride, int32_t *out, int out_max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  //  __ADC_STREAM_DECIMATOR_H__
@@ -0,0 +1,215 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+//  Streaming ADC pipeline.  Samples one or more ADC channels via DMA double buffers at a timer-triggered rate,
+//  decimates each channel with a fixed-point filter and delivers the decimated blocks to sensor listeners as batches.
+//
+//  The two DMA buffers are contiguous, so the ADC driver may fill them with circular DMA.  When each buffer is
+//  full, the driver calls adc_stream_event() in interrupt context.  We post an event to the stream's event queue,
+//  which decimates the completed buffer while DMA fills the other buffer.  So each batch must be processed within
+//  one buffer period (scans_per_buf / scan_hz), else the buffer is overwritten and counted as an overrun.
+//
+//  The stream is a sensor device.  Each batch is dispatched by sensor_read(), which calls the listeners registered
+//  on the stream's sensor through the Sensor Framework, once per batch.
+#include <assert.h>
+#include <string.h>
+#include "os/mynewt.h"
+#include "adc/adc.h"
+#include "adc_stream/adc_stream.h"
+
+static int adc_stream_dev_init(struct os_dev *dev0, void *arg);
+static int adc_stream_event(struct adc_dev *adc, void *arg, adc_event_type_t type, void *buf, int buf_len);
+static void adc_stream_process(struct os_event *ev);
+static int adc_stream_sensor_read(struct sensor *sensor, sensor_type_t type,
+    sensor_data_func_t data_func, void *data_arg, uint32_t timeout);
+static int adc_stream_sensor_get_config(struct sensor *sensor, sensor_type_t type,
+    struct sensor_cfg *cfg);
+
+//  Sensor driver for the stream: a read returns the latest batch.
+static const struct sensor_driver g_adc_stream_sensor_driver = {
+    adc_stream_sensor_read,
+    adc_stream_sensor_get_config
+};
+
+int adc_stream_init(struct adc_stream *stream, const struct adc_stream_cfg *cfg, struct os_eventq *evq) {
+    //  Initialise the ADC stream.  Return 0 if successful.
+    int rc, c;
+    assert(stream);  assert(cfg);  assert(evq);
+    if (cfg->chan_count == 0 || cfg->chan_count > ADC_STREAM_MAX_CHANNELS) { return SYS_EINVAL; }
+    if (cfg->scans_per_buf == 0 || cfg->scans_per_buf > ADC_STREAM_BUF_SCANS) { return SYS_EINVAL; }
+    if (!cfg->dev_name || !cfg->adc_dev_name || !cfg->chans || !cfg->chan_cfgs) { return SYS_EINVAL; }
+    if (cfg->scan_hz == 0 || !cfg->set_scan_rate) { return SYS_EINVAL; }
+
+    memset(stream, 0, sizeof(*stream));
+    stream->cfg = *cfg;
+    stream->evq = evq;
+    stream->ev.ev_cb  = adc_stream_process;
+    stream->ev.ev_arg = stream;
+
+    //  Each channel gets its own decimation filter.
+    for (c = 0; c < cfg->chan_count; c++) {
+        rc = decimator_init(&stream->dec[c], cfg->filter, cfg->filter_order, cfg->decimation);
+        if (rc) { return SYS_EINVAL; }
+    }
+
+    //  Create the sensor device.  adc_stream_dev_init() is called immediately because the OS has started.
+    rc = os_dev_create((struct os_dev *) stream, cfg->dev_name,
+        OS_DEV_INIT_PRIMARY, 0, adc_stream_dev_init, (void *) stream);
+    return rc;
+}
+
+static int adc_stream_dev_init(struct os_dev *dev0, void *arg) {
+    //  Init the stream's sensor and register it with the Sensor Manager.  Return 0 if successful.
+    struct adc_stream *stream = (struct adc_stream *) dev0;
+    int rc;
+    assert(stream);
+    rc = sensor_init(&stream->sensor, dev0);
+    if (rc) { return rc; }
+
+    //  The sensor returns batches of the configured type.
+    rc = sensor_set_driver(&stream->sensor, stream->cfg.type,
+        (struct sensor_driver *) &g_adc_stream_sensor_driver);
+    if (rc) { return rc; }
+    rc = sensor_set_type_mask(&stream->sensor, stream->cfg.type);
+    if (rc) { return rc; }
+
+    //  Register with the Sensor Manager, so that the stream can be found by name.
+    rc = sensor_mgr_register(&stream->sensor);
+    return rc;
+}
+
+int adc_stream_start(struct adc_stream *stream) {
+    //  Open and configure the ADC, and start sampling continuously via DMA.  Return 0 if successful.
+    const struct adc_stream_cfg *cfg;
+    int rc, c, buf_len;
+    assert(stream);
+    cfg = &stream->cfg;
+    if (stream->adc) { return 0; }  //  Already streaming.
+
+    //  Open and lock the ADC.  adc_open_arg enables scan mode for multiple channels.
+    stream->adc = (struct adc_dev *) os_dev_open(cfg->adc_dev_name, OS_TIMEOUT_NEVER, cfg->adc_open_arg);
+    if (!stream->adc) { return SYS_ENODEV; }
+
+    //  Configure each channel in the scan sequence.
+    for (c = 0; c < cfg->chan_count; c++) {
+        rc = adc_chan_config(stream->adc, cfg->chans[c], cfg->chan_cfgs[c]);
+        if (rc) { goto err; }
+        decimator_reset(&stream->dec[c]);
+    }
+
+    //  DMA buffers hold scans_per_buf scan sequences, with the channels interleaved in rank order.  The secondary
+    //  buffer follows the primary buffer, so that the ADC driver may run circular DMA over both.
+    buf_len = adc_buf_size(stream->adc, cfg->chan_count, cfg->scans_per_buf);
+    assert(2 * buf_len <= (int) sizeof(stream->bufs));
+    rc = adc_event_handler_set(stream->adc, adc_stream_event, stream);
+    if (rc) { goto err; }
+    rc = adc_buf_set(stream->adc, stream->bufs, (uint8_t *) stream->bufs + buf_len, buf_len);
+    if (rc) { goto err; }
+
+    //  Each scan sequence is triggered by the ADC driver's timer.
+    rc = cfg->set_scan_rate(stream->adc, cfg->scan_hz);
+    if (rc) { goto err; }
+
+    //  Start the conversions.  The ADC driver fills the buffers in turn.
+    rc = adc_sample(stream->adc);
+    if (rc) { goto err; }
+    return 0;
+err:
+    os_dev_close((struct os_dev *) stream->adc);
+    stream->adc = NULL;
+    return rc;
+}
+
+int adc_stream_stop(struct adc_stream *stream) {
+    //  Stop sampling and close the ADC.  Return 0 if successful.
+    assert(stream);
+    if (!stream->adc) { return 0; }
+    adc_buf_release(stream->adc, stream->bufs, sizeof(stream->bufs));
+    os_eventq_remove(stream->evq, &stream->ev);
+    os_dev_close((struct os_dev *) stream->adc);
+    stream->adc = NULL;
+    return 0;
+}
+
+static int adc_stream_event(struct adc_dev *adc, void *arg, adc_event_type_t type, void *buf, int buf_len) {
+    //  Called by the ADC driver in interrupt context when a DMA buffer is full.  Defer the filtering to the event queue.
+    struct adc_stream *stream = (struct adc_stream *) arg;
+    if (type != ADC_EVENT_RESULT) { return 0; }
+    assert(stream);
+    if (stream->ev.ev_queued) { stream->overruns++; }  //  Previous buffer not processed yet.  It will be skipped.
+    stream->ready_buf = (uint32_t *) buf;
+    os_eventq_put(stream->evq, &stream->ev);
+    return 0;
+}
+
+static void adc_stream_process(struct os_event *ev) {
+    //  Decimate the completed DMA buffer and deliver the batch to the sensor listeners.
+    struct adc_stream *stream = (struct adc_stream *) ev->ev_arg;
+    const struct adc_stream_cfg *cfg;
+    const uint32_t *buf;
+    int c, n, count = 0;
+    assert(stream);
+    cfg = &stream->cfg;
+    buf = stream->ready_buf;
+    if (!buf) { return; }
+
+    //  Each channel has the same decimation phase, so every channel produces the same number of values.
+    const int max_per_chan = ADC_STREAM_BUF_SCANS;
+    for (c = 0; c < cfg->chan_count; c++) {
+        n = decimator_process(&stream->dec[c], buf + c, cfg->scans_per_buf, cfg->chan_count,
+            &stream->out[c * max_per_chan], max_per_chan);
+        assert(c == 0 || n == count);
+        count = n;
+    }
+    if (count == 0) { return; }  //  Not enough samples for a decimated value yet.
+
+    //  Pack the values for each channel together so that listeners see values[c * count + i].
+    for (c = 1; c < cfg->chan_count; c++) {
+        memmove(&stream->out[c * count], &stream->out[c * max_per_chan], count * sizeof(int32_t));
+    }
+    stream->batch.type       = cfg->type;
+    stream->batch.chan_count = cfg->chan_count;
+    stream->batch.count      = count;
+    stream->batch.values     = stream->out;
+
+    //  Dispatch the batch to the sensor listeners: one call per listener for the whole batch.
+    sensor_read(&stream->sensor, cfg->type, NULL, NULL, 0);
+}
+
+static int adc_stream_sensor_read(struct sensor *sensor, sensor_type_t type,
+    sensor_data_func_t data_func, void *data_arg, uint32_t timeout) {
+    //  Return the latest batch to the Sensor Framework, which passes it to the listeners and data_func.
+    //  Return SYS_EAGAIN if no batch has been decimated yet.
+    struct adc_stream *stream;
+    assert(sensor);
+    stream = (struct adc_stream *) SENSOR_GET_DEVICE(sensor);
+    if (!(type & stream->cfg.type)) { return SYS_EINVAL; }
+    if (stream->batch.count == 0) { return SYS_EAGAIN; }
+    return data_func(sensor, data_arg, (void *) &stream->batch, stream->cfg.type);
+}
+
+static int adc_stream_sensor_get_config(struct sensor *sensor, sensor_type_t type,
+    struct sensor_cfg *cfg) {
+    //  Batches are opaque to the Sensor Framework.
+    struct adc_stream *stream;
+    assert(sensor);
+    stream = (struct adc_stream *) SENSOR_GET_DEVICE(sensor);
+    if (!(type & stream->cfg.type)) { return SYS_EINVAL; }
+    cfg->sc_valtype = SENSOR_VALUE_TYPE_OPAQUE;
+    return 0;
+}
@@ -0,0 +1,106 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+//  Fixed-point decimation filters for streaming ADC samples: moving average and CIC (Cascaded Integrator-Comb).
+//  No Mynewt dependencies, so this file may be compiled on the host for testing.
+#include <string.h>
+#include "adc_stream/decimator.h"
+
+#define MAX_GAIN (1ul << 20)  //  Max gain, so that 12-bit samples times gain still fit in 32 bits
+
+int decimator_init(struct decimator *d, uint8_t kind, uint8_t order, uint16_t factor) {
+    //  Initialise the decimation filter.  Return 0 if successful.
+    uint32_t gain = 1;
+    int i;
+    if (!d || factor == 0) { return -1; }
+    if (kind == DECIMATOR_MOVING_AVERAGE) { order = 1; }
+    else if (kind != DECIMATOR_CIC || order == 0 || order > DECIMATOR_MAX_ORDER) { return -1; }
+
+    //  Gain of a CIC filter with differential delay 1 is factor ^ order.
+    for (i = 0; i < order; i++) {
+        gain *= factor;
+        if (gain > MAX_GAIN) { return -1; }
+    }
+    memset(d, 0, sizeof(*d));
+    d->kind   = kind;
+    d->order  = order;
+    d->factor = factor;
+    d->gain   = gain;
+
+    //  If gain is a power of 2, normalise with a shift instead of a division.
+    d->shift = 0xff;
+    for (i = 0; i < 32; i++) {
+        if (gain == (1ul << i)) { d->shift = i; break; }
+    }
+    return 0;
+}
+
+void decimator_reset(struct decimator *d) {
+    //  Reset the filter state, keeping the parameters.
+    d->phase = 0;
+    memset(d->integ, 0, sizeof(d->integ));
+    memset(d->comb,  0, sizeof(d->comb));
+}
+
+static int32_t normalise(const struct decimator *d, uint32_t sum) {
+    //  Divide the filter output by the gain, rounded to nearest.
+    if (d->shift != 0xff) {
+        if (d->shift == 0) { return (int32_t) sum; }
+        return (int32_t) ((sum + (1ul << (d->shift - 1))) >> d->shift);
+    }
+    return (int32_t) ((sum + d->gain / 2) / d->gain);
+}
+
+int decimator_process(struct decimator *d, const uint32_t *in, int in_len, int in_stride, int32_t *out, int out_max) {
+    //  Feed input samples to the decimation filter and write the normalised output samples.  Return the number of output samples.
+    int i, s, n = 0;
+    const uint8_t order = d->order;
+    if (in_stride < 1) { in_stride = 1; }
+
+    if (d->kind == DECIMATOR_MOVING_AVERAGE) {
+        //  Moving average: Accumulate `factor` samples, then output the average and restart.
+        uint32_t acc = d->integ[0];
+        for (i = 0; i < in_len && n < out_max; i++, in += in_stride) {
+            acc += *in;
+            if (++d->phase < d->factor) { continue; }
+            d->phase = 0;
+            out[n++] = normalise(d, acc);
+            acc = 0;
+        }
+        d->integ[0] = acc;
+        return n;
+    }
+
+    //  CIC: Integrators run at input rate.  Combs run at output rate, on every `factor` input samples.
+    for (i = 0; i < in_len && n < out_max; i++, in += in_stride) {
+        uint32_t x = *in;
+        for (s = 0; s < order; s++) {
+            d->integ[s] += x;
+            x = d->integ[s];
+        }
+        if (++d->phase < d->factor) { continue; }
+        d->phase = 0;
+        for (s = 0; s < order; s++) {
+            uint32_t y = x - d->comb[s];  //  Wraparound is fine: the final result fits in 32 bits.
+            d->comb[s] = x;
+            x = y;
+        }
+        out[n++] = normalise(d, x);
+    }
+    return n;
+}
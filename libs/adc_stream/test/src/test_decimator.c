@@ -0,0 +1,106 @@
+//  Test the ADC stream decimation filters with synthetic signals.  Runs on the device or on the host:
+//  gcc -DTEST_HOST -Iinclude -o test_decimator src/decimator.c test/src/test_decimator.c -lm && ./test_decimator
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "adc_stream/decimator.h"
+
+#define NUM_SAMPLES 1024
+static uint32_t in[NUM_SAMPLES];
+static int32_t out[NUM_SAMPLES];
+
+static void test_dc(uint8_t kind, uint8_t order, uint16_t factor) {
+    //  Constant input must produce the same constant output once the filter has settled.
+    struct decimator d;
+    int i, n;
+    for (i = 0; i < NUM_SAMPLES; i++) { in[i] = 4095; }
+    assert(decimator_init(&d, kind, order, factor) == 0);
+    n = decimator_process(&d, in, NUM_SAMPLES, 1, out, NUM_SAMPLES);
+    assert(n == NUM_SAMPLES / factor);
+    for (i = order; i < n; i++) { assert(out[i] == 4095); }
+}
+
+static void test_blocks(uint8_t kind, uint8_t order, uint16_t factor) {
+    //  Feeding the stream in odd-sized blocks must give the same output as one big block.
+    static int32_t out2[NUM_SAMPLES];
+    struct decimator d1, d2;
+    int i, n1, n2 = 0;
+    for (i = 0; i < NUM_SAMPLES; i++) { in[i] = (i * 37) % 4096; }
+    assert(decimator_init(&d1, kind, order, factor) == 0);
+    assert(decimator_init(&d2, kind, order, factor) == 0);
+    n1 = decimator_process(&d1, in, NUM_SAMPLES, 1, out, NUM_SAMPLES);
+    for (i = 0; i < NUM_SAMPLES; i += 7) {
+        int len = (NUM_SAMPLES - i < 7) ? NUM_SAMPLES - i : 7;
+        n2 += decimator_process(&d2, in + i, len, 1, out2 + n2, NUM_SAMPLES - n2);
+    }
+    assert(n1 == n2);
+    assert(memcmp(out, out2, n1 * sizeof(int32_t)) == 0);
+}
+
+static void test_stride(void) {
+    //  Interleaved scan buffer with 2 channels: each channel is decimated separately.
+    struct decimator d0, d1;
+    int i, n;
+    for (i = 0; i < NUM_SAMPLES; i += 2) { in[i] = 100; in[i + 1] = 3000; }
+    assert(decimator_init(&d0, DECIMATOR_CIC, 2, 8) == 0);
+    assert(decimator_init(&d1, DECIMATOR_CIC, 2, 8) == 0);
+    n = decimator_process(&d0, in, NUM_SAMPLES / 2, 2, out, NUM_SAMPLES);
+    assert(n == NUM_SAMPLES / 16);
+    assert(out[n - 1] == 100);
+    n = decimator_process(&d1, in + 1, NUM_SAMPLES / 2, 2, out, NUM_SAMPLES);
+    assert(out[n - 1] == 3000);
+}
+
+static double ripple(uint8_t kind, uint8_t order, uint16_t factor, double cycles_per_sample) {
+    //  Return the peak-to-peak output for a full-scale sine wave around mid-scale.
+    struct decimator d;
+    int i, n, lo = 4095, hi = 0;
+    for (i = 0; i < NUM_SAMPLES; i++) {
+        in[i] = (uint32_t) (2048 + 2047 * sin(2 * M_PI * cycles_per_sample * i));
+    }
+    assert(decimator_init(&d, kind, order, factor) == 0);
+    n = decimator_process(&d, in, NUM_SAMPLES, 1, out, NUM_SAMPLES);
+    for (i = order; i < n; i++) {
+        if (out[i] < lo) { lo = out[i]; }
+        if (out[i] > hi) { hi = out[i]; }
+    }
+    return hi - lo;
+}
+
+static void test_attenuation(void) {
+    //  A tone at 0.3 of the input rate aliases after decimation by 8.  CIC with more stages must reject it better.
+    double ma   = ripple(DECIMATOR_MOVING_AVERAGE, 1, 8, 0.3);
+    double cic3 = ripple(DECIMATOR_CIC, 3, 8, 0.3);
+    printf("ripple at 0.3 fs: moving average %.0f, cic3 %.0f (input 4094)\n", ma, cic3);
+    assert(ma < 4094 / 4);
+    assert(cic3 < ma);
+    //  A slow tone must pass through almost unchanged.
+    assert(ripple(DECIMATOR_CIC, 3, 8, 0.001) > 3900);
+}
+
+static void test_invalid(void) {
+    struct decimator d;
+    assert(decimator_init(&d, DECIMATOR_CIC, 0, 8) != 0);   //  No stages
+    assert(decimator_init(&d, DECIMATOR_CIC, 5, 8) != 0);   //  Too many stages
+    assert(decimator_init(&d, DECIMATOR_CIC, 4, 64) != 0);  //  Gain 2^24 overflows
+    assert(decimator_init(&d, DECIMATOR_MOVING_AVERAGE, 0, 0) != 0);  //  No decimation factor
+}
+
+int test_decimator(void) {
+    test_dc(DECIMATOR_MOVING_AVERAGE, 1, 16);
+    test_dc(DECIMATOR_MOVING_AVERAGE, 1, 10);  //  Not a power of 2: normalised by division
+    test_dc(DECIMATOR_CIC, 3, 16);
+    test_dc(DECIMATOR_CIC, 2, 10);
+    test_blocks(DECIMATOR_MOVING_AVERAGE, 1, 16);
+    test_blocks(DECIMATOR_CIC, 4, 8);
+    test_stride();
+    test_attenuation();
+    test_invalid();
+    printf("decimator tests OK\n");
+    return 0;
+}
+
+#ifdef TEST_HOST
+int main(void) { return test_decimator(); }
+#endif  //  TEST_HOST
@@ -0,0 +1,100 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+//  Mynewt Sensor Driver for the Bosch BMA421 accelerometer on PineTime, connected to I2C port 1.
+//  The accelerometer samples into its FIFO while the CPU sleeps.  At the watermark, the BMA421 interrupts on INT1
+//  and the driver reads the whole batch in one I2C transaction.  Returns SENSOR_TYPE_ACCELEROMETER (one value per
+//  sample) and SENSOR_TYPE_ACTIVITY (step count and wrist tilt).
+#ifndef __BMA421_H__
+#define __BMA421_H__
+
+#include "os/mynewt.h"
+#include "sensor/sensor.h"
+#include "i2c_queue/i2c_queue.h"
+#include "custom_sensor/custom_sensor.h"  //  For SENSOR_TYPE_ACTIVITY
+#include "bma421/bma421_core.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//  Max number of samples read in one batch, and max FIFO watermark.  Samples beyond the batch stay in the FIFO.
+#define BMA421_MAX_BATCH  32
+
+//  Configuration for the BMA421
+struct bma421_cfg {
+    sensor_type_t bc_s_mask;      //  Sensor data types that will be returned: accelerometer and activity
+    struct bma421_core_cfg core;  //  Data rate, range, features and FIFO watermark
+    int int_pin;                  //  GPIO pin for INT1, or -1 to poll the FIFO without interrupts
+};
+
+//  Device for the BMA421
+struct bma421 {
+    struct os_dev dev;        //  Mynewt device
+    struct sensor sensor;     //  Mynewt sensor
+    struct bma421_cfg cfg;    //  Sensor configuration
+    struct bma421_bus bus;    //  Register access through the I2C queue
+    struct i2c_txn txn;       //  I2C transaction for register access
+    uint8_t reg;              //  Register number to be written before reading
+    uint8_t write_buf[1 + BMA421_WRITE_MAX];  //  Register number and bytes to be written
+    uint8_t fifo_buf[BMA421_MAX_BATCH * BMA421_FIFO_FRAME_SIZE];  //  FIFO frames read in one batch
+    struct bma421_sample samples[BMA421_MAX_BATCH];               //  Samples decoded from the FIFO frames
+    uint32_t last_steps;      //  Step count at the last report
+    uint8_t interrupted;      //  1 while reading after an interrupt: report activity only when changed
+};
+
+/**
+ * Create the BMA421 instance.  Implemented in creator.c, function DEVICE_CREATE().
+ */
+void bma421_create(void);
+
+/**
+ * Return the default configuration for the BMA421, from syscfg.yml.
+ *
+ * @param cfg  Pointer to the bma421_cfg device config
+ *
+ * @return 0 on success, and non-zero error code on failure
+ */
+int bma421_default_cfg(struct bma421_cfg *cfg);
+
+/**
+ * Initialize the BMA421 driver.  The BMA421 is configured by bma421_config().
+ *
+ * @param dev  Pointer to the bma421 device descriptor
+ * @param arg  Pointer to the sensor_itf: I2C port and address
+ *
+ * @return 0 on success, and non-zero error code on failure
+ */
+int bma421_init(struct os_dev *dev, void *arg);
+
+/**
+ * Reset and configure the BMA421: load the config file, enable the features and the FIFO,
+ * then start monitoring INT1.
+ *
+ * @param Sensor device bma421 structure
+ * @param Sensor device bma421_cfg config
+ *
+ * @return 0 on success, and non-zero error code on failure
+ */
+int bma421_config(struct bma421 *dev, struct bma421_cfg *cfg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BMA421_H__ */
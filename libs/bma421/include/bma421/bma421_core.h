@@ -0,0 +1,172 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+//  Core of the BMA421 accelerometer driver: register map, initialisation, FIFO batches and step counter.
+//  Registers are accessed through struct bma421_bus, so the core may be tested on the host against
+//  a simulated register model.  This file has no Mynewt dependencies.
+#ifndef __BMA421_CORE_H__
+#define __BMA421_CORE_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//  Registers, from the BMA421 datasheet and the Bosch BMA421 Sensor API
+#define BMA421_REG_CHIP_ID          0x00  //  Chip ID, BMA421_CHIP_ID
+#define BMA421_REG_ERR              0x02  //  Error flags
+#define BMA421_REG_DATA_8           0x12  //  Acceleration X, Y, Z: 6 bytes, little endian, 12 bits left justified
+#define BMA421_REG_INT_STATUS_0     0x1C  //  Feature interrupts: BMA421_INT_STEP_COUNTER, BMA421_INT_WRIST_TILT
+#define BMA421_REG_INT_STATUS_1     0x1D  //  Hardware interrupts: BMA421_INT_FIFO_WM, ...
+#define BMA421_REG_STEP_COUNTER_0   0x1E  //  Step count: 4 bytes, little endian
+#define BMA421_REG_FIFO_LENGTH_0    0x24  //  Number of bytes in the FIFO: 2 bytes, little endian, 14 bits
+#define BMA421_REG_FIFO_DATA        0x26  //  FIFO data.  Reading doesn't advance the register address.
+#define BMA421_REG_INTERNAL_STATUS  0x2A  //  Result of loading the config file: 0x01 if OK
+#define BMA421_REG_ACC_CONF         0x40  //  Output data rate, bandwidth and performance mode
+#define BMA421_REG_ACC_RANGE        0x41  //  Range: 2, 4, 8 or 16 g
+#define BMA421_REG_FIFO_WTM_0       0x46  //  FIFO watermark in bytes: 2 bytes, little endian, 13 bits
+#define BMA421_REG_FIFO_CONFIG_0    0x48  //  FIFO mode: stream or stop on full
+#define BMA421_REG_FIFO_CONFIG_1    0x49  //  FIFO contents: accelerometer, headers
+#define BMA421_REG_INT1_IO_CTRL     0x53  //  INT1 pin: output enable, active level, push-pull
+#define BMA421_REG_INT_LATCH        0x55  //  Latch the interrupts
+#define BMA421_REG_INT1_MAP         0x56  //  Map the feature interrupts to INT1
+#define BMA421_REG_INT_MAP_DATA     0x58  //  Map the FIFO interrupts to INT1 and INT2
+#define BMA421_REG_INIT_CTRL        0x59  //  Start (0) and end (1) loading the config file
+#define BMA421_REG_ASIC_LSB         0x5B  //  Address for loading the config file, in words: bits 3:0 here, bits 11:4 in 0x5C
+#define BMA421_REG_FEATURES_IN      0x5E  //  Config file upload, and feature settings once loaded
+#define BMA421_REG_PWR_CONF         0x7C  //  Advanced power save
+#define BMA421_REG_PWR_CTRL         0x7D  //  Enable the accelerometer
+#define BMA421_REG_CMD              0x7E  //  Commands: BMA421_CMD_SOFT_RESET, BMA421_CMD_FIFO_FLUSH
+
+#define BMA421_CHIP_ID              0x11
+#define BMA421_CMD_SOFT_RESET       0xB6
+#define BMA421_CMD_FIFO_FLUSH       0xB0
+
+//  Interrupt status bits.  Feature interrupts are in INT_STATUS_0 and INT1_MAP.
+#define BMA421_INT_STEP_COUNTER     0x02
+#define BMA421_INT_WRIST_TILT       0x08
+//  FIFO interrupts are in INT_STATUS_1 and INT_MAP_DATA (for INT1).
+#define BMA421_INT_FIFO_FULL        0x01
+#define BMA421_INT_FIFO_WM          0x02
+
+//  Feature settings in FEATURES_IN once the config file is loaded
+#define BMA421_FEATURE_SIZE         70    //  Bytes of feature settings
+#define BMA421_FEATURE_STEP_CNTR    0x3B  //  Step counter settings, byte with the enable bit
+#define BMA421_FEATURE_STEP_CNTR_EN 0x10
+#define BMA421_FEATURE_WRIST_TILT   0x40  //  Wrist tilt settings, byte with the enable bit
+#define BMA421_FEATURE_WRIST_TILT_EN 0x01
+
+//  FIFO
+#define BMA421_FIFO_SIZE            1024  //  Bytes in the FIFO
+#define BMA421_FIFO_FRAME_SIZE      6     //  Bytes per frame without headers: X, Y, Z
+#define BMA421_CONFIG_CHUNK_SIZE    32    //  Bytes of config file per I2C write.  Must be even.
+#define BMA421_WRITE_MAX            BMA421_FEATURE_SIZE  //  Max bytes per I2C write
+
+//  Features to be enabled in bma421_core_cfg
+#define BMA421_FEATURE_STEPS        0x01  //  Step counter
+#define BMA421_FEATURE_TILT         0x02  //  Wrist tilt
+
+//  Register access for the core.  Each function returns 0 if successful.
+struct bma421_bus {
+    //  Read len bytes starting at register reg, in one I2C transaction
+    int (*read)(void *arg, uint8_t reg, uint8_t *buf, uint16_t len);
+    //  Write len bytes starting at register reg, in one I2C transaction.  len is at most BMA421_WRITE_MAX.
+    int (*write)(void *arg, uint8_t reg, const uint8_t *buf, uint16_t len);
+    //  Wait for the number of milliseconds
+    void (*delay_ms)(void *arg, uint32_t ms);
+    void *arg;
+};
+
+//  Configuration for the core
+struct bma421_core_cfg {
+    uint16_t odr_hz;             //  Output data rate: 12 (12.5), 25, 50, 100 or 200 Hz
+    uint8_t  range_g;            //  Range: 2, 4, 8 or 16 g
+    uint8_t  features;           //  BMA421_FEATURE_STEPS and BMA421_FEATURE_TILT.  Require the config file.
+    uint16_t watermark_frames;   //  Interrupt on INT1 when the FIFO has this many samples.  0 for no FIFO interrupt.
+    const uint8_t *config_file;  //  Config file from the Bosch BMA421 Sensor API, or NULL to run without features
+    uint16_t config_file_len;    //  Bytes in the config file
+};
+
+//  One acceleration sample, in raw units.  bma421_core_lsb_per_g() returns the units per g.
+struct bma421_sample {
+    int16_t x, y, z;
+};
+
+//  Interrupt status, step count and FIFO length, read in one I2C transaction
+struct bma421_status {
+    uint8_t  int_status_0;  //  Feature interrupts since the last read
+    uint8_t  int_status_1;  //  FIFO interrupts since the last read
+    uint32_t steps;         //  Step count
+    uint16_t fifo_len;      //  Bytes in the FIFO
+};
+
+/**
+ * Reset and configure the BMA421: load the config file and enable the features, set the data rate and range,
+ * stream the samples into the FIFO without headers and interrupt on INT1 at the watermark.
+ *
+ * @return 0 on success, BMA421_ENODEV if the chip ID doesn't match, BMA421_EIO if the config file
+ *         failed to load, BMA421_EINVAL if the configuration is invalid, else the bus error
+ */
+int bma421_core_init(const struct bma421_bus *bus, const struct bma421_core_cfg *cfg);
+
+/**
+ * Read the interrupt status, step count and FIFO length in one I2C transaction.  Clears the interrupt status.
+ */
+int bma421_core_read_status(const struct bma421_bus *bus, struct bma421_status *status);
+
+/**
+ * Read the FIFO length in one I2C transaction, without clearing the interrupt status.
+ */
+int bma421_core_read_fifo_len(const struct bma421_bus *bus, uint16_t *fifo_len);
+
+/**
+ * Read the complete frames of the FIFO in one I2C transaction and decode them.
+ *
+ * @param fifo_len Bytes in the FIFO, from bma421_core_read_status() or bma421_core_read_fifo_len()
+ * @param buf Buffer for the FIFO data
+ * @param buf_len Size of the buffer.  Frames that don't fit are left in the FIFO.
+ * @param samples Decoded samples
+ * @param max_samples Max number of samples
+ *
+ * @return Number of samples, or negative error
+ */
+int bma421_core_read_fifo(const struct bma421_bus *bus, uint16_t fifo_len, uint8_t *buf, uint16_t buf_len,
+    struct bma421_sample *samples, uint16_t max_samples);
+
+/**
+ * Decode the FIFO frames (without headers) into samples.  Incomplete frames and empty frames
+ * (read past the end of the FIFO) are skipped.  Return the number of samples.
+ */
+int bma421_core_decode_fifo(const uint8_t *buf, uint16_t len, struct bma421_sample *samples, uint16_t max_samples);
+
+/**
+ * Return the raw units per g for the range: 1024 for 2 g, 512 for 4 g, ...
+ */
+int bma421_core_lsb_per_g(uint8_t range_g);
+
+//  Errors returned by the core, matching the Mynewt SYS_E* values
+#define BMA421_EINVAL   (-2)
+#define BMA421_EIO      (-5)
+#define BMA421_ENODEV   (-9)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  //  __BMA421_CORE_H__
@@ -0,0 +1,301 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+//  Mynewt Sensor Driver for the BMA421: sensor API, I2C access through the I2C queue and INT1 handling.
+//  The register sequences are in bma421_core.c.
+#include <string.h>
+#include "os/mynewt.h"
+#include "hal/hal_gpio.h"
+#include "console/console.h"
+#include "sensor/sensor.h"
+#include "sensor/accel.h"
+#include "bma421/bma421.h"
+
+#define BMA421_SENSOR_TYPES (SENSOR_TYPE_ACCELEROMETER | SENSOR_TYPE_ACTIVITY)
+
+#if MYNEWT_VAL(BMA421_CONFIG_FILE)
+//  Config file for the step counter and wrist tilt, from the Bosch BMA421 Sensor API.  Provided by the app.
+extern const uint8_t bma421_config_file[];
+extern const uint16_t bma421_config_file_len;
+#endif  //  MYNEWT_VAL(BMA421_CONFIG_FILE)
+
+//  Exports for the sensor API
+static int bma421_sensor_read(struct sensor *, sensor_type_t, sensor_data_func_t, void *, uint32_t);
+static int bma421_sensor_get_config(struct sensor *, sensor_type_t, struct sensor_cfg *);
+static int bma421_sensor_handle_interrupt(struct sensor *);
+
+//  Global instance of the sensor driver
+static const struct sensor_driver g_bma421_sensor_driver = {
+    .sd_read             = bma421_sensor_read,
+    .sd_get_config       = bma421_sensor_get_config,
+    .sd_handle_interrupt = bma421_sensor_handle_interrupt,
+};
+
+///////////////////////////////////////////////////////////////////////////////
+//  Register Access through the I2C Queue
+
+static int bus_read(void *arg, uint8_t reg, uint8_t *buf, uint16_t len) {
+    //  Write the register number, then read the bytes after a repeated start.
+    struct bma421 *dev = arg;
+    struct sensor_itf *itf = SENSOR_GET_ITF(&dev->sensor);
+    dev->reg = reg;
+    i2c_txn_init(&dev->txn, itf->si_num, itf->si_addr, &dev->reg, 1, buf, len);
+    return i2c_queue_transfer(&dev->txn);
+}
+
+static int bus_write(void *arg, uint8_t reg, const uint8_t *buf, uint16_t len) {
+    //  Write the register number followed by the bytes.
+    struct bma421 *dev = arg;
+    struct sensor_itf *itf = SENSOR_GET_ITF(&dev->sensor);
+    if (len > BMA421_WRITE_MAX) { return SYS_EINVAL; }
+    dev->write_buf[0] = reg;
+    memcpy(dev->write_buf + 1, buf, len);
+    i2c_txn_init(&dev->txn, itf->si_num, itf->si_addr, dev->write_buf, 1 + len, NULL, 0);
+    return i2c_queue_transfer(&dev->txn);
+}
+
+static void bus_delay_ms(void *arg, uint32_t ms) {
+    //  Wait at least the number of milliseconds.
+    os_time_t ticks;
+    os_time_ms_to_ticks(ms, &ticks);
+    os_time_delay(ticks + 1);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Device Functions
+
+int bma421_default_cfg(struct bma421_cfg *cfg) {
+    //  Return the default sensor configuration.
+    memset(cfg, 0, sizeof(struct bma421_cfg));  //  Zero the entire object.
+    cfg->bc_s_mask             = BMA421_SENSOR_TYPES;  //  Return acceleration and activity.
+    cfg->core.odr_hz           = MYNEWT_VAL(BMA421_ODR_HZ);
+    cfg->core.range_g          = MYNEWT_VAL(BMA421_RANGE_G);
+    cfg->core.watermark_frames = MYNEWT_VAL(BMA421_FIFO_WATERMARK);
+    cfg->int_pin               = MYNEWT_VAL(BMA421_INT_PIN);
+#if MYNEWT_VAL(BMA421_CONFIG_FILE)
+    if (MYNEWT_VAL(BMA421_STEP_COUNTER)) { cfg->core.features |= BMA421_FEATURE_STEPS; }
+    if (MYNEWT_VAL(BMA421_WRIST_TILT))   { cfg->core.features |= BMA421_FEATURE_TILT; }
+    cfg->core.config_file     = bma421_config_file;
+    cfg->core.config_file_len = bma421_config_file_len;
+#endif  //  MYNEWT_VAL(BMA421_CONFIG_FILE)
+    return 0;
+}
+
+static int bma421_open(struct os_dev *dev0, uint32_t timeout, void *arg) {
+    //  Nothing to open, the I2C port is shared through the I2C queue.  Return 0 if successful.
+    return 0;
+}
+
+static int bma421_close(struct os_dev *dev0) {
+    //  Close the sensor.  Return 0 if successful.
+    return 0;
+}
+
+/**
+ * Expects to be called back through os_dev_create().
+ *
+ * @param The device object associated with bma421
+ * @param Argument passed to OS device init: the sensor_itf
+ *
+ * @return 0 on success, non-zero error on failure.
+ */
+int bma421_init(struct os_dev *dev0, void *arg) {
+    struct bma421 *dev;
+    struct sensor *sensor;
+    int rc;
+    if (!arg || !dev0) { rc = SYS_ENODEV; goto err; }
+    dev = (struct bma421 *) dev0;
+
+    //  Get the default config.
+    rc = bma421_default_cfg(&dev->cfg);
+    if (rc) { goto err; }
+
+    //  Access the registers through the I2C queue.
+    dev->bus.read     = bus_read;
+    dev->bus.write    = bus_write;
+    dev->bus.delay_ms = bus_delay_ms;
+    dev->bus.arg      = dev;
+
+    //  Init the sensor.
+    sensor = &dev->sensor;
+    rc = sensor_init(sensor, dev0);
+    if (rc != 0) { goto err; }
+
+    //  Add the driver with all the supported sensor data types.
+    rc = sensor_set_driver(sensor, BMA421_SENSOR_TYPES,
+        (struct sensor_driver *) &g_bma421_sensor_driver);
+    if (rc != 0) { goto err; }
+
+    //  Set the interface.
+    rc = sensor_set_interface(sensor, arg);
+    if (rc) { goto err; }
+
+    //  Register with the Sensor Manager.
+    rc = sensor_mgr_register(sensor);
+    if (rc != 0) { goto err; }
+
+    //  Set the handlers for opening and closing the device.
+    OS_DEV_SETHANDLERS(dev0, bma421_open, bma421_close);
+    return (0);
+err:
+    return (rc);
+}
+
+static void bma421_interrupt_handler(void *arg) {
+    //  INT1 fired for the FIFO watermark or a feature.  Read the batch in the Sensor Manager task.
+    struct bma421 *dev = arg;
+    sensor_mgr_put_interrupt_evt(&dev->sensor);
+}
+
+/**
+ * Reset and configure the BMA421
+ *
+ * @param Sensor device bma421 structure
+ * @param Sensor device bma421_cfg config
+ *
+ * @return 0 on success, and non-zero error code on failure
+ */
+int bma421_config(struct bma421 *dev, struct bma421_cfg *cfg) {
+    int rc;
+    //  Read the samples at the watermark in one I2C transaction.
+    if (cfg->core.watermark_frames > BMA421_MAX_BATCH) { rc = SYS_EINVAL; goto err; }
+    rc = sensor_set_type_mask(&(dev->sensor), cfg->bc_s_mask);
+    if (rc) { goto err; }
+    dev->cfg = *cfg;
+
+    //  Load the config file and start sampling into the FIFO.
+    rc = bma421_core_init(&dev->bus, &cfg->core);
+    if (rc) { console_printf("BMA init failed %d\n", rc); goto err; }
+    dev->last_steps = 0;
+
+    //  Read the batches when INT1 goes high.
+    if (cfg->int_pin >= 0 && (cfg->core.watermark_frames || cfg->core.features)) {
+        rc = hal_gpio_irq_init(cfg->int_pin, bma421_interrupt_handler, dev,
+            HAL_GPIO_TRIG_RISING, HAL_GPIO_PULL_NONE);
+        if (rc) { goto err; }
+        hal_gpio_irq_enable(cfg->int_pin);
+    }
+    return 0;
+err:
+    return (rc);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Sensor API
+
+static int report_activity(struct sensor *sensor, struct bma421 *dev, const struct bma421_status *status,
+    sensor_data_func_t data_func, void *data_arg) {
+    //  Report the step count and wrist tilt.  After an interrupt, report only if changed.
+    struct sensor_activity_data sad;
+    uint8_t tilt = (status->int_status_0 & BMA421_INT_WRIST_TILT) ? 1 : 0;
+    if (dev->interrupted && !tilt && status->steps == dev->last_steps) { return 0; }
+    dev->last_steps = status->steps;
+
+    sad.sad_steps               = status->steps;
+    sad.sad_wrist_tilt          = tilt;
+    sad.sad_steps_is_valid      = (dev->cfg.core.features & BMA421_FEATURE_STEPS) ? 1 : 0;
+    sad.sad_wrist_tilt_is_valid = (dev->cfg.core.features & BMA421_FEATURE_TILT) ? 1 : 0;
+    return data_func(sensor, data_arg, &sad, SENSOR_TYPE_ACTIVITY);
+}
+
+static int report_samples(struct sensor *sensor, struct bma421 *dev, int count,
+    sensor_data_func_t data_func, void *data_arg) {
+    //  Convert each sample to m/s^2 and call the Listener Function.
+    struct sensor_accel_data sad;
+    float scale = STANDARD_ACCEL_GRAVITY / bma421_core_lsb_per_g(dev->cfg.core.range_g);
+    int rc, i;
+    memset(&sad, 0, sizeof(sad));
+    sad.sad_x_is_valid = sad.sad_y_is_valid = sad.sad_z_is_valid = 1;
+    for (i = 0; i < count; i++) {
+        sad.sad_x = dev->samples[i].x * scale;
+        sad.sad_y = dev->samples[i].y * scale;
+        sad.sad_z = dev->samples[i].z * scale;
+        rc = data_func(sensor, data_arg, &sad, SENSOR_TYPE_ACCELEROMETER);
+        if (rc) { return rc; }
+    }
+    return 0;
+}
+
+static int bma421_sensor_read(struct sensor *sensor, sensor_type_t type,
+    sensor_data_func_t data_func, void *data_arg, uint32_t timeout) {
+    //  Read the status and step count in one I2C transaction, then the batches of samples.
+    struct bma421_status status;
+    struct bma421 *dev;
+    uint16_t fifo_len, watermark;
+    int rc, count;
+
+    if (!(type & BMA421_SENSOR_TYPES)) { rc = SYS_EINVAL; goto err; }
+    dev = (struct bma421 *) SENSOR_GET_DEVICE(sensor); assert(dev);
+    rc = bma421_core_read_status(&dev->bus, &status);
+    if (rc) { goto err; }
+
+    if ((type & SENSOR_TYPE_ACTIVITY) && data_func) {
+        rc = report_activity(sensor, dev, &status, data_func, data_arg);
+        if (rc) { goto err; }
+    }
+    if (!(type & SENSOR_TYPE_ACCELEROMETER)) { return 0; }
+
+    //  INT1 is not latched and fires when the FIFO rises to the watermark.  If the FIFO is still at the watermark
+    //  after the batch, e.g. samples arrived during the read, INT1 would stay high and never fire again.
+    //  So read batches until the FIFO is below the watermark.
+    watermark = dev->cfg.core.watermark_frames * BMA421_FIFO_FRAME_SIZE;
+    fifo_len = status.fifo_len;
+    for (;;) {
+        count = bma421_core_read_fifo(&dev->bus, fifo_len, dev->fifo_buf, sizeof(dev->fifo_buf),
+            dev->samples, BMA421_MAX_BATCH);
+        if (count < 0) { rc = count; goto err; }
+        if (data_func) {
+            rc = report_samples(sensor, dev, count, data_func, data_arg);
+            if (rc) { goto err; }
+        }
+        if (watermark == 0) { break; }
+        rc = bma421_core_read_fifo_len(&dev->bus, &fifo_len);
+        if (rc) { goto err; }
+        if (fifo_len < watermark) { break; }
+    }
+    return 0;
+err:
+    return rc;
+}
+
+static int bma421_sensor_handle_interrupt(struct sensor *sensor) {
+    //  Called by the Sensor Manager after INT1 fired.  Read the batch and pass it to the listeners.
+    struct bma421 *dev = (struct bma421 *) SENSOR_GET_DEVICE(sensor);
+    int rc;
+    dev->interrupted = 1;
+    rc = sensor_read(sensor, dev->cfg.bc_s_mask, NULL, NULL, OS_TIMEOUT_NEVER);
+    dev->interrupted = 0;
+    return rc;
+}
+
+static int bma421_sensor_get_config(struct sensor *sensor, sensor_type_t type,
+    struct sensor_cfg *cfg) {
+    //  Return the type of the sensor value returned by the sensor.
+    int rc;
+    if (type & SENSOR_TYPE_ACCELEROMETER) {
+        cfg->sc_valtype = SENSOR_VALUE_TYPE_FLOAT_TRIPLET;  //  X, Y, Z in m/s^2
+    } else if (type & SENSOR_TYPE_ACTIVITY) {
+        cfg->sc_valtype = SENSOR_VALUE_TYPE_INT32;          //  Step count
+    } else {
+        rc = SYS_EINVAL;
+        goto err;
+    }
+    return (0);
+err:
+    return (rc);
+}
@@ -0,0 +1,222 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+//  Core of the BMA421 accelerometer driver.  No Mynewt dependencies, so this file may be compiled on the host
+//  and tested against a simulated register model.
+#include <stddef.h>
+#include "bma421/bma421_core.h"
+
+#define ACC_CONF_PERF_MODE     0x80  //  Continuous filter mode
+#define ACC_CONF_BWP_NORMAL    0x20  //  Normal filter bandwidth
+#define FIFO_CONFIG_1_ACC_EN   0x40  //  Store accelerometer samples in the FIFO, without headers
+#define INT1_IO_CTRL_OUTPUT    0x0A  //  Output enabled, active high, push-pull
+#define PWR_CTRL_ACC_EN        0x04  //  Accelerometer enabled
+#define PWR_CONF_ADV_SAVE      0x03  //  Advanced power save, with FIFO self wakeup
+#define INTERNAL_STATUS_OK     0x01  //  Config file loaded
+#define FIFO_LENGTH_MASK       0x3FFF
+#define FIFO_EMPTY_FRAME       0x8000  //  Returned for each axis when reading past the end of the FIFO
+#define STATUS_SIZE            (BMA421_REG_FIFO_LENGTH_0 + 2 - BMA421_REG_INT_STATUS_0)
+
+static int write_reg(const struct bma421_bus *bus, uint8_t reg, uint8_t value) {
+    return bus->write(bus->arg, reg, &value, 1);
+}
+
+static int odr_code(uint16_t odr_hz) {
+    //  Return the ACC_CONF code for the output data rate, or -1 if not supported.
+    switch (odr_hz) {
+        case 12:  return 0x05;
+        case 25:  return 0x06;
+        case 50:  return 0x07;
+        case 100: return 0x08;
+        case 200: return 0x09;
+        default:  return -1;
+    }
+}
+
+static int range_code(uint8_t range_g) {
+    //  Return the ACC_RANGE code for the range, or -1 if not supported.
+    switch (range_g) {
+        case 2:  return 0x00;
+        case 4:  return 0x01;
+        case 8:  return 0x02;
+        case 16: return 0x03;
+        default: return -1;
+    }
+}
+
+int bma421_core_lsb_per_g(uint8_t range_g) {
+    int code = range_code(range_g);
+    if (code < 0) { return BMA421_EINVAL; }
+    return 1024 >> code;  //  12-bit samples: 2048 units for the full range
+}
+
+static int load_config_file(const struct bma421_bus *bus, const struct bma421_core_cfg *cfg) {
+    //  Upload the config file for the features, in chunks, then check that the BMA421 accepted it.
+    uint8_t asic[2], status;
+    uint16_t offset, len;
+    int rc;
+
+    rc = write_reg(bus, BMA421_REG_INIT_CTRL, 0x00);  if (rc) { goto err; }
+
+    for (offset = 0; offset < cfg->config_file_len; offset += len) {
+        len = cfg->config_file_len - offset;
+        if (len > BMA421_CONFIG_CHUNK_SIZE) { len = BMA421_CONFIG_CHUNK_SIZE; }
+        //  Set the destination address in words, then write the chunk.
+        asic[0] = (offset / 2) & 0x0F;
+        asic[1] = (offset / 2) >> 4;
+        rc = bus->write(bus->arg, BMA421_REG_ASIC_LSB, asic, sizeof(asic));  if (rc) { goto err; }
+        rc = bus->write(bus->arg, BMA421_REG_FEATURES_IN, cfg->config_file + offset, len);  if (rc) { goto err; }
+    }
+
+    //  Start the feature engine and check the result.
+    rc = write_reg(bus, BMA421_REG_INIT_CTRL, 0x01);  if (rc) { goto err; }
+    bus->delay_ms(bus->arg, 150);
+    rc = bus->read(bus->arg, BMA421_REG_INTERNAL_STATUS, &status, 1);  if (rc) { goto err; }
+    if ((status & 0x0F) != INTERNAL_STATUS_OK) { rc = BMA421_EIO; goto err; }
+    return 0;
+err:
+    return rc;
+}
+
+static int enable_features(const struct bma421_bus *bus, uint8_t features) {
+    //  Set the enable bits in the feature settings.  The settings must be read and written in full.
+    uint8_t settings[BMA421_FEATURE_SIZE];
+    int rc;
+
+    rc = bus->read(bus->arg, BMA421_REG_FEATURES_IN, settings, sizeof(settings));  if (rc) { goto err; }
+    if (features & BMA421_FEATURE_STEPS) { settings[BMA421_FEATURE_STEP_CNTR]  |= BMA421_FEATURE_STEP_CNTR_EN; }
+    if (features & BMA421_FEATURE_TILT)  { settings[BMA421_FEATURE_WRIST_TILT] |= BMA421_FEATURE_WRIST_TILT_EN; }
+    rc = bus->write(bus->arg, BMA421_REG_FEATURES_IN, settings, sizeof(settings));  if (rc) { goto err; }
+    return 0;
+err:
+    return rc;
+}
+
+int bma421_core_init(const struct bma421_bus *bus, const struct bma421_core_cfg *cfg) {
+    uint16_t watermark = cfg->watermark_frames * BMA421_FIFO_FRAME_SIZE;
+    int odr = odr_code(cfg->odr_hz), range = range_code(cfg->range_g);
+    uint8_t features = cfg->config_file ? cfg->features : 0;
+    uint8_t chip_id, buf[2], int1_map = 0;
+    int rc;
+
+    if (odr < 0 || range < 0) { return BMA421_EINVAL; }
+    if (cfg->watermark_frames > BMA421_FIFO_SIZE / BMA421_FIFO_FRAME_SIZE) { return BMA421_EINVAL; }
+    if (cfg->config_file && (cfg->config_file_len == 0 || (cfg->config_file_len & 1))) { return BMA421_EINVAL; }
+
+    rc = bus->read(bus->arg, BMA421_REG_CHIP_ID, &chip_id, 1);  if (rc) { goto err; }
+    if (chip_id != BMA421_CHIP_ID) { rc = BMA421_ENODEV; goto err; }
+    rc = write_reg(bus, BMA421_REG_CMD, BMA421_CMD_SOFT_RESET);  if (rc) { goto err; }
+    bus->delay_ms(bus->arg, 2);
+
+    //  The BMA421 starts in advanced power save, where writes must be 450 us apart.  Disable it for the writes below.
+    rc = write_reg(bus, BMA421_REG_PWR_CONF, 0x00);  if (rc) { goto err; }
+    bus->delay_ms(bus->arg, 1);
+
+    //  Load the config file and enable the step counter and wrist tilt.
+    if (features) {
+        rc = load_config_file(bus, cfg);  if (rc) { goto err; }
+        rc = enable_features(bus, features);  if (rc) { goto err; }
+        if (features & BMA421_FEATURE_STEPS) { int1_map |= BMA421_INT_STEP_COUNTER; }
+        if (features & BMA421_FEATURE_TILT)  { int1_map |= BMA421_INT_WRIST_TILT; }
+    }
+
+    //  Set the data rate and range.
+    rc = write_reg(bus, BMA421_REG_ACC_CONF, ACC_CONF_PERF_MODE | ACC_CONF_BWP_NORMAL | odr);  if (rc) { goto err; }
+    rc = write_reg(bus, BMA421_REG_ACC_RANGE, range);  if (rc) { goto err; }
+
+    //  Stream the samples into the FIFO without headers, so that each frame is 6 bytes.
+    rc = write_reg(bus, BMA421_REG_FIFO_CONFIG_0, 0x00);  if (rc) { goto err; }
+    rc = write_reg(bus, BMA421_REG_FIFO_CONFIG_1, FIFO_CONFIG_1_ACC_EN);  if (rc) { goto err; }
+    buf[0] = watermark & 0xFF;
+    buf[1] = watermark >> 8;
+    rc = bus->write(bus->arg, BMA421_REG_FIFO_WTM_0, buf, sizeof(buf));  if (rc) { goto err; }
+
+    //  Interrupt on INT1 at the FIFO watermark and for the features.
+    rc = write_reg(bus, BMA421_REG_INT1_IO_CTRL, INT1_IO_CTRL_OUTPUT);  if (rc) { goto err; }
+    rc = write_reg(bus, BMA421_REG_INT_LATCH, 0x00);  if (rc) { goto err; }
+    rc = write_reg(bus, BMA421_REG_INT_MAP_DATA, cfg->watermark_frames ? BMA421_INT_FIFO_WM : 0);  if (rc) { goto err; }
+    rc = write_reg(bus, BMA421_REG_INT1_MAP, int1_map);  if (rc) { goto err; }
+
+    //  Start sampling from an empty FIFO.  Every access after this is a read, which is allowed in advanced power save.
+    rc = write_reg(bus, BMA421_REG_CMD, BMA421_CMD_FIFO_FLUSH);  if (rc) { goto err; }
+    rc = write_reg(bus, BMA421_REG_PWR_CTRL, PWR_CTRL_ACC_EN);  if (rc) { goto err; }
+    bus->delay_ms(bus->arg, 1);
+    rc = write_reg(bus, BMA421_REG_PWR_CONF, PWR_CONF_ADV_SAVE);  if (rc) { goto err; }
+    return 0;
+err:
+    return rc;
+}
+
+int bma421_core_read_status(const struct bma421_bus *bus, struct bma421_status *status) {
+    //  INT_STATUS_0 to FIFO_LENGTH_1 are consecutive, so read them in one burst.
+    uint8_t buf[STATUS_SIZE];
+    const uint8_t *steps = buf + BMA421_REG_STEP_COUNTER_0 - BMA421_REG_INT_STATUS_0;
+    const uint8_t *fifo_len = buf + BMA421_REG_FIFO_LENGTH_0 - BMA421_REG_INT_STATUS_0;
+    int rc = bus->read(bus->arg, BMA421_REG_INT_STATUS_0, buf, sizeof(buf));
+    if (rc) { return rc; }
+    status->int_status_0 = buf[0];
+    status->int_status_1 = buf[1];
+    status->steps = steps[0] | (steps[1] << 8) | ((uint32_t) steps[2] << 16) | ((uint32_t) steps[3] << 24);
+    status->fifo_len = (fifo_len[0] | (fifo_len[1] << 8)) & FIFO_LENGTH_MASK;
+    return 0;
+}
+
+int bma421_core_read_fifo_len(const struct bma421_bus *bus, uint16_t *fifo_len) {
+    //  Read only the FIFO length, so that the interrupt status is not cleared.
+    uint8_t buf[2];
+    int rc = bus->read(bus->arg, BMA421_REG_FIFO_LENGTH_0, buf, sizeof(buf));
+    if (rc) { return rc; }
+    *fifo_len = (buf[0] | (buf[1] << 8)) & FIFO_LENGTH_MASK;
+    return 0;
+}
+
+int bma421_core_read_fifo(const struct bma421_bus *bus, uint16_t fifo_len, uint8_t *buf, uint16_t buf_len,
+    struct bma421_sample *samples, uint16_t max_samples) {
+    //  Read only complete frames.  The rest stay in the FIFO for the next batch.
+    uint16_t frames = fifo_len / BMA421_FIFO_FRAME_SIZE;
+    uint16_t len;
+    int rc;
+    if (frames > buf_len / BMA421_FIFO_FRAME_SIZE) { frames = buf_len / BMA421_FIFO_FRAME_SIZE; }
+    if (frames > max_samples) { frames = max_samples; }
+    if (frames == 0) { return 0; }
+
+    len = frames * BMA421_FIFO_FRAME_SIZE;
+    rc = bus->read(bus->arg, BMA421_REG_FIFO_DATA, buf, len);
+    if (rc) { return rc; }
+    return bma421_core_decode_fifo(buf, len, samples, max_samples);
+}
+
+static int16_t decode_axis(const uint8_t *p) {
+    //  12 bits, left justified: shift right with sign.
+    return (int16_t) (p[0] | (p[1] << 8)) >> 4;
+}
+
+int bma421_core_decode_fifo(const uint8_t *buf, uint16_t len, struct bma421_sample *samples, uint16_t max_samples) {
+    uint16_t offset, count = 0;
+    for (offset = 0; offset + BMA421_FIFO_FRAME_SIZE <= len && count < max_samples; offset += BMA421_FIFO_FRAME_SIZE) {
+        const uint8_t *p = buf + offset;
+        if ((p[0] | (p[1] << 8)) == FIFO_EMPTY_FRAME
+            && (p[2] | (p[3] << 8)) == FIFO_EMPTY_FRAME
+            && (p[4] | (p[5] << 8)) == FIFO_EMPTY_FRAME) { continue; }
+        samples[count].x = decode_axis(p);
+        samples[count].y = decode_axis(p + 2);
+        samples[count].z = decode_axis(p + 4);
+        count++;
+    }
+    return count;
+}
@@ -0,0 +1,333 @@
+//  Test the BMA421 driver core against a simulated register model.  Runs on the device or on the host:
+//  gcc -O2 -DTEST_HOST -Iinclude -o test_bma421 src/bma421_core.c test/src/test_bma421.c && ./test_bma421
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "bma421/bma421_core.h"
+
+#define CONFIG_FILE_SIZE 256
+#define WATERMARK        25
+
+//  Simulated BMA421: registers, FIFO, feature settings and the uploaded config file
+static struct sim {
+    uint8_t  regs[128];
+    uint8_t  fifo[BMA421_FIFO_SIZE];
+    uint16_t fifo_len;
+    uint8_t  features[BMA421_FEATURE_SIZE];
+    uint8_t  config[CONFIG_FILE_SIZE];
+    int      transactions;       //  I2C transactions
+    int      fifo_reads;         //  I2C transactions that read the FIFO
+    int      power_save_writes;  //  Writes in advanced power save without a delay since the last write
+    int      waited;             //  1 if there was a delay since the last write
+} sim;
+
+static uint8_t config_file[CONFIG_FILE_SIZE];
+
+static void sim_reset(void) {
+    //  Registers after power on or soft reset.  The config file is lost.
+    memset(sim.regs, 0, sizeof(sim.regs));
+    memset(sim.features, 0, sizeof(sim.features));
+    memset(sim.config, 0, sizeof(sim.config));
+    sim.fifo_len = 0;
+    sim.regs[BMA421_REG_CHIP_ID] = BMA421_CHIP_ID;
+    sim.regs[BMA421_REG_PWR_CONF] = 0x03;
+    sim.waited = 1;
+}
+
+static void sim_update_fifo_len(void) {
+    sim.regs[BMA421_REG_FIFO_LENGTH_0] = sim.fifo_len & 0xFF;
+    sim.regs[BMA421_REG_FIFO_LENGTH_0 + 1] = sim.fifo_len >> 8;
+}
+
+static int sim_int1(void) {
+    //  Return 1 if INT1 is asserted.
+    return (sim.regs[BMA421_REG_INT_STATUS_0] & sim.regs[BMA421_REG_INT1_MAP])
+        || (sim.regs[BMA421_REG_INT_STATUS_1] & sim.regs[BMA421_REG_INT_MAP_DATA]);
+}
+
+static void sim_sample(int16_t x, int16_t y, int16_t z) {
+    //  Sample the acceleration (12 bits) into the FIFO.
+    int16_t axes[3] = { x, y, z };
+    int i;
+    if (!(sim.regs[BMA421_REG_PWR_CTRL] & 0x04)) { return; }
+    if (sim.fifo_len + BMA421_FIFO_FRAME_SIZE > BMA421_FIFO_SIZE) { return; }
+    for (i = 0; i < 3; i++) {
+        uint16_t raw = (uint16_t) (axes[i] << 4);
+        sim.fifo[sim.fifo_len++] = raw & 0xFF;
+        sim.fifo[sim.fifo_len++] = raw >> 8;
+    }
+    sim_update_fifo_len();
+    uint16_t wtm = sim.regs[BMA421_REG_FIFO_WTM_0] | (sim.regs[BMA421_REG_FIFO_WTM_0 + 1] << 8);
+    if (wtm && sim.fifo_len >= wtm) { sim.regs[BMA421_REG_INT_STATUS_1] |= BMA421_INT_FIFO_WM; }
+}
+
+static void sim_step(void) {
+    //  Count a step, if the step counter is enabled.
+    uint32_t steps;
+    if (!(sim.features[BMA421_FEATURE_STEP_CNTR] & BMA421_FEATURE_STEP_CNTR_EN)) { return; }
+    memcpy(&steps, &sim.regs[BMA421_REG_STEP_COUNTER_0], 4);  //  Host is little endian
+    steps++;
+    memcpy(&sim.regs[BMA421_REG_STEP_COUNTER_0], &steps, 4);
+    sim.regs[BMA421_REG_INT_STATUS_0] |= BMA421_INT_STEP_COUNTER;
+}
+
+static int sim_read(void *arg, uint8_t reg, uint8_t *buf, uint16_t len) {
+    uint16_t i;
+    (void) arg;
+    sim.transactions++;
+    if (reg == BMA421_REG_FIFO_DATA) {
+        //  Pop the FIFO.  Reading past the end returns empty frames.
+        sim.fifo_reads++;
+        for (i = 0; i < len; i++) { buf[i] = (i & 1) ? 0x80 : 0x00; }
+        uint16_t n = len < sim.fifo_len ? len : sim.fifo_len;
+        memcpy(buf, sim.fifo, n);
+        memmove(sim.fifo, sim.fifo + n, sim.fifo_len - n);
+        sim.fifo_len -= n;
+        sim_update_fifo_len();
+        if (sim.fifo_len < (sim.regs[BMA421_REG_FIFO_WTM_0] | (sim.regs[BMA421_REG_FIFO_WTM_0 + 1] << 8))) {
+            sim.regs[BMA421_REG_INT_STATUS_1] &= ~BMA421_INT_FIFO_WM;
+        }
+        return 0;
+    }
+    if (reg == BMA421_REG_FEATURES_IN) {
+        assert(len <= BMA421_FEATURE_SIZE);
+        memcpy(buf, sim.features, len);
+        return 0;
+    }
+    assert(reg + len <= sizeof(sim.regs));
+    memcpy(buf, &sim.regs[reg], len);
+    //  Reading the interrupt status clears it
+    if (reg <= BMA421_REG_INT_STATUS_0 && reg + len > BMA421_REG_INT_STATUS_0) { sim.regs[BMA421_REG_INT_STATUS_0] = 0; }
+    return 0;
+}
+
+static int sim_write(void *arg, uint8_t reg, const uint8_t *buf, uint16_t len) {
+    (void) arg;
+    sim.transactions++;
+    assert(len > 0 && len <= BMA421_WRITE_MAX);
+    if ((sim.regs[BMA421_REG_PWR_CONF] & 0x01) && !sim.waited) { sim.power_save_writes++; }
+    sim.waited = 0;
+    if (reg == BMA421_REG_CMD) {
+        if (buf[0] == BMA421_CMD_SOFT_RESET) { sim_reset();  sim.waited = 0; }
+        if (buf[0] == BMA421_CMD_FIFO_FLUSH) { sim.fifo_len = 0;  sim_update_fifo_len(); }
+        return 0;
+    }
+    if (reg == BMA421_REG_FEATURES_IN) {
+        if (sim.regs[BMA421_REG_INIT_CTRL] == 0) {
+            //  Upload the config file at the word address
+            uint16_t offset = 2 * ((sim.regs[BMA421_REG_ASIC_LSB] & 0x0F) | (sim.regs[BMA421_REG_ASIC_LSB + 1] << 4));
+            assert(!(sim.regs[BMA421_REG_PWR_CONF] & 0x01));
+            assert(offset + len <= CONFIG_FILE_SIZE);
+            memcpy(sim.config + offset, buf, len);
+        } else {
+            //  Feature settings must be written in full
+            assert(len == BMA421_FEATURE_SIZE);
+            memcpy(sim.features, buf, len);
+        }
+        return 0;
+    }
+    assert(reg + len <= sizeof(sim.regs));
+    memcpy(&sim.regs[reg], buf, len);
+    if (reg == BMA421_REG_INIT_CTRL && buf[0] == 1) {
+        //  Start the feature engine if the config file is intact
+        sim.regs[BMA421_REG_INTERNAL_STATUS] = memcmp(sim.config, config_file, CONFIG_FILE_SIZE) ? 0x02 : 0x01;
+    }
+    return 0;
+}
+
+static void sim_delay_ms(void *arg, uint32_t ms) { (void) arg;  (void) ms;  sim.waited = 1; }
+
+static const struct bma421_bus bus = { sim_read, sim_write, sim_delay_ms, NULL };
+
+static struct bma421_core_cfg make_cfg(void) {
+    struct bma421_core_cfg cfg = {
+        25, 2, BMA421_FEATURE_STEPS | BMA421_FEATURE_TILT, WATERMARK, config_file, CONFIG_FILE_SIZE,
+    };
+    return cfg;
+}
+
+static void test_init(void) {
+    //  Load the config file, enable the features and configure the FIFO.
+    struct bma421_core_cfg cfg = make_cfg();
+    int i;
+    for (i = 0; i < CONFIG_FILE_SIZE; i++) { config_file[i] = (uint8_t) (i * 7 + 3); }
+    sim_reset();
+    sim.power_save_writes = 0;
+    assert(bma421_core_init(&bus, &cfg) == 0);
+    assert(sim.power_save_writes == 0);
+    assert(memcmp(sim.config, config_file, CONFIG_FILE_SIZE) == 0);
+    assert(sim.features[BMA421_FEATURE_STEP_CNTR] & BMA421_FEATURE_STEP_CNTR_EN);
+    assert(sim.features[BMA421_FEATURE_WRIST_TILT] & BMA421_FEATURE_WRIST_TILT_EN);
+    assert((sim.regs[BMA421_REG_ACC_CONF] & 0x0F) == 0x06);  //  25 Hz
+    assert(sim.regs[BMA421_REG_ACC_RANGE] == 0x00);          //  2 g
+    assert(sim.regs[BMA421_REG_FIFO_CONFIG_1] == 0x40);      //  Accelerometer without headers
+    assert(sim.regs[BMA421_REG_FIFO_WTM_0] == WATERMARK * BMA421_FIFO_FRAME_SIZE);
+    assert(sim.regs[BMA421_REG_INT_MAP_DATA] == BMA421_INT_FIFO_WM);
+    assert(sim.regs[BMA421_REG_INT1_MAP] == (BMA421_INT_STEP_COUNTER | BMA421_INT_WRIST_TILT));
+    assert(sim.regs[BMA421_REG_PWR_CTRL] == 0x04);
+    assert(sim.regs[BMA421_REG_PWR_CONF] & 0x01);
+}
+
+static void test_init_errors(void) {
+    //  Wrong chip, corrupted config file, unsupported configuration.
+    struct bma421_core_cfg cfg = make_cfg();
+    uint8_t corrupt[CONFIG_FILE_SIZE];
+    sim_reset();
+    sim.regs[BMA421_REG_CHIP_ID] = 0x13;
+    assert(bma421_core_init(&bus, &cfg) == BMA421_ENODEV);
+
+    sim_reset();
+    memcpy(corrupt, config_file, sizeof(corrupt));
+    corrupt[100] ^= 0xFF;
+    cfg.config_file = corrupt;
+    assert(bma421_core_init(&bus, &cfg) == BMA421_EIO);
+
+    cfg = make_cfg();  cfg.odr_hz = 30;
+    assert(bma421_core_init(&bus, &cfg) == BMA421_EINVAL);
+    cfg = make_cfg();  cfg.range_g = 3;
+    assert(bma421_core_init(&bus, &cfg) == BMA421_EINVAL);
+    cfg = make_cfg();  cfg.watermark_frames = 200;
+    assert(bma421_core_init(&bus, &cfg) == BMA421_EINVAL);
+}
+
+static void test_no_config_file(void) {
+    //  Without the config file, the features are disabled but the FIFO works.
+    struct bma421_core_cfg cfg = make_cfg();
+    struct bma421_status status;
+    int i;
+    cfg.config_file = NULL;  cfg.config_file_len = 0;
+    sim_reset();
+    sim.power_save_writes = 0;
+    assert(bma421_core_init(&bus, &cfg) == 0);
+    assert(sim.power_save_writes == 0);  //  Power save is disabled after the reset, not only for the config file
+    assert(sim.regs[BMA421_REG_INT1_MAP] == 0);
+    assert(sim.features[BMA421_FEATURE_STEP_CNTR] == 0);
+    for (i = 0; i < WATERMARK; i++) { sim_sample(i, -i, 512); }
+    assert(sim_int1());
+    assert(bma421_core_read_status(&bus, &status) == 0);
+    assert(status.fifo_len == WATERMARK * BMA421_FIFO_FRAME_SIZE);
+}
+
+static void test_batch(void) {
+    //  Read a batch of samples at the watermark: one transaction for the status, one for the FIFO.
+    struct bma421_core_cfg cfg = make_cfg();
+    struct bma421_status status;
+    struct bma421_sample samples[32];
+    static uint8_t buf[BMA421_FIFO_SIZE];
+    int i, n;
+    sim_reset();
+    assert(bma421_core_init(&bus, &cfg) == 0);
+    for (i = 0; i < WATERMARK; i++) {
+        assert(!sim_int1());
+        sim_sample(i * 80 - 1000, -2048 + i, 2047 - i);
+    }
+    assert(sim_int1());
+
+    sim.transactions = sim.fifo_reads = sim.power_save_writes = 0;
+    assert(bma421_core_read_status(&bus, &status) == 0);
+    assert(status.int_status_1 & BMA421_INT_FIFO_WM);
+    n = bma421_core_read_fifo(&bus, status.fifo_len, buf, sizeof(buf), samples, 32);
+    assert(n == WATERMARK);
+    assert(sim.transactions == 2 && sim.fifo_reads == 1);
+    for (i = 0; i < n; i++) {
+        assert(samples[i].x == i * 80 - 1000);
+        assert(samples[i].y == -2048 + i);
+        assert(samples[i].z == 2047 - i);
+    }
+    assert(sim.fifo_len == 0 && !sim_int1());
+    assert(sim.power_save_writes == 0);
+    printf("%d samples in %d I2C transactions, instead of %d\n", n, sim.transactions, n);
+
+    //  Frames that don't fit in the buffer stay in the FIFO.
+    for (i = 0; i < 10; i++) { sim_sample(i, i, i); }
+    assert(bma421_core_read_status(&bus, &status) == 0);
+    n = bma421_core_read_fifo(&bus, status.fifo_len, buf, 4 * BMA421_FIFO_FRAME_SIZE + 3, samples, 32);
+    assert(n == 4 && samples[3].x == 3);
+    n = bma421_core_read_fifo(&bus, sim.fifo_len, buf, sizeof(buf), samples, 5);
+    assert(n == 5 && samples[0].x == 4);
+    assert(sim.fifo_len == BMA421_FIFO_FRAME_SIZE);
+}
+
+static void test_drain(void) {
+    //  INT1 is not latched and fires on the rising edge.  If samples arrive while reading the batch and the FIFO stays
+    //  at the watermark, INT1 stays high.  Read batches like bma421_sensor_read() until the FIFO is below the watermark.
+    struct bma421_core_cfg cfg = make_cfg();
+    struct bma421_status status;
+    struct bma421_sample samples[WATERMARK];
+    static uint8_t buf[BMA421_FIFO_SIZE];
+    uint16_t fifo_len;
+    int i, n, batches = 0, total = 0;
+    sim_reset();
+    assert(bma421_core_init(&bus, &cfg) == 0);
+    for (i = 0; i < 2 * WATERMARK + 5; i++) { sim_sample(i, 0, 0); }
+    sim_step();
+    assert(sim_int1());
+
+    assert(bma421_core_read_status(&bus, &status) == 0);
+    assert(status.steps == 1);
+    fifo_len = status.fifo_len;
+    for (;;) {
+        n = bma421_core_read_fifo(&bus, fifo_len, buf, sizeof(buf), samples, WATERMARK);
+        assert(n > 0 && samples[0].x == total);
+        total += n;
+        batches++;
+        if (batches == 1) { for (i = 0; i < 10; i++) { sim_sample(2 * WATERMARK + 5 + i, 0, 0); } }  //  During the read
+        assert(bma421_core_read_fifo_len(&bus, &fifo_len) == 0);
+        if (fifo_len < WATERMARK * BMA421_FIFO_FRAME_SIZE) { break; }
+    }
+    assert(batches == 2 && total == 2 * WATERMARK && sim.fifo_len == 15 * BMA421_FIFO_FRAME_SIZE);
+    assert(!sim_int1());
+
+    //  The next batch raises INT1 again
+    for (i = 0; i < 10; i++) { sim_sample(0, 0, 0); }
+    assert(sim_int1());
+}
+
+static void test_decode(void) {
+    //  Empty frames from reading past the end of the FIFO are skipped.
+    static const uint8_t frames[] = {
+        0x10, 0x00, 0xF0, 0xFF, 0x00, 0x40,  //  1, -1, 1024
+        0x00, 0x80, 0x00, 0x80, 0x00, 0x80,  //  Empty
+        0x00, 0x80, 0x00, 0x00, 0xF0, 0x7F,  //  -2048, 0, 2047
+        0x01, 0x02,                          //  Incomplete
+    };
+    struct bma421_sample samples[4];
+    assert(bma421_core_decode_fifo(frames, sizeof(frames), samples, 4) == 2);
+    assert(samples[0].x == 1 && samples[0].y == -1 && samples[0].z == 1024);
+    assert(samples[1].x == -2048 && samples[1].y == 0 && samples[1].z == 2047);
+    assert(bma421_core_decode_fifo(frames, sizeof(frames), samples, 1) == 1);
+    assert(bma421_core_lsb_per_g(2) == 1024 && bma421_core_lsb_per_g(16) == 128);
+    assert(bma421_core_lsb_per_g(3) == BMA421_EINVAL);
+}
+
+static void test_steps(void) {
+    //  Step count and step interrupt are read with the FIFO status.
+    struct bma421_core_cfg cfg = make_cfg();
+    struct bma421_status status;
+    int i;
+    sim_reset();
+    assert(bma421_core_init(&bus, &cfg) == 0);
+    for (i = 0; i < 300; i++) { sim_step(); }
+    assert(sim_int1());
+    assert(bma421_core_read_status(&bus, &status) == 0);
+    assert(status.steps == 300 && (status.int_status_0 & BMA421_INT_STEP_COUNTER));
+    assert(!sim_int1());
+    assert(bma421_core_read_status(&bus, &status) == 0);
+    assert(status.steps == 300 && status.int_status_0 == 0);
+}
+
+int test_bma421(void) {
+    test_init();
+    test_init_errors();
+    test_no_config_file();
+    test_batch();
+    test_drain();
+    test_decode();
+    test_steps();
+    printf("bma421 tests OK\n");
+    return 0;
+}
+
+#ifdef TEST_HOST
+int main(void) { return test_bma421(); }
+#endif  //  TEST_HOST
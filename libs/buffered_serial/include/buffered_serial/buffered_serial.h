@@ -81,6 +81,7 @@ private:
     uint32_t      _txbuf_size;
     uint32_t      _rxbuf_size; 
     uint8_t       _initialised;  //  Set to non-zero if UART port has been initialised.
+    uint8_t       _rx_enabled;   //  Set to zero to drop received bytes and stall the UART RX interrupt.
     os_sem        _rx_sem;     //  Semaphore that is signalled for every byte received.
     void (*_cbs[2])(void *);   //  RX, TX callbacks, indexed by RxIrq, TxIrq.
     void *_cbs_arg[2];         //  RX, TX callback arguments, indexed by RxIrq, TxIrq.
@@ -148,6 +149,16 @@ public:
      */
     void attach(void (*func)(void *), void *arg, IrqType type=RxIrq);
 
+    /** Stop receiving.  The rx buffer is cleared and the next received byte is rejected,
+     *  which makes the UART driver disable the RX interrupt until start_rx() is called.
+     *  Transmitting is not affected.
+     */
+    void stop_rx(void);
+
+    /** Resume receiving after stop_rx()
+     */
+    void start_rx(void);
+
     //  TODO: Move these internal variables to protected section.
     int rxIrq(uint8_t byte);
     int txIrq(void);
@@ -116,6 +116,7 @@ int setup_uart(BufferedSerial *serial) {
 void BufferedSerial::init(char *txbuf, uint32_t txbuf_size, char *rxbuf, uint32_t rxbuf_size, const char* name)
 {
     _initialised = 0;
+    _rx_enabled = 1;
     _uart = 0;
     _baud = 0;
     _txbuf_size = txbuf_size;
@@ -194,6 +195,8 @@ size_t BufferedSerial::write(const void *s, size_t length)
 int BufferedSerial::rxIrq(uint8_t byte)
 {
     //  UART driver reports incoming byte of data. Return -1 if data was dropped.
+    //  When RX is stopped, the UART driver stalls the RX interrupt after we return -1.
+    if (!_rx_enabled) { return -1; }
     _rxbuf.put(byte);  //  Add to TX buffer.
     os_error_t rc = os_sem_release(&_rx_sem);  //  Signal to semaphore that data is available.
     assert(rc == OS_OK);
@@ -226,6 +229,19 @@ void BufferedSerial::prime(void)
     hal_uart_start_tx(_uart);  //  Start transmitting UART data in the buffer.  txIrq will retrieve the data from the buffer.
 }
 
+void BufferedSerial::stop_rx(void)
+{
+    _rx_enabled = 0;
+    _rxbuf.clear();
+}
+
+void BufferedSerial::start_rx(void)
+{
+    _rx_enabled = 1;
+    //  Restart the stalled RX interrupt.  If the UART has not been primed, prime() will start it.
+    if (_initialised) { hal_uart_start_rx(_uart); }
+}
+
 void BufferedSerial::attach(void (*func)(void *), void *arg, IrqType type)
 {
     _cbs[type] = func;
@@ -34,6 +34,10 @@ extern "C" {
 //  Allocate the next unused Sensor Type ID.
 #define SENSOR_TYPE_AMBIENT_TEMPERATURE_RAW SENSOR_TYPE_USER_DEFINED_1
 #define SENSOR_TYPE_GEOLOCATION             SENSOR_TYPE_USER_DEFINED_2
+#define SENSOR_TYPE_MULTI                   SENSOR_TYPE_USER_DEFINED_3
+#define SENSOR_TYPE_GPS_SATELLITES          SENSOR_TYPE_USER_DEFINED_4
+#define SENSOR_TYPE_ACTIVITY                SENSOR_TYPE_USER_DEFINED_5
+#define SENSOR_TYPE_HEART_RATE              SENSOR_TYPE_USER_DEFINED_6
 
 //  Raw Temperature Sensor: Instead of floating-point computed temperature, we transmit the
 //  raw temperature value as integer to the Collector Node and CoAP Server to reduce message
@@ -51,14 +55,14 @@ struct sensor_temp_raw_data {
     uint8_t  strd_temp_raw_is_valid;  
 } __attribute__((packed));
 
-//  Geolocation
+//  Geolocation in fixed-point, so that MCUs without FPU don't need floating-point to handle coordinates
 struct sensor_geolocation_data {   
-    ///  Latitude (degrees)
-    double sgd_latitude;
-    ///  Longitude (degrees)
-    double sgd_longitude;
-    ///  Altitude (metres)
-    double sgd_altitude;
+    ///  Latitude (1e-7 degrees)
+    int32_t sgd_latitude_e7;
+    ///  Longitude (1e-7 degrees)
+    int32_t sgd_longitude_e7;
+    ///  Altitude (centimetres)
+    int32_t sgd_altitude_cm;
 
     ///  1 if latitude is valid
     uint8_t  sgd_latitude_is_valid;  
@@ -68,6 +72,91 @@ struct sensor_geolocation_data {
     uint8_t  sgd_altitude_is_valid;  
 } __attribute__((packed));
 
+//  GPS Satellites: Number of satellites used for the fix and horizontal dilution of precision
+struct sensor_satellites_data {   
+    ///  Number of satellites in use
+    uint32_t ssd_satellites;
+    ///  Horizontal dilution of precision, times 100
+    uint32_t ssd_hdop;
+
+    ///  1 if satellites is valid
+    uint8_t  ssd_satellites_is_valid;  
+    ///  1 if HDOP is valid
+    uint8_t  ssd_hdop_is_valid;  
+} __attribute__((packed));
+
+//  Activity: Step count and wrist tilt, computed by the accelerometer
+struct sensor_activity_data {   
+    ///  Number of steps since the accelerometer was reset
+    uint32_t sad_steps;
+    ///  1 if the wrist was tilted towards the face since the last report
+    uint8_t  sad_wrist_tilt;
+
+    ///  1 if steps is valid
+    uint8_t  sad_steps_is_valid;  
+    ///  1 if wrist tilt is valid
+    uint8_t  sad_wrist_tilt_is_valid;  
+} __attribute__((packed));
+
+//  Heart Rate: Computed on the device from the optical sensor, instead of transmitting the raw samples
+struct sensor_heart_rate_data {   
+    ///  Heart rate in beats per minute
+    uint32_t shr_bpm;
+    ///  Confidence of the heart rate, 0 to 100
+    uint32_t shr_confidence;
+
+    ///  1 if heart rate is valid, i.e. the confidence is high enough
+    uint8_t  shr_bpm_is_valid;  
+    ///  1 if confidence is valid
+    uint8_t  shr_confidence_is_valid;  
+} __attribute__((packed));
+
+/////////////////////////////////////////////////////////
+//  Multi-Value Sensor Data
+
+//  When SENSOR_MULTI_READ is enabled and the read request includes SENSOR_TYPE_MULTI, a driver fills
+//  all requested sensor types in one call and passes them to the Listener Function as a single
+//  sensor_multi_data record with type SENSOR_TYPE_MULTI.  This saves one listener dispatch per value,
+//  e.g. latitude / longitude / altitude plus satellites, or all fields of a Remote Sensor frame.
+//  Listeners must register for SENSOR_TYPE_MULTI to receive the record.  The data pointers are valid
+//  only during the Listener Function call.
+
+//  Max number of sensor values in a multi-value record.  Must sync with rust/mynewt/src/hw/sensor.rs
+#define SENSOR_MULTI_MAX_VALUES 4
+
+//  Return non-zero if the read request for sensor types `type` should be returned as a multi-value record.
+#define SENSOR_MULTI_REQUESTED(type) (MYNEWT_VAL(SENSOR_MULTI_READ) && ((type) & SENSOR_TYPE_MULTI))
+
+///  One sensor value in a multi-value record
+struct sensor_multi_value {
+    ///  Sensor type of the value, e.g. SENSOR_TYPE_GEOLOCATION
+    sensor_type_t smv_type;
+    ///  Sensor data for the sensor type, e.g. struct sensor_geolocation_data
+    void *smv_data;
+};
+
+///  Multi-value record passed to Listener Functions with type SENSOR_TYPE_MULTI
+struct sensor_multi_data {
+    ///  Number of values in smd_values
+    uint32_t smd_count;
+    ///  Sensor values
+    struct sensor_multi_value smd_values[SENSOR_MULTI_MAX_VALUES];
+};
+
+//  Empty the multi-value record.
+static inline void sensor_multi_init(struct sensor_multi_data *md) {
+    md->smd_count = 0;
+}
+
+//  Append the sensor data for the sensor type to the multi-value record.  Return 0 if successful, SYS_ENOMEM if full.
+static inline int sensor_multi_add(struct sensor_multi_data *md, sensor_type_t type, void *data) {
+    if (md->smd_count >= SENSOR_MULTI_MAX_VALUES) { return SYS_ENOMEM; }
+    md->smd_values[md->smd_count].smv_type = type;
+    md->smd_values[md->smd_count].smv_data = data;
+    md->smd_count++;
+    return 0;
+}
+
 #ifdef __cplusplus
 }
 #endif
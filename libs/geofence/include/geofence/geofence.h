@@ -0,0 +1,42 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+//  Geofences for Mynewt.  GPS fixes are tested against a list of fences in flash.  When a fix enters or leaves
+//  a fence, the transition is transmitted to the CoAP server right away, without waiting for the next sensor poll.
+#ifndef __GEOFENCE_H__
+#define __GEOFENCE_H__
+
+#include "os/mynewt.h"
+#include "geofence/geofence_engine.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//  Index the fences and start checking fixes against them.  The fences must remain valid, e.g. declared as const.
+//  `func` (may be NULL) is called for each transition, in addition to the uplink.  Return 0 if successful.
+int geofence_start(const struct geofence *fences, uint16_t count, geofence_func_t func, void *arg);
+
+//  Check a GPS fix against the fences.  Called by the GPS driver after each fix.  Return the number of transitions.
+int geofence_check_fix(int32_t lat_e7, int32_t lng_e7);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  //  __GEOFENCE_H__
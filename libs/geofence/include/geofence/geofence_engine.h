@@ -0,0 +1,94 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+//  Geofence evaluation engine.  Tests GPS fixes against circles and polygons, with a coarse grid index
+//  so that each fix is tested against nearby fences only.  Coordinates are in 1e-7 degrees and all arithmetic
+//  is in integers.  This file has no Mynewt dependencies, so the engine may be benchmarked on the host.
+#ifndef __GEOFENCE_ENGINE_H__
+#define __GEOFENCE_ENGINE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef GEOFENCE_GRID_SIZE
+#define GEOFENCE_GRID_SIZE  16  //  Number of grid cells along each side of the index.  The index takes (GEOFENCE_GRID_SIZE^2 + 1) * 2 bytes.
+#endif
+#ifndef GEOFENCE_MAX_INSIDE
+#define GEOFENCE_MAX_INSIDE  8  //  Max number of fences that a fix may be inside at the same time
+#endif
+
+//  Geofence shapes
+#define GEOFENCE_CIRCLE   1  //  Circle: points[0] is the centre, radius in metres
+#define GEOFENCE_POLYGON  2  //  Polygon: points[0] to points[count - 1] are the vertices, in order.  May be concave.
+
+//  A position in 1e-7 degrees
+struct geofence_point {
+    int32_t lat_e7;  //  Latitude
+    int32_t lng_e7;  //  Longitude
+};
+
+//  A geofence.  Declare fences and their points as const so that they are stored in flash.
+//  Fences must not cross the 180 degree meridian.
+struct geofence {
+    uint16_t id;        //  Fence ID, reported in transitions
+    uint8_t  type;      //  GEOFENCE_CIRCLE or GEOFENCE_POLYGON
+    uint16_t count;     //  Number of points: 1 for circles, number of vertices for polygons
+    uint32_t radius_m;  //  Radius of circle in metres.  Not used for polygons.
+    const struct geofence_point *points;  //  Centre of circle, or vertices of polygon
+};
+
+//  Function that will be called when a fix enters (`entered` is true) or leaves a fence
+typedef void (*geofence_func_t)(void *arg, const struct geofence *fence, bool entered);
+
+//  Grid index over a list of fences, and the fences that the last fix was inside.
+//  The grid covers the bounding box of all fences.  Each cell lists the fences whose bounding box overlaps the cell.
+struct geofence_index {
+    const struct geofence *fences;  //  List of fences
+    uint16_t count;                 //  Number of fences
+    int32_t  min_lat_e7;            //  South-west corner of the grid
+    int32_t  min_lng_e7;
+    uint32_t cell_lat_e7;           //  Size of each grid cell
+    uint32_t cell_lng_e7;
+    uint16_t cell_start[GEOFENCE_GRID_SIZE * GEOFENCE_GRID_SIZE + 1];  //  Fences for cell c are at entries[cell_start[c]] to entries[cell_start[c + 1] - 1]
+    uint16_t *entries;              //  Fence numbers (index into fences), grouped by cell
+    uint16_t inside[GEOFENCE_MAX_INSIDE];  //  Fence numbers that the last fix was inside
+    uint8_t  inside_count;          //  Number of fences that the last fix was inside
+};
+
+//  Build the grid index for the list of fences.  `entries` is a buffer for `max_entries` fence numbers,
+//  which must hold one entry for every cell overlapped by every fence.  Return the number of entries used,
+//  or -1 if the fences are invalid or `entries` is too small.
+int geofence_index_init(struct geofence_index *index, const struct geofence *fences, uint16_t count,
+    uint16_t *entries, uint16_t max_entries);
+
+//  Test a fix against the nearby fences.  Call `func` for each fence that the fix has entered or left since the last fix.
+//  Return the number of transitions.
+int geofence_index_update(struct geofence_index *index, int32_t lat_e7, int32_t lng_e7, geofence_func_t func, void *arg);
+
+//  Return true if the position is inside the fence.  Points on the boundary may be inside or outside.
+bool geofence_contains(const struct geofence *fence, int32_t lat_e7, int32_t lng_e7);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  //  __GEOFENCE_ENGINE_H__
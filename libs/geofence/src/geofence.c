@@ -0,0 +1,127 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+//  Geofences for Mynewt: Check GPS fixes against the fences and transmit the transitions to the CoAP server.
+#include <string.h>
+#include <os/os.h>
+#include <console/console.h>
+#include "geofence/geofence.h"
+#if MYNEWT_VAL(GEOFENCE_UPLINK)
+#include <sensor_network/sensor_network.h>
+#include <sensor_coap/sensor_coap.h>
+#endif  //  GEOFENCE_UPLINK
+
+#define MAX_EVENTS MYNEWT_VAL(GEOFENCE_MAX_EVENTS)
+
+//  A transition waiting to be transmitted
+struct geofence_event {
+    uint16_t id;       //  Fence ID
+    uint8_t entered;   //  1 if entered, 0 if left
+};
+
+static struct geofence_index fence_index;                               //  Grid index of the fences
+static uint16_t fence_entries[MYNEWT_VAL(GEOFENCE_MAX_ENTRIES)];       //  Fence numbers for the grid index
+static bool started = false;                                           //  True if geofence_start() has been called
+static geofence_func_t user_func;                                      //  Transition function from geofence_start()
+static void *user_arg;                                                 //  Argument for the transition function
+
+#if MYNEWT_VAL(GEOFENCE_UPLINK)
+static struct geofence_event events[MAX_EVENTS];  //  Transitions waiting to be transmitted, oldest first
+static uint8_t event_count;                       //  Number of transitions waiting
+static struct os_callout uplink_callout;          //  Callout to transmit the transitions
+static void uplink_callback(struct os_event *ev);
+#endif  //  GEOFENCE_UPLINK
+
+static void on_transition(void *arg, const struct geofence *fence, bool entered);
+
+int geofence_start(const struct geofence *fences, uint16_t count, geofence_func_t func, void *arg) {
+    //  Index the fences and start checking fixes against them.  Return 0 if successful.
+    int rc = geofence_index_init(&fence_index, fences, count, fence_entries, MYNEWT_VAL(GEOFENCE_MAX_ENTRIES));
+    if (rc < 0) { rc = SYS_EINVAL; goto err; }  //  Invalid fence, or GEOFENCE_MAX_ENTRIES too small
+    console_printf("GEO %d fences, %d index entries\n", count, rc);
+    user_func = func;
+    user_arg = arg;
+#if MYNEWT_VAL(GEOFENCE_UPLINK)
+    os_callout_init(&uplink_callout, os_eventq_dflt_get(), uplink_callback, NULL);
+#endif  //  GEOFENCE_UPLINK
+    started = true;
+    return 0;
+err:
+    return rc;
+}
+
+int geofence_check_fix(int32_t lat_e7, int32_t lng_e7) {
+    //  Check a GPS fix against the fences.  Return the number of transitions.
+    if (!started) { return 0; }
+    return geofence_index_update(&fence_index, lat_e7, lng_e7, on_transition, NULL);
+}
+
+static void on_transition(void *arg, const struct geofence *fence, bool entered) {
+    //  Called by the engine when a fix enters or leaves a fence.  Queue the transition for transmission.
+    console_printf("GEO %s fence %d\n", entered ? "enter" : "leave", fence->id);
+    if (user_func) { user_func(user_arg, fence, entered); }
+#if MYNEWT_VAL(GEOFENCE_UPLINK)
+    if (event_count == MAX_EVENTS) {
+        //  Queue is full because the network is down.  Drop the oldest transition.
+        memmove(&events[0], &events[1], (MAX_EVENTS - 1) * sizeof(events[0]));
+        event_count--;
+    }
+    events[event_count].id = fence->id;
+    events[event_count].entered = entered;
+    event_count++;
+    os_callout_reset(&uplink_callout, 0);  //  Transmit now
+#endif  //  GEOFENCE_UPLINK
+}
+
+#if MYNEWT_VAL(GEOFENCE_UPLINK)
+static bool send_event(const struct geofence_event *event) {
+    //  Compose a CoAP message with the transition and send to the CoAP server.  Return false if network is not ready.
+    //    {"values":[
+    //      {"key":"device", "value":"0102030405060708090a0b0c0d0e0f10"},
+    //      {"key":"fence",  "value":12},
+    //      {"key":"event",  "value":"enter"}
+    //    ]}
+    const char *device_id = get_device_id();  assert(device_id);
+    bool rc = init_server_post(NULL);
+    if (!rc) { return false; }  //  Network transport not ready.  Try again later.
+    rc = sensor_network_prepare_post(APPLICATION_JSON);  assert(rc);
+
+    CP_ROOT({                     //  Create the payload root
+        CP_ARRAY(root, values, {  //  Create "values" as an array of items under the root
+            CP_ITEM_STR(values, "device", device_id);
+            CP_ITEM_INT(values, "fence", event->id);
+            CP_ITEM_STR(values, "event", event->entered ? "enter" : "leave");
+        });                       //  End CP_ARRAY: Close the "values" array
+    });                           //  End CP_ROOT:  Close the payload root
+
+    rc = do_server_post();  assert(rc);
+    return true;
+}
+
+static void uplink_callback(struct os_event *ev) {
+    //  Transmit the queued transitions, oldest first.  If the network is not ready, try again in a while.
+    while (event_count > 0) {
+        if (!send_event(&events[0])) {
+            os_callout_reset(&uplink_callout, MYNEWT_VAL(GEOFENCE_RETRY_INTERVAL) * OS_TICKS_PER_SEC / 1000);
+            return;
+        }
+        memmove(&events[0], &events[1], (event_count - 1) * sizeof(events[0]));
+        event_count--;
+    }
+}
+#endif  //  GEOFENCE_UPLINK
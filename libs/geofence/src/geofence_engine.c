@@ -0,0 +1,227 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+//  Geofence evaluation engine: grid index, fixed-point circle test and point-in-polygon.
+//  No Mynewt dependencies, so this file may be compiled on the host for benchmarking.
+#include <string.h>
+#include "geofence/geofence_engine.h"
+
+#define GRID_CELLS           (GEOFENCE_GRID_SIZE * GEOFENCE_GRID_SIZE)
+#define E7_PER_100_METRES    8983         //  1e-7 degrees of latitude per 100 metres
+#define E7_90_DEGREES        900000000L
+#define E7_180_DEGREES       1800000000L
+#define COS_TABLE_STEP       (E7_90_DEGREES / 16)  //  5.625 degrees
+
+//  Cosine of latitudes 0 to 90 degrees in steps of 5.625 degrees, in Q15
+static const uint16_t cos_table[17] = {
+    32768, 32610, 32138, 31357, 30274, 28899, 27246, 25330,
+    23170, 20788, 18205, 15447, 12540,  9512,  6393,  3212, 0,
+};
+
+//  Bounding box of a fence, in 1e-7 degrees
+struct bbox {
+    int32_t min_lat, min_lng, max_lat, max_lng;
+};
+
+static int32_t cos_q15(int32_t lat_e7) {
+    //  Return the cosine of the latitude in Q15, by linear interpolation.
+    uint32_t lat = (lat_e7 < 0) ? -(uint32_t) lat_e7 : (uint32_t) lat_e7;
+    if (lat >= E7_90_DEGREES) { return 0; }
+    uint32_t i = lat / COS_TABLE_STEP;
+    int32_t c0 = cos_table[i], c1 = cos_table[i + 1];
+    return c0 - (int32_t) ((int64_t) (c0 - c1) * (lat % COS_TABLE_STEP) / COS_TABLE_STEP);
+}
+
+static int32_t clamp_lng(int64_t lng) {
+    if (lng > E7_180_DEGREES) { return E7_180_DEGREES; }
+    if (lng < -E7_180_DEGREES) { return -E7_180_DEGREES; }
+    return (int32_t) lng;
+}
+
+static int fence_bbox(const struct geofence *fence, struct bbox *box) {
+    //  Compute the bounding box of the fence.  Return 0 if successful, -1 if the fence is invalid.
+    const struct geofence_point *p = fence->points;
+    uint16_t i;
+    if (!p) { return -1; }
+    if (fence->type == GEOFENCE_CIRCLE) {
+        if (fence->count != 1) { return -1; }
+        int64_t r = (int64_t) fence->radius_m * E7_PER_100_METRES / 100;
+        int32_t cos = cos_q15(p->lat_e7);
+        //  Near the poles, the circle may span all longitudes.
+        int64_t r_lng = (cos > 0) ? (r << 15) / cos : 2 * E7_180_DEGREES;
+        box->min_lat = (int32_t) (p->lat_e7 - r);  box->max_lat = (int32_t) (p->lat_e7 + r);
+        box->min_lng = clamp_lng(p->lng_e7 - r_lng);  box->max_lng = clamp_lng(p->lng_e7 + r_lng);
+        return 0;
+    }
+    if (fence->type != GEOFENCE_POLYGON || fence->count < 3) { return -1; }
+    box->min_lat = box->max_lat = p[0].lat_e7;
+    box->min_lng = box->max_lng = p[0].lng_e7;
+    for (i = 1; i < fence->count; i++) {
+        if (p[i].lat_e7 < box->min_lat) { box->min_lat = p[i].lat_e7; }
+        if (p[i].lat_e7 > box->max_lat) { box->max_lat = p[i].lat_e7; }
+        if (p[i].lng_e7 < box->min_lng) { box->min_lng = p[i].lng_e7; }
+        if (p[i].lng_e7 > box->max_lng) { box->max_lng = p[i].lng_e7; }
+    }
+    return 0;
+}
+
+static bool circle_contains(const struct geofence *fence, int32_t lat_e7, int32_t lng_e7) {
+    //  Compare the distance from the centre with the radius.  Longitudes are scaled by the cosine
+    //  of the latitude of the centre, which is accurate for circles up to tens of kilometres.
+    const struct geofence_point *c = fence->points;
+    int64_t r = (int64_t) fence->radius_m * E7_PER_100_METRES / 100;
+    int64_t dy = (int64_t) lat_e7 - c->lat_e7;
+    if (dy > r || dy < -r) { return false; }
+    int64_t dx = (((int64_t) lng_e7 - c->lng_e7) * cos_q15(c->lat_e7)) >> 15;
+    if (dx > r || dx < -r) { return false; }
+    return dx * dx + dy * dy <= r * r;
+}
+
+static bool polygon_contains(const struct geofence *fence, int32_t lat_e7, int32_t lng_e7) {
+    //  Count the edges crossed by a ray from the position towards the east.  Inside if odd.
+    //  The crossing test is done by cross-multiplying instead of dividing: latitude differences fit in 31 bits
+    //  and longitude differences in 32 bits, so the products fit in 64 bits.
+    const struct geofence_point *p = fence->points;
+    bool inside = false;
+    uint16_t i, j;
+    for (i = 0, j = fence->count - 1; i < fence->count; j = i++) {
+        int32_t yi = p[i].lat_e7, yj = p[j].lat_e7;
+        if ((yi > lat_e7) == (yj > lat_e7)) { continue; }  //  Edge doesn't straddle the ray
+        //  Ray crosses the edge if lng < xi + (xj - xi) * (lat - yi) / (yj - yi)
+        int64_t dy  = (int64_t) yj - yi;
+        int64_t lhs = ((int64_t) lng_e7 - p[i].lng_e7) * dy;
+        int64_t rhs = ((int64_t) p[j].lng_e7 - p[i].lng_e7) * ((int64_t) lat_e7 - yi);
+        if ((dy > 0) ? (lhs < rhs) : (lhs > rhs)) { inside = !inside; }
+    }
+    return inside;
+}
+
+bool geofence_contains(const struct geofence *fence, int32_t lat_e7, int32_t lng_e7) {
+    //  Return true if the position is inside the fence.
+    switch (fence->type) {
+        case GEOFENCE_CIRCLE:  return circle_contains(fence, lat_e7, lng_e7);
+        case GEOFENCE_POLYGON: return polygon_contains(fence, lat_e7, lng_e7);
+        default:               return false;
+    }
+}
+
+static void cell_range(const struct geofence_index *index, const struct bbox *box,
+    uint32_t *row0, uint32_t *row1, uint32_t *col0, uint32_t *col1) {
+    //  Return the rows and columns of the grid cells overlapped by the bounding box.
+    *row0 = (uint32_t) ((int64_t) box->min_lat - index->min_lat_e7) / index->cell_lat_e7;
+    *row1 = (uint32_t) ((int64_t) box->max_lat - index->min_lat_e7) / index->cell_lat_e7;
+    *col0 = (uint32_t) ((int64_t) box->min_lng - index->min_lng_e7) / index->cell_lng_e7;
+    *col1 = (uint32_t) ((int64_t) box->max_lng - index->min_lng_e7) / index->cell_lng_e7;
+}
+
+int geofence_index_init(struct geofence_index *index, const struct geofence *fences, uint16_t count,
+    uint16_t *entries, uint16_t max_entries) {
+    //  Build the grid index for the list of fences.  Return the number of entries used, or -1 if error.
+    struct bbox box, all;
+    uint32_t total = 0, row, col, row0, row1, col0, col1;
+    uint16_t f;
+    int c;
+    if (!index || (count > 0 && (!fences || !entries))) { return -1; }
+    memset(index, 0, sizeof(*index));
+    index->fences  = fences;
+    index->count   = count;
+    index->entries = entries;
+    index->cell_lat_e7 = index->cell_lng_e7 = 1;
+    if (count == 0) { return 0; }
+
+    //  Size the grid to cover all fences.
+    for (f = 0; f < count; f++) {
+        if (fence_bbox(&fences[f], &box) != 0) { return -1; }
+        if (f == 0) { all = box; continue; }
+        if (box.min_lat < all.min_lat) { all.min_lat = box.min_lat; }
+        if (box.max_lat > all.max_lat) { all.max_lat = box.max_lat; }
+        if (box.min_lng < all.min_lng) { all.min_lng = box.min_lng; }
+        if (box.max_lng > all.max_lng) { all.max_lng = box.max_lng; }
+    }
+    index->min_lat_e7  = all.min_lat;
+    index->min_lng_e7  = all.min_lng;
+    index->cell_lat_e7 = (uint32_t) (((int64_t) all.max_lat - all.min_lat) / GEOFENCE_GRID_SIZE + 1);
+    index->cell_lng_e7 = (uint32_t) (((int64_t) all.max_lng - all.min_lng) / GEOFENCE_GRID_SIZE + 1);
+
+    //  Count the fences in each cell.
+    for (f = 0; f < count; f++) {
+        fence_bbox(&fences[f], &box);
+        cell_range(index, &box, &row0, &row1, &col0, &col1);
+        total += (row1 - row0 + 1) * (col1 - col0 + 1);
+        if (total > max_entries) { return -1; }
+        for (row = row0; row <= row1; row++) {
+            for (col = col0; col <= col1; col++) { index->cell_start[row * GEOFENCE_GRID_SIZE + col]++; }
+        }
+    }
+    //  Convert the counts to the end of each cell's entries.
+    for (c = 1; c <= GRID_CELLS; c++) { index->cell_start[c] += index->cell_start[c - 1]; }
+
+    //  Fill the entries from the end of each cell, in reverse order so that each cell lists its fences in order.
+    //  Afterwards cell_start[c] is the start of cell c.
+    for (f = count; f-- > 0; ) {
+        fence_bbox(&fences[f], &box);
+        cell_range(index, &box, &row0, &row1, &col0, &col1);
+        for (row = row0; row <= row1; row++) {
+            for (col = col0; col <= col1; col++) { entries[--index->cell_start[row * GEOFENCE_GRID_SIZE + col]] = f; }
+        }
+    }
+    index->cell_start[GRID_CELLS] = (uint16_t) total;
+    return (int) total;
+}
+
+static bool list_contains(const uint16_t *list, uint8_t len, uint16_t f) {
+    uint8_t i;
+    for (i = 0; i < len; i++) { if (list[i] == f) { return true; } }
+    return false;
+}
+
+int geofence_index_update(struct geofence_index *index, int32_t lat_e7, int32_t lng_e7, geofence_func_t func, void *arg) {
+    //  Test the fix against the fences in its grid cell.  Report the transitions since the last fix.
+    uint16_t inside[GEOFENCE_MAX_INSIDE];
+    uint8_t inside_count = 0, i;
+    int64_t row = ((int64_t) lat_e7 - index->min_lat_e7) / index->cell_lat_e7;
+    int64_t col = ((int64_t) lng_e7 - index->min_lng_e7) / index->cell_lng_e7;
+    int transitions = 0;
+
+    //  Fences outside the cell don't contain the fix, because the cell lists all fences that overlap it.
+    if (index->count > 0 && lat_e7 >= index->min_lat_e7 && lng_e7 >= index->min_lng_e7
+        && row < GEOFENCE_GRID_SIZE && col < GEOFENCE_GRID_SIZE) {
+        uint32_t cell = (uint32_t) (row * GEOFENCE_GRID_SIZE + col);
+        uint16_t e;
+        for (e = index->cell_start[cell]; e < index->cell_start[cell + 1]; e++) {
+            uint16_t f = index->entries[e];
+            if (inside_count < GEOFENCE_MAX_INSIDE && geofence_contains(&index->fences[f], lat_e7, lng_e7)) {
+                inside[inside_count++] = f;
+            }
+        }
+    }
+    //  Report the fences we have left, then the fences we have entered.
+    for (i = 0; i < index->inside_count; i++) {
+        if (list_contains(inside, inside_count, index->inside[i])) { continue; }
+        if (func) { func(arg, &index->fences[index->inside[i]], false); }
+        transitions++;
+    }
+    for (i = 0; i < inside_count; i++) {
+        if (list_contains(index->inside, index->inside_count, inside[i])) { continue; }
+        if (func) { func(arg, &index->fences[inside[i]], true); }
+        transitions++;
+    }
+    memcpy(index->inside, inside, inside_count * sizeof(inside[0]));
+    index->inside_count = inside_count;
+    return transitions;
+}
@@ -0,0 +1,165 @@
+//  Test and benchmark the geofence engine with thousands of fences.  Runs on the device or on the host:
+//  gcc -O2 -DTEST_HOST -Iinclude -o test_geofence src/geofence_engine.c test/src/test_geofence.c && ./test_geofence
+#include <assert.h>
+#include <stdio.h>
+#include <time.h>
+#include "geofence/geofence_engine.h"
+
+#define NUM_FENCES   4000
+#define NUM_VERTICES 8
+#define NUM_FIXES    20000
+#define MAX_ENTRIES  30000
+
+static struct geofence fences[NUM_FENCES];
+static struct geofence_point points[NUM_FENCES][NUM_VERTICES];
+static uint16_t entries[MAX_ENTRIES];
+static struct geofence_index fence_index;
+static int32_t fix_lat[NUM_FIXES], fix_lng[NUM_FIXES];
+static uint32_t seed = 1;
+
+static int32_t random_range(int32_t lo, int32_t hi) {
+    //  Return a pseudo-random number between lo and hi inclusive.  Same sequence on every platform.
+    seed = seed * 1103515245 + 12345;
+    return lo + (int32_t) (((uint64_t) (seed >> 1) * (uint32_t) (hi - lo + 1)) >> 31);
+}
+
+static int transitions, entered, left;
+
+static void count_transition(void *arg, const struct geofence *fence, bool in) {
+    (void) arg;  (void) fence;
+    transitions++;
+    if (in) { entered++; } else { left++; }
+}
+
+static void test_shapes(void) {
+    //  Square, concave polygon and circle, checked at known positions.
+    static const struct geofence_point square[] = {
+        { 10000000, 20000000 }, { 10000000, 20100000 }, { 10100000, 20100000 }, { 10100000, 20000000 },
+    };
+    //  L-shape: the north-east quarter of the square is cut out.
+    static const struct geofence_point ell[] = {
+        { 10000000, 20000000 }, { 10000000, 20100000 }, { 10050000, 20100000 },
+        { 10050000, 20050000 }, { 10100000, 20050000 }, { 10100000, 20000000 },
+    };
+    static const struct geofence_point centre[] = { { 500000000, 80000000 } };
+    struct geofence f = { 1, GEOFENCE_POLYGON, 4, 0, square };
+    assert(geofence_contains(&f, 10050000, 20050000));
+    assert(!geofence_contains(&f, 10150000, 20050000));
+    assert(!geofence_contains(&f, 10050000, 19990000));
+    f.count = 6;  f.points = ell;
+    assert(geofence_contains(&f, 10025000, 20075000));   //  South-east arm
+    assert(geofence_contains(&f, 10075000, 20025000));   //  North-west arm
+    assert(!geofence_contains(&f, 10075000, 20075000));  //  Cut-out corner
+    //  Circle of 100 m at 50 degrees north.  1e-7 degrees of longitude is 0.643 of 1e-7 degrees of latitude.
+    f.type = GEOFENCE_CIRCLE;  f.count = 1;  f.radius_m = 100;  f.points = centre;
+    assert(geofence_contains(&f, 500000000 + 95 * 898 / 10, 80000000));
+    assert(!geofence_contains(&f, 500000000 + 105 * 898 / 10, 80000000));
+    assert(geofence_contains(&f, 500000000, 80000000 + 95 * 1397 / 10));
+    assert(!geofence_contains(&f, 500000000, 80000000 + 105 * 1397 / 10));
+}
+
+static void test_transitions(void) {
+    //  Walk through two overlapping circles and check the enter / leave events.
+    static const struct geofence_point c1[] = { { 0, 0 } }, c2[] = { { 0, 20000 } };
+    static const struct geofence two[] = {
+        { 1, GEOFENCE_CIRCLE, 1, 150, c1 },
+        { 2, GEOFENCE_CIRCLE, 1, 150, c2 },
+    };
+    static uint16_t e[GEOFENCE_GRID_SIZE * GEOFENCE_GRID_SIZE * 2];
+    assert(geofence_index_init(&fence_index, two, 2, e, sizeof(e) / sizeof(e[0])) > 0);
+    transitions = entered = left = 0;
+    assert(geofence_index_update(&fence_index, 0, -50000, count_transition, NULL) == 0);  //  Outside both
+    assert(geofence_index_update(&fence_index, 0, -10000, count_transition, NULL) == 1);  //  Enter 1
+    assert(geofence_index_update(&fence_index, 0, 10000, count_transition, NULL) == 1);   //  Enter 2, still in 1
+    assert(geofence_index_update(&fence_index, 0, 30000, count_transition, NULL) == 1);   //  Leave 1
+    assert(geofence_index_update(&fence_index, 0, 90000, count_transition, NULL) == 1);   //  Leave 2, outside the grid
+    assert(entered == 2 && left == 2);
+    assert(geofence_index_init(&fence_index, two, 2, e, 1) == -1);  //  Entries buffer too small
+}
+
+static void make_fences(void) {
+    //  Scatter circles and polygons of 50 m to 500 m over 1 degree square.
+    int f, v;
+    for (f = 0; f < NUM_FENCES; f++) {
+        int32_t lat = random_range(515000000, 525000000), lng = random_range(-5000000, 5000000);
+        int32_t size = random_range(450, 4500);
+        fences[f].id = f;
+        fences[f].points = points[f];
+        if (f % 2 == 0) {
+            fences[f].type = GEOFENCE_CIRCLE;
+            fences[f].count = 1;
+            fences[f].radius_m = size / 9;
+            points[f][0].lat_e7 = lat;  points[f][0].lng_e7 = lng;
+            continue;
+        }
+        //  Star-shaped polygon with vertices at random distances around the centre.
+        static const int8_t dx[NUM_VERTICES] = { 10, 7, 0, -7, -10, -7, 0, 7 };
+        static const int8_t dy[NUM_VERTICES] = { 0, 7, 10, 7, 0, -7, -10, -7 };
+        fences[f].type = GEOFENCE_POLYGON;
+        fences[f].count = NUM_VERTICES;
+        for (v = 0; v < NUM_VERTICES; v++) {
+            int32_t r = random_range(size / 3, size);
+            points[f][v].lat_e7 = lat + dy[v] * r / 10;
+            points[f][v].lng_e7 = lng + dx[v] * r * 16 / 100;  //  Scaled for 52 degrees north
+        }
+    }
+    for (f = 0; f < NUM_FIXES; f++) {
+        fix_lat[f] = random_range(514000000, 526000000);
+        fix_lng[f] = random_range(-5100000, 5100000);
+    }
+}
+
+static void test_index(void) {
+    //  The grid fence_index must report the same fences as testing every fence.
+    int f, i, n, total = 0;
+    int used = geofence_index_init(&fence_index, fences, NUM_FENCES, entries, MAX_ENTRIES);
+    assert(used > 0);
+    for (f = 0; f < NUM_FIXES; f++) {
+        geofence_index_update(&fence_index, fix_lat[f], fix_lng[f], NULL, NULL);
+        for (i = 0, n = 0; i < NUM_FENCES; i++) {
+            if (!geofence_contains(&fences[i], fix_lat[f], fix_lng[f])) { continue; }
+            n++;
+        }
+        if (n > GEOFENCE_MAX_INSIDE) { n = GEOFENCE_MAX_INSIDE; }
+        assert(fence_index.inside_count == n);
+        for (i = 0; i < fence_index.inside_count; i++) {
+            assert(geofence_contains(&fences[fence_index.inside[i]], fix_lat[f], fix_lng[f]));
+        }
+        total += n;
+    }
+    printf("%d fences, %d index entries (%d bytes), %d of %d fixes inside a fence\n",
+        NUM_FENCES, used, (int) (used * sizeof(entries[0]) + sizeof(fence_index)), total, NUM_FIXES);
+}
+
+static void test_speed(void) {
+    //  Time the indexed update against testing every fence.
+    volatile int sum = 0;
+    int f, i;
+    clock_t start = clock();
+    transitions = 0;
+    for (f = 0; f < NUM_FIXES; f++) {
+        geofence_index_update(&fence_index, fix_lat[f], fix_lng[f], count_transition, NULL);
+    }
+    clock_t mid = clock();
+    for (f = 0; f < NUM_FIXES / 10; f++) {
+        for (i = 0; i < NUM_FENCES; i++) { sum = sum + geofence_contains(&fences[i], fix_lat[f], fix_lng[f]); }
+    }
+    clock_t end = clock();
+    printf("indexed: %.2f us/fix, every fence: %.2f us/fix, %d transitions\n",
+        (mid - start) * 1e6 / CLOCKS_PER_SEC / NUM_FIXES,
+        (end - mid) * 1e6 / CLOCKS_PER_SEC / (NUM_FIXES / 10), transitions);
+}
+
+int test_geofence(void) {
+    test_shapes();
+    test_transitions();
+    make_fences();
+    test_index();
+    test_speed();
+    printf("geofence tests OK\n");
+    return 0;
+}
+
+#ifdef TEST_HOST
+int main(void) { return test_geofence(); }
+#endif  //  TEST_HOST
@@ -44,7 +44,7 @@ extern "C" {  //  Expose the types and functions below to C functions.
 
 //  GPS Configuration
 struct gps_l70r_cfg {
-    sensor_type_t bc_s_mask;   //  Sensor data types that will be returned, i.e. Geolocation only
+    sensor_type_t bc_s_mask;   //  Sensor data types that will be returned. Default: Geolocation. Add Satellites and Multi for both in one record
     int uart;                  //  UART port: 0 for UART2, 1 for UART0, 2 for UART3
 };
 
@@ -56,6 +56,17 @@ struct gps_l70r {
     int last_error;           //  Last error encountered
 };
 
+//  GPS power manager statistics.  Average power-on time per fix is on_time_ms / fixes,
+//  average time to fix after wakeup is total_ttff_ms / wakes.
+struct gps_l70r_power_stats {
+    uint32_t on_time_ms;     //  Total time the receiver has been running, excluding standby and periodic sleep
+    uint32_t wakes;          //  Number of times the receiver was woken up to acquire a fix
+    uint32_t fixes;          //  Number of position fixes received while running
+    uint32_t timeouts;       //  Number of wakeups that ended without a fix
+    uint32_t last_ttff_ms;   //  Time to fix after the last wakeup
+    uint32_t total_ttff_ms;  //  Sum of time to fix after all wakeups
+};
+
 //  Start the GPS driver. Return 0 if successful.
 int gps_l70r_start(void);
 
@@ -75,6 +86,9 @@ int gps_l70r_config(struct gps_l70r *drv, struct gps_l70r_cfg *cfg);
 //  Connect to the GPS module.  Return 0 if successful.
 int gps_l70r_connect(struct gps_l70r *dev);  
 
+//  Copy the GPS power manager statistics into stats.  All zero if GPS_L70R_POWER_MANAGER is disabled.
+void gps_l70r_get_power_stats(struct gps_l70r_power_stats *stats);
+
 //  Internal Sensor Functions
 
 //  Configure the GPS driver as a Mynewt Sensor.  Return 0 if successful.
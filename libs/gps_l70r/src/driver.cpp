@@ -25,6 +25,9 @@
 #include <tiny_gps_plus/tiny_gps_plus.h>
 #include <buffered_serial/buffered_serial.h>
 #include "gps_l70r/gps_l70r.h"
+#if MYNEWT_VAL(GPS_L70R_GEOFENCE)
+#include <geofence/geofence.h>
+#endif  //  GPS_L70R_GEOFENCE
 
 /// Set this to 1 so that `power_sleep()` will not sleep when network is busy connecting.  Defined in apps/my_sensor_app/src/power.c
 extern "C" int power_standby_wakeup();
@@ -47,6 +50,11 @@ static void rx_callback(struct os_event *ev);
 static const char *compute_checksum(const uint8_t *buf);
 static char nibble_to_hex(uint8_t n);
 
+#if MYNEWT_VAL(GPS_L70R_POWER_MANAGER)
+static void power_start(struct gps_l70r *dev);
+static void power_fix(void);
+#endif  //  GPS_L70R_POWER_MANAGER
+
 /////////////////////////////////////////////////////////
 //  GPS Commands. Refer to "L70-R Series GPS Protocol Specification"
 
@@ -68,6 +76,11 @@ enum CommandId {
     FIRST_COMMAND = 0,
     EASY_QUERY,
     EASY_ENABLE,
+    SET_NMEA_OUTPUT,
+    SET_FIX_INTERVAL,
+    PERIODIC_MODE,
+    NORMAL_MODE,
+    STANDBY_MODE,
 };
 
 /// List of GPS commands. Exclude the leading "$PMTK" and the trailing "*" and checksum.
@@ -76,6 +89,15 @@ static const char *COMMANDS[] = {
     "",          //  FIRST_COMMAND
     "869,0",     //  EASY_QUERY
     "869,1,%d",  //  EASY_ENABLE: 0 to disable EASY, 1 to enable EASY
+    //  SET_NMEA_OUTPUT: Output rate of each sentence, in position fixes. 0 to disable the sentence.
+    //  Fields: GLL, RMC, VTG, GGA, GSA, GSV, 11 reserved fields, ZDA, MCHN.  We only output RMC and GGA.
+    "314,0,%d,0,%d,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0",
+    "220,%d",    //  SET_FIX_INTERVAL: Position fix interval in milliseconds
+    //  PERIODIC_MODE: Periodic standby mode (type 2) with run time and sleep time in milliseconds,
+    //  followed by the second run time and sleep time that are used when no fix is obtained.
+    "225,2,%d,%d,%d,%d",
+    "225,0",     //  NORMAL_MODE: Leave periodic mode and run continuously
+    "161,0",     //  STANDBY_MODE: Stop searching for satellites until any byte is received on the UART
 };
 
 /////////////////////////////////////////////////////////
@@ -152,19 +174,17 @@ static bool send_command(struct gps_l70r *dev, enum CommandId id) {
     return res;
 }
 
-/*
-///  Send a GPS command with 1 int parameter e.g. `$PMTK869,1,1*35<CR><LF>`
-static bool send_command_int(struct gps_l70r *dev, enum CommandId id, int arg) {
+///  Send a GPS command with int parameters e.g. `$PMTK869,1,1*35<CR><LF>`
+static bool send_command_int(struct gps_l70r *dev, enum CommandId id, int arg1, int arg2 = 0, int arg3 = 0, int arg4 = 0) {
     static char cmd_buf[64];
     assert(dev);
     const char *cmd = get_command(dev, id);
     assert(cmd);  assert(strlen(cmd) + 16 < sizeof(cmd_buf));
-    sprintf(cmd_buf, cmd, arg);
+    sprintf(cmd_buf, cmd, arg1, arg2, arg3, arg4);  //  Extra args are ignored by sprintf()
     bool res = send_raw_command(dev, cmd_buf);
-    console_flush();
+    // console_flush();
     return res;
 }
-*/
 
 static const char *compute_checksum(const uint8_t *buf) {
     //  Return a string with 2 hex digits, that is the exclusive OR of all bytes in buf (excluding leading "$").
@@ -288,6 +308,10 @@ int gps_l70r_start(void) {
             int rc = gps_l70r_connect(dev);
             assert(rc == 0);
         }
+#if MYNEWT_VAL(GPS_L70R_POWER_MANAGER)
+        //  Duty cycle the receiver according to fix age and motion.
+        power_start(dev);
+#endif  //  GPS_L70R_POWER_MANAGER
 
         //  Close the GPS_L70R device when we are done.
         os_dev_close((struct os_dev *) dev);
@@ -305,7 +329,12 @@ int gps_l70r_connect(struct gps_l70r *dev) {
     serial.prime();  //  Start transmitting and receiving on UART port
     serial.write("\r\n\r\n", 4);
     send_command(dev, EASY_QUERY);  //  Get EASY status
-    ////send_command_int(dev, EASY_ENABLE, 1);  //  Enable EASY to accelerate TTFF by predicting satellite navigation messages from received ephemeris
+    //  Output only the sentences needed by the sensor, to reduce UART traffic and parsing.
+    send_command_int(dev, SET_NMEA_OUTPUT, MYNEWT_VAL(GPS_L70R_NMEA_RMC_RATE), MYNEWT_VAL(GPS_L70R_NMEA_GGA_RATE));
+    send_command_int(dev, SET_FIX_INTERVAL, MYNEWT_VAL(GPS_L70R_FIX_INTERVAL));
+#if MYNEWT_VAL(GPS_L70R_EASY_ENABLE)
+    send_command_int(dev, EASY_ENABLE, 1);  //  Enable EASY to accelerate TTFF by predicting satellite navigation messages from received ephemeris
+#endif  //  GPS_L70R_EASY_ENABLE
     return 0;
 }
 
@@ -323,6 +352,18 @@ static void rx_callback(struct os_event *ev) {
         // if (ch != '\r') { char buf[1]; buf[0] = (char) ch; console_buffer(buf, 1); } ////
         // if (ch == '\n') { console_flush(); } ////
     }
+#if MYNEWT_VAL(GPS_L70R_GEOFENCE)
+    //  Check each new fix against the geofences.
+    static uint32_t geofence_fix_count = 0;
+    if (gps_parser.sentencesWithFix() != geofence_fix_count && gps_parser.location.isValid()) {
+        geofence_fix_count = gps_parser.sentencesWithFix();
+        geofence_check_fix(gps_parser.location.latE7(), gps_parser.location.lngE7());
+    }
+#endif  //  GPS_L70R_GEOFENCE
+#if MYNEWT_VAL(GPS_L70R_POWER_MANAGER)
+    //  Let the power manager decide what to do after each new position fix.
+    power_fix();
+#endif  //  GPS_L70R_POWER_MANAGER
 /*
     if (gps_parser.location.isUpdated()) {
         console_printf("*** lat: "); console_printdouble(gps_parser.location.lat());
@@ -341,6 +382,141 @@ static void rx_callback(struct os_event *ev) {
     }
 }
 
+/////////////////////////////////////////////////////////
+//  Power Manager
+
+#if MYNEWT_VAL(GPS_L70R_POWER_MANAGER)
+//  The receiver is woken up to acquire a fix.  After the fix, if we have moved more than GPS_L70R_MOTION_DISTANCE
+//  since the previous fix, the receiver duty cycles itself in periodic mode so that the fixes keep coming.
+//  If we are stationary, the receiver goes to standby and the UART RX is stopped until the fix is
+//  GPS_L70R_FIX_MAX_AGE old.  EASY (when enabled) keeps the ephemeris fresh across standby, so the next fix is quick.
+
+/// Power states of the receiver
+enum PowerState {
+    POWER_ACQUIRING,  //  Running continuously, waiting for a fix after wakeup
+    POWER_PERIODIC,   //  Moving: Receiver alternates between run and sleep by itself (PMTK225)
+    POWER_STANDBY,    //  Stationary: Receiver in standby (PMTK161), UART RX stopped
+};
+
+#define PERIODIC_RUN_TIME   MYNEWT_VAL(GPS_L70R_PERIODIC_RUN_TIME)
+#define PERIODIC_SLEEP_TIME MYNEWT_VAL(GPS_L70R_PERIODIC_SLEEP_TIME)
+
+static struct gps_l70r *power_dev;            //  Device for sending commands
+static struct os_callout power_callout;       //  Fires for wakeup and for wakeup timeout
+static enum PowerState power_state;           //  Current power state
+static os_time_t power_state_time;            //  Time when on-time was last accounted
+static os_time_t wake_time;                   //  Time of the last wakeup
+static uint32_t last_fix_count;               //  Number of sentences with fix, at the last check
+static int32_t last_lat_e7, last_lng_e7;      //  Position of the previous fix, in 1e-7 degrees
+static bool has_last_fix;                     //  True if last_lat_e7 and last_lng_e7 are valid
+static struct gps_l70r_power_stats power_stats;
+
+static void power_account(void) {
+    //  Add the time since the last accounting to the on-time.  In periodic mode the receiver
+    //  is only running for the run time in every cycle.
+    os_time_t now = os_time_get();
+    uint32_t elapsed_ms = os_time_ticks_to_ms32(now - power_state_time);
+    power_state_time = now;
+    switch (power_state) {
+        case POWER_ACQUIRING: power_stats.on_time_ms += elapsed_ms; break;
+        case POWER_PERIODIC:
+            power_stats.on_time_ms += (uint32_t) ((uint64_t) elapsed_ms * PERIODIC_RUN_TIME
+                / (PERIODIC_RUN_TIME + PERIODIC_SLEEP_TIME));
+            break;
+        case POWER_STANDBY: break;
+    }
+}
+
+static void power_wake(void) {
+    //  Wake up the receiver to acquire a new fix.  Any byte received by the receiver ends the standby.
+    power_account();
+    serial.start_rx();
+    send_command(power_dev, NORMAL_MODE);
+    power_state = POWER_ACQUIRING;
+    wake_time = os_time_get();
+    power_stats.wakes++;
+    os_callout_reset(&power_callout, os_time_ms_to_ticks32(MYNEWT_VAL(GPS_L70R_WAKE_TIMEOUT)));
+}
+
+static void power_standby(void) {
+    //  Put the receiver in standby and stop the UART RX until the fix is too old.
+    power_account();
+    if (power_state == POWER_PERIODIC) { send_command(power_dev, NORMAL_MODE); }
+    send_command(power_dev, STANDBY_MODE);
+    serial.stop_rx();
+    power_state = POWER_STANDBY;
+    os_callout_reset(&power_callout, os_time_ms_to_ticks32(MYNEWT_VAL(GPS_L70R_FIX_MAX_AGE)));
+}
+
+static void power_periodic(void) {
+    //  Let the receiver duty cycle itself while we are moving.  If it fails to get a fix,
+    //  it runs for the wakeup timeout and sleeps for the maximum fix age before trying again.
+    power_account();
+    send_command_int(power_dev, PERIODIC_MODE, PERIODIC_RUN_TIME, PERIODIC_SLEEP_TIME,
+        MYNEWT_VAL(GPS_L70R_WAKE_TIMEOUT), MYNEWT_VAL(GPS_L70R_FIX_MAX_AGE));
+    power_state = POWER_PERIODIC;
+    os_callout_stop(&power_callout);
+}
+
+static void power_callback(struct os_event *ev) {
+    //  Callout that is invoked when the fix is too old (in standby) or the wakeup has timed out (acquiring).
+    if (power_state == POWER_STANDBY) { power_wake(); return; }
+    if (power_state == POWER_ACQUIRING) {
+        console_printf("GPS no fix after %ld ms\n", (long) MYNEWT_VAL(GPS_L70R_WAKE_TIMEOUT));
+        power_stats.timeouts++;
+        power_standby();
+    }
+}
+
+static void power_start(struct gps_l70r *dev) {
+    //  Start the power manager.  The receiver is already running after gps_l70r_connect().
+    power_dev = dev;
+    os_callout_init(&power_callout, os_eventq_dflt_get(), power_callback, NULL);
+    power_state = POWER_ACQUIRING;
+    power_state_time = wake_time = os_time_get();
+    power_stats.wakes++;
+    os_callout_reset(&power_callout, os_time_ms_to_ticks32(MYNEWT_VAL(GPS_L70R_WAKE_TIMEOUT)));
+}
+
+static void power_fix(void) {
+    //  Called after parsing received data.  If there is a new position fix, choose the next power state.
+    uint32_t fix_count = gps_parser.sentencesWithFix();
+    if (fix_count == last_fix_count || !gps_parser.location.isValid()) { return; }
+    last_fix_count = fix_count;
+    if (power_state == POWER_STANDBY) { return; }  //  Sentence received before standby
+    power_stats.fixes++;
+    if (power_state == POWER_ACQUIRING) {
+        //  Record the time to fix after wakeup.
+        uint32_t ttff_ms = os_time_ticks_to_ms32(os_time_get() - wake_time);
+        power_stats.last_ttff_ms = ttff_ms;
+        power_stats.total_ttff_ms += ttff_ms;
+        console_printf("GPS fix in %ld ms\n", (long) ttff_ms);
+    }
+    //  Compare with the previous fix to see whether we are moving.
+    int32_t lat_e7 = gps_parser.location.latE7();
+    int32_t lng_e7 = gps_parser.location.lngE7();
+    bool moving = !has_last_fix ||
+        TinyGPSPlus::distanceBetweenE7(last_lat_e7, last_lng_e7, lat_e7, lng_e7) > MYNEWT_VAL(GPS_L70R_MOTION_DISTANCE);
+    last_lat_e7 = lat_e7;  last_lng_e7 = lng_e7;  has_last_fix = true;
+    if (!moving) { power_standby(); }
+    else if (power_state != POWER_PERIODIC) { power_periodic(); }
+}
+
+void gps_l70r_get_power_stats(struct gps_l70r_power_stats *stats) {
+    //  Copy the power manager statistics into stats.  On-time includes the time until now.
+    assert(stats);
+    if (power_dev) { power_account(); }
+    *stats = power_stats;
+}
+
+#else   //  !GPS_L70R_POWER_MANAGER
+void gps_l70r_get_power_stats(struct gps_l70r_power_stats *stats) {
+    //  Without the power manager the receiver is never duty cycled, so there are no statistics.
+    assert(stats);
+    memset(stats, 0, sizeof(*stats));
+}
+#endif  //  GPS_L70R_POWER_MANAGER
+
 /// Given n=0..15, return '0'..'F'.
 static char nibble_to_hex(uint8_t n) {
     return (n < 10)
@@ -53,7 +53,11 @@ int gps_l70r_sensor_init(struct gps_l70r *dev, void *arg) {
     if (rc != 0) { goto err; }
 
     //  Add the driver with all the supported sensor data types.
-    rc = sensor_set_driver(sensor, SENSOR_TYPE_GEOLOCATION,
+    sensor_type_t types = (sensor_type_t) (SENSOR_TYPE_GEOLOCATION | SENSOR_TYPE_GPS_SATELLITES);
+#if MYNEWT_VAL(SENSOR_MULTI_READ)  //  If multi-value records are enabled...
+    types = (sensor_type_t) (types | SENSOR_TYPE_MULTI);
+#endif  //  MYNEWT_VAL(SENSOR_MULTI_READ)
+    rc = sensor_set_driver(sensor, types,
         (struct sensor_driver *) &g_gps_l70r_sensor_driver);
     if (rc != 0) { goto err; }
 
@@ -73,29 +77,59 @@ err:
 static int gps_l70r_sensor_read(struct sensor *sensor, sensor_type_t type,
     sensor_data_func_t data_func, void *data_arg, uint32_t timeout) {
     //  Read the sensor values depending on the sensor types specified in the sensor config.
-    union {  //  Union that represents all possible sensor values.
-        struct sensor_geolocation_data sgd;  //  Geolocation sensor data
-    } databuf;
-    struct sensor_geolocation_data *sensor_data = &databuf.sgd;  //  Sensor data will be passed through this
+    //  If a multi-value record is requested, all requested values are passed to the Listener Function in one call.
+    struct sensor_geolocation_data geo_data;  //  Geolocation sensor data
+    struct sensor_satellites_data  sat_data;  //  Satellites sensor data
     int rc = 0;
 
-    //  We only allow reading of geolocation
-    if (!(type & SENSOR_TYPE_GEOLOCATION)) { rc = SYS_EINVAL; goto err; }
+    //  We only allow reading of geolocation and satellites
+    if (!(type & (SENSOR_TYPE_GEOLOCATION | SENSOR_TYPE_GPS_SATELLITES))) { rc = SYS_EINVAL; goto err; }
 
     //  Save the GPS geolocation based on the parsed NMEA data
-    memset(sensor_data, 0, sizeof(struct sensor_geolocation_data));  //  Init all fields to 0
-    if (gps_parser.location.isValid()) {  //  If we have parsed a valid latitude / longtude
-        sensor_data->sgd_latitude           = gps_parser.location.lat();
-        sensor_data->sgd_longitude          = gps_parser.location.lng();
-        sensor_data->sgd_latitude_is_valid  = 1;
-        sensor_data->sgd_longitude_is_valid = 1;
+    memset(&geo_data, 0, sizeof(geo_data));  //  Init all fields to 0
+    if (type & SENSOR_TYPE_GEOLOCATION) {
+        if (gps_parser.location.isValid()) {  //  If we have parsed a valid latitude / longtude
+            geo_data.sgd_latitude_e7        = gps_parser.location.latE7();  //  No floating-point needed
+            geo_data.sgd_longitude_e7       = gps_parser.location.lngE7();
+            geo_data.sgd_latitude_is_valid  = 1;
+            geo_data.sgd_longitude_is_valid = 1;
+        }
+        if (gps_parser.altitude.isValid()) {  //  If we have parsed a valid altitude
+            geo_data.sgd_altitude_cm        = gps_parser.altitude.value();  //  Altitude is parsed in centimetres
+            geo_data.sgd_altitude_is_valid  = 1;
+        }
     }
-    if (gps_parser.altitude.isValid()) {  //  If we have parsed a valid altitude
-        sensor_data->sgd_altitude           = gps_parser.altitude.meters();
-        sensor_data->sgd_altitude_is_valid  = 1;
+    //  Save the satellites and HDOP based on the parsed NMEA data
+    memset(&sat_data, 0, sizeof(sat_data));  //  Init all fields to 0
+    if (type & SENSOR_TYPE_GPS_SATELLITES) {
+        if (gps_parser.satellites.isValid()) {  //  If we have parsed the number of satellites
+            sat_data.ssd_satellites          = gps_parser.satellites.value();
+            sat_data.ssd_satellites_is_valid = 1;
+        }
+        if (gps_parser.hdop.isValid()) {  //  If we have parsed the HDOP
+            sat_data.ssd_hdop                = gps_parser.hdop.value();
+            sat_data.ssd_hdop_is_valid       = 1;
+        }
     }
-    if (data_func) {  //  Call the Listener Function to process the sensor data.
-        rc = data_func(sensor, data_arg, sensor_data, SENSOR_TYPE_GEOLOCATION);
+    if (!data_func) { return 0; }  //  No Listener Function to call.
+
+    if (SENSOR_MULTI_REQUESTED(type)) {
+        //  Call the Listener Function once with all the requested values.
+        struct sensor_multi_data multi_data;
+        sensor_multi_init(&multi_data);
+        if (type & SENSOR_TYPE_GEOLOCATION)    { sensor_multi_add(&multi_data, SENSOR_TYPE_GEOLOCATION, &geo_data); }
+        if (type & SENSOR_TYPE_GPS_SATELLITES) { sensor_multi_add(&multi_data, SENSOR_TYPE_GPS_SATELLITES, &sat_data); }
+        rc = data_func(sensor, data_arg, &multi_data, SENSOR_TYPE_MULTI);
+        if (rc) { goto err; }
+        return 0;
+    }
+    //  Call the Listener Function for each sensor type to process the sensor data.
+    if (type & SENSOR_TYPE_GEOLOCATION) {
+        rc = data_func(sensor, data_arg, &geo_data, SENSOR_TYPE_GEOLOCATION);
+        if (rc) { goto err; }
+    }
+    if (type & SENSOR_TYPE_GPS_SATELLITES) {
+        rc = data_func(sensor, data_arg, &sat_data, SENSOR_TYPE_GPS_SATELLITES);
         if (rc) { goto err; }
     }
     return 0;
@@ -107,11 +141,14 @@ static int gps_l70r_sensor_get_config(struct sensor *sensor, sensor_type_t type,
     struct sensor_cfg *cfg) {
     //  Return the type of the sensor value returned by the sensor.
     int rc;
-    if (!(type & SENSOR_TYPE_GEOLOCATION)) {
+    if (type & SENSOR_TYPE_GEOLOCATION) {
+        cfg->sc_valtype = SENSOR_VALUE_TYPE_INT32_TRIPLET;  //  We return 3 fixed-point integers: latitude, longitude, altitude
+    } else if (type & SENSOR_TYPE_GPS_SATELLITES) {
+        cfg->sc_valtype = SENSOR_VALUE_TYPE_INT32;  //  We return integers: satellites, HDOP
+    } else {
         rc = SYS_EINVAL;
         goto err;
     }
-    cfg->sc_valtype = SENSOR_VALUE_TYPE_FLOAT_TRIPLET;  //  We return 3 floats: latitude, longitude, altitude
     return (0);
 err:
     return (rc);
@@ -119,7 +156,9 @@ err:
 
 int gps_l70r_sensor_default_cfg(struct gps_l70r_cfg *cfg) {
     //  Copy the default sensor config into cfg.  Returns 0.
-    cfg->bc_s_mask = SENSOR_TYPE_ALL;  //  Return all sensor values
+    //  Return geolocation only, as before satellites were added.  SENSOR_TYPE_ALL would also dispatch satellites
+    //  to listeners that expect geolocation.  Add SENSOR_TYPE_GPS_SATELLITES to the mask to poll both.
+    cfg->bc_s_mask = SENSOR_TYPE_GEOLOCATION;
     return 0;
 }
 
@@ -0,0 +1,132 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+//  Mynewt Sensor Driver for the HRS3300 heart rate sensor on PineTime, connected to I2C port 1.
+//  A timer samples the PPG channel at 25 Hz through the I2C queue, without waiting.  Each second, the batch of
+//  samples runs through the fixed-point pipeline in hrs3300_ppg.c and the heart rate is reported as
+//  SENSOR_TYPE_HEART_RATE.  The raw samples are not reported.
+#ifndef __HRS3300_H__
+#define __HRS3300_H__
+
+#include "os/mynewt.h"
+#include "hal/hal_timer.h"
+#include "sensor/sensor.h"
+#include "i2c_queue/i2c_queue.h"
+#include "custom_sensor/custom_sensor.h"  //  For SENSOR_TYPE_HEART_RATE
+#include "hrs3300/hrs3300_ppg.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//  Registers, from the HRS3300 datasheet
+#define HRS3300_REG_ID          0x00  //  Device ID, HRS3300_ID
+#define HRS3300_REG_ENABLE      0x01  //  HRS enable, wait time between conversions, LED drive bit 1
+#define HRS3300_REG_C1DATAM     0x08  //  First of the data registers 0x08 to 0x0F, read in one transaction
+#define HRS3300_REG_PDRIVER     0x0C  //  LED drive bit 0, power on
+#define HRS3300_REG_RES         0x16  //  ADC resolution of the HRS and ALS channels
+#define HRS3300_REG_HGAIN       0x17  //  HRS gain
+
+#define HRS3300_ID              0x21
+#define HRS3300_DATA_SIZE       8     //  Bytes in the data registers 0x08 to 0x0F
+
+//  Size of the sample buffer between the I2C Task and the Sensor Manager.  Must be a power of 2.
+#define HRS3300_BUFFER_SIZE     64
+
+//  Configuration for the HRS3300
+struct hrs3300_cfg {
+    sensor_type_t bc_s_mask;    //  Sensor data types that will be returned, i.e. heart rate
+    uint16_t batch;             //  Samples per batch, i.e. heart rate reported every batch / 25 seconds
+    uint8_t min_confidence;     //  Heart rate is valid if the confidence is at least this, 0 to 100
+};
+
+//  Device for the HRS3300
+struct hrs3300 {
+    struct os_dev dev;          //  Mynewt device
+    struct sensor sensor;       //  Mynewt sensor
+    struct hrs3300_cfg cfg;     //  Sensor configuration
+    struct i2c_txn reg_txn;     //  I2C transaction for configuring the registers
+    struct i2c_txn sample_txn;  //  I2C transaction for sampling, submitted by the timer
+    struct hal_timer timer;     //  Timer that starts each sample
+    uint32_t next_tick;         //  Time of the next sample, in os_cputime ticks
+    uint32_t period_ticks;      //  Time between samples, in os_cputime ticks
+    uint8_t reg_buf[2];         //  Register number and value to be written
+    uint8_t sample_reg;         //  Register number for sampling
+    uint8_t sample_buf[HRS3300_DATA_SIZE];  //  Data registers read by the sampling transaction
+    uint32_t buffer[HRS3300_BUFFER_SIZE];   //  Samples from the I2C Task, waiting to be processed
+    volatile uint16_t head;     //  Next sample to be written by the I2C Task
+    volatile uint16_t tail;     //  Next sample to be processed
+    uint32_t overruns;          //  Samples dropped because the I2C bus or the buffer was busy
+    struct hrs3300_ppg ppg;     //  PPG pipeline
+    uint8_t running;            //  1 if sampling
+};
+
+/**
+ * Create the HRS3300 instance.  Implemented in creator.c, function DEVICE_CREATE().
+ */
+void hrs3300_create(void);
+
+/**
+ * Return the default configuration for the HRS3300, from syscfg.yml.
+ *
+ * @param cfg  Pointer to the hrs3300_cfg device config
+ *
+ * @return 0 on success, and non-zero error code on failure
+ */
+int hrs3300_default_cfg(struct hrs3300_cfg *cfg);
+
+/**
+ * Initialize the HRS3300 driver.  The HRS3300 is configured by hrs3300_config().
+ *
+ * @param dev  Pointer to the hrs3300 device descriptor
+ * @param arg  Pointer to the sensor_itf: I2C port and address
+ *
+ * @return 0 on success, and non-zero error code on failure
+ */
+int hrs3300_init(struct os_dev *dev, void *arg);
+
+/**
+ * Configure the HRS3300, with the LED off and sampling stopped.  Called by hrs3300_create() at startup.
+ *
+ * @param Sensor device hrs3300 structure
+ * @param Sensor device hrs3300_cfg config
+ *
+ * @return 0 on success, and non-zero error code on failure
+ */
+int hrs3300_config(struct hrs3300 *dev, struct hrs3300_cfg *cfg);
+
+/**
+ * Switch on the LED and start sampling.  The pipeline starts again from the first sample.  Called by the app
+ * while it needs the heart rate, e.g. when the heart rate screen is shown.  Stop with hrs3300_stop().
+ *
+ * @return 0 on success, and non-zero error code on failure
+ */
+int hrs3300_start(struct hrs3300 *dev);
+
+/**
+ * Stop sampling and switch off the LED to save power.
+ *
+ * @return 0 on success, and non-zero error code on failure
+ */
+int hrs3300_stop(struct hrs3300 *dev);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HRS3300_H__ */
@@ -0,0 +1,95 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+//  Fixed-point PPG pipeline for the HRS3300 heart rate sensor: band-pass filter, peak detection and heart rate
+//  estimate with confidence.  Integers only, so it runs without floating-point.  No Mynewt dependencies,
+//  so this file may be compiled on the host and validated against PPG traces.
+#ifndef __HRS3300_PPG_H__
+#define __HRS3300_PPG_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HRS3300_PPG_RATE_HZ      25   //  Sample rate.  The filter coefficients are computed for this rate.
+#define HRS3300_PPG_MIN_BPM      30   //  Slowest heart rate detected
+#define HRS3300_PPG_MAX_BPM      220  //  Fastest heart rate detected
+#define HRS3300_PPG_INTERVALS    8    //  Beat intervals used for the estimate
+#define HRS3300_PPG_SETTLE       HRS3300_PPG_RATE_HZ  //  Samples to settle the filter before detecting peaks
+#define HRS3300_PPG_MIN_AMPLITUDE 16  //  Min pulse amplitude in raw units.  Below this, there is no skin contact.
+
+//  Second-order section in Direct Form I.  Samples are in Q8 raw units, coefficients in Q28.
+struct hrs3300_biquad {
+    int32_t x1, x2;  //  Previous inputs
+    int32_t y1, y2;  //  Previous outputs
+    int32_t err;     //  Rounding error of the last output, fed back into the next output
+};
+
+//  State of the pipeline
+struct hrs3300_ppg {
+    struct hrs3300_biquad hp;   //  High-pass at 0.5 Hz: removes the DC level and baseline wander
+    struct hrs3300_biquad lp;   //  Low-pass at 4 Hz: removes noise above 240 BPM
+    uint8_t started;            //  1 after the first sample has been filtered
+    uint32_t n;                 //  Samples processed
+    int32_t v1, v2;             //  Previous two filtered samples, inverted so that each heart beat is a peak
+    int32_t envelope;           //  Decaying peak amplitude of the filtered signal, in Q8 raw units
+    int32_t beat_level;         //  Average height of the recent beats in Q8 raw units, 0 if unknown
+    uint32_t last_peak;         //  Time of the last peak in Q8 samples, including artifacts
+    uint8_t has_peak;           //  1 if last_peak is a beat, so the next beat completes an interval
+    uint8_t rejects;            //  Number of consecutive peaks rejected as motion artifacts
+    uint32_t intervals[HRS3300_PPG_INTERVALS];  //  Latest beat intervals in Q8 samples
+    uint8_t interval_count;     //  Number of valid intervals, up to HRS3300_PPG_INTERVALS
+    uint8_t interval_next;      //  Index of the next interval to be replaced
+};
+
+//  Heart rate estimate
+struct hrs3300_estimate {
+    uint16_t bpm;         //  Heart rate in beats per minute, 0 if unknown
+    uint8_t confidence;   //  0 to 100: percentage of the recent beat intervals that agree with the estimate
+};
+
+/**
+ * Reset the pipeline.
+ */
+void hrs3300_ppg_init(struct hrs3300_ppg *ppg);
+
+/**
+ * Filter one raw sample through the band-pass filter.  Return the filtered sample in Q8 raw units.
+ */
+int32_t hrs3300_ppg_filter(struct hrs3300_ppg *ppg, uint32_t raw);
+
+/**
+ * Filter the raw samples and detect the heart beats.
+ *
+ * @return Number of heart beats detected
+ */
+int hrs3300_ppg_process(struct hrs3300_ppg *ppg, const uint32_t *samples, uint16_t count);
+
+/**
+ * Estimate the heart rate from the median of the recent beat intervals.  The confidence is 0 if the
+ * pulse is too weak, e.g. the watch is not worn.
+ */
+void hrs3300_ppg_estimate(const struct hrs3300_ppg *ppg, struct hrs3300_estimate *est);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  //  __HRS3300_PPG_H__
@@ -0,0 +1,286 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+//  Mynewt Sensor Driver for the HRS3300: sensor API, sampling timer and I2C access through the I2C queue.
+//  The signal processing is in hrs3300_ppg.c.
+#include <string.h>
+#include "os/mynewt.h"
+#include "os/os_cputime.h"
+#include "console/console.h"
+#include "sensor/sensor.h"
+#include "hrs3300/hrs3300.h"
+
+#define ENABLE_HEN        0x80  //  Enable the heart rate sensor
+#define ENABLE_WAIT_12MS  0x60  //  Wait 12.5 ms between conversions
+#define PDRIVER_ON        0x6F  //  LED drive 20 mA, power on
+#define PDRIVER_OFF       0x4F  //  Power off
+#define RES_16_BITS       0x88  //  16-bit ADC for the HRS and ALS channels
+#define HGAIN_64X         0x10  //  HRS gain 64x
+
+//  Exports for the sensor API
+static int hrs3300_sensor_read(struct sensor *, sensor_type_t, sensor_data_func_t, void *, uint32_t);
+static int hrs3300_sensor_get_config(struct sensor *, sensor_type_t, struct sensor_cfg *);
+static int hrs3300_sensor_handle_interrupt(struct sensor *);
+
+//  Global instance of the sensor driver
+static const struct sensor_driver g_hrs3300_sensor_driver = {
+    .sd_read             = hrs3300_sensor_read,
+    .sd_get_config       = hrs3300_sensor_get_config,
+    .sd_handle_interrupt = hrs3300_sensor_handle_interrupt,
+};
+
+///////////////////////////////////////////////////////////////////////////////
+//  Register Access through the I2C Queue
+
+static int write_reg(struct hrs3300 *dev, uint8_t reg, uint8_t value) {
+    //  Write the register and wait for the I2C Task.
+    struct sensor_itf *itf = SENSOR_GET_ITF(&dev->sensor);
+    dev->reg_buf[0] = reg;
+    dev->reg_buf[1] = value;
+    i2c_txn_init(&dev->reg_txn, itf->si_num, itf->si_addr, dev->reg_buf, 2, NULL, 0);
+    return i2c_queue_transfer(&dev->reg_txn);
+}
+
+static int read_reg(struct hrs3300 *dev, uint8_t reg, uint8_t *value) {
+    //  Read the register and wait for the I2C Task.
+    struct sensor_itf *itf = SENSOR_GET_ITF(&dev->sensor);
+    dev->reg_buf[0] = reg;
+    i2c_txn_init(&dev->reg_txn, itf->si_num, itf->si_addr, dev->reg_buf, 1, value, 1);
+    return i2c_queue_transfer(&dev->reg_txn);
+}
+
+static uint32_t decode_hrs(const uint8_t *data) {
+    //  HRS channel is scattered across C0DATAM (0x09), C0DATAH (0x0A) and C0DATAL (0x0F).
+    uint8_t m = data[0x09 - HRS3300_REG_C1DATAM];
+    uint8_t h = data[0x0A - HRS3300_REG_C1DATAM];
+    uint8_t l = data[0x0F - HRS3300_REG_C1DATAM];
+    return (m << 8) | ((h & 0x0F) << 4) | (l & 0x0F) | ((uint32_t) (l & 0x30) << 12);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Sampling
+
+static void sample_timer_cb(void *arg) {
+    //  Called in the timer interrupt at 25 Hz.  Start reading the sample without waiting.
+    struct hrs3300 *dev = arg;
+    if (!dev->running) { return; }
+    dev->next_tick += dev->period_ticks;  //  Schedule from the last tick, so that the rate doesn't drift
+    os_cputime_timer_start(&dev->timer, dev->next_tick);
+    if (i2c_queue_submit(&dev->sample_txn) != 0) { dev->overruns++; }  //  Previous sample still on the bus
+}
+
+static void sample_done(struct i2c_txn *txn, void *arg) {
+    //  Called in the I2C Task when the sample has been read.  Buffer it, and process a complete batch
+    //  in the Sensor Manager task.
+    struct hrs3300 *dev = arg;
+    uint16_t count = dev->head - dev->tail;
+    if (txn->rc != 0 || count >= HRS3300_BUFFER_SIZE) { dev->overruns++; return; }
+    dev->buffer[dev->head & (HRS3300_BUFFER_SIZE - 1)] = decode_hrs(dev->sample_buf);
+    dev->head++;
+    if (count + 1 == dev->cfg.batch) { sensor_mgr_put_interrupt_evt(&dev->sensor); }
+}
+
+int hrs3300_start(struct hrs3300 *dev) {
+    int rc;
+    rc = write_reg(dev, HRS3300_REG_ENABLE, ENABLE_HEN | ENABLE_WAIT_12MS);  if (rc) { goto err; }
+    rc = write_reg(dev, HRS3300_REG_PDRIVER, PDRIVER_ON);  if (rc) { goto err; }
+
+    //  Start the pipeline from scratch, then sample at the pipeline rate.
+    hrs3300_ppg_init(&dev->ppg);
+    dev->tail = dev->head;
+    dev->period_ticks = os_cputime_usecs_to_ticks(1000000 / HRS3300_PPG_RATE_HZ);
+    dev->next_tick = os_cputime_get32() + dev->period_ticks;
+    dev->running = 1;
+    os_cputime_timer_start(&dev->timer, dev->next_tick);
+    return 0;
+err:
+    return rc;
+}
+
+int hrs3300_stop(struct hrs3300 *dev) {
+    int rc;
+    dev->running = 0;
+    os_cputime_timer_stop(&dev->timer);
+    rc = write_reg(dev, HRS3300_REG_ENABLE, ENABLE_WAIT_12MS);  if (rc) { goto err; }
+    rc = write_reg(dev, HRS3300_REG_PDRIVER, PDRIVER_OFF);  if (rc) { goto err; }
+    return 0;
+err:
+    return rc;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Device Functions
+
+int hrs3300_default_cfg(struct hrs3300_cfg *cfg) {
+    //  Return the default sensor configuration.
+    memset(cfg, 0, sizeof(struct hrs3300_cfg));  //  Zero the entire object.
+    cfg->bc_s_mask      = SENSOR_TYPE_HEART_RATE;  //  Return heart rate only.
+    cfg->batch          = MYNEWT_VAL(HRS3300_BATCH);
+    cfg->min_confidence = MYNEWT_VAL(HRS3300_MIN_CONFIDENCE);
+    return 0;
+}
+
+static int hrs3300_open(struct os_dev *dev0, uint32_t timeout, void *arg) {
+    //  Nothing to open, the I2C port is shared through the I2C queue.  Return 0 if successful.
+    return 0;
+}
+
+static int hrs3300_close(struct os_dev *dev0) {
+    //  Close the sensor.  Return 0 if successful.
+    return 0;
+}
+
+/**
+ * Expects to be called back through os_dev_create().
+ *
+ * @param The device object associated with hrs3300
+ * @param Argument passed to OS device init: the sensor_itf
+ *
+ * @return 0 on success, non-zero error on failure.
+ */
+int hrs3300_init(struct os_dev *dev0, void *arg) {
+    struct hrs3300 *dev;
+    struct sensor *sensor;
+    int rc;
+    if (!arg || !dev0) { rc = SYS_ENODEV; goto err; }
+    dev = (struct hrs3300 *) dev0;
+
+    //  Get the default config.
+    rc = hrs3300_default_cfg(&dev->cfg);
+    if (rc) { goto err; }
+
+    //  Init the sensor.
+    sensor = &dev->sensor;
+    rc = sensor_init(sensor, dev0);
+    if (rc != 0) { goto err; }
+
+    //  Add the driver with all the supported sensor data types.
+    rc = sensor_set_driver(sensor, SENSOR_TYPE_HEART_RATE,
+        (struct sensor_driver *) &g_hrs3300_sensor_driver);
+    if (rc != 0) { goto err; }
+
+    //  Set the interface.
+    rc = sensor_set_interface(sensor, arg);
+    if (rc) { goto err; }
+
+    //  Register with the Sensor Manager.
+    rc = sensor_mgr_register(sensor);
+    if (rc != 0) { goto err; }
+
+    //  Set the handlers for opening and closing the device.
+    OS_DEV_SETHANDLERS(dev0, hrs3300_open, hrs3300_close);
+    return (0);
+err:
+    return (rc);
+}
+
+/**
+ * Configure the HRS3300, with the LED off and sampling stopped.  hrs3300_start() starts measuring.
+ *
+ * @param Sensor device hrs3300 structure
+ * @param Sensor device hrs3300_cfg config
+ *
+ * @return 0 on success, and non-zero error code on failure
+ */
+int hrs3300_config(struct hrs3300 *dev, struct hrs3300_cfg *cfg) {
+    struct sensor_itf *itf;
+    uint8_t id;
+    int rc;
+    itf = SENSOR_GET_ITF(&(dev->sensor)); assert(itf);
+    if (cfg->batch == 0 || cfg->batch > HRS3300_BUFFER_SIZE) { rc = SYS_EINVAL; goto err; }
+    rc = sensor_set_type_mask(&(dev->sensor), cfg->bc_s_mask);
+    if (rc) { goto err; }
+    dev->cfg = *cfg;
+
+    rc = read_reg(dev, HRS3300_REG_ID, &id);
+    if (rc) { goto err; }
+    if (id != HRS3300_ID) { console_printf("HRS bad id %02x\n", id); rc = SYS_ENODEV; goto err; }
+    rc = write_reg(dev, HRS3300_REG_RES, RES_16_BITS);  if (rc) { goto err; }
+    rc = write_reg(dev, HRS3300_REG_HGAIN, HGAIN_64X);  if (rc) { goto err; }
+
+    //  Each sample reads the data registers 0x08 to 0x0F in one I2C transaction.
+    dev->sample_reg = HRS3300_REG_C1DATAM;
+    i2c_txn_init(&dev->sample_txn, itf->si_num, itf->si_addr,
+        &dev->sample_reg, 1, dev->sample_buf, HRS3300_DATA_SIZE);
+    dev->sample_txn.cb = sample_done;
+    dev->sample_txn.cb_arg = dev;
+    os_cputime_timer_init(&dev->timer, sample_timer_cb, dev);
+
+    //  Called at startup, so keep the LED off until the app measures the heart rate.
+    return hrs3300_stop(dev);
+err:
+    return (rc);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Sensor API
+
+static int hrs3300_sensor_read(struct sensor *sensor, sensor_type_t type,
+    sensor_data_func_t data_func, void *data_arg, uint32_t timeout) {
+    //  Process the buffered samples and report the heart rate.
+    struct sensor_heart_rate_data shr;
+    struct hrs3300_estimate est;
+    struct hrs3300 *dev;
+    uint16_t head, start, len;
+    int rc;
+
+    if (!(type & SENSOR_TYPE_HEART_RATE)) { rc = SYS_EINVAL; goto err; }
+    dev = (struct hrs3300 *) SENSOR_GET_DEVICE(sensor); assert(dev);
+
+    //  Process the samples where they are in the buffer, in up to 2 contiguous runs.
+    head = dev->head;
+    while (dev->tail != head) {
+        start = dev->tail & (HRS3300_BUFFER_SIZE - 1);
+        len = head - dev->tail;
+        if (len > HRS3300_BUFFER_SIZE - start) { len = HRS3300_BUFFER_SIZE - start; }
+        hrs3300_ppg_process(&dev->ppg, &dev->buffer[start], len);
+        dev->tail += len;
+    }
+
+    hrs3300_ppg_estimate(&dev->ppg, &est);
+    shr.shr_bpm                 = est.bpm;
+    shr.shr_confidence          = est.confidence;
+    shr.shr_bpm_is_valid        = (est.bpm > 0 && est.confidence >= dev->cfg.min_confidence) ? 1 : 0;
+    shr.shr_confidence_is_valid = 1;
+    if (data_func) {  //  Call the Listener Function to process the sensor data.
+        rc = data_func(sensor, data_arg, &shr, SENSOR_TYPE_HEART_RATE);
+        if (rc) { goto err; }
+    }
+    return 0;
+err:
+    return rc;
+}
+
+static int hrs3300_sensor_handle_interrupt(struct sensor *sensor) {
+    //  Called by the Sensor Manager when a batch is complete.  Pass the heart rate to the listeners.
+    return sensor_read(sensor, SENSOR_TYPE_HEART_RATE, NULL, NULL, OS_TIMEOUT_NEVER);
+}
+
+static int hrs3300_sensor_get_config(struct sensor *sensor, sensor_type_t type,
+    struct sensor_cfg *cfg) {
+    //  Return the type of the sensor value returned by the sensor.
+    int rc;
+    if (!(type & SENSOR_TYPE_HEART_RATE)) {
+        rc = SYS_EINVAL;
+        goto err;
+    }
+    cfg->sc_valtype = SENSOR_VALUE_TYPE_INT32;  //  Beats per minute
+    return (0);
+err:
+    return (rc);
+}
@@ -0,0 +1,159 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+//  Fixed-point PPG pipeline for the HRS3300.  No Mynewt dependencies, so this file may be compiled on the host
+//  and validated against PPG traces.
+#include <string.h>
+#include "hrs3300/hrs3300_ppg.h"
+
+#define COEF_SHIFT   28                 //  Coefficients are in Q28
+#define SAMPLE_SHIFT 8                  //  Samples are filtered in Q8 raw units
+#define Q8_PER_MINUTE (60 * HRS3300_PPG_RATE_HZ * 256)              //  Q8 samples per minute
+#define MIN_GAP      (Q8_PER_MINUTE / HRS3300_PPG_MAX_BPM)          //  Shortest beat interval in Q8 samples
+#define MAX_GAP      (Q8_PER_MINUTE / HRS3300_PPG_MIN_BPM)          //  Longest beat interval in Q8 samples
+#define ENVELOPE_DECAY 6                //  Envelope decays by 1/64 per sample: time constant of 2.6 seconds
+#define ARTIFACT_PEAKS 4                //  Consecutive high peaks accepted as the new beat height
+
+//  Second-order Butterworth sections for 25 Hz, computed with the bilinear transform.  Each is b0, b1, b2, a1, a2 in Q28.
+//  b1 of the high-pass is exactly -2 * b0, so that the DC gain is exactly 0.
+static const int32_t hp_coef[5] = { 245610159, -491220318, 245610159, -489275943, 224729238 };  //  0.5 Hz high-pass
+static const int32_t lp_coef[5] = {  39010083,   78020166,  39010083, -180128000,  67732876 };  //  4 Hz low-pass
+
+static int32_t biquad(struct hrs3300_biquad *s, const int32_t *c, int32_t x) {
+    //  Direct Form I with 64-bit accumulator.  The rounding error is fed back, otherwise the high-pass
+    //  gets stuck at a small DC offset because its poles are close to 1.
+    int64_t acc = (int64_t) c[0] * x + (int64_t) c[1] * s->x1 + (int64_t) c[2] * s->x2
+        - (int64_t) c[3] * s->y1 - (int64_t) c[4] * s->y2 + s->err;
+    int32_t y = (int32_t) (acc >> COEF_SHIFT);
+    s->err = (int32_t) (acc - ((int64_t) y << COEF_SHIFT));
+    s->x2 = s->x1;  s->x1 = x;
+    s->y2 = s->y1;  s->y1 = y;
+    return y;
+}
+
+void hrs3300_ppg_init(struct hrs3300_ppg *ppg) {
+    memset(ppg, 0, sizeof(struct hrs3300_ppg));
+}
+
+int32_t hrs3300_ppg_filter(struct hrs3300_ppg *ppg, uint32_t raw) {
+    int32_t x = (int32_t) (raw << SAMPLE_SHIFT);
+    if (!ppg->started) {
+        //  Start the high-pass in steady state at the first sample, so that the DC level doesn't ring through.
+        ppg->hp.x1 = ppg->hp.x2 = x;
+        ppg->started = 1;
+    }
+    return biquad(&ppg->lp, lp_coef, biquad(&ppg->hp, hp_coef, x));
+}
+
+static void add_interval(struct hrs3300_ppg *ppg, uint32_t interval) {
+    ppg->intervals[ppg->interval_next] = interval;
+    ppg->interval_next = (ppg->interval_next + 1) % HRS3300_PPG_INTERVALS;
+    if (ppg->interval_count < HRS3300_PPG_INTERVALS) { ppg->interval_count++; }
+}
+
+static int detect_peak(struct hrs3300_ppg *ppg, int32_t v) {
+    //  The previous sample v1 is a beat if it's a local max above half the height of the recent beats.
+    //  Return 1 if a beat was detected.
+    int32_t v1 = ppg->v1, v2 = ppg->v2, denom;
+    int32_t threshold = (ppg->beat_level ? ppg->beat_level : ppg->envelope) / 2;
+    int32_t offset = 0;
+    uint32_t t, interval;
+    if (ppg->n < HRS3300_PPG_SETTLE) { return 0; }
+    if (ppg->envelope < (HRS3300_PPG_MIN_AMPLITUDE << SAMPLE_SHIFT)) { return 0; }
+    if (!(v1 > v2 && v1 >= v && v1 > threshold)) { return 0; }
+
+    //  Locate the peak between samples by fitting a parabola through the 3 samples.
+    denom = v2 - 2 * v1 + v;
+    if (denom < 0) {
+        offset = (int32_t) ((int64_t) (v2 - v) * 128 / denom);
+        if (offset > 128) { offset = 128; }
+        if (offset < -128) { offset = -128; }
+    }
+    t = (ppg->n - 1) * 256 + offset;
+    interval = t - ppg->last_peak;
+    if (ppg->has_peak && interval < MIN_GAP) { return 0; }  //  Too soon after the last beat, e.g. the dicrotic notch
+
+    //  Peaks much higher than the recent beats are motion artifacts.  They break the chain of intervals,
+    //  unless they persist, e.g. the sensor was moved to a better position.
+    if (ppg->beat_level && v1 > 2 * ppg->beat_level && ++ppg->rejects < ARTIFACT_PEAKS) {
+        ppg->last_peak = t;
+        ppg->has_peak = 0;
+        return 0;
+    }
+    if (ppg->rejects >= ARTIFACT_PEAKS) { ppg->beat_level = v1; }
+    ppg->rejects = 0;
+    ppg->beat_level = ppg->beat_level ? ppg->beat_level + (v1 - ppg->beat_level) / 8 : v1;
+
+    ppg->last_peak = t;
+    if (!ppg->has_peak || interval > MAX_GAP) {
+        //  First beat, or beats were missed.  Start again from this beat.
+        ppg->has_peak = 1;
+        return 1;
+    }
+    add_interval(ppg, interval);
+    return 1;
+}
+
+int hrs3300_ppg_process(struct hrs3300_ppg *ppg, const uint32_t *samples, uint16_t count) {
+    int beats = 0;
+    uint16_t i;
+    for (i = 0; i < count; i++) {
+        //  Blood absorbs the light, so the raw signal dips at each beat.  Invert it so that each beat is a peak.
+        int32_t v = -hrs3300_ppg_filter(ppg, samples[i]);
+        ppg->envelope -= ppg->envelope >> ENVELOPE_DECAY;
+        if (v > ppg->envelope) { ppg->envelope = v; }
+        beats += detect_peak(ppg, v);
+        if (ppg->n * 256 - ppg->last_peak > MAX_GAP) {
+            //  No beats for a while, e.g. the beats are below the threshold after motion.  Forget the beat height.
+            ppg->beat_level = 0;
+            ppg->has_peak = 0;
+        }
+        ppg->v2 = ppg->v1;
+        ppg->v1 = v;
+        ppg->n++;
+    }
+    return beats;
+}
+
+void hrs3300_ppg_estimate(const struct hrs3300_ppg *ppg, struct hrs3300_estimate *est) {
+    uint32_t sorted[HRS3300_PPG_INTERVALS], median, tolerance;
+    int count = ppg->interval_count, agree = 0, i, j;
+    est->bpm = 0;
+    est->confidence = 0;
+    if (count == 0) { return; }
+
+    //  Median of the intervals, by insertion sort.
+    for (i = 0; i < count; i++) {
+        uint32_t interval = ppg->intervals[i];
+        for (j = i; j > 0 && sorted[j - 1] > interval; j--) { sorted[j] = sorted[j - 1]; }
+        sorted[j] = interval;
+    }
+    median = (count & 1) ? sorted[count / 2] : (sorted[count / 2 - 1] + sorted[count / 2]) / 2;
+    est->bpm = (Q8_PER_MINUTE + median / 2) / median;
+
+    //  Confidence is the percentage of a full set of intervals within 12.5% of the median.
+    //  Without skin contact, or if the beats have stopped, there is no confidence.
+    if (ppg->envelope < (HRS3300_PPG_MIN_AMPLITUDE << SAMPLE_SHIFT)) { return; }
+    if (ppg->n * 256 - ppg->last_peak > MAX_GAP) { return; }
+    tolerance = median / 8;
+    for (i = 0; i < count; i++) {
+        uint32_t interval = ppg->intervals[i];
+        if (interval + tolerance >= median && interval <= median + tolerance) { agree++; }
+    }
+    est->confidence = agree * 100 / HRS3300_PPG_INTERVALS;
+}
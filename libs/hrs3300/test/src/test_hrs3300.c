@@ -0,0 +1,234 @@
+//  Validate the accuracy and cost of the HRS3300 PPG pipeline on the host.  Runs on the device or on the host:
+//  gcc -O2 -DTEST_HOST -Iinclude -o test_hrs3300 src/hrs3300_ppg.c test/src/test_hrs3300.c -lm && ./test_hrs3300
+//  To validate against a recorded trace (one raw sample per line at 25 Hz) with the reference heart rate,
+//  failing if the mean absolute error is above 5 BPM or the given limit:
+//  ./test_hrs3300 trace.csv 72 [max_mae]
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "hrs3300/hrs3300_ppg.h"
+
+#define RATE         HRS3300_PPG_RATE_HZ
+#define TRACE_SECS   120
+#define TRACE_LEN    (TRACE_SECS * RATE)
+#define WARMUP_SECS  10  //  Seconds before the estimate is scored
+#define MAX_TRACE    (3600 * RATE)
+#define MAX_RECORDED_MAE 5.0  //  Default limit for the mean absolute error of a recorded trace in BPM
+
+static uint32_t seed = 1;
+
+static double random_uniform(void) {
+    //  Return a pseudo-random number between 0 and 1.  Same sequence on every platform.
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 1) / 2147483648.0;
+}
+
+static double random_noise(void) {
+    //  Return approximately Gaussian noise with standard deviation 1.
+    return (random_uniform() + random_uniform() + random_uniform() + random_uniform() - 2.0) * 1.732;
+}
+
+//  Synthetic trace: heart rate ramps from bpm_start to bpm_end, with breathing, noise and motion artifacts
+struct trace_spec {
+    const char *name;
+    double bpm_start, bpm_end;
+    double pulse;     //  Pulse amplitude in raw units
+    double noise;     //  Noise standard deviation in raw units
+    int motion;       //  1 for a burst of motion artifacts every 20 seconds
+    double min_confidence;  //  Min average confidence expected, or negative if no valid estimate is expected
+};
+
+static const struct trace_spec specs[] = {
+    { "resting",     62,  62, 400,  10, 0,  80 },
+    { "noisy",       75,  75, 300,  40, 0,  60 },
+    { "exercise",   150, 150, 250,  20, 0,  70 },
+    { "ramp",        70, 130, 350,  20, 0,  60 },
+    { "slow",        42,  42, 400,  15, 0,  70 },
+    { "motion",      80,  80, 350,  20, 1,  40 },
+    { "not worn",     0,   0,   0,   5, 0,  -1 },
+};
+
+static uint32_t trace[MAX_TRACE];
+static double reference[MAX_TRACE];
+
+static double pulse_shape(double phase) {
+    //  One heart beat: systolic peak followed by a smaller dicrotic wave.
+    double s = (phase - 0.2) / 0.08, d = (phase - 0.5) / 0.1;
+    return exp(-s * s) + 0.35 * exp(-d * d);
+}
+
+static void make_trace(const struct trace_spec *spec) {
+    double phase = 0;
+    int i;
+    for (i = 0; i < TRACE_LEN; i++) {
+        double t = (double) i / RATE;
+        double bpm = spec->bpm_start + (spec->bpm_end - spec->bpm_start) * i / TRACE_LEN;
+        double raw = 40000;
+        if (spec->pulse > 0) {
+            //  Breathing and slow drift of the baseline, only when worn
+            raw += 300 * sin(2 * M_PI * 0.25 * t) + 200 * sin(2 * M_PI * 0.02 * t);
+        }
+        raw -= spec->pulse * pulse_shape(phase) + spec->noise * random_noise();
+        if (spec->motion && fmod(t, 20) > 17) { raw += 1500 * sin(2 * M_PI * 1.7 * t) * random_uniform(); }
+        phase = fmod(phase + bpm / 60 / RATE, 1.0);
+        trace[i] = (uint32_t) raw;
+        reference[i] = bpm;
+    }
+}
+
+struct score {
+    double mae;         //  Mean absolute error of the valid estimates in BPM
+    double confidence;  //  Average confidence
+    int estimates, within_5;
+};
+
+static struct score run_trace(int len) {
+    //  Feed the trace in batches of one second, like the driver, and score the estimate after each batch.
+    struct hrs3300_ppg ppg;
+    struct hrs3300_estimate est;
+    struct score sc = { 0, 0, 0, 0 };
+    double error = 0, confidence = 0;
+    int i, batches = 0;
+    hrs3300_ppg_init(&ppg);
+    for (i = 0; i + RATE <= len; i += RATE) {
+        hrs3300_ppg_process(&ppg, trace + i, RATE);
+        if (i < WARMUP_SECS * RATE) { continue; }
+        hrs3300_ppg_estimate(&ppg, &est);
+        batches++;
+        confidence += est.confidence;
+        if (est.confidence < 50) { continue; }
+        double e = fabs(est.bpm - reference[i + RATE - 1]);
+        error += e;
+        sc.estimates++;
+        if (e <= 5) { sc.within_5++; }
+    }
+    sc.mae = sc.estimates ? error / sc.estimates : 0;
+    sc.confidence = batches ? confidence / batches : 0;
+    return sc;
+}
+
+static void test_filter(void) {
+    //  The filter rejects DC and passes the heart rate band.
+    struct hrs3300_ppg ppg;
+    int32_t y = 0, peak;
+    int i;
+    hrs3300_ppg_init(&ppg);
+    for (i = 0; i < 200; i++) { y = hrs3300_ppg_filter(&ppg, 50000); }
+    assert(y == 0);  //  Steady state from the first sample
+    for (i = 0; i < 500; i++) { y = hrs3300_ppg_filter(&ppg, 60000); }
+    assert(abs(y) < 2);  //  Step settles back to 0
+    //  Gain at 1.5 Hz (90 BPM) is close to 1, below 0.15 at 0.05 Hz (baseline drift) and 8 Hz (noise)
+    double freqs[3] = { 1.5, 0.05, 8 };
+    int f;
+    for (f = 0; f < 3; f++) {
+        hrs3300_ppg_init(&ppg);
+        peak = 0;
+        for (i = 0; i < 100 * RATE; i++) {
+            y = hrs3300_ppg_filter(&ppg, (uint32_t) (40000 + 1000 * sin(2 * M_PI * freqs[f] * i / RATE)));
+            if (i > 60 * RATE && abs(y) > peak) { peak = abs(y); }
+        }
+        double gain = peak / 256.0 / 1000;
+        if (f == 0) { assert(gain > 0.9 && gain < 1.1); } else { assert(gain < 0.15); }
+    }
+}
+
+static void test_traces(void) {
+    //  Accuracy of the estimate on synthetic traces with known heart rate.
+    unsigned s;
+    for (s = 0; s < sizeof(specs) / sizeof(specs[0]); s++) {
+        const struct trace_spec *spec = &specs[s];
+        make_trace(spec);
+        struct score sc = run_trace(TRACE_LEN);
+        printf("%-10s %3.0f-%3.0f BPM: MAE %.1f BPM, %d of %d estimates within 5 BPM, confidence %.0f\n",
+            spec->name, spec->bpm_start, spec->bpm_end, sc.mae, sc.within_5, sc.estimates, sc.confidence);
+        fflush(stdout);
+        if (spec->min_confidence < 0) {
+            assert(sc.estimates == 0);
+            continue;
+        }
+        assert(sc.confidence >= spec->min_confidence);
+        assert(sc.estimates > 0 && sc.mae < 3);
+        assert(sc.within_5 * 10 >= sc.estimates * 9);
+    }
+}
+
+static void test_cost(void) {
+    //  Time the filter and the whole pipeline per sample.
+    struct hrs3300_ppg ppg;
+    volatile int32_t sink = 0;
+    int i, r, repeats = 200;
+    make_trace(&specs[0]);
+    clock_t start = clock();
+    for (r = 0; r < repeats; r++) {
+        hrs3300_ppg_init(&ppg);
+        for (i = 0; i < TRACE_LEN; i++) { sink = sink + hrs3300_ppg_filter(&ppg, trace[i]); }
+    }
+    clock_t mid = clock();
+    for (r = 0; r < repeats; r++) {
+        hrs3300_ppg_init(&ppg);
+        hrs3300_ppg_process(&ppg, trace, TRACE_LEN);
+    }
+    clock_t end = clock();
+    double samples = (double) repeats * TRACE_LEN;
+    printf("filter: %.1f ns/sample (10 multiply-accumulates), pipeline: %.1f ns/sample\n",
+        (mid - start) * 1e9 / CLOCKS_PER_SEC / samples, (end - mid) * 1e9 / CLOCKS_PER_SEC / samples);
+}
+
+#ifdef TEST_HOST
+static int test_recorded(const char *path, double bpm, double max_mae) {
+    //  Score a recorded trace against the reference heart rate.  Return 1 if there is no valid estimate
+    //  or the mean absolute error is above max_mae.
+    FILE *f = fopen(path, "r");
+    unsigned long raw;
+    int len = 0, i;
+    if (!f) { perror(path); return 1; }
+    while (len < MAX_TRACE && fscanf(f, "%lu%*[^\n]", &raw) == 1) { trace[len++] = (uint32_t) raw; }
+    fclose(f);
+    for (i = 0; i < len; i++) { reference[i] = bpm; }
+    struct score sc = run_trace(len);
+    printf("%s: %d samples, MAE %.1f BPM, %d of %d estimates within 5 BPM, confidence %.0f\n",
+        path, len, sc.mae, sc.within_5, sc.estimates, sc.confidence);
+    if (sc.estimates == 0 || sc.mae > max_mae) {
+        printf("%s: FAILED, MAE limit %.1f BPM\n", path, max_mae);
+        return 1;
+    }
+    return 0;
+}
+
+static void test_recorded_file(void) {
+    //  Check the trace file format and the MAE limit.  No recorded trace is included, so the file is
+    //  written from a synthetic trace: this checks the scoring, not the accuracy on real recordings.
+    char path[] = "/tmp/test_hrs3300_XXXXXX";
+    FILE *f = fdopen(mkstemp(path), "w");
+    int i;
+    assert(f);
+    make_trace(&specs[1]);  //  Noisy, 75 BPM
+    for (i = 0; i < TRACE_LEN; i++) { fprintf(f, "%u,%d\n", (unsigned) trace[i], i); }
+    fclose(f);
+    assert(test_recorded(path, 75, MAX_RECORDED_MAE) == 0);
+    assert(test_recorded(path, 90, MAX_RECORDED_MAE) == 1);  //  Wrong reference heart rate
+    remove(path);
+}
+#endif  //  TEST_HOST
+
+int test_hrs3300(void) {
+    test_filter();
+    test_traces();
+    test_cost();
+#ifdef TEST_HOST
+    test_recorded_file();
+#endif  //  TEST_HOST
+    printf("hrs3300 tests OK\n");
+    return 0;
+}
+
+#ifdef TEST_HOST
+int main(int argc, char **argv) {
+    if (argc == 3 || argc == 4) {
+        return test_recorded(argv[1], atof(argv[2]), argc == 4 ? atof(argv[3]) : MAX_RECORDED_MAE);
+    }
+    return test_hrs3300();
+}
+#endif  //  TEST_HOST
@@ -0,0 +1,100 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+//  Non-blocking I2C transaction queue.  Callers submit transactions without waiting, from tasks or interrupt handlers.
+//  The I2C Task executes the transactions one at a time, so devices on the same bus don't interfere, then completes each
+//  transaction through a callback or by posting an event to the caller's event queue.
+#ifndef __I2C_QUEUE_H__
+#define __I2C_QUEUE_H__
+
+#include "os/mynewt.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct i2c_txn;
+
+//  Function called in the I2C Task when a transaction is complete.  txn->rc is 0 if successful, else the HAL I2C error.
+//  The transaction may be submitted again from the callback.
+typedef void (*i2c_txn_cb_t)(struct i2c_txn *txn, void *arg);
+
+//  I2C transaction: write write_len bytes, then read read_len bytes after a repeated start.  Either length may be 0.
+//  Buffers must remain valid until the transaction is complete.
+struct i2c_txn {
+    struct os_event ev;           //  Internal: event posted to the I2C Task
+    uint8_t i2c_num;              //  I2C interface number, e.g. 1
+    uint8_t address;              //  7-bit I2C address
+    uint16_t write_len;           //  Number of bytes to write, e.g. the register number
+    uint16_t read_len;            //  Number of bytes to read
+    uint16_t timeout_ms;          //  Timeout for each of the write and the read
+    const uint8_t *write_buf;     //  Bytes to write
+    uint8_t *read_buf;            //  Buffer for the bytes read
+    i2c_txn_cb_t cb;              //  If not NULL, called when complete
+    void *cb_arg;                 //  Argument for the callback
+    struct os_eventq *done_evq;   //  If not NULL, done_ev is posted to this event queue when complete
+    struct os_event *done_ev;     //  Event to be posted, with ev_arg pointing to anything, e.g. the transaction
+    int rc;                       //  Result: 0 if successful, else the HAL I2C error
+    volatile uint8_t busy;        //  1 while the transaction is queued or executing
+};
+
+/**
+ * Set up a write-then-read transaction.  The completion callback and event are cleared.
+ *
+ * @param txn The transaction
+ * @param i2c_num I2C interface number
+ * @param address 7-bit I2C address
+ * @param write_buf Bytes to write, e.g. the register number.  NULL if write_len is 0.
+ * @param write_len Number of bytes to write
+ * @param read_buf Buffer for the bytes read.  NULL if read_len is 0.
+ * @param read_len Number of bytes to read
+ */
+void i2c_txn_init(struct i2c_txn *txn, uint8_t i2c_num, uint8_t address,
+    const uint8_t *write_buf, uint16_t write_len, uint8_t *read_buf, uint16_t read_len);
+
+/**
+ * Submit the transaction to the I2C Task without waiting.  May be called from an interrupt handler.
+ *
+ * @param txn The transaction, not already queued or executing
+ *
+ * @return 0 on success, SYS_EBUSY if the transaction is queued or executing, SYS_EINVAL if invalid
+ */
+int i2c_queue_submit(struct i2c_txn *txn);
+
+/**
+ * Submit the transaction and wait until it is complete.  Must not be called from the I2C Task or an interrupt handler.
+ * The callback of the transaction is replaced.
+ *
+ * @param txn The transaction, not already queued or executing
+ *
+ * @return 0 on success, SYS_ETIMEOUT if the I2C Task didn't start the transaction in time (the transaction is removed
+ *         from the queue), else the submit error or HAL I2C error.  The transaction is never busy when this returns,
+ *         so it may be set up and submitted again.
+ */
+int i2c_queue_transfer(struct i2c_txn *txn);
+
+/**
+ * Start the I2C Task.  Called by sysinit() during startup.
+ */
+void i2c_queue_init(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  //  __I2C_QUEUE_H__
@@ -0,0 +1,162 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+//  Non-blocking I2C transaction queue.  Transactions are posted as events to the I2C Event Queue.  The I2C Task
+//  executes each transaction with the blocking HAL I2C functions, so only the I2C Task waits for the bus.
+//  A write-then-read transaction writes without a stop condition, then reads after a repeated start.
+#include <assert.h>
+#include <string.h>
+#include "os/mynewt.h"
+#include "hal/hal_i2c.h"
+#include "i2c_queue/i2c_queue.h"
+
+#define I2C_QUEUE_STACK_SIZE OS_STACK_ALIGN(MYNEWT_VAL(I2C_QUEUE_STACK_SIZE))
+
+static struct os_eventq i2c_evq;   //  Transactions waiting for the I2C Task
+static struct os_task i2c_task;    //  I2C Task
+static os_stack_t i2c_task_stack[I2C_QUEUE_STACK_SIZE];
+
+static void i2c_task_func(void *arg);
+static void i2c_txn_execute(struct os_event *ev);
+static void i2c_txn_release(struct i2c_txn *txn, void *arg);
+
+void i2c_txn_init(struct i2c_txn *txn, uint8_t i2c_num, uint8_t address,
+    const uint8_t *write_buf, uint16_t write_len, uint8_t *read_buf, uint16_t read_len) {
+    //  Set up a write-then-read transaction.
+    assert(txn);  assert(!txn->busy);
+    memset(txn, 0, sizeof(*txn));
+    txn->i2c_num    = i2c_num;
+    txn->address    = address;
+    txn->write_buf  = write_buf;
+    txn->write_len  = write_len;
+    txn->read_buf   = read_buf;
+    txn->read_len   = read_len;
+    txn->timeout_ms = 100;
+}
+
+int i2c_queue_submit(struct i2c_txn *txn) {
+    //  Submit the transaction to the I2C Task without waiting.  Return 0 if successful.
+    os_sr_t sr;
+    assert(txn);
+    if (txn->write_len + txn->read_len == 0) { return SYS_EINVAL; }
+    if ((txn->write_len && !txn->write_buf) || (txn->read_len && !txn->read_buf)) { return SYS_EINVAL; }
+    OS_ENTER_CRITICAL(sr);
+    if (txn->busy) { OS_EXIT_CRITICAL(sr); return SYS_EBUSY; }
+    txn->busy = 1;
+    OS_EXIT_CRITICAL(sr);
+
+    txn->ev.ev_cb  = i2c_txn_execute;
+    txn->ev.ev_arg = txn;
+    txn->rc = 0;
+    os_eventq_put(&i2c_evq, &txn->ev);
+    return 0;
+}
+
+int i2c_queue_transfer(struct i2c_txn *txn) {
+    //  Submit the transaction and wait until it is complete.  Return 0 if successful.
+    struct os_sem sem;
+    os_time_t ticks;
+    os_sr_t sr;
+    int rc, queued;
+    assert(os_sched_get_current_task() != &i2c_task);
+    rc = os_sem_init(&sem, 0);
+    if (rc) { return rc; }
+    txn->cb     = i2c_txn_release;
+    txn->cb_arg = &sem;
+    rc = i2c_queue_submit(txn);
+    if (rc) { return rc; }
+
+    //  Wait for both the write and the read to time out, plus the transactions queued before this one.
+    os_time_ms_to_ticks(4 * (uint32_t) txn->timeout_ms, &ticks);
+    rc = os_sem_pend(&sem, ticks);
+    if (rc == OS_TIMEOUT) {
+        //  If still queued, cancel the transaction so that it may be set up and submitted again.
+        OS_ENTER_CRITICAL(sr);
+        queued = txn->busy && txn->ev.ev_queued;
+        if (queued) {
+            os_eventq_remove(&i2c_evq, &txn->ev);
+            txn->rc   = SYS_ETIMEOUT;
+            txn->busy = 0;
+        }
+        OS_EXIT_CRITICAL(sr);
+        if (queued) { return SYS_ETIMEOUT; }
+        //  Else the I2C Task is executing it, and the HAL times out the write and the read.  Wait for the callback.
+        os_sem_pend(&sem, OS_TIMEOUT_NEVER);
+    }
+    return txn->rc;
+}
+
+void i2c_queue_init(void) {
+    //  Start the I2C Task.
+    int rc;
+    os_eventq_init(&i2c_evq);
+    rc = os_task_init(&i2c_task, "i2c", i2c_task_func, NULL,
+        MYNEWT_VAL(I2C_QUEUE_TASK_PRIO), OS_WAIT_FOREVER,
+        i2c_task_stack, I2C_QUEUE_STACK_SIZE);
+    assert(rc == 0);
+}
+
+static void i2c_task_func(void *arg) {
+    //  Execute the transactions one at a time.  When there are no transactions, block until one arrives.
+    for (;;) {
+        os_eventq_run(&i2c_evq);
+    }
+}
+
+static void i2c_txn_execute(struct os_event *ev) {
+    //  Execute the transaction in the I2C Task, then complete it through the callback and the event.
+    struct i2c_txn *txn = (struct i2c_txn *) ev->ev_arg;
+    struct hal_i2c_master_data data;
+    struct os_eventq *done_evq;
+    struct os_event *done_ev;
+    i2c_txn_cb_t cb;
+    void *cb_arg;
+    os_sr_t sr;
+    int rc = 0;
+    assert(txn);
+
+    //  Write without a stop condition if a read follows.
+    if (txn->write_len) {
+        data.address = txn->address;
+        data.len     = txn->write_len;
+        data.buffer  = (uint8_t *) txn->write_buf;
+        rc = hal_i2c_master_write(txn->i2c_num, &data, txn->timeout_ms, txn->read_len ? 0 : 1);
+    }
+    //  Read after a repeated start, then stop.
+    if (rc == 0 && txn->read_len) {
+        data.address = txn->address;
+        data.len     = txn->read_len;
+        data.buffer  = txn->read_buf;
+        rc = hal_i2c_master_read(txn->i2c_num, &data, txn->timeout_ms, 1);
+    }
+    txn->rc = rc;
+
+    //  Copy the completion before releasing the transaction, because the callback may submit it again.
+    OS_ENTER_CRITICAL(sr);
+    cb = txn->cb;  cb_arg = txn->cb_arg;
+    done_evq = txn->done_evq;  done_ev = txn->done_ev;
+    txn->busy = 0;
+    OS_EXIT_CRITICAL(sr);
+    if (cb) { cb(txn, cb_arg); }
+    if (done_evq && done_ev) { os_eventq_put(done_evq, done_ev); }
+}
+
+static void i2c_txn_release(struct i2c_txn *txn, void *arg) {
+    //  Callback for i2c_queue_transfer(): wake up the waiting task.
+    os_sem_release((struct os_sem *) arg);
+}
@@ -0,0 +1,16 @@
+//  Simulated HAL I2C for testing i2c_queue on the host, see test/src/test_i2c_queue.c
+#ifndef __I2C_QUEUE_TEST_HAL_I2C_H__
+#define __I2C_QUEUE_TEST_HAL_I2C_H__
+
+#include <stdint.h>
+
+struct hal_i2c_master_data {
+    uint8_t address;
+    uint16_t len;
+    uint8_t *buffer;
+};
+
+int hal_i2c_master_write(uint8_t i2c_num, struct hal_i2c_master_data *pdata, uint32_t timeout, uint8_t last_op);
+int hal_i2c_master_read(uint8_t i2c_num, struct hal_i2c_master_data *pdata, uint32_t timeout, uint8_t last_op);
+
+#endif  //  __I2C_QUEUE_TEST_HAL_I2C_H__
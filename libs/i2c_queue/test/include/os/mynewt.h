@@ -0,0 +1,57 @@
+//  Simulated Mynewt OS for testing i2c_queue on the host.  Single-threaded: the event queues, semaphores and the
+//  I2C Task are driven by test/src/test_i2c_queue.c, and critical sections do nothing.
+#ifndef __I2C_QUEUE_TEST_MYNEWT_H__
+#define __I2C_QUEUE_TEST_MYNEWT_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SYS_EOK       0
+#define SYS_EINVAL   -2
+#define SYS_ETIMEOUT -3
+#define SYS_EBUSY    -8
+
+#define OS_TIMEOUT       6
+#define OS_TIMEOUT_NEVER UINT32_MAX
+#define OS_WAIT_FOREVER  (-1)
+
+#define OS_STACK_ALIGN(x) (x)
+#define MYNEWT_VAL(x) MYNEWT_VAL_ ## x
+#define MYNEWT_VAL_I2C_QUEUE_STACK_SIZE 256
+#define MYNEWT_VAL_I2C_QUEUE_TASK_PRIO  128
+
+#define OS_ENTER_CRITICAL(sr) ((sr) = 0)
+#define OS_EXIT_CRITICAL(sr)  ((void) (sr))
+
+typedef uint32_t os_sr_t;
+typedef uint32_t os_time_t;
+typedef uint32_t os_stack_t;
+
+struct os_event;
+typedef void os_event_fn(struct os_event *ev);
+
+struct os_event {
+    uint8_t ev_queued;
+    os_event_fn *ev_cb;
+    void *ev_arg;
+    struct os_event *ev_next;  //  Simulation: next event in the queue
+};
+
+struct os_eventq { struct os_event *evq_head; };
+struct os_sem { uint16_t sem_tokens; };
+struct os_task { int t_prio; };
+typedef void os_task_func_t(void *arg);
+
+void os_eventq_init(struct os_eventq *evq);
+void os_eventq_put(struct os_eventq *evq, struct os_event *ev);
+void os_eventq_remove(struct os_eventq *evq, struct os_event *ev);
+void os_eventq_run(struct os_eventq *evq);
+int os_sem_init(struct os_sem *sem, uint16_t tokens);
+int os_sem_release(struct os_sem *sem);
+int os_sem_pend(struct os_sem *sem, os_time_t timeout);
+int os_time_ms_to_ticks(uint32_t ms, os_time_t *out_ticks);
+int os_task_init(struct os_task *t, const char *name, os_task_func_t *func, void *arg, uint8_t prio,
+    os_time_t sanity_itvl, os_stack_t *stack_bottom, uint16_t stack_size);
+struct os_task *os_sched_get_current_task(void);
+
+#endif  //  __I2C_QUEUE_TEST_MYNEWT_H__
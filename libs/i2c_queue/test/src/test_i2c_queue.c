@@ -0,0 +1,263 @@
+//  Test the I2C transaction queue on the host, with the OS and the HAL simulated by the headers in test/include:
+//  gcc -Wall -DTEST_HOST -Itest/include -Iinclude -o test_i2c_queue src/i2c_queue.c test/src/test_i2c_queue.c && ./test_i2c_queue
+//  The I2C Task doesn't run by itself: each test decides what the I2C Task does while a caller waits on a semaphore.
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "os/mynewt.h"
+#include "hal/hal_i2c.h"
+#include "i2c_queue/i2c_queue.h"
+
+#define ADDRESS 0x18
+
+//  What the I2C Task does while i2c_queue_transfer() waits
+enum sim_wait {
+    WAIT_RUN,     //  Execute the queued transactions
+    WAIT_STALL,   //  Nothing, e.g. starved by higher priority tasks
+    WAIT_START,   //  Take the next transaction from the queue, then finish it during the next wait
+};
+
+//  Simulated OS and I2C bus
+static struct sim {
+    struct os_eventq *i2c_evq;   //  Event queue of the I2C Task
+    struct os_event *executing;  //  Transaction taken from the queue by the I2C Task, not finished
+    enum sim_wait wait;          //  What the I2C Task does during the next wait
+    int waits;                   //  Number of waits on a semaphore
+    int writes, reads;           //  HAL I2C calls
+    uint8_t last_write_op;       //  last_op of the last write
+    int hal_rc;                  //  Result of the HAL I2C calls
+} sim;
+
+////////////////////////////////////////////////////////////////////////////////
+//  Simulated OS
+
+void os_eventq_init(struct os_eventq *evq) {
+    evq->evq_head = NULL;
+    sim.i2c_evq = evq;  //  Only the I2C Task has an event queue
+}
+
+void os_eventq_put(struct os_eventq *evq, struct os_event *ev) {
+    struct os_event **last = &evq->evq_head;
+    if (ev->ev_queued) { return; }
+    while (*last) { last = &(*last)->ev_next; }
+    ev->ev_next = NULL;
+    ev->ev_queued = 1;
+    *last = ev;
+}
+
+void os_eventq_remove(struct os_eventq *evq, struct os_event *ev) {
+    struct os_event **e = &evq->evq_head;
+    while (*e && *e != ev) { e = &(*e)->ev_next; }
+    if (*e) { *e = ev->ev_next; ev->ev_queued = 0; }
+}
+
+static struct os_event *sim_take(struct os_eventq *evq) {
+    //  Take the first event from the queue, like the I2C Task in os_eventq_get()
+    struct os_event *ev = evq->evq_head;
+    if (ev) { evq->evq_head = ev->ev_next; ev->ev_queued = 0; }
+    return ev;
+}
+
+void os_eventq_run(struct os_eventq *evq) {
+    struct os_event *ev = sim_take(evq);
+    if (ev) { ev->ev_cb(ev); }
+}
+
+int os_sem_init(struct os_sem *sem, uint16_t tokens) { sem->sem_tokens = tokens; return 0; }
+
+int os_sem_release(struct os_sem *sem) { sem->sem_tokens++; return 0; }
+
+int os_sem_pend(struct os_sem *sem, os_time_t timeout) {
+    //  While the caller waits, the I2C Task runs as set by the test
+    if (sem->sem_tokens == 0) {
+        sim.waits++;
+        if (sim.executing) {
+            struct os_event *ev = sim.executing;
+            sim.executing = NULL;
+            ev->ev_cb(ev);
+        } else if (sim.wait == WAIT_RUN) {
+            while (sim.i2c_evq->evq_head) { os_eventq_run(sim.i2c_evq); }
+        } else if (sim.wait == WAIT_START) {
+            sim.executing = sim_take(sim.i2c_evq);
+        }
+    }
+    if (sem->sem_tokens == 0) {
+        assert(timeout != OS_TIMEOUT_NEVER);  //  Would wait forever
+        return OS_TIMEOUT;
+    }
+    sem->sem_tokens--;
+    return 0;
+}
+
+int os_time_ms_to_ticks(uint32_t ms, os_time_t *out_ticks) { *out_ticks = ms; return 0; }
+
+int os_task_init(struct os_task *t, const char *name, os_task_func_t *func, void *arg, uint8_t prio,
+    os_time_t sanity_itvl, os_stack_t *stack_bottom, uint16_t stack_size) {
+    t->t_prio = prio;  //  The test runs the I2C Task
+    return 0;
+}
+
+struct os_task *os_sched_get_current_task(void) { return NULL; }
+
+////////////////////////////////////////////////////////////////////////////////
+//  Simulated I2C bus: a device that returns the register number plus the offset of each byte read
+
+static uint8_t last_register;
+
+int hal_i2c_master_write(uint8_t i2c_num, struct hal_i2c_master_data *pdata, uint32_t timeout, uint8_t last_op) {
+    assert(i2c_num == 1 && pdata->address == ADDRESS && pdata->len > 0);
+    sim.writes++;
+    sim.last_write_op = last_op;
+    last_register = pdata->buffer[0];
+    return sim.hal_rc;
+}
+
+int hal_i2c_master_read(uint8_t i2c_num, struct hal_i2c_master_data *pdata, uint32_t timeout, uint8_t last_op) {
+    int i;
+    assert(i2c_num == 1 && pdata->address == ADDRESS && last_op == 1);
+    sim.reads++;
+    for (i = 0; i < pdata->len; i++) { pdata->buffer[i] = last_register + i; }
+    return sim.hal_rc;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Tests
+
+static void sim_start(enum sim_wait wait) {
+    struct os_eventq *evq = sim.i2c_evq;
+    memset(&sim, 0, sizeof(sim));
+    sim.i2c_evq = evq;
+    sim.wait = wait;
+}
+
+static int callbacks;
+static struct i2c_txn *resubmit;  //  Transaction submitted again by the callback, until callbacks reaches 3
+
+static void count_callback(struct i2c_txn *txn, void *arg) {
+    assert(!txn->busy && arg == &callbacks);
+    callbacks++;
+    if (txn == resubmit && callbacks < 3) { assert(i2c_queue_submit(txn) == 0); }
+}
+
+static void test_submit(void) {
+    //  Submit without waiting, complete through the callback and the event
+    static const uint8_t reg[1] = { 0x10 };
+    uint8_t buf[4];
+    struct i2c_txn txn = { 0 };
+    struct os_eventq done_evq = { 0 };
+    struct os_event done_ev = { 0 };
+    sim_start(WAIT_RUN);
+    callbacks = 0;  resubmit = NULL;
+
+    i2c_txn_init(&txn, 1, ADDRESS, reg, 1, buf, sizeof(buf));
+    txn.cb = count_callback;  txn.cb_arg = &callbacks;
+    txn.done_evq = &done_evq;  txn.done_ev = &done_ev;
+    assert(i2c_queue_submit(&txn) == 0);
+    assert(txn.busy);
+    assert(i2c_queue_submit(&txn) == SYS_EBUSY);  //  Already queued
+    os_eventq_run(sim.i2c_evq);
+    assert(!txn.busy && txn.rc == 0 && callbacks == 1 && done_ev.ev_queued);
+    assert(sim.writes == 1 && sim.last_write_op == 0 && sim.reads == 1);  //  Repeated start before the read
+    assert(buf[0] == 0x10 && buf[3] == 0x13);
+
+    //  Invalid transactions
+    i2c_txn_init(&txn, 1, ADDRESS, NULL, 0, NULL, 0);
+    assert(i2c_queue_submit(&txn) == SYS_EINVAL);
+    i2c_txn_init(&txn, 1, ADDRESS, NULL, 1, buf, 1);
+    assert(i2c_queue_submit(&txn) == SYS_EINVAL);
+}
+
+static void test_write_only(void) {
+    //  Write without a read ends with a stop condition
+    static const uint8_t cmd[2] = { 0x7E, 0xB6 };
+    struct i2c_txn txn = { 0 };
+    sim_start(WAIT_RUN);
+    i2c_txn_init(&txn, 1, ADDRESS, cmd, 2, NULL, 0);
+    assert(i2c_queue_transfer(&txn) == 0);
+    assert(sim.writes == 1 && sim.last_write_op == 1 && sim.reads == 0);
+}
+
+static void test_transfer(void) {
+    //  Submit and wait, with a HAL error
+    static const uint8_t reg[1] = { 0x20 };
+    uint8_t buf[2];
+    struct i2c_txn txn = { 0 };
+    sim_start(WAIT_RUN);
+    i2c_txn_init(&txn, 1, ADDRESS, reg, 1, buf, sizeof(buf));
+    assert(i2c_queue_transfer(&txn) == 0);
+    assert(!txn.busy && buf[1] == 0x21 && sim.waits == 1);
+
+    sim.hal_rc = 5;
+    i2c_txn_init(&txn, 1, ADDRESS, reg, 1, buf, sizeof(buf));
+    assert(i2c_queue_transfer(&txn) == 5);
+    assert(!txn.busy && sim.reads == 1);  //  No read after the write failed
+}
+
+static void test_timeout_queued(void) {
+    //  The I2C Task doesn't start the transaction in time: it's removed from the queue, and the same transaction
+    //  is set up and transferred again, like the register accesses of the bma421 and hrs3300 drivers
+    static const uint8_t reg[1] = { 0x30 };
+    uint8_t buf[1];
+    struct i2c_txn txn = { 0 };
+    sim_start(WAIT_STALL);
+    i2c_txn_init(&txn, 1, ADDRESS, reg, 1, buf, sizeof(buf));
+    assert(i2c_queue_transfer(&txn) == SYS_ETIMEOUT);
+    assert(!txn.busy && !txn.ev.ev_queued && sim.i2c_evq->evq_head == NULL);
+
+    sim.wait = WAIT_RUN;
+    i2c_txn_init(&txn, 1, ADDRESS, reg, 1, buf, sizeof(buf));  //  Would fail the busy assertion
+    assert(i2c_queue_transfer(&txn) == 0);
+    assert(sim.writes == 1 && buf[0] == 0x30);  //  Cancelled transaction was never executed
+}
+
+static void test_timeout_executing(void) {
+    //  The I2C Task starts the transaction but doesn't finish in time: wait until the HAL completes it
+    static const uint8_t reg[1] = { 0x40 };
+    uint8_t buf[1];
+    struct i2c_txn txn = { 0 };
+    sim_start(WAIT_START);
+    i2c_txn_init(&txn, 1, ADDRESS, reg, 1, buf, sizeof(buf));
+    assert(i2c_queue_transfer(&txn) == 0);
+    assert(sim.waits == 2 && !txn.busy && buf[0] == 0x40);
+
+    sim.hal_rc = 3;  //  HAL timed out
+    i2c_txn_init(&txn, 1, ADDRESS, reg, 1, buf, sizeof(buf));
+    assert(i2c_queue_transfer(&txn) == 3);
+    assert(!txn.busy);
+}
+
+static void test_order(void) {
+    //  Transactions run one at a time in the order submitted, and may be submitted again by the callback
+    static const uint8_t reg_a[1] = { 0x50 }, reg_b[1] = { 0x60 };
+    uint8_t buf_a[1], buf_b[1];
+    struct i2c_txn a = { 0 }, b = { 0 };
+    sim_start(WAIT_RUN);
+    callbacks = 0;
+    i2c_txn_init(&a, 1, ADDRESS, reg_a, 1, buf_a, 1);
+    i2c_txn_init(&b, 1, ADDRESS, reg_b, 1, buf_b, 1);
+    a.cb = count_callback;  a.cb_arg = &callbacks;
+    resubmit = &a;
+    assert(i2c_queue_submit(&a) == 0);
+    assert(i2c_queue_submit(&b) == 0);
+    while (sim.i2c_evq->evq_head) { os_eventq_run(sim.i2c_evq); }
+    assert(callbacks == 3 && sim.writes == 4);  //  a, b, then a twice more
+    assert(!a.busy && !b.busy && buf_a[0] == 0x50 && buf_b[0] == 0x60);
+    resubmit = NULL;
+}
+
+int test_i2c_queue(void) {
+    i2c_queue_init();
+    assert(sim.i2c_evq);
+    test_submit();
+    test_write_only();
+    test_transfer();
+    test_timeout_queued();
+    test_timeout_executing();
+    test_order();
+    printf("i2c_queue tests OK\n");
+    return 0;
+}
+
+#ifdef TEST_HOST
+int main(void) { return test_i2c_queue(); }
+#endif  //  TEST_HOST
@@ -26,19 +26,20 @@
 extern "C" {
 #endif
 
-//! Helper Functions for Mynewt JSON Encoding API
+//! Helper Functions for Mynewt JSON Encoding API. Keys and text values are passed with their lengths
+//! and don't need to be null-terminated.
 
 ///  Assume we are writing an object now.  Write the key name and start a child array.
 ///  ```
 ///  {a:b --> {a:b, key:[
 ///  ```
-void json_helper_set_array(void *object, const char *key);
+void json_helper_set_array(void *object, const char *key, int key_len);
 
 ///  End the child array and resume writing the parent object.
 ///  ```
 ///  {a:b, key:[... --> {a:b, key:[...]
 ///  ```
-void json_helper_close_array(void *object, const char *key);
+void json_helper_close_array(void *object, const char *key, int key_len);
 
 ///  Assume we have called `set_array`.  Start an array item, assumed to be an object.
 ///  ```
@@ -53,16 +54,22 @@ void json_helper_object_array_start_item(const char *key);
 void json_helper_object_array_end_item(const char *key) ;
 
 ///  Encode an int value into the current JSON encoding value `coap_json_value`
-void json_helper_set_int(void *object, const char *key, uint64_t value);
+void json_helper_set_int(void *object, const char *key, int key_len, uint64_t value);
 
 ///  Encode an unsigned int value into the current JSON encoding value `coap_json_value`
-void json_helper_set_uint(void *object, const char *key, uint64_t value);
+void json_helper_set_uint(void *object, const char *key, int key_len, uint64_t value);
 
 ///  Encode a float value into the current JSON encoding value `coap_json_value`
-void json_helper_set_float(void *object, const char *key, float value);
+void json_helper_set_float(void *object, const char *key, int key_len, float value);
+
+///  Encode a fixed-point value with 7 decimal places (e.g. 1e-7 degrees) into the current JSON encoding value `coap_json_value`
+void json_helper_set_fixed7(void *object, const char *key, int key_len, int32_t value);
+
+///  Encode an array of `count` integers into the current JSON object with the specified key: `key: [1, 2, 3]`
+void json_helper_set_int_array(void *object, const char *key, int key_len, const int32_t *values, uint32_t count);
 
 ///  Encode a text value into the current JSON encoding value `coap_json_value`
-void json_helper_set_text_string(void *object, const char *key, const char *value);
+void json_helper_set_text_string(void *object, const char *key, int key_len, const char *value, int value_len);
 
 #ifdef __cplusplus
 }
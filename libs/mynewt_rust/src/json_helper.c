@@ -22,18 +22,21 @@
 #include <sensor_coap/sensor_coap.h>
 #include <mynewt_rust/json_helper.h>
 
+//  Keys and text values are passed with their lengths, so they don't need to be null-terminated.
+//  Rust strings are passed without copying, and the lengths are not computed again with strlen().
+
 //  Assume we are writing an object now.  Write the key name and start a child array.
 //  {a:b --> {a:b, key:[
-void json_helper_set_array(void *object, const char *key) {
+void json_helper_set_array(void *object, const char *key, int key_len) {
     assert(key);
-    //  console_printf("json_helper_set_array: %s\n", key); ////
-    json_rep_set_array_k(object, (char *) key);
+    json_rep_set_array_n(object, key, key_len);
 }
 
 //  End the child array and resume writing the parent object.
 //  {a:b, key:[... --> {a:b, key:[...]
-void json_helper_close_array(void *object, const char *key) {
+void json_helper_close_array(void *object, const char *key, int key_len) {
     assert(key);
+    (void) key_len;
     json_rep_close_array(object, key);
 }
 
@@ -53,25 +56,40 @@ void json_helper_object_array_end_item(const char *key) {
 }
 
 //  Encode a value into JSON: int, unsigned int, float, text, ...
-void json_helper_set_int(void *object, const char *key, uint64_t value) {
+void json_helper_set_int(void *object, const char *key, int key_len, uint64_t value) {
+    assert(key);
+    json_rep_set_int_n(object, key, key_len, value);
+}
+
+void json_helper_set_uint(void *object, const char *key, int key_len, uint64_t value) {
     assert(key);
-    //  console_printf("json_helper_set_int: %s\n", key); ////
-    json_rep_set_int_k(object, (char *) key, value);
+    json_rep_set_uint_n(object, key, key_len, value);
 }
 
-void json_helper_set_uint(void *object, const char *key, uint64_t value) {
+void json_helper_set_float(void *object, const char *key, int key_len, float value) {
     assert(key);
-    json_rep_set_uint_k(object, (char *) key, value);
+    json_rep_set_float_n(object, key, key_len, value);
 }
 
-void json_helper_set_float(void *object, const char *key, float value) {
+void json_helper_set_fixed7(void *object, const char *key, int key_len, int32_t value) {
     assert(key);
-    json_rep_set_float_k(object, (char *) key, value);
+    json_rep_set_fixed7_n(object, key, key_len, value);
+}
+
+//  Encode an array of integers into JSON.
+//  {a:b --> {a:b, key:[1,2,3]
+void json_helper_set_int_array(void *object, const char *key, int key_len, const int32_t *values, uint32_t count) {
+    assert(key);  assert(values || count == 0);
+    json_rep_set_array_n(object, key, key_len);
+    for (uint32_t i = 0; i < count; i++) {
+        JSON_VALUE_INT(&coap_json_value, values[i]);
+        json_encode_array_value(&coap_json_encoder, &coap_json_value);
+    }
+    json_rep_close_array(object, key);
 }
 
-void json_helper_set_text_string(void *object, const char *key, const char *value) {
+void json_helper_set_text_string(void *object, const char *key, int key_len, const char *value, int value_len) {
     assert(key);
     assert(value);
-    //  console_printf("json_helper_set_text_string: %s\n", key); ////
-    json_rep_set_text_string_k(object, (char *) key, value);
+    json_rep_set_text_string_n(object, key, key_len, value, value_len);
 }
@@ -24,7 +24,7 @@
 #include "sensor/temperature.h"
 #include "sensor/pressure.h"
 #include "sensor/humidity.h"
-#include "custom_sensor/custom_sensor.h"  //  For SENSOR_TYPE_AMBIENT_TEMPERATURE_RAW
+#include "custom_sensor/custom_sensor.h"  //  For SENSOR_TYPE_AMBIENT_TEMPERATURE_RAW, SENSOR_TYPE_MULTI
 #include "remote_sensor/remote_sensor.h"
 
 //  Macros for Remote Sensors
@@ -48,11 +48,59 @@ static const struct sensor_driver g_sensor_driver = {
 /////////////////////////////////////////////////////////
 //  Read Sensor Functions
 
+static const struct sensor_type_descriptor *lookup_descriptor(sensor_type_t type) {
+    //  Return the Sensor Type Descriptor for the Sensor Type, or NULL if not found.
+    const struct sensor_type_descriptor *st = sensor_types;
+    while (st->type && type != st->type) { st++; }
+    if (type != st->type) { return NULL; }
+    return st;
+}
+
+static int sensor_read_multi(struct sensor *sensor, sensor_type_t type,
+    sensor_data_func_t data_func, void *data_arg, oc_rep_t *rep) {
+    //  Convert all fields in the "rep" list whose Sensor Types are in "type" and call the Listener Function 
+    //  once per multi-value record, instead of once per field.  Return 0 if successful.
+    union sensor_data_union data[SENSOR_MULTI_MAX_VALUES];
+    struct sensor_multi_data multi_data;
+    int rc = 0;
+    sensor_multi_init(&multi_data);
+
+    //  For each field in the payload...
+    for (; rep; rep = rep->next) {
+        //  Find the Sensor Type.  Skip fields that were not requested.
+        sensor_type_t field_type = remote_sensor_lookup_type(oc_string(rep->name));
+        if (!(field_type & type)) { continue; }
+        const struct sensor_type_descriptor *st = lookup_descriptor(field_type);
+        if (!st) { rc = SYS_EINVAL; goto err; }
+
+        //  Convert the value and append to the record.
+        void *d = st->save_func(&data[multi_data.smd_count], rep);
+        rc = sensor_multi_add(&multi_data, field_type, d);
+        assert(rc == 0);
+
+        //  If the record is full, pass it to the Listener Function and start a new record.
+        if (multi_data.smd_count == SENSOR_MULTI_MAX_VALUES) {
+            rc = data_func(sensor, data_arg, &multi_data, SENSOR_TYPE_MULTI);
+            if (rc) { goto err; }
+            sensor_multi_init(&multi_data);
+        }
+    }
+    if (multi_data.smd_count > 0) {  //  Pass the remaining values to the Listener Function.
+        rc = data_func(sensor, data_arg, &multi_data, SENSOR_TYPE_MULTI);
+        if (rc) { goto err; }
+    }
+    return 0;
+err:
+    return rc;
+}
+
 static int sensor_read_internal(struct sensor *sensor, sensor_type_t type,
     sensor_data_func_t data_func, void *data_arg, uint32_t timeout) {
     //  Read the sensor value depending on the sensor type specified in the sensor config.
     //  Call the Listener Function (may be NULL) with the sensor value.
     //  data_arg is a sensor_read_ctx whose user_arg is an (oc_rep_t *) with type and value passed by process_coap_message().
+    //  If a multi-value record is requested, user_arg is the first field of the payload and all requested fields
+    //  are passed to the Listener Function together.
     assert(sensor);
     if (!data_func) { return 0; }  //  If no Listener Function, then don't continue.
     assert(data_arg);
@@ -61,10 +109,13 @@ static int sensor_read_internal(struct sensor *sensor, sensor_type_t type,
     assert(rep);
     int rc = 0;
 
+    if (SENSOR_MULTI_REQUESTED(type)) {
+        return sensor_read_multi(sensor, type, data_func, data_arg, rep);
+    }
+
     //  Find the Sensor Type.
-    const struct sensor_type_descriptor *st = sensor_types;
-    while (st->type && type != st->type) { st++; }
-    if (type != st->type) { rc = SYS_EINVAL; goto err; }
+    const struct sensor_type_descriptor *st = lookup_descriptor(type);
+    if (!st) { rc = SYS_EINVAL; goto err; }
 
     //  Convert the value.
     union sensor_data_union data;
@@ -124,6 +175,9 @@ int remote_sensor_init(struct os_dev *dev0, void *arg) {
     //  Add the driver with all the supported sensor data types.
     int all_types = 0;  const struct sensor_type_descriptor *st = sensor_types;
     while (st->type) { all_types |= st->type; st++; }
+#if MYNEWT_VAL(SENSOR_MULTI_READ)  //  If multi-value records are enabled...
+    all_types |= SENSOR_TYPE_MULTI;
+#endif  //  MYNEWT_VAL(SENSOR_MULTI_READ)
 
     rc = sensor_set_driver(sensor, all_types, (struct sensor_driver *) &g_sensor_driver);
     if (rc != 0) { goto err; }
@@ -24,6 +24,7 @@
 #include <assert.h>
 #include <os/os.h>
 #include <sensor/sensor.h>
+#include <custom_sensor/custom_sensor.h>
 #include <console/console.h>
 #include <os/os_mbuf.h>
 #include <oic/oc_rep.h>
@@ -124,16 +125,28 @@ static int process_coap_message(const char *name, uint8_t *data, uint8_t size0)
     assert(rc == 0);
     oc_rep_t *first_rep = rep;
 
+    //  Fetch the Remote Sensor by name.  "name" looks like "b3b4b5b6f1", the Sensor Node Address.
+    struct sensor *remote_sensor = sensor_mgr_find_next_bydevname(name, NULL);
+    assert(remote_sensor);  //  Sensor not found
+
+#if MYNEWT_VAL(SENSOR_MULTI_READ)  //  If multi-value records are enabled...
+    //  Collect the Sensor Types of all fields in the payload, e.g. t -> SENSOR_TYPE_AMBIENT_TEMPERATURE_RAW
+    int types = SENSOR_TYPE_MULTI;
+    for (; rep; rep = rep->next) {
+        sensor_type_t type = remote_sensor_lookup_type(oc_string(rep->name));  
+        assert(type);  //  Unknown field name
+        types |= type;
+    }
+    //  Send one read request to Remote Sensor for all fields.  The Listener Functions are called with a multi-value record.
+    rc = sensor_read(remote_sensor, types, NULL, first_rep, 0);
+    assert(rc == 0);
+#else   //  If every read returns a single value...
     //  For each field in the payload...
     while(rep) {
         //  Convert the field name to sensor type, e.g. t -> SENSOR_TYPE_AMBIENT_TEMPERATURE_RAW
         sensor_type_t type = remote_sensor_lookup_type(oc_string(rep->name));  
         assert(type);  //  Unknown field name
 
-        //  Fetch the Remote Sensor by name.  "name" looks like "b3b4b5b6f1", the Sensor Node Address.
-        struct sensor *remote_sensor = sensor_mgr_find_next_bydevname(name, NULL);
-        assert(remote_sensor);  //  Sensor not found
-
         //  Send the read request to Remote Sensor.  This causes the sensor to be read and Listener Function to be called.
         rc = sensor_read(remote_sensor, type, NULL, rep, 0);
         assert(rc == 0);
@@ -141,6 +154,7 @@ static int process_coap_message(const char *name, uint8_t *data, uint8_t size0)
         //  Move to next field in the payload.
         rep = rep->next;
     }
+#endif  //  MYNEWT_VAL(SENSOR_MULTI_READ)
     //  Free the decoded representation.
     oc_free_rep(first_rep);
     return 0;
@@ -42,6 +42,10 @@ bool prepare_sensor_post(struct oc_server_handle *server, const char *uri, int c
 //  Send the sensor post request to CoAP server.
 bool do_sensor_post(void);
 
+//  Append the pre-encoded bytes to the payload of the sensor post request, in the current encoding format.
+//  Return 0 if successful.
+int coap_rep_append(const uint8_t *data, int len);
+
 ///////////////////////////////////////////////////////////////////////////////
 //  JSON Common Encoding Macros
 
@@ -49,6 +53,7 @@ bool do_sensor_post(void);
 #include <json/json.h>
 #define COAP_CONTENT_FORMAT APPLICATION_JSON   //  Specify JSON content type and accept type in the CoAP header.
 #define JSON_VALUE_TYPE_EXT_FLOAT (6)          //  For custom encoding of floats.
+#define JSON_VALUE_TYPE_EXT_FIXED7 (7)         //  For custom encoding of fixed-point values with 7 decimal places, e.g. coordinates.
 
 extern struct json_encoder coap_json_encoder;  //  Note: We don't support concurrent encoding of JSON messages.
 extern struct json_value coap_json_value;      //  Custom JSON value being encoded.
@@ -57,6 +62,8 @@ void json_rep_new(struct os_mbuf *m);   //  Prepare to write a new JSON CoAP pay
 void json_rep_reset(void);              //  Close the current JSON CoAP payload.  Erase the JSON encoder.
 int json_rep_finalize(void);            //  Finalise the payload and return the payload size.
 int json_encode_object_entry_ext(struct json_encoder *encoder, char *key, struct json_value *val);  //  Custom encoder for floats.
+int json_encode_object_entry_n(struct json_encoder *encoder, const char *key, int key_len, struct json_value *val);  //  Key with length, not null-terminated.
+int json_encode_object_key_n(struct json_encoder *encoder, const char *key, int key_len);  //  Write the key of an entry, array or child object.
 
 //  Start the JSON representation.  Assume top level is object.
 //  --> {
@@ -88,6 +95,11 @@ void json_rep_end_root_object(void);
 (__jv)->jv_type = JSON_VALUE_TYPE_EXT_FLOAT;  \
 (__jv)->jv_val.fl = (float) __v;
 
+//  Define a fixed-point JSON value with 7 decimal places, e.g. 413613370 is encoded as 41.3613370.
+#define JSON_VALUE_EXT_FIXED7(__jv, __v)       \
+(__jv)->jv_type = JSON_VALUE_TYPE_EXT_FIXED7;  \
+(__jv)->jv_val.u = (uint64_t) (int64_t) (int32_t) __v;
+
 //  Encode a value into JSON: int, unsigned int, float, text, ... `_k` version does not stringify the key.
 #define json_rep_set_int(          object, key, value) { JSON_VALUE_INT      (&coap_json_value, value);          json_encode_object_entry    (&coap_json_encoder, #key, &coap_json_value); }
 #define json_rep_set_int_k(        object, key, value) { JSON_VALUE_INT      (&coap_json_value, value);          json_encode_object_entry    (&coap_json_encoder, key,  &coap_json_value); }
@@ -95,9 +107,19 @@ void json_rep_end_root_object(void);
 #define json_rep_set_uint_k(       object, key, value) { JSON_VALUE_UINT     (&coap_json_value, value);          json_encode_object_entry    (&coap_json_encoder, key,  &coap_json_value); }
 #define json_rep_set_float(        object, key, value) { JSON_VALUE_EXT_FLOAT(&coap_json_value, value);          json_encode_object_entry_ext(&coap_json_encoder, #key, &coap_json_value); }
 #define json_rep_set_float_k(      object, key, value) { JSON_VALUE_EXT_FLOAT(&coap_json_value, value);          json_encode_object_entry_ext(&coap_json_encoder, key,  &coap_json_value); }
+#define json_rep_set_fixed7_k(     object, key, value) { JSON_VALUE_EXT_FIXED7(&coap_json_value, value);         json_encode_object_entry_ext(&coap_json_encoder, key,  &coap_json_value); }
 #define json_rep_set_text_string(  object, key, value) { JSON_VALUE_STRING   (&coap_json_value, (char *) value); json_encode_object_entry    (&coap_json_encoder, #key, &coap_json_value); }
 #define json_rep_set_text_string_k(object, key, value) { JSON_VALUE_STRING   (&coap_json_value, (char *) value); json_encode_object_entry    (&coap_json_encoder, key,  &coap_json_value); }
 
+//  Same as above, except that the key and text value are passed with their lengths, so they don't need to be null-terminated
+//  and are not scanned with strlen().  Used by the Rust encoding helpers in libs/mynewt_rust.
+#define json_rep_set_array_n(      object, key, key_len)        { json_encode_object_key_n(&coap_json_encoder, key, key_len);  json_encode_array_start(&coap_json_encoder); }
+#define json_rep_set_int_n(        object, key, key_len, value) { JSON_VALUE_INT      (&coap_json_value, value);  json_encode_object_entry_n(&coap_json_encoder, key, key_len, &coap_json_value); }
+#define json_rep_set_uint_n(       object, key, key_len, value) { JSON_VALUE_UINT     (&coap_json_value, value);  json_encode_object_entry_n(&coap_json_encoder, key, key_len, &coap_json_value); }
+#define json_rep_set_float_n(      object, key, key_len, value) { JSON_VALUE_EXT_FLOAT(&coap_json_value, value);  json_encode_object_entry_n(&coap_json_encoder, key, key_len, &coap_json_value); }
+#define json_rep_set_fixed7_n(     object, key, key_len, value) { JSON_VALUE_EXT_FIXED7(&coap_json_value, value); json_encode_object_entry_n(&coap_json_encoder, key, key_len, &coap_json_value); }
+#define json_rep_set_text_string_n(object, key, key_len, value, value_len) { JSON_VALUE_STRINGN(&coap_json_value, (char *) value, value_len); json_encode_object_entry_n(&coap_json_encoder, key, key_len, &coap_json_value); }
+
 #endif  //  MYNEWT_VAL(COAP_JSON_ENCODING)
 
 ///////////////////////////////////////////////////////////////////////////////
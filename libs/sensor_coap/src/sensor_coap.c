@@ -285,24 +285,49 @@ void json_rep_end_root_object(void) {
 static int json_encode_value_ext(struct json_encoder *encoder, struct json_value *jv);
 static void split_float(float f, bool *neg, int *i, int *d);
 
-///  Extended version of json_encode_object_entry that handles floats.  Original version: repos\apache-mynewt-core\encoding\json\src\json_encode.c
+///  Extended version of json_encode_object_entry that handles floats and fixed-point values.  Original version: repos\apache-mynewt-core\encoding\json\src\json_encode.c
 int
 json_encode_object_entry_ext(struct json_encoder *encoder, char *key,
         struct json_value *val)
 {
-    assert(encoder); assert(key); assert(val);
-    int rc;
+    assert(key);
+    return json_encode_object_entry_n(encoder, key, strlen(key), val);
+}
 
+///  Write the key of an object entry, array or child object with the key length, so that the key
+///  doesn't need to be null-terminated.  Original version: json_encode_object_key() in
+///  repos\apache-mynewt-core\encoding\json\src\json_encode.c
+int
+json_encode_object_key_n(struct json_encoder *encoder, const char *key, int key_len)
+{
+    assert(encoder); assert(key);
     if (encoder->je_wr_commas) {
         encoder->je_write(encoder->je_arg, ",", sizeof(",")-1);
         encoder->je_wr_commas = 0;
     }
     /* Write the key entry */
     encoder->je_write(encoder->je_arg, "\"", sizeof("\"")-1);
-    encoder->je_write(encoder->je_arg, key, strlen(key));
+    encoder->je_write(encoder->je_arg, (char *) key, key_len);
     encoder->je_write(encoder->je_arg, "\": ", sizeof("\": ")-1);
+    return (0);
+}
+
+///  Encode an object entry with the key length, so that the key doesn't need to be null-terminated.
+///  Handles the standard JSON values, floats and fixed-point values.
+int
+json_encode_object_entry_n(struct json_encoder *encoder, const char *key, int key_len,
+        struct json_value *val)
+{
+    assert(encoder); assert(key); assert(val);
+    int rc;
 
-    rc = json_encode_value_ext(encoder, val);
+    rc = json_encode_object_key_n(encoder, key, key_len);
+    if (rc != 0) {
+        goto err;
+    }
+    rc = (val->jv_type == JSON_VALUE_TYPE_EXT_FLOAT || val->jv_type == JSON_VALUE_TYPE_EXT_FIXED7)
+        ? json_encode_value_ext(encoder, val)
+        : json_encode_value(encoder, val);
     if (rc != 0) {
         goto err;
     }
@@ -313,7 +338,7 @@ err:
     return (rc);
 }
 
-///  Extended version of json_encode_value_ext that handles floats.  Original version: repos\apache-mynewt-core\encoding\json\src\json_encode.c
+///  Extended version of json_encode_value_ext that handles floats and fixed-point values.  Original version: repos\apache-mynewt-core\encoding\json\src\json_encode.c
 static int
 json_encode_value_ext(struct json_encoder *encoder, struct json_value *jv)
 {
@@ -337,6 +362,20 @@ json_encode_value_ext(struct json_encoder *encoder, struct json_value *jv)
             encoder->je_write(encoder->je_arg, encoder->je_encode_buf, len);
             break;
         }
+        case JSON_VALUE_TYPE_EXT_FIXED7: {
+            //  Encode the fixed-point value with 7 decimal places, without floating-point.
+            int32_t v = (int32_t) jv->jv_val.u;
+            uint32_t v_abs = (v < 0) ? -(uint32_t) v : (uint32_t) v;  //  Absolute value of v
+            len = sprintf(
+                encoder->je_encode_buf,
+                "%s%lu.%07lu",
+                (v < 0) ? "-" : "",  //  Sign
+                (unsigned long) (v_abs / 10000000),  //  Integer part
+                (unsigned long) (v_abs % 10000000)   //  7 decimal places
+            );
+            encoder->je_write(encoder->je_arg, encoder->je_encode_buf, len);
+            break;
+        }
         default:
             rc = -1;
             goto err;
@@ -357,3 +396,23 @@ static void split_float(float f, bool *neg, int *i, int *d) {
 }
 
 #endif  //  MYNEWT_VAL(COAP_JSON_ENCODING)
+
+///  Append the pre-encoded bytes to the payload of the sensor post request, in the current encoding format.
+///  Used by the `coap!()` macro in Rust to append the parts of the payload that were encoded at compile time.
+///  Return 0 if successful.
+int
+coap_rep_append(const uint8_t *data, int len)
+{
+    assert(data);
+#if MYNEWT_VAL(COAP_JSON_ENCODING)  //  If we are encoding the CoAP payload in JSON...
+    if (oc_content_format == APPLICATION_JSON) { return json_write_mbuf(NULL, (char *) data, len); }
+#endif  //  MYNEWT_VAL(COAP_JSON_ENCODING)
+#if MYNEWT_VAL(COAP_CBOR_ENCODING)  //  If we are encoding the CoAP payload in CBOR...
+    if (oc_content_format == APPLICATION_CBOR) {
+        //  Write through the CBOR encoder so that oc_rep_finalize() counts the bytes.
+        struct cbor_encoder_writer *writer = g_encoder.writer;  assert(writer);
+        return writer->write(writer, (const char *) data, len);
+    }
+#endif  //  MYNEWT_VAL(COAP_CBOR_ENCODING)
+    return -1;
+}
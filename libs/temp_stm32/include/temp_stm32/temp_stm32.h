@@ -31,11 +31,11 @@
 
 #include "os/mynewt.h"
 #include "sensor/sensor.h"
+#include "custom_sensor/custom_sensor.h"                       //  For SENSOR_TYPE_AMBIENT_TEMPERATURE_RAW, SENSOR_TYPE_MULTI
 
 //  Define Sensor Type, Sensor Value Type and Sensor Key (Raw and Computed Temperature)
 
 #if MYNEWT_VAL(RAW_TEMP)                                       //  If we are returning raw temperature (integers)...
-#include "custom_sensor/custom_sensor.h"                       //  For SENSOR_TYPE_AMBIENT_TEMPERATURE_RAW
 #define TEMP_SENSOR_TYPE       SENSOR_TYPE_AMBIENT_TEMPERATURE_RAW  //  Set to raw sensor type
 #define TEMP_SENSOR_VALUE_TYPE SENSOR_VALUE_TYPE_INT32         //  Return integer sensor values
 #define TEMP_SENSOR_KEY        "t"                             //  Use key (field name) "t" to transmit raw temperature to CoAP Server or Collector Node
@@ -68,6 +68,12 @@ struct temp_stm32 {
     struct temp_stm32_cfg cfg;  //  Sensor configuration
     os_time_t last_read_time;   //  Last time the sensor was read.
     struct adc_dev *adc;        //  ADC device that will be used to access the sensor.
+#if MYNEWT_VAL(TEMP_STM32_DMA_SAMPLES) > 0  //  If we are collecting samples via DMA...
+    struct os_sem dma_sem;      //  Released by the ADC event handler when a DMA buffer is complete and a reader is waiting.
+    uint32_t *dma_ready_buf;    //  DMA buffer most recently completed, with TEMP_STM32_DMA_SAMPLES samples.
+    uint8_t dma_started;        //  1 if the ADC is kept open and converting continuously via DMA.
+    uint8_t dma_waiting;        //  1 if a reader is waiting for the next DMA buffer.
+#endif  //  MYNEWT_VAL(TEMP_STM32_DMA_SAMPLES) > 0
 };
 
 /**
@@ -115,6 +121,21 @@ int temp_stm32_config(struct temp_stm32 *temp_stm32, struct temp_stm32_cfg *cfg)
  */
 int temp_stm32_get_raw_temperature(struct temp_stm32 *dev, int num_readings, int *temp_sum, uint8_t *temp_diff);
 
+#if MYNEWT_VAL(TEMP_STM32_DMA_SAMPLES) > 0  //  If we are collecting samples via DMA...
+/**
+ * Get filtered raw temperature from STM32 internal temperature sensor by collecting TEMP_STM32_DMA_SAMPLES samples via DMA.
+ * On first call, the ADC is opened and left converting continuously into double buffers.  Will block until the next
+ * DMA buffer is complete.  The samples are averaged, or median-filtered if TEMP_STM32_DMA_MEDIAN is 1.
+ *
+ * @param dev The temp_stm32 device
+ * @param timeout How long to wait for the DMA buffer, in milliseconds.  OS_TIMEOUT_NEVER to wait forever.
+ * @param rawtemp Pointer to an int. Will store the filtered raw temperature, ranging from 0 to 4095.
+ *
+ * @return 0 on success, and non-zero error code on failure
+ */
+int temp_stm32_get_filtered_temperature(struct temp_stm32 *dev, uint32_t timeout, int *rawtemp);
+#endif  //  MYNEWT_VAL(TEMP_STM32_DMA_SAMPLES) > 0
+
 #ifdef __cplusplus
 }
 #endif
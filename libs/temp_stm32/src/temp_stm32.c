@@ -81,6 +81,13 @@ int temp_stm32_default_cfg(struct temp_stm32_cfg *cfg) {
 }
 #endif  //  DSTM32F103xB
 
+#if MYNEWT_VAL(TEMP_STM32_DMA_SAMPLES) > 0  //  If we are collecting samples via DMA...
+#define DMA_SAMPLES MYNEWT_VAL(TEMP_STM32_DMA_SAMPLES)  //  Number of samples per DMA buffer
+static uint32_t dma_bufs[2][DMA_SAMPLES];  //  Primary and secondary DMA buffers, swapped by the ADC driver when full
+static int temp_stm32_start_dma(struct temp_stm32 *dev);
+static uint32_t *temp_stm32_next_dma_buffer(struct temp_stm32 *dev, uint32_t timeout);
+#endif  //  MYNEWT_VAL(TEMP_STM32_DMA_SAMPLES) > 0
+
 static int temp_stm32_open(struct os_dev *dev0, uint32_t timeout, void *arg) {
     //  Setup ADC channel configuration for temperature sensor.  Return 0 if successful.
     //  This locks the ADC channel until the sensor is closed.
@@ -89,6 +96,10 @@ static int temp_stm32_open(struct os_dev *dev0, uint32_t timeout, void *arg) {
     struct temp_stm32_cfg *cfg;
     dev = (struct temp_stm32 *) dev0;  assert(dev);  
     cfg = &dev->cfg; assert(cfg); assert(cfg->adc_channel);  assert(cfg->adc_channel_cfg);  assert(cfg->adc_dev_name);
+#if MYNEWT_VAL(TEMP_STM32_DMA_SAMPLES) > 0
+    //  If DMA is running, port ADC1 is already open and configured.  Keep using it.
+    if (dev->dma_started) { return 0; }
+#endif  //  MYNEWT_VAL(TEMP_STM32_DMA_SAMPLES) > 0
 
     //  Open port ADC1.
     dev->adc = (struct adc_dev *) os_dev_open(cfg->adc_dev_name, timeout, cfg->adc_open_arg);
@@ -113,6 +124,10 @@ static int temp_stm32_close(struct os_dev *dev0) {
     //  console_printf("ADC close\n");  ////
     struct temp_stm32 *dev;    
     dev = (struct temp_stm32 *) dev0;
+#if MYNEWT_VAL(TEMP_STM32_DMA_SAMPLES) > 0
+    //  If DMA is running, keep port ADC1 open so that it stays configured between reads.
+    if (dev->dma_started) { return 0; }
+#endif  //  MYNEWT_VAL(TEMP_STM32_DMA_SAMPLES) > 0
     if (dev->adc) {
         //  Close port ADC1.
         os_dev_close((struct os_dev *) dev->adc);
@@ -136,6 +151,13 @@ int temp_stm32_init(struct os_dev *dev0, void *arg) {
     if (!arg || !dev0) { rc = SYS_ENODEV; goto err; }
     dev = (struct temp_stm32 *) dev0;
     dev->adc = NULL;
+#if MYNEWT_VAL(TEMP_STM32_DMA_SAMPLES) > 0
+    dev->dma_ready_buf = NULL;
+    dev->dma_started = 0;
+    dev->dma_waiting = 0;
+    rc = os_sem_init(&dev->dma_sem, 0);
+    if (rc) { goto err; }
+#endif  //  MYNEWT_VAL(TEMP_STM32_DMA_SAMPLES) > 0
 
     //  Get the default config.
     rc = temp_stm32_default_cfg(&dev->cfg);
@@ -147,8 +169,13 @@ int temp_stm32_init(struct os_dev *dev0, void *arg) {
     if (rc != 0) { goto err; }
 
     //  Add the driver with all the supported sensor data types.
+#if MYNEWT_VAL(SENSOR_MULTI_READ)  //  If multi-value records are enabled...
+    rc = sensor_set_driver(sensor, TEMP_SENSOR_TYPE | SENSOR_TYPE_MULTI,
+        (struct sensor_driver *) &g_temp_stm32_sensor_driver);
+#else   //  If every read returns a single value...
     rc = sensor_set_driver(sensor, TEMP_SENSOR_TYPE,
         (struct sensor_driver *) &g_temp_stm32_sensor_driver);
+#endif  //  MYNEWT_VAL(SENSOR_MULTI_READ)
     if (rc != 0) { goto err; }
 
     //  Set the interface.
@@ -183,6 +210,10 @@ static int temp_stm32_sensor_read(struct sensor *sensor, sensor_type_t type,
     if (!(type & TEMP_SENSOR_TYPE)) { rc = SYS_EINVAL; goto err; }
     dev = (struct temp_stm32 *) SENSOR_GET_DEVICE(sensor); assert(dev);
     rawtemp = -1;
+#if MYNEWT_VAL(TEMP_STM32_DMA_SAMPLES) > 0  //  If we are collecting samples via DMA...
+    //  Port ADC1 stays open and converts continuously.  Wait for the next DMA buffer and filter the samples.
+    rc = temp_stm32_get_filtered_temperature(dev, timeout, &rawtemp);
+#else   //  If we are using blocking reads...
     {   //  Begin ADC Lock: Open and lock port ADC1, configure channel 16.
         rc = temp_stm32_open((struct os_dev *) dev, 0, NULL);
         if (rc) { goto err; }
@@ -192,6 +223,7 @@ static int temp_stm32_sensor_read(struct sensor *sensor, sensor_type_t type,
 
         temp_stm32_close((struct os_dev *) dev);
     }   //  End ADC Lock: Close and unlock port ADC1.
+#endif  //  MYNEWT_VAL(TEMP_STM32_DMA_SAMPLES) > 0
     if (rc) { goto err; }  //  console_printf("rawtemp: %d\n", rawtemp);  ////
 
     //  Convert the raw temperature to actual temperature. From https://github.com/cnoviello/mastering-stm32/blob/master/nucleo-f446RE/src/ch12/main-ex1.c
@@ -234,7 +266,13 @@ static int temp_stm32_sensor_read(struct sensor *sensor, sensor_type_t type,
     temp_data->std_temp_is_valid = 1;  //  console_printf("temp: ");  console_printfloat(temp);  console_printf("\n");  ////
 #endif  //  MYNEWT_VAL(RAW_TEMP)
     
-    if (data_func) {  //  Call the Listener Function to process the sensor data.
+    if (data_func && SENSOR_MULTI_REQUESTED(type)) {  //  Call the Listener Function with a multi-value record.
+        struct sensor_multi_data multi_data;
+        sensor_multi_init(&multi_data);
+        sensor_multi_add(&multi_data, TEMP_SENSOR_TYPE, temp_data);
+        rc = data_func(sensor, data_arg, &multi_data, SENSOR_TYPE_MULTI);
+        if (rc) { goto err; }
+    } else if (data_func) {  //  Call the Listener Function to process the sensor data.
         rc = data_func(sensor, data_arg, temp_data, TEMP_SENSOR_TYPE);
         if (rc) { goto err; }
     }
@@ -272,6 +310,10 @@ int temp_stm32_get_raw_temperature(struct temp_stm32 *dev, int num_readings, int
     int lasttemp = 0;      //  Previous raw temperature
     uint8_t lastdiff = 0;  //  Delta between current raw temperature and previous raw temperature
     *temp_sum = 0;
+#if MYNEWT_VAL(TEMP_STM32_DMA_SAMPLES) > 0
+    uint32_t *dma_buf = NULL;    //  If DMA is running, samples are taken from the completed DMA buffers
+    int dma_index = DMA_SAMPLES;  //  Index of the next sample in dma_buf
+#endif  //  MYNEWT_VAL(TEMP_STM32_DMA_SAMPLES) > 0
 
     //  When called with num_readings = 1:  This function returns a valid raw temperature value (0 to 4095)
     //  When called with num_readings = 64: This function is used to generate 32 noisy bytes as the entropy 
@@ -292,10 +334,23 @@ int temp_stm32_get_raw_temperature(struct temp_stm32 *dev, int num_readings, int
     for (i = 0; i < num_readings; i++) {  //  For each sample to be read...
         //  Read the ADC value: rawtemp will be in the range 0 to 4095.
         rawtemp = -1;
-        //  Block until the temperature is read from the ADC channel.
-        rc = adc_read_channel(dev->adc, 0, &rawtemp);  //  Channel number is not used
-        assert(rc == 0);
-        if (rc) { goto err; }
+#if MYNEWT_VAL(TEMP_STM32_DMA_SAMPLES) > 0
+        if (dev->dma_started) {
+            //  ADC1 is converting continuously via DMA.  Take the next sample from the completed DMA buffers.
+            if (dma_index >= DMA_SAMPLES) {
+                dma_buf = temp_stm32_next_dma_buffer(dev, OS_TIMEOUT_NEVER);
+                if (!dma_buf) { rc = SYS_ETIMEOUT; goto err; }
+                dma_index = 0;
+            }
+            rawtemp = dma_buf[dma_index++];
+        } else
+#endif  //  MYNEWT_VAL(TEMP_STM32_DMA_SAMPLES) > 0
+        {
+            //  Block until the temperature is read from the ADC channel.
+            rc = adc_read_channel(dev->adc, 0, &rawtemp);  //  Channel number is not used
+            assert(rc == 0);
+            if (rc) { goto err; }
+        }
         assert(rawtemp > 0);  //  If equals 0, it means we haven't sampled any values.  Check the above note.
 
         //  Populate the temp_diff array with the deltas.
@@ -314,6 +369,133 @@ err:
     return rc;
 }
 
+#if MYNEWT_VAL(TEMP_STM32_DMA_SAMPLES) > 0  //  If we are collecting samples via DMA...
+
+static int temp_stm32_dma_event(struct adc_dev *adc, void *arg, adc_event_type_t type, void *buf, int buf_len) {
+    //  Called by the ADC driver in interrupt context when a DMA buffer is full.  The driver has already
+    //  swapped in the other buffer, so buf will not be overwritten until the next buffer is complete.
+    struct temp_stm32 *dev = (struct temp_stm32 *) arg;
+    if (type != ADC_EVENT_RESULT) { return 0; }
+    assert(dev);  assert(buf_len == DMA_SAMPLES);
+    dev->dma_ready_buf = (uint32_t *) buf;
+    if (dev->dma_waiting) {
+        //  Wake up the reader waiting for this buffer.
+        dev->dma_waiting = 0;
+        os_sem_release(&dev->dma_sem);
+    }
+    return 0;
+}
+
+static int temp_stm32_start_dma(struct temp_stm32 *dev) {
+    //  Open and configure port ADC1, then start timer-triggered conversions via DMA into the double buffers.
+    //  Port ADC1 stays open until the device is reset, so we don't pay the open / lock / configure / calibrate
+    //  overhead on every reading.  Return 0 if successful.
+    int rc;
+    assert(dev);
+    if (dev->dma_started) { return 0; }
+
+    rc = temp_stm32_open((struct os_dev *) dev, 0, NULL);
+    if (rc) { goto err; }
+
+    rc = adc_event_handler_set(dev->adc, temp_stm32_dma_event, dev);
+    if (rc) { goto close; }
+
+    rc = adc_buf_set(dev->adc, dma_bufs[0], dma_bufs[1], adc_buf_size(dev->adc, 1, DMA_SAMPLES));
+    if (rc) { goto close; }
+
+#ifdef STM32F103xB  //  Blue Pill: Pace the conversions with the ADC trigger timer.
+    rc = stm32f1_adc_set_trigger_rate(dev->adc, MYNEWT_VAL(TEMP_STM32_DMA_RATE));
+    if (rc) { goto close; }
+#endif  //  STM32F103xB
+#ifdef STM32L476xx  //  STM32L476: Pace the conversions with the ADC trigger timer.
+    rc = stm32l4_adc_set_trigger_rate(dev->adc, MYNEWT_VAL(TEMP_STM32_DMA_RATE));
+    if (rc) { goto close; }
+#endif  //  STM32L476xx
+
+    rc = adc_sample(dev->adc);  //  Start the DMA conversions.
+    if (rc) { goto close; }
+
+    dev->dma_started = 1;
+    return 0;
+close:
+    temp_stm32_close((struct os_dev *) dev);
+err:
+    return rc;
+}
+
+static uint32_t *temp_stm32_next_dma_buffer(struct temp_stm32 *dev, uint32_t timeout) {
+    //  Block until the next DMA buffer is complete.  Return the buffer, or NULL if timeout.
+    //  timeout is in milliseconds, or OS_TIMEOUT_NEVER.
+    os_sr_t sr;
+    os_time_t ticks = (timeout == OS_TIMEOUT_NEVER) ? OS_TIMEOUT_NEVER : os_time_ms_to_ticks32(timeout);
+    assert(dev);  assert(dev->dma_started);
+
+    dev->dma_waiting = 1;
+    if (os_sem_pend(&dev->dma_sem, ticks) != OS_OK) {
+        OS_ENTER_CRITICAL(sr);
+        dev->dma_waiting = 0;  //  Timed out: don't let a late buffer release the semaphore for the next reader.
+        OS_EXIT_CRITICAL(sr);
+        return NULL;
+    }
+    return dev->dma_ready_buf;
+}
+
+#if MYNEWT_VAL(TEMP_STM32_DMA_MEDIAN)
+static int median_samples(const uint32_t *buf, int len) {
+    //  Return the median of the samples.  Insertion sort is fine for a few dozen 12-bit samples.
+    uint16_t sorted[DMA_SAMPLES];
+    int i, j;
+    assert(len > 0 && len <= DMA_SAMPLES);
+    for (i = 0; i < len; i++) {
+        uint16_t v = (uint16_t) buf[i];
+        for (j = i; j > 0 && sorted[j - 1] > v; j--) { sorted[j] = sorted[j - 1]; }
+        sorted[j] = v;
+    }
+    return sorted[len / 2];
+}
+#else
+static int average_samples(const uint32_t *buf, int len) {
+    //  Return the average of the samples, rounded to nearest.  Sum of 12-bit samples will not overflow for len < 2^19.
+    uint32_t sum = 0;
+    int i;
+    assert(len > 0);
+    for (i = 0; i < len; i++) { sum += buf[i]; }
+    return (int) ((sum + len / 2) / len);
+}
+#endif  //  MYNEWT_VAL(TEMP_STM32_DMA_MEDIAN)
+
+/**
+ * Get filtered raw temperature from STM32 internal temperature sensor by collecting TEMP_STM32_DMA_SAMPLES samples via DMA.
+ * On first call, the ADC is opened and left converting continuously into double buffers.  Will block until the next
+ * DMA buffer is complete.  The samples are averaged, or median-filtered if TEMP_STM32_DMA_MEDIAN is 1.
+ *
+ * @param dev The temp_stm32 device
+ * @param timeout How long to wait for the DMA buffer, in milliseconds.  OS_TIMEOUT_NEVER to wait forever.
+ * @param rawtemp Pointer to an int. Will store the filtered raw temperature, ranging from 0 to 4095.
+ *
+ * @return 0 on success, and non-zero error code on failure
+ */
+int temp_stm32_get_filtered_temperature(struct temp_stm32 *dev, uint32_t timeout, int *rawtemp) {
+    uint32_t *buf;
+    int rc;
+    assert(dev);  assert(rawtemp);
+
+    rc = temp_stm32_start_dma(dev);
+    if (rc) { return rc; }
+
+    //  Wait for a buffer that was sampled after this call, so the reading is fresh.
+    buf = temp_stm32_next_dma_buffer(dev, timeout);
+    if (!buf) { return SYS_ETIMEOUT; }
+
+#if MYNEWT_VAL(TEMP_STM32_DMA_MEDIAN)
+    *rawtemp = median_samples(buf, DMA_SAMPLES);
+#else
+    *rawtemp = average_samples(buf, DMA_SAMPLES);
+#endif  //  MYNEWT_VAL(TEMP_STM32_DMA_MEDIAN)
+    return 0;
+}
+#endif  //  MYNEWT_VAL(TEMP_STM32_DMA_SAMPLES) > 0
+
 static int temp_stm32_sensor_get_config(struct sensor *sensor, sensor_type_t type,
     struct sensor_cfg *cfg) {
     //  Return the type of the sensor value returned by the sensor.
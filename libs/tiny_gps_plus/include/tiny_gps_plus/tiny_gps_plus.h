@@ -33,6 +33,11 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 ////#error millis() not defined for OS_TICKS_PER_SEC
 ////#endif  //  OS_TICKS_PER_SEC
 
+#elif defined(TEST_HOST)  //  For testing on the host computer
+#include <stdint.h>
+#include <time.h>
+#define millis() ((uint32_t) (clock() / (CLOCKS_PER_SEC / 1000)))
+
 #elif defined(ARDUINO) && ARDUINO >= 100  //  For Arduino
 #include "Arduino.h"
 #else
@@ -70,6 +75,8 @@ public:
    const RawDegrees &rawLng()     { updated = false; return rawLngData; }
    double lat();
    double lng();
+   int32_t latE7();  // Latitude in 1e-7 degrees, without floating-point
+   int32_t lngE7();  // Longitude in 1e-7 degrees, without floating-point
 
    TinyGPSLocation() : valid(false), updated(false)
    {}
@@ -96,7 +103,7 @@ public:
    uint8_t month();
    uint8_t day();
 
-   TinyGPSDate() : valid(false), updated(false), date(0)
+   TinyGPSDate() : valid(false), updated(false), date(0), newDate(0)
    {}
 
 private:
@@ -121,7 +128,7 @@ public:
    uint8_t second();
    uint8_t centisecond();
 
-   TinyGPSTime() : valid(false), updated(false), time(0)
+   TinyGPSTime() : valid(false), updated(false), time(0), newTime(0)
    {}
 
 private:
@@ -141,7 +148,7 @@ public:
    uint32_t age() const    { return valid ? millis() - lastCommitTime : (uint32_t)ULONG_MAX; }
    int32_t value()         { updated = false; return val; }
 
-   TinyGPSDecimal() : valid(false), updated(false), val(0)
+   TinyGPSDecimal() : valid(false), updated(false), val(0), newval(0)
    {}
 
 private:
@@ -161,7 +168,7 @@ public:
    uint32_t age() const    { return valid ? millis() - lastCommitTime : (uint32_t)ULONG_MAX; }
    uint32_t value()        { updated = false; return val; }
 
-   TinyGPSInteger() : valid(false), updated(false), val(0)
+   TinyGPSInteger() : valid(false), updated(false), val(0), newval(0)
    {}
 
 private:
@@ -247,6 +254,10 @@ public:
   static double courseTo(double lat1, double long1, double lat2, double long2);
   static const char *cardinal(double course);
 
+  // Fixed-point versions for MCUs without an FPU.  Coordinates are in 1e-7 degrees.
+  static uint32_t distanceBetweenE7(int32_t lat1, int32_t long1, int32_t lat2, int32_t long2);  // Meters
+  static uint16_t courseToE7(int32_t lat1, int32_t long1, int32_t lat2, int32_t long2);        // Centidegrees
+
   static int32_t parseDecimal(const char *term);
   static void parseDegrees(const char *term, RawDegrees &deg);
 
@@ -254,6 +265,7 @@ public:
   uint32_t sentencesWithFix() const { return sentencesWithFixCount; }
   uint32_t failedChecksum()   const { return failedChecksumCount; }
   uint32_t passedChecksum()   const { return passedChecksumCount; }
+  uint32_t sentencesSkipped() const { return skippedSentenceCount; }
 
 private:
   enum {GPS_SENTENCE_GPGGA, GPS_SENTENCE_GPRMC, GPS_SENTENCE_OTHER};
@@ -266,6 +278,7 @@ private:
   uint8_t curTermNumber;
   uint8_t curTermOffset;
   bool sentenceHasFix;
+  bool skipSentence;
 
   // custom element support
   friend class TinyGPSCustom;
@@ -278,9 +291,11 @@ private:
   uint32_t sentencesWithFixCount;
   uint32_t failedChecksumCount;
   uint32_t passedChecksumCount;
+  uint32_t skippedSentenceCount;
 
   // internal utilities
   int fromHex(char a);
+  static uint8_t sentenceType(const char *term);
   bool endOfTermHandler();
 };
 
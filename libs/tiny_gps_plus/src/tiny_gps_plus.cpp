@@ -26,9 +26,9 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #define byte    uint8_t
 #define PI      M_PI
 #define TWO_PI  (M_PI * 2.0)
-#define sq(x)   (x * x)
-#define radians(x) (x * M_PI / 180.0)
-#define degrees(x) (x * 180.0 / M_PI)
+#define sq(x)   ((x) * (x))
+#define radians(x) ((x) * M_PI / 180.0)
+#define degrees(x) ((x) * 180.0 / M_PI)
 #define seed48 NOTUSED_seed48
 #include <math.h>
 #undef seed48
@@ -49,12 +49,14 @@ TinyGPSPlus::TinyGPSPlus()
   ,  curTermNumber(0)
   ,  curTermOffset(0)
   ,  sentenceHasFix(false)
+  ,  skipSentence(false)
   ,  customElts(0)
   ,  customCandidates(0)
   ,  encodedCharCount(0)
   ,  sentencesWithFixCount(0)
   ,  failedChecksumCount(0)
   ,  passedChecksumCount(0)
+  ,  skippedSentenceCount(0)
 {
   term[0] = '\0';
 }
@@ -67,6 +69,10 @@ bool TinyGPSPlus::encode(char c)
 {
   ++encodedCharCount;
 
+  // Sentences we don't parse are skipped until the next '$', without parity or term work
+  if (skipSentence && c != '$')
+    return false;
+
   switch(c)
   {
   case ',': // term terminators
@@ -94,6 +100,7 @@ bool TinyGPSPlus::encode(char c)
     curSentenceType = GPS_SENTENCE_OTHER;
     isChecksumTerm = false;
     sentenceHasFix = false;
+    skipSentence = false;
     return false;
 
   default: // ordinary characters
@@ -162,6 +169,20 @@ void TinyGPSPlus::parseDegrees(const char *term, RawDegrees &deg)
   deg.negative = false;
 }
 
+// static
+// Identify the sentence type from the first term e.g. GPRMC, GNGGA.  Only RMC and GGA
+// from GPS (GP) or combined GNSS (GN) talkers are parsed.
+uint8_t TinyGPSPlus::sentenceType(const char *term)
+{
+  if (term[0] != 'G' || (term[1] != 'P' && term[1] != 'N'))
+    return GPS_SENTENCE_OTHER;
+  if (!strcmp(term + 2, _GPRMCterm + 2))
+    return GPS_SENTENCE_GPRMC;
+  if (!strcmp(term + 2, _GPGGAterm + 2))
+    return GPS_SENTENCE_GPGGA;
+  return GPS_SENTENCE_OTHER;
+}
+
 #define COMBINE(sentence_type, term_number) (((unsigned)(sentence_type) << 5) | term_number)
 
 // Processes a just-completed term
@@ -219,18 +240,19 @@ bool TinyGPSPlus::endOfTermHandler()
   // the first term determines the sentence type
   if (curTermNumber == 0)
   {
-    if (!strcmp(term, _GPRMCterm) || !strcmp(term, _GNRMCterm))
-      curSentenceType = GPS_SENTENCE_GPRMC;
-    else if (!strcmp(term, _GPGGAterm) || !strcmp(term, _GNGGAterm))
-      curSentenceType = GPS_SENTENCE_GPGGA;
-    else
-      curSentenceType = GPS_SENTENCE_OTHER;
+    curSentenceType = sentenceType(term);
 
     // Any custom candidates of this sentence type?
     for (customCandidates = customElts; customCandidates != NULL && strcmp(customCandidates->sentenceName, term) < 0; customCandidates = customCandidates->next);
     if (customCandidates != NULL && strcmp(customCandidates->sentenceName, term) > 0)
        customCandidates = NULL;
 
+    // Nothing to parse in this sentence?  Skip the rest of it.
+    if (curSentenceType == GPS_SENTENCE_OTHER && customCandidates == NULL)
+    {
+      skipSentence = true;
+      ++skippedSentenceCount;
+    }
     return false;
   }
 
@@ -337,6 +359,137 @@ double TinyGPSPlus::courseTo(double lat1, double long1, double lat2, double long
   return degrees(a2);
 }
 
+// Fixed-point coordinates: 1e-7 degree units in int32, e.g. 53.3613370 degrees = 533613370.
+// Integer-only versions of distanceBetween() and courseTo() for MCUs without an FPU.
+
+#define E7_PER_DEGREE        10000000L
+#define E7_90_DEGREES        900000000L
+#define E7_180_DEGREES       1800000000L
+#define E7_360_DEGREES       3600000000LL
+#define COS_TABLE_STEP       (E7_90_DEGREES / 64)  // 1.40625 degrees in 1e-7 degrees
+#define COS_TABLE_STEP_RECIP 20015998ULL           // 2^48 / COS_TABLE_STEP, for converting the step remainder to Q16
+#define METERS_PER_E7_Q24    186607ULL             // Meters per 1e-7 degree on a sphere of radius 6372795 m, in Q24
+
+// Cosine of 0 to 90 degrees in 64 steps, in Q15 (32768 = 1.0)
+static const uint16_t cosTableQ15[65] = {
+  32768, 32758, 32729, 32679, 32610, 32522, 32413, 32286,
+  32138, 31972, 31786, 31581, 31357, 31114, 30853, 30572,
+  30274, 29957, 29622, 29269, 28899, 28511, 28106, 27684,
+  27246, 26791, 26320, 25833, 25330, 24812, 24279, 23732,
+  23170, 22595, 22006, 21403, 20788, 20160, 19520, 18868,
+  18205, 17531, 16846, 16151, 15447, 14733, 14010, 13279,
+  12540, 11793, 11039, 10279,  9512,  8740,  7962,  7180,
+   6393,  5602,  4808,  4011,  3212,  2411,  1608,   804,
+      0,
+};
+
+// Cosine of the angle (-180 to 180 degrees, in 1e-7 degrees) in Q15.  Max error is 1 LSB.
+static int32_t cosE7(int32_t angle)
+{
+  uint32_t a = angle < 0 ? (uint32_t)(-(int64_t)angle) : (uint32_t)angle;
+  bool negative = false;
+  if (a > (uint32_t)E7_180_DEGREES) a = (uint32_t)(E7_360_DEGREES - a);
+  if (a > (uint32_t)E7_90_DEGREES) { a = E7_180_DEGREES - a; negative = true; }
+
+  // Interpolate linearly between table entries
+  uint32_t i = a / COS_TABLE_STEP;
+  uint32_t frac = (uint32_t)(((uint64_t)(a % COS_TABLE_STEP) * COS_TABLE_STEP_RECIP) >> 32);  // Q16
+  int32_t c = cosTableQ15[i];
+  if (i < 64)
+    c -= (int32_t)(((uint32_t)(cosTableQ15[i] - cosTableQ15[i + 1]) * frac) >> 16);
+  return negative ? -c : c;
+}
+
+// Integer square root of n, rounded down
+static uint32_t isqrt64(uint64_t n)
+{
+  uint64_t root = 0, bit = 1ULL << 62;
+  while (bit > n) bit >>= 2;
+  while (bit != 0)
+  {
+    if (n >= root + bit)
+    {
+      n -= root + bit;
+      root = (root >> 1) + bit;
+    }
+    else
+      root >>= 1;
+    bit >>= 2;
+  }
+  return (uint32_t)root;
+}
+
+// Arctangent of z (Q15, 0 to 1.0) in centidegrees (0 to 4500).  Max error is 0.09 degrees.
+static int32_t atanQ15(int32_t z)
+{
+  // atan(z) ~= 45 z + z (1 - z) (14.02 + 3.80 z) degrees
+  int32_t w = (z * (32768 - z)) >> 15;
+  int32_t k = 1402 + ((380 * z) >> 15);
+  return (4500 * z + w * k + 16384) >> 15;
+}
+
+// Offsets east (dx) and north (dy) from position 1 to position 2, in 1e-7 degrees of latitude.
+// Longitude is scaled by the cosine of the mean latitude (equirectangular projection).
+// Returns the longitude difference in 1e-7 degrees and the mean latitude.
+static int64_t offsetE7(int32_t lat1, int32_t long1, int32_t lat2, int32_t long2, int64_t &dx, int64_t &dy, int32_t &meanLat)
+{
+  int64_t dlng = (int64_t)long2 - long1;
+  if (dlng > E7_180_DEGREES) dlng -= E7_360_DEGREES;
+  else if (dlng < -E7_180_DEGREES) dlng += E7_360_DEGREES;
+  meanLat = (int32_t)(((int64_t)lat1 + lat2) / 2);
+  dx = (dlng * cosE7(meanLat)) / 32768;
+  dy = (int64_t)lat2 - lat1;
+  return dlng;
+}
+
+/* static */
+uint32_t TinyGPSPlus::distanceBetweenE7(int32_t lat1, int32_t long1, int32_t lat2, int32_t long2)
+{
+  // returns distance in meters between two positions, both specified as
+  // latitude and longitude in 1e-7 degrees.  Uses the equirectangular
+  // approximation on the same sphere as distanceBetween(), with integer
+  // arithmetic only.  Error vs great-circle distance is below 0.01% up to
+  // 100 km and 0.25% at 1000 km (latitudes up to 70 degrees).
+  int64_t dx, dy;
+  int32_t meanLat;
+  offsetE7(lat1, long1, lat2, long2, dx, dy, meanLat);
+  uint32_t d = isqrt64((uint64_t)(dx * dx + dy * dy));
+  return (uint32_t)(((uint64_t)d * METERS_PER_E7_Q24 + (1UL << 23)) >> 24);
+}
+
+/* static */
+uint16_t TinyGPSPlus::courseToE7(int32_t lat1, int32_t long1, int32_t lat2, int32_t long2)
+{
+  // returns course in centidegrees (North=0, West=27000) from position 1 to
+  // position 2, both specified as latitude and longitude in 1e-7 degrees.
+  // Integer arithmetic only.  Error vs courseTo() is below 0.15 degrees
+  // up to 100 km and 0.2 degrees at 1000 km (latitudes up to 70 degrees).
+  int64_t dx, dy;
+  int32_t meanLat;
+  int64_t dlng = offsetE7(lat1, long1, lat2, long2, dx, dy, meanLat);
+  uint64_t ax = dx < 0 ? -dx : dx, ay = dy < 0 ? -dy : dy;
+  if (ax == 0 && ay == 0) return 0;
+
+  // Angle from the nearest north / south axis: atan(min / max), scaled to fit 32-bit division
+  uint64_t hi = ax > ay ? ax : ay, lo = ax > ay ? ay : ax;
+  while (hi >= 65536) { hi >>= 1; lo >>= 1; }
+  int32_t a = atanQ15((int32_t)(((uint32_t)lo << 15) / (uint32_t)hi));
+  if (ax > ay) a = 9000 - a;  // Closer to the east / west axis
+
+  // Map to the quadrant, clockwise from north
+  int32_t course;
+  if (dx >= 0) course = dy >= 0 ? a : 18000 - a;
+  else         course = dy >= 0 ? 36000 - a : 18000 + a;
+
+  // The above is the bearing at the mean latitude.  Convert to the initial bearing by
+  // removing half the convergence of meridians: dlng * sin(meanLat) / 2, in centidegrees.
+  int32_t sinMeanLat = cosE7(E7_90_DEGREES - meanLat);
+  course -= (int32_t)((dlng * sinMeanLat) / (32768LL * 2 * 100000));
+  course %= 36000;
+  if (course < 0) course += 36000;
+  return (uint16_t)course;
+}
+
 const char *TinyGPSPlus::cardinal(double course)
 {
   static const char* directions[] = {"N", "NNE", "NE", "ENE", "E", "ESE", "SE", "SSE", "S", "SSW", "SW", "WSW", "W", "WNW", "NW", "NNW"};
@@ -376,6 +529,25 @@ double TinyGPSLocation::lng()
    return rawLngData.negative ? -ret : ret;
 }
 
+// Convert raw degrees to 1e-7 degrees without floating-point
+static int32_t rawToE7(const RawDegrees &raw)
+{
+   int32_t ret = (int32_t)raw.deg * E7_PER_DEGREE + (int32_t)((raw.billionths + 50) / 100);
+   return raw.negative ? -ret : ret;
+}
+
+int32_t TinyGPSLocation::latE7()
+{
+   updated = false;
+   return rawToE7(rawLatData);
+}
+
+int32_t TinyGPSLocation::lngE7()
+{
+   updated = false;
+   return rawToE7(rawLngData);
+}
+
 void TinyGPSDate::commit()
 {
    date = newDate;
@@ -0,0 +1,358 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+//  Recorded NMEA streams for the TinyGPSPlus replay test, with the values expected after replaying each one.
+//  The L70R stream is an excerpt of logs/gps.log.  The others were generated to cover other receivers and fix conditions.
+//  Expected counts follow the Mynewt parser: only RMC and GGA are checksummed, other sentences are counted as skipped.
+#ifndef __NMEA_LOGS_H__
+#define __NMEA_LOGS_H__
+#include <stdint.h>
+
+struct nmea_expected {
+    uint32_t passed;          //  passedChecksum()
+    uint32_t failed;          //  failedChecksum()
+    uint32_t skipped;         //  sentencesSkipped()
+    uint32_t with_fix;        //  sentencesWithFix()
+    uint8_t  location_valid;  //  location.isValid()
+    int32_t  lat_e7;          //  location.latE7()
+    int32_t  lng_e7;          //  location.lngE7()
+    uint8_t  altitude_valid;  //  altitude.isValid()
+    int32_t  altitude;        //  altitude.value(), centimetres
+    uint32_t satellites;      //  satellites.value()
+    int32_t  hdop;            //  hdop.value(), hundredths
+    uint8_t  date_valid;      //  date.isValid()
+    uint32_t date;            //  date.value(), DDMMYY
+    uint32_t time;            //  time.value(), HHMMSSCC
+    int32_t  speed;           //  speed.value(), hundredths of a knot
+    int32_t  course;          //  course.value(), centidegrees
+};
+
+struct nmea_log {
+    const char *name;
+    const char *data;
+    uint32_t size;
+    struct nmea_expected expected;
+};
+
+//  Quectel L70R cold start to first fix, from logs/gps.log: console output interleaved, bytes lost
+static const char l70r_console_log[] =
+    "$GPGGA,234857.105,,,,,0,0,,,M,,M,,*43\r\n"
+    "$,,,,0.00,0.00,090919,,,N*4E\r\n"
+    "$$GPGGA,234858.105,,,,,0,0,,,M,,M,,*4C\r\n"
+    "$\r\n"
+    "$G$GPGGA,234859.105,,,,,0,0,,,M,,M,,*4D\r\n"
+    "$G,06,,,33,02,,,23,30,,,23*7D\r\n"
+    "$GPR$GPGGA,234900.105,,,,,0,0,,,M,,M,,*40\r\n"
+    "$G3,02,,,25,30,,,24*7C\r\n"
+    "$$GPGGA,234901.090,,,,,0,0,,,M,,M,,*4C\r\n"
+    "$,V,,,,,0.00,0.00,090919,,,N*41\r\n"
+    "$GPVTGA,A,1,,,,,,,,,,,,,,,*1E\r\n"
+    "$GPG00,N,0.00,K,N*32\r\n"
+    "$GPGGA,234902.310,,,,,0,0,,,M,,M,,*44\r\n"
+    "$\r\n"
+    "$$GPGGA,234903.305,,,,,0,3,,,M,,M,,*42\r\n"
+    "$GP*** satellites: 3\r\n"
+    ",,,$GPGGA,234904.305,,,,,0,3,,,M,,M,,*45\r\n"
+    "$28,36,004,*74\r\n"
+    "$GPGS2,090919,,,N*74\r\n"
+    "$$GPGGA,234906.000,,,,,0,3,,,M,,M,,*41\r\n"
+    "$33,28,36,004,*73\r\n"
+    "$05,090919,,,N*76\r\n"
+    "$G$GPGGA,234907.000,0116.2278,N,10348.4871,E,1,3,9.05,146.1,M,3.9,M,,*6D\r\n"
+    "*** lat: 1.2704 / lng: 103.8081 / alt: 146.10\r\n"
+    "\r\n"
+    "$GPGLL,015.2278,N,10348.4871,E,0.21,110.36,090919,,,A*66\r\n"
+    "$146.1,M,3.9,M,,*62\r\n"
+    "$231,21,06,53,251,32,07,46,172,32,28,36,004,*71\r\n"
+    "$GPGSV07.205,A,0116.2267,N,10348.4866,E,0.47,115.88,090919,,,A*69\r\n"
+    "$$GPGGA,234909.000,0116.2265,N,10348.4867,E,1,3,9.07,146.1,M,3.9,M,,*6A\r\n"
+    "*** lat: 1.2704 / lng: 103.8081 / alt: 146.10\r\n"
+    "\r\n"
+    "$GPGLL,01GS9,,11,03,038,,13,02,269,,193,,,*7D\r\n"
+    "$GPGGPVTG,110.64,T,,M,0.29,N,0.55,K,A*34\r\n"
+    "$GPGGA,234910.000,0116.2267,N,10348.4868,E,1,3,9.08,146.1,M,3.9,M,,*60\r\n"
+    "$G*** lat: 1.2704 / lng: 103.8081 / alt: 146.10\r\n"
+    "5F\r\n"
+    "$GPGS,1PVTG,84.59,T,,M,0.09,N,0.16,K,A*03\r\n"
+    "ADC open ch 16\r\n"
+    "STM read int temp sensor\r\n"
+    "Rust handle_sensor_data\r\n"
+    "TMP listener got rawtmp\r\n"
+    "Rust send_sensor_data\r\n"
+    "NET network not ready\r\n"
+    "TMP network not ready\r\n"
+    "$GPGGA,234911.000,0116.2240,N,10348.4850,E,1,3,9.09,146.1,M,3.9,M,,*6E\r\n"
+    "*** lat: 1.2704 / lng: 103.8080 / alt: 146.10\r\n"
+    "\r\n"
+    "$GPGLL,06,$GPGGA,234912.000,0116.2216,N,10348.4835,E,1,3,9.10,146.1,M,3.9,M,,*65\r\n"
+    "*** lat: 1.2703 / lng: 103.8080 / alt: 146.10\r\n"
+    "\r\n"
+    "$GPGLL,0\r\n"
+    "V,3$GPGGA,234913.000,0116.2163,N,10348.4799,E,1,3,9.11,146.1,M,3.9,M,,*6D\r\n"
+    "*** lat: 1.2702 / lng: 103.8080 / alt: 146.10\r\n"
+    "\r\n"
+    "$GPGLL,053,2513.000,A,0116.2163,N,10348.4799,E,0.35,154.43,090919,,,A*64\r\n"
+    "$GPV8,E,1,3,9.11,146.1,M,3.9,M,,*66\r\n"
+    "$1,09,30,69,231,30,06,53,251,32,07,46,172,33,28,36,004,*70\r\n"
+    "$\r\n"
+    "$$GPGGA,234915.000,0116.2116,N,10348.4765,E,1,3,9.13,146.1,M,3.9,M,,*68\r\n"
+    "*** lat: 1.2701 / lng: 103.8079 / alt: 146.10\r\n"
+    "\r\n"
+    "$GPGLL,0,38.4765,E,0.20,184.18,090919,,,A*64\r\n"
+    "$$GPGGA,234916.000,0116.2110,N,10348.4762,E,1,3,9.14,146.1,M,3.9,M,,*6D\r\n"
+    "*** lat: 1.2701 / lng: 103.8079 / alt: 146.10\r\n"
+    "\r\n"
+    "$GPGLL,01$G3,09,02,,,28*78\r\n"
+    "$$GPGGA,234917.000,0116.2105,N,10348.4759,E,1,3,9.16,146.1,M,3.9,M,,*62\r\n"
+    "$GPS*** lat: 1.2701 / lng: 103.8079 / alt: 146.10\r\n"
+    "A,A,2,06,11,02,038,,13,02,269,,193,,,*7C\r\n"
+    "$5.15,T,,M,0.11,N,0.21,K,A*06\r\n"
+    "$GPGGA,234918.000,0116.2099,N,10348.4755,E,1,3,9.16,146.1,M,3.9,M,,*65\r\n"
+    "*** lat: 1.2701 / lng: 103.8079 / alt: 146.10\r\n"
+    "\r\n"
+    "$GPGLL,01PG2,038,,13,02,269,,193,,,*7C\r\n"
+    "$,M,0.19,N,0.35,K,A*32\r\n"
+    "$GPGGA,234919.000,0116.2094,N,10348.4749,E,1,3,9.18,146.1,M,3.9,M,,*6A\r\n"
+    "*** lat: 1.2701 / lng: 103.8079 / alt: 146.10\r\n"
+    "\r\n"
+    "$GPGLL,00,3,02,269,,193,,,*7C\r\n"
+    "$GPGSV0.24,N,0.44,K,A*35\r\n"
+    "$GPGGA0,A,A*5E\r\n"
+    "$GPGS,2,09,09,17,159,21,11,02,038,,13,02,269,,193,,,*7F\r\n"
+    "$A*6F\r\n"
+    "$GP$GPGGA,234921.000,0116.2091,N,10348.4744,E,1,3,9.20,146.1,M,3.9,M,,*62\r\n"
+    "$*** lat: 1.2701 / lng: 103.8079 / alt: 146.10\r\n"
+    "1,30,06,531.000,A,0116.2091,N,10348.4744,E,0.39,254.70,090919,,,A*66\r\n"
+    "$$GPGGA,234922.000,0116.2091,N,10348.4745,E,1,3,9.21,146.1,M,3.9,M,,*61\r\n"
+    "*** lat: 1.2701 / lng: 103.8079 / alt: 146.10\r\n"
+    "\r\n"
+    "$GPGLL,016,,,*75\r\n"
+    "$A*3A\r\n"
+    "$GPGGA,234923.000,0116.2090,N,10348.4742,E,1,3,9.22,146.1,M,3.9,M,,*65\r\n"
+    "$G*** lat: 1.2701 / lng: 103.8079 / alt: 146.10\r\n"
+    ",30,,,,,,038,,13,02,269,,193,,,*7A\r\n"
+    "$G2,T,,M,0.70,N,1.30,K,A*3F\r\n"
+    "$GPGGA,234924.000,0116.2091,N,10348.4741,E,1,3,9.23,146.1,M,3.9,M,,*61\r\n"
+    "*** lat: 1.2701 / lng: 103.8079 / alt: 146.10\r\n"
+    "\r\n"
+    "$GPGLL,0,,,193,,,*75\r\n"
+    "$GA*34\r\n"
+    "$GPGGA,234925.000,0116.2092,N,10348.4740,E,1,3,9.24,146.1,M,3.9,M,,*65\r\n"
+    "*** lat: 1.2701 / lng: 103.8079 / alt: 146.10\r\n"
+    "\r\n"
+    "$GPGLL,01,$GPGSV,3,3,09,02,,,25*75\r\n"
+    "$GPRMA,234925.210,0116.2093,N,10348.4740,E,1,3,9.24,146.1,M,3.9,M,,*67\r\n"
+    "$,,,,,,,,,9.29,9.24,1.00*0D\r\n"
+    "$9,,193,,,*75\r\n"
+    "$GP,A*37\r\n"
+    "$GPGGA,234927.000,0116.2090,N,10348.4736,E,1,3,9.26,146.1,M,3.9,M,,*66\r\n"
+    "*** lat: 1.2701 / lng: 103.8078 / alt: 146.10\r\n"
+    "\r\n"
+    "$GPGLL,0,1,10348.4736,E,0.68,225.19,090919,,,A*69\r\n"
+    "$ADC open ch 16\r\n"
+    "STM read int temp sensor\r\n"
+    "Rust handle_sensor_data\r\n"
+    "TMP listener got rawtmp\r\n"
+    "Rust send_sensor_data\r\n"
+    "NET network not ready\r\n"
+    "TMP network not ready\r\n"
+    "$GPGGA,234928.000,0116.2090,N,10348.4735,E,1,3,9.27,146.1,M,3.9,M,,*6B\r\n";
+
+//  MTK multi-GNSS receiver: GN talker, GSA / GSV / VTG skipped, moving east at 10 m/s
+static const char mtk_gnss_moving_log[] =
+    "$GNGGA,081500.00,0121.1260,N,10349.1880,E,1,10,0.80,21.5,M,4.5,M,,*49\r\n"
+    "$GNGSA,A,3,05,12,15,18,20,24,25,,,,,,1.52,0.82,1.28*13\r\n"
+    "$GNGSA,A,3,68,69,78,79,,,,,,,,,1.52,0.82,1.28*1B\r\n"
+    "$GPGSV,3,1,10,05,45,123,38,12,30,234,35,15,60,045,40,18,15,300,28*75\r\n"
+    "$GLGSV,2,1,07,68,45,123,33,69,30,234,31,78,60,045,36,79,15,300,25*66\r\n"
+    "$GNRMC,081500.00,A,0121.1260,N,10349.1880,E,19.44,90.00,170426,,,A*42\r\n"
+    "$GNVTG,90.00,T,,M,19.44,N,36.00,K,A*17\r\n"
+    "$GNGGA,081501.00,0121.1260,N,10349.1934,E,1,11,0.81,21.6,M,4.5,M,,*45\r\n"
+    "$GNGSA,A,3,05,12,15,18,20,24,25,,,,,,1.52,0.82,1.28*13\r\n"
+    "$GNGSA,A,3,68,69,78,79,,,,,,,,,1.52,0.82,1.28*1B\r\n"
+    "$GPGSV,3,1,10,05,45,123,38,12,30,234,35,15,60,045,40,18,15,300,28*75\r\n"
+    "$GLGSV,2,1,07,68,45,123,33,69,30,234,31,78,60,045,36,79,15,300,25*66\r\n"
+    "$GNRMC,081501.00,A,0121.1260,N,10349.1934,E,19.45,90.10,170426,,,A*4D\r\n"
+    "$GNVTG,90.10,T,,M,19.45,N,36.00,K,A*17\r\n"
+    "$GNGGA,081502.00,0121.1260,N,10349.1988,E,1,12,0.82,21.7,M,4.5,M,,*40\r\n"
+    "$GNGSA,A,3,05,12,15,18,20,24,25,,,,,,1.52,0.82,1.28*13\r\n"
+    "$GNGSA,A,3,68,69,78,79,,,,,,,,,1.52,0.82,1.28*1B\r\n"
+    "$GPGSV,3,1,10,05,45,123,38,12,30,234,35,15,60,045,40,18,15,300,28*75\r\n"
+    "$GLGSV,2,1,07,68,45,123,33,69,30,234,31,78,60,045,36,79,15,300,25*66\r\n"
+    "$GNRMC,081502.00,A,0121.1260,N,10349.1988,E,19.46,90.20,170426,,,A*49\r\n"
+    "$GNVTG,90.20,T,,M,19.46,N,36.00,K,A*17\r\n"
+    "$GNGGA,081503.00,0121.1260,N,10349.2042,E,1,10,0.83,21.8,M,4.5,M,,*41\r\n"
+    "$GNGSA,A,3,05,12,15,18,20,24,25,,,,,,1.52,0.82,1.28*13\r\n"
+    "$GNGSA,A,3,68,69,78,79,,,,,,,,,1.52,0.82,1.28*1B\r\n"
+    "$GPGSV,3,1,10,05,45,123,38,12,30,234,35,15,60,045,40,18,15,300,28*75\r\n"
+    "$GLGSV,2,1,07,68,45,123,33,69,30,234,31,78,60,045,36,79,15,300,25*66\r\n"
+    "$GNRMC,081503.00,A,0121.1260,N,10349.2042,E,19.47,90.30,170426,,,A*44\r\n"
+    "$GNVTG,90.30,T,,M,19.47,N,36.00,K,A*17\r\n"
+    "$GNGGA,081504.00,0121.1260,N,10349.2096,E,1,11,0.84,21.9,M,4.5,M,,*48\r\n"
+    "$GNGSA,A,3,05,12,15,18,20,24,25,,,,,,1.52,0.82,1.28*13\r\n"
+    "$GNGSA,A,3,68,69,78,79,,,,,,,,,1.52,0.82,1.28*1B\r\n"
+    "$GPGSV,3,1,10,05,45,123,38,12,30,234,35,15,60,045,40,18,15,300,28*75\r\n"
+    "$GLGSV,2,1,07,68,45,123,33,69,30,234,31,78,60,045,36,79,15,300,25*66\r\n"
+    "$GNRMC,081504.00,A,0121.1260,N,10349.2096,E,19.48,90.40,170426,,,A*42\r\n"
+    "$GNVTG,90.40,T,,M,19.48,N,36.00,K,A*1F\r\n"
+    "$GNGGA,081505.00,0121.1260,N,10349.2150,E,1,12,0.85,22.0,M,4.5,M,,*4A\r\n"
+    "$GNGSA,A,3,05,12,15,18,20,24,25,,,,,,1.52,0.82,1.28*13\r\n"
+    "$GNGSA,A,3,68,69,78,79,,,,,,,,,1.52,0.82,1.28*1B\r\n"
+    "$GPGSV,3,1,10,05,45,123,38,12,30,234,35,15,60,045,40,18,15,300,28*75\r\n"
+    "$GLGSV,2,1,07,68,45,123,33,69,30,234,31,78,60,045,36,79,15,300,25*66\r\n"
+    "$GNRMC,081505.00,A,0121.1260,N,10349.2150,E,19.49,90.50,170426,,,A*48\r\n"
+    "$GNVTG,90.50,T,,M,19.49,N,36.00,K,A*1F\r\n"
+    "$GNGGA,081506.00,0121.1260,N,10349.2203,E,1,10,0.86,22.1,M,4.5,M,,*4C\r\n"
+    "$GNGSA,A,3,05,12,15,18,20,24,25,,,,,,1.52,0.82,1.28*13\r\n"
+    "$GNGSA,A,3,68,69,78,79,,,,,,,,,1.52,0.82,1.28*1B\r\n"
+    "$GPGSV,3,1,10,05,45,123,38,12,30,234,35,15,60,045,40,18,15,300,28*75\r\n"
+    "$GLGSV,2,1,07,68,45,123,33,69,30,234,31,78,60,045,36,79,15,300,25*66\r\n"
+    "$GNRMC,081506.00,A,0121.1260,N,10349.2203,E,19.50,90.60,170426,,,A*45\r\n"
+    "$GNVTG,90.60,T,,M,19.50,N,36.00,K,A*14\r\n"
+    "$GNGGA,081507.00,0121.1260,N,10349.2257,E,1,11,0.87,22.2,M,4.5,M,,*4F\r\n"
+    "$GNGSA,A,3,05,12,15,18,20,24,25,,,,,,1.52,0.82,1.28*13\r\n"
+    "$GNGSA,A,3,68,69,78,79,,,,,,,,,1.52,0.82,1.28*1B\r\n"
+    "$GPGSV,3,1,10,05,45,123,38,12,30,234,35,15,60,045,40,18,15,300,28*75\r\n"
+    "$GLGSV,2,1,07,68,45,123,33,69,30,234,31,78,60,045,36,79,15,300,25*66\r\n"
+    "$GNRMC,081507.00,A,0121.1260,N,10349.2257,E,19.51,90.70,170426,,,A*45\r\n"
+    "$GNVTG,90.70,T,,M,19.51,N,36.00,K,A*14\r\n"
+    "$GNGGA,081508.00,0121.1260,N,10349.2311,E,1,12,0.88,22.3,M,4.5,M,,*4E\r\n"
+    "$GNGSA,A,3,05,12,15,18,20,24,25,,,,,,1.52,0.82,1.28*13\r\n"
+    "$GNGSA,A,3,68,69,78,79,,,,,,,,,1.52,0.82,1.28*1B\r\n"
+    "$GPGSV,3,1,10,05,45,123,38,12,30,234,35,15,60,045,40,18,15,300,28*75\r\n"
+    "$GLGSV,2,1,07,68,45,123,33,69,30,234,31,78,60,045,36,79,15,300,25*66\r\n"
+    "$GNRMC,081508.00,A,0121.1260,N,10349.2311,E,19.52,90.80,170426,,,A*45\r\n"
+    "$GNVTG,90.80,T,,M,19.52,N,36.00,K,A*18\r\n"
+    "$GNGGA,081509.00,0121.1260,N,10349.2365,E,1,10,0.89,22.4,M,4.5,M,,*48\r\n"
+    "$GNGSA,A,3,05,12,15,18,20,24,25,,,,,,1.52,0.82,1.28*13\r\n"
+    "$GNGSA,A,3,68,69,78,79,,,,,,,,,1.52,0.82,1.28*1B\r\n"
+    "$GPGSV,3,1,10,05,45,123,38,12,30,234,35,15,60,045,40,18,15,300,28*75\r\n"
+    "$GLGSV,2,1,07,68,45,123,33,69,30,234,31,78,60,045,36,79,15,300,25*66\r\n"
+    "$GNRMC,081509.00,A,0121.1260,N,10349.2365,E,19.53,90.90,170426,,,A*47\r\n"
+    "$GNVTG,90.90,T,,M,19.53,N,36.00,K,A*18\r\n"
+    "$GNGGA,081510.00,0121.1260,N,10349.2419,E,1,11,0.90,22.5,M,4.5,M,,*44\r\n"
+    "$GNGSA,A,3,05,12,15,18,20,24,25,,,,,,1.52,0.82,1.28*13\r\n"
+    "$GNGSA,A,3,68,69,78,79,,,,,,,,,1.52,0.82,1.28*1B\r\n"
+    "$GPGSV,3,1,10,05,45,123,38,12,30,234,35,15,60,045,40,18,15,300,28*75\r\n"
+    "$GLGSV,2,1,07,68,45,123,33,69,30,234,31,78,60,045,36,79,15,300,25*66\r\n"
+    "$GNRMC,081510.00,A,0121.1260,N,10349.2419,E,19.54,91.00,170426,,,A*4C\r\n"
+    "$GNVTG,91.00,T,,M,19.54,N,36.00,K,A*17\r\n"
+    "$GNGGA,081511.00,0121.1260,N,10349.2473,E,1,12,0.91,22.6,M,4.5,M,,*48\r\n"
+    "$GNGSA,A,3,05,12,15,18,20,24,25,,,,,,1.52,0.82,1.28*13\r\n"
+    "$GNGSA,A,3,68,69,78,79,,,,,,,,,1.52,0.82,1.28*1B\r\n"
+    "$GPGSV,3,1,10,05,45,123,38,12,30,234,35,15,60,045,40,18,15,300,28*75\r\n"
+    "$GLGSV,2,1,07,68,45,123,33,69,30,234,31,78,60,045,36,79,15,300,25*66\r\n"
+    "$GNRMC,081511.00,A,0121.1260,N,10349.2473,E,19.55,91.10,170426,,,A*41\r\n"
+    "$GNVTG,91.10,T,,M,19.55,N,36.00,K,A*17\r\n";
+
+//  u-blox receiver: TXT / VTG / GSA / GLL skipped, DGPS fix south and west, below sea level, time rolls over midnight
+static const char ublox_dgps_sw_log[] =
+    "$GPTXT,01,01,02,u-blox ag - www.u-blox.com*50\r\n"
+    "$GPTXT,01,01,02,HW  UBX-G70xx   00070000*57\r\n"
+    "$GPRMC,235955.00,A,4935.0000,S,06821.1000,W,0.012,,311226,,,D*76\r\n"
+    "$GPVTG,,T,,M,0.012,N,0.022,K,D*25\r\n"
+    "$GPGGA,235955.00,4935.0000,S,06821.1000,W,2,09,0.91,-105.4,M,14.2,M,,0000*71\r\n"
+    "$GPGSA,A,3,01,03,08,11,14,17,19,22,28,,,,1.63,0.91,1.35*02\r\n"
+    "$GPGLL,4935.0000,S,06821.1000,W,235955.00,A,D*69\r\n"
+    "$GPRMC,235956.00,A,4935.0000,S,06821.1000,W,0.012,,311226,,,D*75\r\n"
+    "$GPVTG,,T,,M,0.012,N,0.022,K,D*25\r\n"
+    "$GPGGA,235956.00,4935.0000,S,06821.1000,W,2,09,0.91,-105.4,M,14.2,M,,0000*72\r\n"
+    "$GPGSA,A,3,01,03,08,11,14,17,19,22,28,,,,1.63,0.91,1.35*02\r\n"
+    "$GPGLL,4935.0000,S,06821.1000,W,235956.00,A,D*6A\r\n"
+    "$GPRMC,235957.00,A,4935.0000,S,06821.1000,W,0.012,,311226,,,D*74\r\n"
+    "$GPVTG,,T,,M,0.012,N,0.022,K,D*25\r\n"
+    "$GPGGA,235957.00,4935.0000,S,06821.1000,W,2,09,0.91,-105.4,M,14.2,M,,0000*73\r\n"
+    "$GPGSA,A,3,01,03,08,11,14,17,19,22,28,,,,1.63,0.91,1.35*02\r\n"
+    "$GPGLL,4935.0000,S,06821.1000,W,235957.00,A,D*6B\r\n"
+    "$GPRMC,235958.00,A,4935.0000,S,06821.1000,W,0.012,,311226,,,D*7B\r\n"
+    "$GPVTG,,T,,M,0.012,N,0.022,K,D*25\r\n"
+    "$GPGGA,235958.00,4935.0000,S,06821.1000,W,2,09,0.91,-105.4,M,14.2,M,,0000*7C\r\n"
+    "$GPGSA,A,3,01,03,08,11,14,17,19,22,28,,,,1.63,0.91,1.35*02\r\n"
+    "$GPGLL,4935.0000,S,06821.1000,W,235958.00,A,D*64\r\n"
+    "$GPRMC,235959.00,A,4935.0000,S,06821.1000,W,0.012,,311226,,,D*7A\r\n"
+    "$GPVTG,,T,,M,0.012,N,0.022,K,D*25\r\n"
+    "$GPGGA,235959.00,4935.0000,S,06821.1000,W,2,09,0.91,-105.4,M,14.2,M,,0000*7D\r\n"
+    "$GPGSA,A,3,01,03,08,11,14,17,19,22,28,,,,1.63,0.91,1.35*02\r\n"
+    "$GPGLL,4935.0000,S,06821.1000,W,235959.00,A,D*65\r\n"
+    "$GPRMC,000000.00,A,4935.0000,S,06821.1000,W,0.012,,311226,,,D*7B\r\n"
+    "$GPVTG,,T,,M,0.012,N,0.022,K,D*25\r\n"
+    "$GPGGA,000000.00,4935.0000,S,06821.1000,W,2,09,0.91,-105.4,M,14.2,M,,0000*7C\r\n"
+    "$GPGSA,A,3,01,03,08,11,14,17,19,22,28,,,,1.63,0.91,1.35*02\r\n"
+    "$GPGLL,4935.0000,S,06821.1000,W,000000.00,A,D*64\r\n"
+    "$GPRMC,000001.00,A,4935.0000,S,06821.1000,W,0.012,,311226,,,D*7A\r\n"
+    "$GPVTG,,T,,M,0.012,N,0.022,K,D*25\r\n"
+    "$GPGGA,000001.00,4935.0000,S,06821.1000,W,2,09,0.91,-105.4,M,14.2,M,,0000*7D\r\n"
+    "$GPGSA,A,3,01,03,08,11,14,17,19,22,28,,,,1.63,0.91,1.35*02\r\n"
+    "$GPGLL,4935.0000,S,06821.1000,W,000001.00,A,D*65\r\n"
+    "$GPRMC,000002.00,A,4935.0000,S,06821.1000,W,0.012,,311226,,,D*79\r\n"
+    "$GPVTG,,T,,M,0.012,N,0.022,K,D*25\r\n"
+    "$GPGGA,000002.00,4935.0000,S,06821.1000,W,2,09,0.91,-105.4,M,14.2,M,,0000*7E\r\n"
+    "$GPGSA,A,3,01,03,08,11,14,17,19,22,28,,,,1.63,0.91,1.35*02\r\n"
+    "$GPGLL,4935.0000,S,06821.1000,W,000002.00,A,D*66\r\n";
+
+//  Fix lost: RMC void and GGA quality 0 with empty fields keep the last location, speed and altitude
+static const char fix_lost_log[] =
+    "$GPGGA,120000.00,5128.2000,N,00027.2580,W,1,07,1.20,25.0,M,47.0,M,,*7B\r\n"
+    "$GPRMC,120000.00,A,5128.2000,N,00027.2580,W,27.00,270.00,010526,,,A*79\r\n"
+    "$GPGGA,120001.00,5128.2000,N,00027.2700,W,1,07,1.20,25.0,M,47.0,M,,*70\r\n"
+    "$GPRMC,120001.00,A,5128.2000,N,00027.2700,W,27.00,270.00,010526,,,A*72\r\n"
+    "$GPGGA,120002.00,5128.2000,N,00027.2820,W,1,07,1.20,25.0,M,47.0,M,,*7E\r\n"
+    "$GPRMC,120002.00,A,5128.2000,N,00027.2820,W,27.00,270.00,010526,,,A*7C\r\n"
+    "$GPGGA,120003.00,5128.2000,N,00027.2940,W,1,07,1.20,25.0,M,47.0,M,,*78\r\n"
+    "$GPRMC,120003.00,A,5128.2000,N,00027.2940,W,27.00,270.00,010526,,,A*7A\r\n"
+    "$GPGGA,120004.00,,,,,0,00,,,M,,M,,*4F\r\n"
+    "$GPRMC,120004.00,V,,,,,,,010526,,,N*7A\r\n"
+    "$GPGGA,120005.00,,,,,0,00,,,M,,M,,*4E\r\n"
+    "$GPRMC,120005.00,V,,,,,,,010526,,,N*7B\r\n"
+    "$GPGGA,120006.00,,,,,0,00,,,M,,M,,*4D\r\n"
+    "$GPRMC,120006.00,V,,,,,,,010526,,,N*78\r\n"
+    "$GPGGA,120007.00,,,,,0,00,,,M,,M,,*4C\r\n"
+    "$GPRMC,120007.00,V,,,,,,,010526,,,N*79\r\n";
+
+//  Corrupted stream: bad checksums, lowercase hex, truncated sentences, binary noise, overlong field
+static const char corrupted_log[] =
+    "$GPRMC,101459.00,A,3723.4600,N,12202.2600,W,1.52,45.00,150826,,,A*7b\r\n"
+    "$GPGGA,101500.00,3723.4651,N,12202.2690,W,1,05,2.10,12.5,M,-25.7,M,,*5A\r\n"
+    "$GPGGA,101501.00,3723.46$GPGGA,101500.00,3723.4650,N,12202.2690,W,1,05,2.10,12.5,M,-25.7,M,,*5A\r\n"
+    "\x00""\xff""#@!garbage\r\n"
+    "$GPRMC,101501.00,A,3723.4700,N,12202.2700,W,1.50,45.00,150826,,,*ZZ\r\n"
+    "$GPGGA,101502.00,3723.470012345678901,N,12202.2700,W,1,05,2.10,12.5,M,-25.7,M,,*64\r\n"
+    "$GPGSV,1,1,01,05,45,123,38*FF\r\n"
+    "$GPGGA*\r\n"
+    "$*\r\n"
+    "$\r\n"
+    "$GPRMC,101503.00,A,3723.4800,N,12202.2800,W,1.60,46.00,150826,,,A*77\r\n";
+
+//  passed, failed, skipped, with_fix, location_valid, lat_e7, lng_e7, altitude_valid, altitude,
+//  satellites, hdop, date_valid, date, time, speed, course
+static const struct nmea_log nmea_logs[] = {
+    { "l70r_console", l70r_console_log, sizeof(l70r_console_log) - 1,
+      { 27, 39, 54, 18, 1, 12701500, 1038078917, 1, 14610, 3, 927, 0, 0, 23492800, 0, 0 } },
+    { "mtk_gnss_moving", mtk_gnss_moving_log, sizeof(mtk_gnss_moving_log) - 1,
+      { 24, 0, 60, 24, 1, 13521000, 1038207883, 1, 2260, 12, 91, 1, 170426, 8151100, 1955, 9110 } },
+    { "ublox_dgps_sw", ublox_dgps_sw_log, sizeof(ublox_dgps_sw_log) - 1,
+      { 16, 0, 26, 16, 1, -495833333, -683516667, 1, -10540, 9, 91, 1, 311226, 200, 1, 0 } },
+    { "fix_lost", fix_lost_log, sizeof(fix_lost_log) - 1,
+      { 16, 0, 0, 8, 1, 514700000, -4549000, 1, 2500, 0, 120, 1, 10526, 12000700, 2700, 27000 } },
+    { "corrupted", corrupted_log, sizeof(corrupted_log) - 1,
+      { 4, 3, 3, 4, 1, 373913333, -1220380000, 1, 1250, 5, 210, 1, 150826, 10150300, 160, 4600 } },
+};
+
+#define NUM_NMEA_LOGS (sizeof(nmea_logs) / sizeof(nmea_logs[0]))
+
+#endif  //  __NMEA_LOGS_H__
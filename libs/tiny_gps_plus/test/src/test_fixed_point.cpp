@@ -0,0 +1,122 @@
+//  Accuracy and speed benchmark for the fixed-point coordinate functions, compared with the double-precision versions.
+//  Runs on the device or on the host:
+//  g++ -DTEST_HOST -Iinclude -o test_fixed_point src/tiny_gps_plus.cpp test/src/test_fixed_point.cpp && ./test_fixed_point
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+#include "tiny_gps_plus/tiny_gps_plus.h"
+
+#define NUM_PAIRS 2000
+#define NUM_LOOPS 100
+
+static int32_t lat1[NUM_PAIRS], lng1[NUM_PAIRS], lat2[NUM_PAIRS], lng2[NUM_PAIRS];
+static uint32_t seed = 1;
+
+static int32_t random_range(int32_t lo, int32_t hi) {
+    //  Return a pseudo-random number between lo and hi inclusive.  Same sequence on every platform.
+    seed = seed * 1103515245 + 12345;
+    return lo + (int32_t) (((uint64_t) (seed >> 1) * (uint32_t) (hi - lo + 1)) >> 31);
+}
+
+static void make_pairs(int32_t max_offset) {
+    //  Generate pairs of positions at latitudes up to 70 degrees, up to max_offset (1e-7 degrees) apart.
+    for (int i = 0; i < NUM_PAIRS; i++) {
+        lat1[i] = random_range(-700000000, 700000000);
+        lng1[i] = random_range(-1800000000, 1799999999);
+        lat2[i] = lat1[i] + random_range(-max_offset, max_offset);
+        int64_t lng = (int64_t) lng1[i] + random_range(-max_offset, max_offset);
+        if (lng >= 1800000000) { lng -= 3600000000LL; }  //  Wrap around the date line
+        if (lng < -1800000000) { lng += 3600000000LL; }
+        lng2[i] = (int32_t) lng;
+    }
+}
+
+static void test_accuracy(const char *label, int32_t max_offset, double max_dist_err, double max_course_err) {
+    //  Compare the fixed-point distance and course with the double-precision versions.
+    make_pairs(max_offset);
+    double worst_dist = 0, worst_course = 0;
+    for (int i = 0; i < NUM_PAIRS; i++) {
+        double a = lat1[i] / 1e7, b = lng1[i] / 1e7, c = lat2[i] / 1e7, d = lng2[i] / 1e7;
+        double dist = TinyGPSPlus::distanceBetween(a, b, c, d);
+        uint32_t dist_e7 = TinyGPSPlus::distanceBetweenE7(lat1[i], lng1[i], lat2[i], lng2[i]);
+        if (dist < 10) { continue; }  //  Too close for meaningful relative errors
+        double err = (fabs(dist_e7 - dist) - 0.5) / dist * 100;  //  Exclude rounding to whole metres
+        if (err > worst_dist) { worst_dist = err; }
+
+        double course = TinyGPSPlus::courseTo(a, b, c, d);
+        double course_e7 = TinyGPSPlus::courseToE7(lat1[i], lng1[i], lat2[i], lng2[i]) / 100.0;
+        double diff = fabs(course_e7 - course);
+        if (diff > 180) { diff = 360 - diff; }
+        if (diff > worst_course) { worst_course = diff; }
+    }
+    printf("%-10s max distance error %.4f%%, max course error %.3f deg\n", label, worst_dist, worst_course);
+    fflush(stdout);
+    assert(worst_dist < max_dist_err);
+    assert(worst_course < max_course_err);
+}
+
+static void test_parse(void) {
+    //  latE7() / lngE7() must agree with lat() / lng() to the nearest 1e-7 degree.
+    TinyGPSPlus gps;
+    const char *s = "$GPGGA,092750.000,5321.6802,N,00630.3372,W,1,8,1.03,61.7,M,55.2,M,,*76\r\n";
+    while (*s) { gps.encode(*s++); }
+    assert(gps.location.isValid());
+    assert(gps.location.latE7() == (int32_t) lround(gps.location.lat() * 1e7));
+    assert(gps.location.lngE7() == (int32_t) lround(gps.location.lng() * 1e7));
+    assert(gps.location.lngE7() < 0);  //  West is negative
+    assert(gps.altitude.value() == 6170);  //  Altitude in centimetres
+}
+
+static void test_edges(void) {
+    assert(TinyGPSPlus::distanceBetweenE7(0, 0, 0, 0) == 0);
+    assert(TinyGPSPlus::courseToE7(0, 0, 0, 0) == 0);
+    assert(TinyGPSPlus::courseToE7(0, 0, 1000, 0) == 0);      //  North
+    assert(TinyGPSPlus::courseToE7(0, 0, 0, 1000) == 9000);   //  East
+    assert(TinyGPSPlus::courseToE7(0, 0, -1000, 0) == 18000); //  South
+    assert(TinyGPSPlus::courseToE7(0, 0, 0, -1000) == 27000); //  West
+    //  Across the date line: 0.2 degrees apart, not 359.8
+    uint32_t d = TinyGPSPlus::distanceBetweenE7(0, 1799000000, 0, -1799000000);
+    assert(d > 22000 && d < 22500);
+    assert(TinyGPSPlus::courseToE7(0, 1799000000, 0, -1799000000) == 9000);
+}
+
+static void test_speed(void) {
+    //  Time both versions over the same pairs.  On an MCU without FPU the gap is much wider than on the host.
+    volatile double sum = 0;
+    volatile uint32_t sum_e7 = 0;
+    make_pairs(10000000);
+    clock_t start = clock();
+    for (int n = 0; n < NUM_LOOPS; n++) {
+        for (int i = 0; i < NUM_PAIRS; i++) {
+            sum = sum + TinyGPSPlus::distanceBetween(lat1[i] / 1e7, lng1[i] / 1e7, lat2[i] / 1e7, lng2[i] / 1e7)
+                + TinyGPSPlus::courseTo(lat1[i] / 1e7, lng1[i] / 1e7, lat2[i] / 1e7, lng2[i] / 1e7);
+        }
+    }
+    clock_t mid = clock();
+    for (int n = 0; n < NUM_LOOPS; n++) {
+        for (int i = 0; i < NUM_PAIRS; i++) {
+            sum_e7 = sum_e7 + TinyGPSPlus::distanceBetweenE7(lat1[i], lng1[i], lat2[i], lng2[i])
+                + TinyGPSPlus::courseToE7(lat1[i], lng1[i], lat2[i], lng2[i]);
+        }
+    }
+    clock_t end = clock();
+    double calls = 2.0 * NUM_LOOPS * NUM_PAIRS;
+    printf("double: %.1f ns/call, fixed-point: %.1f ns/call\n",
+        (mid - start) * 1e9 / CLOCKS_PER_SEC / calls, (end - mid) * 1e9 / CLOCKS_PER_SEC / calls);
+}
+
+int test_fixed_point(void) {
+    test_parse();
+    test_edges();
+    test_accuracy("1 km",     90000,    0.1, 0.15);
+    test_accuracy("100 km",   9000000,  0.1, 0.15);
+    test_accuracy("1000 km",  90000000, 0.5, 0.5);
+    test_speed();
+    printf("fixed-point tests OK\n");
+    return 0;
+}
+
+#ifdef TEST_HOST
+int main(void) { return test_fixed_point(); }
+#endif  //  TEST_HOST
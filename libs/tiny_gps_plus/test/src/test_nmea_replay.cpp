@@ -0,0 +1,94 @@
+//  Replay recorded NMEA streams through TinyGPSPlus: check the parsed fields against the expected values,
+//  then measure parsing throughput for each stream.  Runs on the device or on the host:
+//  g++ -O2 -DTEST_HOST -Iinclude -o test_nmea_replay src/tiny_gps_plus.cpp test/src/test_nmea_replay.cpp && ./test_nmea_replay
+#include <assert.h>
+#include <stdio.h>
+#include <time.h>
+#include "tiny_gps_plus/tiny_gps_plus.h"
+#include "nmea_logs.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define READ_CYCLES() __rdtsc()  //  Time stamp counter, close to the core clock on recent CPUs
+#endif  //  __x86_64__ || __i386__
+
+#define NUM_LOOPS 2000
+
+static int failures = 0;
+
+#define CHECK(log, field, actual, expected) check(log, field, (int64_t) (actual), (int64_t) (expected))
+
+static void check(const struct nmea_log *log, const char *field, int64_t actual, int64_t expected) {
+    if (actual == expected) { return; }
+    printf("%s: %s is %lld, expected %lld\n", log->name, field, (long long) actual, (long long) expected);
+    failures++;
+}
+
+static void replay(TinyGPSPlus &gps, const struct nmea_log *log) {
+    //  Feed every byte of the stream to the parser, as the UART would.
+    for (uint32_t i = 0; i < log->size; i++) { gps.encode(log->data[i]); }
+}
+
+static void test_conformance(const struct nmea_log *log) {
+    //  Replay the stream once into a new parser and compare every field with the expected values.
+    const struct nmea_expected *e = &log->expected;
+    TinyGPSPlus gps;
+    replay(gps, log);
+    CHECK(log, "charsProcessed",   gps.charsProcessed(),   log->size);
+    CHECK(log, "passedChecksum",   gps.passedChecksum(),   e->passed);
+    CHECK(log, "failedChecksum",   gps.failedChecksum(),   e->failed);
+    CHECK(log, "sentencesSkipped", gps.sentencesSkipped(), e->skipped);
+    CHECK(log, "sentencesWithFix", gps.sentencesWithFix(), e->with_fix);
+    CHECK(log, "location valid",   gps.location.isValid(), e->location_valid);
+    if (e->location_valid) {
+        CHECK(log, "latE7", gps.location.latE7(), e->lat_e7);
+        CHECK(log, "lngE7", gps.location.lngE7(), e->lng_e7);
+    }
+    CHECK(log, "altitude valid", gps.altitude.isValid(), e->altitude_valid);
+    if (e->altitude_valid) { CHECK(log, "altitude", gps.altitude.value(), e->altitude); }
+    CHECK(log, "satellites", gps.satellites.value(), e->satellites);
+    CHECK(log, "hdop",       gps.hdop.value(),       e->hdop);
+    CHECK(log, "date valid", gps.date.isValid(),     e->date_valid);
+    if (e->date_valid) { CHECK(log, "date", gps.date.value(), e->date); }
+    CHECK(log, "time",       gps.time.value(),       e->time);
+    CHECK(log, "speed",      gps.speed.value(),      e->speed);
+    CHECK(log, "course",     gps.course.value(),     e->course);
+}
+
+static void test_throughput(const struct nmea_log *log) {
+    //  Replay the stream many times into one parser and report bytes per second and time per sentence.
+    //  Sentences include the skipped ones, since the parser still has to scan them for the next '$'.
+    TinyGPSPlus gps;
+#ifdef READ_CYCLES
+    uint64_t start_cycles = READ_CYCLES();
+#endif  //  READ_CYCLES
+    clock_t start = clock();
+    for (int n = 0; n < NUM_LOOPS; n++) { replay(gps, log); }
+    clock_t end = clock();
+    double secs = (double) (end - start) / CLOCKS_PER_SEC;
+    double sentences = (double) gps.passedChecksum() + gps.failedChecksum() + gps.sentencesSkipped();
+    printf("%-16s %6lu bytes %4lu sentences  %7.1f MB/s %7.1f ns/sentence",
+        log->name, (unsigned long) log->size, (unsigned long) (sentences / NUM_LOOPS),
+        gps.charsProcessed() / secs / 1e6, secs * 1e9 / sentences);
+#ifdef READ_CYCLES
+    uint64_t cycles = READ_CYCLES() - start_cycles;
+    printf(" %7.1f cycles/sentence %5.2f cycles/byte", cycles / sentences, (double) cycles / gps.charsProcessed());
+#endif  //  READ_CYCLES
+    printf("\n");
+    //  Replaying must not change the outcome, only multiply the counts.
+    CHECK(log, "replayed passedChecksum", gps.passedChecksum(), log->expected.passed * NUM_LOOPS);
+}
+
+int test_nmea_replay(void) {
+    for (uint32_t i = 0; i < NUM_NMEA_LOGS; i++) { test_conformance(&nmea_logs[i]); }
+    fflush(stdout);
+    assert(failures == 0);
+    for (uint32_t i = 0; i < NUM_NMEA_LOGS; i++) { test_throughput(&nmea_logs[i]); }
+    assert(failures == 0);
+    printf("NMEA replay tests OK\n");
+    return 0;
+}
+
+#ifdef TEST_HOST
+int main(void) { return test_nmea_replay(); }
+#endif  //  TEST_HOST
@@ -24,6 +24,8 @@
 
 use mynewt::{
     result::*,                  //  Import Mynewt result and error types
+    kernel::os,                 //  Import Mynewt OS API
+    executor::{ self, Deferred },  //  Import Mynewt async executor
     hw::sensor::{               //  Import Mynewt Sensor API
         SensorValue, SensorValueType,
     },
@@ -32,17 +34,25 @@ use mynewt::{
     libs::{
         sensor_network,         //  Import Mynewt Sensor Network API
     },
-    coap, d, Strn,              //  Import Mynewt macros
+    coap, d, Ptr, Strn,         //  Import Mynewt macros
+    coap_root, coap_array, coap_item, coap_item_int_val, coap_item_str,
 };
 use mynewt_macros::strn;        //  Import Mynewt procedural macros
+use crate::trail::{             //  Import GPS trail buffer
+    Trail, TrailPoint, TRAIL_SIZE, TRAIL_TOLERANCE,
+};
 
 ///  Aggregate the sensor value with other sensor data before transmitting to server.
 ///  If the sensor value is a GPS geolocation, we remember it and attach it to other sensor data for transmission.
-#[cfg(feature = "use_float")]  //  If floating-point is enabled...
+///  The geolocation is also added to the trail, which is attached to the next transmission.
+///  Geolocation is in fixed-point so this works without floating-point.
 pub fn aggregate_sensor_data(sensor_value: &SensorValue) -> MynewtResult<()>  {  //  Returns an error code upon error.
-    if let SensorValueType::Geolocation {..} = sensor_value.value {
+    if let SensorValueType::Geolocation { latitude, longitude, .. } = sensor_value.value {
         //  If this is a geolocation, save the geolocation for later transmission.
         unsafe { CURRENT_GEOLOCATION = sensor_value.value };  //  Current geolocation is unsafe because it's a mutable static
+        //  Add the geolocation to the trail, timestamped in seconds.
+        let time = os::time_get() ? / os::OS_TICKS_PER_SEC;
+        unsafe { TRAIL.add(TrailPoint { time, latitude, longitude }) };  //  Trail is unsafe because it's a mutable static
         Ok(())
     } else {
         //  If this is temperature sensor data, attach the current geolocation to the sensor data for transmission.
@@ -55,10 +65,20 @@ pub fn aggregate_sensor_data(sensor_value: &SensorValue) -> MynewtResult<()>  {
     }
 }
 
-#[cfg(not(feature = "use_float"))]  //  If floating-point and geolocation are disabled, send sensor data without geolocation
-pub fn aggregate_sensor_data(sensor_value: &SensorValue) -> MynewtResult<()>  {  //  Returns an error code upon error.
-    //  Transmit sensor value without geolocation and return the result
-    send_sensor_data(sensor_value)
+///  Aggregate and transmit the sensor value like `aggregate_sensor_data()`, for use with `mynewt::executor`.
+///  Composing the CoAP message blocks while another task is composing, so the aggregation runs in the task
+///  that owns `eventq` (e.g. the default Event Queue) while other futures continue to run.
+///  Returns `SYS_EBUSY` if the previous sensor value is still being transmitted.
+pub async fn aggregate_sensor_data_async(sensor_value: &SensorValue, eventq: *mut os::os_eventq) -> MynewtResult<()> {
+    if unsafe { POST_DEFERRED.is_busy() } { return Err(MynewtError::SYS_EBUSY); }
+    unsafe { POST_VALUE = Some(*sensor_value) };  //  Sensor value is copied because the future may be dropped
+    executor::run_deferred(unsafe { &mut POST_DEFERRED }, eventq, aggregate_deferred, core::ptr::null_mut()).await
+}
+
+///  Aggregate the sensor value saved by `aggregate_sensor_data_async()`
+fn aggregate_deferred(_arg: Ptr) -> MynewtResult<()> {
+    let sensor_value = unsafe { POST_VALUE.take() }.ok_or(MynewtError::SYS_EINVAL) ? ;
+    aggregate_sensor_data(&sensor_value)
 }
 
 /// Compose a CoAP JSON message with the Sensor Key (field name), Value and Geolocation (optional) in `val`
@@ -69,9 +89,12 @@ pub fn aggregate_sensor_data(sensor_value: &SensorValue) -> MynewtResult<()>  {
 /// ```json
 /// {"values":[
 ///   {"key":"t",      "value":1715, "geo": { "lat": ..., "long": ... }},
-///   {"key":"device", "value":"0102030405060708090a0b0c0d0e0f10"}
+///   {"key":"device", "value":"0102030405060708090a0b0c0d0e0f10"},
+///   {"key":"trail",  "age":[...], "lat":[...], "long":[...]}
 /// ]}
 /// ```
+/// The trail item is present only if we have recorded any geolocation since the last transmission.
+/// See `encode_trail()` for the trail encoding.
 fn send_sensor_data(val: &SensorValue) -> MynewtResult<()>  {  //  Returns an error code upon error.
     console::print("Rust send_sensor_data: ");
     if let SensorValueType::Uint(i) = val.value {
@@ -93,25 +116,46 @@ fn send_sensor_data(val: &SensorValue) -> MynewtResult<()>  {  //  Returns an er
     //  If network transport not ready, tell caller (Sensor Listener) to try again later.
     if !rc { return Err(MynewtError::SYS_EAGAIN); }
 
-    //  Compose the CoAP Payload using the coap!() macro.
-    //  Select @json or @cbor To encode CoAP Payload in JSON or CBOR format.
-    let _payload = coap!( @json {        
-        //  Create `values` as an array of items under the root.
-        //  Assume `val` contains `key: "t", val: 2870, geo: { lat, long }`. 
-        //  Append to the `values` array the Sensor Key, Value and optional Geolocation:
-        //  `{"key": "t", "value": 2870, "geo": { "lat": ..., "long": ... }}`
-        val,
+    //  Take the simplified trail recorded since the last transmission.
+    let mut trail = [TrailPoint::default(); TRAIL_SIZE + 1];
+    let trail_len = unsafe { TRAIL.segment(&mut trail) };  //  Trail is unsafe because it's a mutable static
 
-        //  Append to the `values` array the random device ID:
-        //  `{"key":"device", "value":"0102030405060708090a0b0c0d0e0f10"}`
-        "device": &device_id,
-    });
+    if trail_len < 2 {
+        //  No trail to attach.  Compose the CoAP Payload using the coap!() macro.
+        //  Select @json or @cbor To encode CoAP Payload in JSON or CBOR format.
+        let _payload = coap!( @json {        
+            //  Create `values` as an array of items under the root.
+            //  Assume `val` contains `key: "t", val: 2870, geo: { lat, long }`. 
+            //  Append to the `values` array the Sensor Key, Value and optional Geolocation:
+            //  `{"key": "t", "value": 2870, "geo": { "lat": ..., "long": ... }}`
+            val,
+
+            //  Append to the `values` array the random device ID:
+            //  `{"key":"device", "value":"0102030405060708090a0b0c0d0e0f10"}`
+            "device": &device_id,
+        });
+    } else {
+        //  The coap!() template only has string and sensor value items, not the integer arrays
+        //  of the trail, so we compose the payload item by item with coap_root!() etc.
+        coap_root!(@json COAP_CONTEXT {
+            coap_array!(@json COAP_CONTEXT, values, {
+                coap_item_int_val!(@json COAP_CONTEXT, val);
+                coap_item_str!(@json COAP_CONTEXT, "device", &device_id);
+                coap_item!(@json COAP_CONTEXT, {
+                    unsafe { encode_trail(&mut COAP_CONTEXT, &trail[..trail_len]) };
+                });
+            });
+        });
+    }
 
     //  Post the CoAP Server message to the CoAP Background Task for transmission.  After posting the
     //  message to the background task, we release a semaphore that unblocks other requests
     //  to compose and post CoAP messages.
     sensor_network::do_server_post() ? ;
 
+    //  Start the next trail segment from the last transmitted geolocation.
+    unsafe { TRAIL.restart() };  //  Trail is unsafe because it's a mutable static
+
     //  Display the URL with the random device ID for viewing the sensor data.
     console::print("NET view your sensor at \nhttps://blue-pill-geolocate.appspot.com?device=");
     console::print_strn(&device_id); console::print("\n");
@@ -120,6 +164,39 @@ fn send_sensor_data(val: &SensorValue) -> MynewtResult<()>  {  //  Returns an er
     Ok(())
 }
 
+///  Encode the trail as an item in the `values` array.  Timestamps are encoded as the age in seconds
+///  relative to the newest geolocation.  Latitude and longitude are in 1e-7 degrees, with the first
+///  geolocation encoded in full and the rest as differences from the previous geolocation, which are
+///  much shorter.  The server recovers the coordinates by summing the differences.
+/// ```json
+/// {"key":"trail", "age":[120,60,0], "lat":[14121132,-250,-310], "long":[22199454,180,95]}
+/// ```
+fn encode_trail(context: &mut CoapContext, trail: &[TrailPoint]) {
+    let mut age  = [0i32; TRAIL_SIZE + 1];
+    let mut lat  = [0i32; TRAIL_SIZE + 1];
+    let mut long = [0i32; TRAIL_SIZE + 1];
+    let newest = trail[trail.len() - 1].time;
+    for (i, point) in trail.iter().enumerate() {
+        age[i] = newest.wrapping_sub(point.time) as i32;
+        if i == 0 {
+            lat[i]  = point.latitude;
+            long[i] = point.longitude;
+        } else {
+            lat[i]  = point.latitude.wrapping_sub(trail[i - 1].latitude);
+            long[i] = point.longitude.wrapping_sub(trail[i - 1].longitude);
+        }
+    }
+    context.json_set_text_string(strn!("key"), strn!("trail"));
+    context.json_set_int_array(strn!("age"),  &age[..trail.len()]);
+    context.json_set_int_array(strn!("lat"),  &lat[..trail.len()]);
+    context.json_set_int_array(strn!("long"), &long[..trail.len()]);
+}
+
 ///  Current geolocation recorded from GPS
-#[cfg(feature = "use_float")]  //  If floating-point is enabled...
-static mut CURRENT_GEOLOCATION: SensorValueType = SensorValueType::None;
\ No newline at end of file
+static mut CURRENT_GEOLOCATION: SensorValueType = SensorValueType::None;
+
+///  Trail of geolocations since the last transmission, simplified to within `TRAIL_TOLERANCE` metres
+static mut TRAIL: Trail = Trail::new(TRAIL_TOLERANCE);
+///  Deferred call and sensor value for `aggregate_sensor_data_async()`
+static mut POST_DEFERRED: Deferred = Deferred::new();
+static mut POST_VALUE: Option<SensorValue> = None;
@@ -24,10 +24,10 @@ use mynewt::{
     hw::sensor_mgr,                         //  Import Mynewt Sensor Manager API
     hw::sensor::{        
         self,                               //  Import Mynewt Sensor API
-        sensor_type_t,
+        sensor_listener, SensorListener, SensorValue,
     },
     sys::console,                           //  Import Mynewt Console API
-    Strn,                                   //  Import Mynewt macros    
+    Strn, fill_zero,                        //  Import Mynewt macros    
 };
 use mynewt_macros::{ init_strn };           //  Import Mynewt procedural macros
 use crate::app_network;                     //  Import `app_network.rs` for sending sensor data
@@ -38,8 +38,21 @@ static SENSOR_DEVICE: Strn      = init_strn!("temp_stub_0");
 const SENSOR_POLL_TIME: u32     = (30 * 1000);  
 ///  Use key (field name) `t` to transmit raw temperature to CoAP Server
 const TEMP_SENSOR_KEY: Strn     = init_strn!("t");
-///  Type of sensor: Raw temperature sensor (integer sensor values 0 to 4095)
-const TEMP_SENSOR_TYPE: sensor_type_t = sensor::SENSOR_TYPE_AMBIENT_TEMPERATURE_RAW;
+
+///  Listener that transmits the sensor data: decodes raw temperature (integer from 0 to 4095) and calls `aggregate_sensor_data()`.
+///  Resolved at compile time, see `sensor::static_sensor_listener()`.
+struct TempListener;
+
+impl SensorListener for TempListener {
+    type Data = sensor::RawTemperature;
+    const SENSOR_KEY: &'static Strn = &TEMP_SENSOR_KEY;
+    fn handle(sensor_value: &SensorValue) -> MynewtResult<()> {
+        app_network::aggregate_sensor_data(sensor_value)
+    }
+}
+
+///  Sensor listener registered with Mynewt, which keeps a pointer to it
+static mut TEMP_LISTENER: sensor_listener = fill_zero!(sensor_listener);
 
 ///  Ask Mynewt to poll or read the temperature sensor and call `aggregate_sensor_data()`
 ///  Return `Ok()` if successful, else return `Err()` with `MynewtError` error code inside.
@@ -56,14 +69,10 @@ pub fn start_sensor_listener() -> MynewtResult<()>  {  //  Returns an error code
     sensor::set_poll_rate_ms(&SENSOR_DEVICE, SENSOR_POLL_TIME) ? ;
 
     // Create a sensor listener that will call function `aggregate_sensor_data` after polling the sensor data
-    let listener = sensor::new_sensor_listener(
-        &TEMP_SENSOR_KEY,   //  Transmit as field: `t`
-        TEMP_SENSOR_TYPE,   //  Type of sensor data: Raw temperature (integer from 0 to 4095)
-        app_network::aggregate_sensor_data  //  Call this function with the polled data: `aggregate_sensor_data`
-    ) ? ;
+    unsafe { TEMP_LISTENER = sensor::static_sensor_listener::<TempListener>() };
 
     //  Register the Listener Function to be called with the polled sensor data.
-    sensor::register_listener(sensor, listener) ? ;  //  `?` means in case of error, return error now.
+    sensor::register_static_listener(sensor, unsafe { &mut TEMP_LISTENER }) ? ;  //  `?` means in case of error, return error now.
 
     //  Return `Ok()` to indicate success.  This line should not end with a semicolon (;).
     Ok(())
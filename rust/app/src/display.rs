@@ -1,49 +1,39 @@
 //  Display Driver code has been moved to https://github.com/lupyuen/piet-embedded/blob/master/piet-embedded-graphics/src/display.rs
-use embedded_graphics::{
-    prelude::*,
-    fonts,
-    pixelcolor::Rgb565,
-    primitives::{
-        Circle,
-        Rectangle,
-    },
-};
 use mynewt::{
     result::*,
     sys::console,
+    dirty::Rect,
+    display::DisplayBus,
+    spi::SpiBus,
+    fill,
+    text,
 };
 
+/// RGB565 colours
+const BLACK: u16   = 0x0000;
+const BLUE: u16    = 0x001f;
+const MAGENTA: u16 = 0xf81f;
+const YELLOW: u16  = 0xffe0;
+
 /// Render some graphics and text to the PineTime display. `start_display()` must have been called earlier.
 pub fn test_display() -> MynewtResult<()> {
     console::print("Rust test display\n"); console::flush();
     
-    //  Create black background
-    let background = Rectangle::<Rgb565>
-        ::new( Coord::new( 0, 0 ), Coord::new( 239, 239 ) )   //  Rectangle coordinates
-        .fill( Some( Rgb565::from(( 0x00, 0x00, 0x00 )) ) );  //  Black
+    //  Whole display, the clip area of the shapes
+    let screen = Rect::new(0, 0, 239, 239);
 
-    //  Create circle
-    let circle = Circle::<Rgb565>
-        ::new( Coord::new( 40, 40 ), 40 )                     //  Circle centre and radius
-        .fill( Some( Rgb565::from(( 0xff, 0x00, 0xff )) ) );  //  Magenta
+    //  Render black background as one window of a repeated colour
+    fill::fill_rect(&mut SpiBus, &screen, &screen, BLACK) ? ;
 
-    //  Create square
-    let square = Rectangle::<Rgb565>
-        ::new( Coord::new( 60, 60 ), Coord::new( 150, 150 ) ) //  Square coordinates
-        .fill( Some( Rgb565::from(( 0x00, 0x00, 0xff )) ) );  //  Blue
+    //  Render magenta circle as one span per row
+    fill::fill_circle(&mut SpiBus, 40, 40, 40, &screen, MAGENTA) ? ;
 
-    //  Create text
-    let text = fonts::Font12x16::<Rgb565>
-        ::render_str("I AM PINETIME")                          //  Text to be rendered
-        .stroke( Some( Rgb565::from(( 0x00, 0x00, 0x00 )) ) )  //  Black text
-        .fill(   Some( Rgb565::from(( 0xff, 0xff, 0x00 )) ) )  //  Yellow background
-        .translate( Coord::new( 20, 16 ));                     //  Shift the text
+    //  Render blue square
+    fill::fill_rect(&mut SpiBus, &Rect::new(60, 60, 150, 150), &screen, BLUE) ? ;
 
-    //  Render background, circle, square and text to display
-    druid::draw_to_display(background);
-    druid::draw_to_display(circle);
-    druid::draw_to_display(square);
-    druid::draw_to_display(text);    
+    //  Render black text on yellow background with the glyph atlas, one window for the line
+    text::draw_text(&mut SpiBus, "I AM PINETIME", 20, 16, BLACK, YELLOW) ? ;
+    SpiBus.flush() ? ;
 
     //  Return success to the caller
     Ok(())
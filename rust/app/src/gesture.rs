@@ -0,0 +1,236 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+//!  Gesture recognizer for the touch controller.  Turns the touch points reported after each touch interrupt
+//!  into taps, long presses and swipes.  The first touch point is sent at once as a touch down, so that the UI
+//!  may respond before the gesture is known.  Invalid `(0,0)` points reported by the controller are ignored.
+//!  The controller doesn't always report the finger being lifted, so the caller also reports a release
+//!  when no touch has been reported for `RELEASE_MS`.  Times are in milliseconds.
+//!  To test on the host: `rustc --edition 2018 --test gesture.rs -o /tmp/test_gesture && /tmp/test_gesture`
+
+///  Finger is considered lifted when no touch has been reported for this long
+pub const RELEASE_MS: u32 = 80;
+
+///  Finger must be held for this long without moving to make a long press
+const LONG_PRESS_MS: u32 = 600;
+
+///  Finger may move this many pixels in each direction and still make a tap or long press
+const TAP_SLOP: u16 = 16;
+
+///  Finger must move at least this many pixels to make a swipe
+const SWIPE_MIN: u16 = 40;
+
+///  Touch action reported by the controller: touch down
+pub const ACTION_DOWN: u8 = 0;
+
+///  Touch action reported by the controller: touch up
+pub const ACTION_UP: u8 = 1;
+
+///  Touch action reported by the controller: contact
+pub const ACTION_CONTACT: u8 = 2;
+
+///  Gesture recognized from the touch points
+#[derive(Clone, Copy, Debug, PartialEq)]
+pub enum Gesture {
+    ///  Finger down at the first touch point.  Sent at once, before the touch is recognized as another gesture.
+    Down { x: u16, y: u16 },
+    ///  Short touch without moving, at the first touch point
+    Tap { x: u16, y: u16 },
+    ///  Touch held without moving for `LONG_PRESS_MS`, at the first touch point.  Sent while the finger is still down.
+    LongPress { x: u16, y: u16 },
+    ///  Touch moved by at least `SWIPE_MIN` pixels, starting at the first touch point
+    Swipe { direction: Direction, x: u16, y: u16 },
+}
+
+///  Direction of a swipe
+#[derive(Clone, Copy, Debug, PartialEq)]
+pub enum Direction { Up, Down, Left, Right }
+
+///  Touch point and the time it was reported
+#[derive(Clone, Copy)]
+struct Point { x: u16, y: u16, time: u32 }
+
+///  Gesture recognizer state for a single finger
+pub struct GestureEngine {
+    ///  First touch point, if the finger is down
+    start: Option<Point>,
+    ///  Last touch point
+    last: Point,
+    ///  True if the finger has moved beyond `TAP_SLOP`
+    moved: bool,
+    ///  True if a long press has been sent for this touch
+    long_pressed: bool,
+}
+
+impl GestureEngine {
+    ///  Create a gesture recognizer with the finger lifted
+    pub const fn new() -> GestureEngine {
+        GestureEngine { start: None, last: Point { x: 0, y: 0, time: 0 }, moved: false, long_pressed: false }
+    }
+
+    ///  Return true if the finger is down
+    pub fn is_touching(&self) -> bool {
+        self.start.is_some()
+    }
+
+    ///  Handle a touch point reported by the controller with the action (down, up or contact).
+    ///  Returns the gesture recognized, if any.
+    pub fn touch(&mut self, x: u16, y: u16, action: u8, now: u32) -> Option<Gesture> {
+        if x == 0 && y == 0 { return None; }  //  Invalid point, see `touch_sensor.rs`
+        let point = Point { x, y, time: now };
+        let start = match self.start {
+            None => {
+                //  Finger down.  A lone touch up is treated as a touch down, and makes a tap when released after `RELEASE_MS`.
+                self.start = Some(point);
+                self.last = point;
+                self.moved = false;
+                self.long_pressed = false;
+                return Some(Gesture::Down { x, y });
+            }
+            Some(start) => start,
+        };
+        self.last = point;
+        if distance(start.x, x) > TAP_SLOP || distance(start.y, y) > TAP_SLOP { self.moved = true; }
+        if action == ACTION_UP { return self.release(now); }
+        if !self.moved && !self.long_pressed && now.wrapping_sub(start.time) >= LONG_PRESS_MS {
+            self.long_pressed = true;
+            return Some(Gesture::LongPress { x: start.x, y: start.y });
+        }
+        None
+    }
+
+    ///  Handle the finger being lifted, or no touch reported for `RELEASE_MS`.  Returns the gesture recognized, if any.
+    pub fn release(&mut self, now: u32) -> Option<Gesture> {
+        let start = self.start.take() ? ;
+        let (dx, dy) = (self.last.x as i32 - start.x as i32, self.last.y as i32 - start.y as i32);
+        if dx.abs() >= SWIPE_MIN as i32 || dy.abs() >= SWIPE_MIN as i32 {
+            //  Swipe in the direction that moved the most
+            let direction =
+                if dx.abs() >= dy.abs() { if dx > 0 { Direction::Right } else { Direction::Left } }
+                else if dy > 0 { Direction::Down } else { Direction::Up };
+            return Some(Gesture::Swipe { direction, x: start.x, y: start.y });
+        }
+        if self.moved || self.long_pressed { return None; }
+        //  Held without moving.  Long press if no touch was reported in time to send it while the finger was down.
+        if self.last.time.wrapping_sub(start.time) >= LONG_PRESS_MS || now.wrapping_sub(start.time) >= LONG_PRESS_MS + RELEASE_MS {
+            return Some(Gesture::LongPress { x: start.x, y: start.y });
+        }
+        Some(Gesture::Tap { x: start.x, y: start.y })
+    }
+}
+
+///  Distance between two coordinates
+fn distance(a: u16, b: u16) -> u16 {
+    if a > b { a - b } else { b - a }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    ///  Feed the touch points `(x, y, action, time)` to a new recognizer, then release at `release_time`.
+    ///  Returns the gestures recognized after the touch down, which must be sent for the first valid point.
+    fn script(points: &[(u16, u16, u8, u32)], release_time: u32) -> Vec<Gesture> {
+        let mut engine = GestureEngine::new();
+        let mut gestures = Vec::new();
+        for &(x, y, action, time) in points {
+            if let Some(gesture) = engine.touch(x, y, action, time) { gestures.push(gesture); }
+        }
+        if let Some(gesture) = engine.release(release_time) { gestures.push(gesture); }
+        assert!(!engine.is_touching());
+        let &(x, y, _, _) = points.iter().find(|p| p.0 != 0 || p.1 != 0).unwrap();
+        assert_eq!(gestures.remove(0), Gesture::Down { x, y });
+        gestures
+    }
+
+    #[test]
+    fn tap() {
+        let gestures = script(&[
+            (100, 120, ACTION_DOWN, 0), (0, 0, ACTION_CONTACT, 10), (104, 118, ACTION_CONTACT, 40), (103, 121, ACTION_UP, 90),
+        ], 90);
+        assert_eq!(gestures, [Gesture::Tap { x: 100, y: 120 }]);
+    }
+
+    #[test]
+    fn down_is_sent_at_once() {
+        //  Touch down is sent for the first point, before the tap is recognized
+        let mut engine = GestureEngine::new();
+        assert_eq!(engine.touch(0, 0, ACTION_DOWN, 0), None);
+        assert_eq!(engine.touch(100, 120, ACTION_DOWN, 5), Some(Gesture::Down { x: 100, y: 120 }));
+        assert_eq!(engine.touch(101, 120, ACTION_CONTACT, 30), None);
+        assert_eq!(engine.touch(101, 121, ACTION_UP, 60), Some(Gesture::Tap { x: 100, y: 120 }));
+    }
+
+    #[test]
+    fn lone_touch_up() {
+        //  Controller reports only the touch up: touch down at once, tap when released after `RELEASE_MS`
+        let gestures = script(&[(100, 120, ACTION_UP, 0)], RELEASE_MS);
+        assert_eq!(gestures, [Gesture::Tap { x: 100, y: 120 }]);
+    }
+
+    #[test]
+    fn tap_without_touch_up() {
+        //  Controller doesn't report the touch up.  Released after `RELEASE_MS`.
+        let gestures = script(&[(100, 120, ACTION_DOWN, 0), (101, 120, ACTION_CONTACT, 30)], 30 + RELEASE_MS);
+        assert_eq!(gestures, [Gesture::Tap { x: 100, y: 120 }]);
+    }
+
+    #[test]
+    fn long_press() {
+        //  Long press is sent while the finger is down, and nothing is sent on release
+        let mut points = vec![(60, 60, ACTION_DOWN, 0)];
+        for time in (50..=800).step_by(50) { points.push((62, 59, ACTION_CONTACT, time)); }
+        points.push((61, 60, ACTION_UP, 850));
+        let gestures = script(&points, 850);
+        assert_eq!(gestures, [Gesture::LongPress { x: 60, y: 60 }]);
+    }
+
+    #[test]
+    fn long_press_without_contact() {
+        //  No touch reported after the touch down, so the long press is sent on release
+        let gestures = script(&[(60, 60, ACTION_DOWN, 0)], LONG_PRESS_MS + RELEASE_MS);
+        assert_eq!(gestures, [Gesture::LongPress { x: 60, y: 60 }]);
+    }
+
+    #[test]
+    fn swipes() {
+        let cases = [
+            ((30, 120), (200, 130), Direction::Right),
+            ((200, 120), (30, 110), Direction::Left),
+            ((120, 200), (125, 40), Direction::Up),
+            ((120, 40), (110, 200), Direction::Down),
+        ];
+        for &((x0, y0), (x1, y1), direction) in cases.iter() {
+            let mut points = vec![(x0, y0, ACTION_DOWN, 0)];
+            for step in 1..=10u32 {
+                let x = (x0 as i32 + (x1 as i32 - x0 as i32) * step as i32 / 10) as u16;
+                let y = (y0 as i32 + (y1 as i32 - y0 as i32) * step as i32 / 10) as u16;
+                points.push((x, y, if step == 10 { ACTION_UP } else { ACTION_CONTACT }, step * 20));
+            }
+            let gestures = script(&points, 200);
+            assert_eq!(gestures, [Gesture::Swipe { direction, x: x0, y: y0 }]);
+        }
+    }
+
+    #[test]
+    fn short_drag_is_ignored() {
+        //  Moved beyond `TAP_SLOP` but less than `SWIPE_MIN`: neither a tap nor a swipe
+        let gestures = script(&[(100, 100, ACTION_DOWN, 0), (125, 100, ACTION_CONTACT, 50), (130, 100, ACTION_UP, 100)], 100);
+        assert_eq!(gestures, []);
+    }
+}
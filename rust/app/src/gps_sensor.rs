@@ -24,10 +24,10 @@ use mynewt::{
     hw::sensor_mgr,                         //  Import Mynewt Sensor Manager API
     hw::sensor::{        
         self,                               //  Import Mynewt Sensor API
-        sensor_type_t,
+        sensor_listener, SensorListener, SensorValue,
     },
     sys::console,                           //  Import Mynewt Console API
-    Strn,                                   //  Import Mynewt macros    
+    Strn, fill_zero,                        //  Import Mynewt macros    
 };
 use mynewt_macros::{ init_strn };           //  Import Mynewt procedural macros
 use crate::app_network;                     //  Import `app_network.rs` for sending sensor data
@@ -38,11 +38,25 @@ static GPS_DEVICE: Strn      = init_strn!("gps_l70r_0");
 const GPS_POLL_TIME: u32     = (11 * 1000);  
 ///  Use key (field name) `geo` to transmit GPS geolocation to CoAP Server
 const GPS_SENSOR_KEY: Strn   = init_strn!("geo");
-///  Type of sensor: Geolocation (latitude, longitude, altitude)
-const GPS_SENSOR_TYPE: sensor_type_t = sensor::SENSOR_TYPE_GEOLOCATION;
+
+///  Listener that transmits the sensor data: decodes the GPS geolocation and calls `aggregate_sensor_data()`.
+///  Resolved at compile time, see `sensor::static_sensor_listener()`.
+struct GpsListener;
+
+impl SensorListener for GpsListener {
+    type Data = sensor::Geolocation;
+    const SENSOR_KEY: &'static Strn = &GPS_SENSOR_KEY;
+    fn handle(sensor_value: &SensorValue) -> MynewtResult<()> {
+        app_network::aggregate_sensor_data(sensor_value)
+    }
+}
+
+///  Sensor listener registered with Mynewt, which keeps a pointer to it
+static mut GPS_LISTENER: sensor_listener = fill_zero!(sensor_listener);
 
 ///  Ask Mynewt to poll the GPS sensor and call `aggregate_sensor_data()`
 ///  Return `Ok()` if successful, else return `Err()` with `MynewtError` error code inside.
+#[allow(dead_code)]
 pub fn start_gps_listener() -> MynewtResult<()>  {  //  Returns an error code upon error.
     //  Start the GPS driver.
     console::print("Rust GPS poll\n");
@@ -57,14 +71,10 @@ pub fn start_gps_listener() -> MynewtResult<()>  {  //  Returns an error code up
     sensor::set_poll_rate_ms(&GPS_DEVICE, GPS_POLL_TIME) ? ;
 
     // Create a sensor listener that will call function `aggregate_sensor_data` after polling the sensor data
-    let listener = sensor::new_sensor_listener(
-        &GPS_SENSOR_KEY,  //  Transmit as field: `geo`
-        GPS_SENSOR_TYPE,  //  Type of sensor data: GPS Geolocation
-        app_network::aggregate_sensor_data  //  Call this function with the polled data: `aggregate_sensor_data`
-    ) ? ;
+    unsafe { GPS_LISTENER = sensor::static_sensor_listener::<GpsListener>() };
 
     //  Register the Listener Function to be called with the polled sensor data.
-    sensor::register_listener(sensor, listener) ? ;  //  `?` means in case of error, return error now.
+    sensor::register_static_listener(sensor, unsafe { &mut GPS_LISTENER }) ? ;  //  `?` means in case of error, return error now.
 
     //  Return `Ok()` to indicate success.  This line should not end with a semicolon (;).
     Ok(())
@@ -34,6 +34,8 @@ extern crate macros as mynewt_macros;   //  Declare the Mynewt Procedural Macros
 mod app_network;    //  Declare `app_network.rs` as Rust module `app_network` for Application Network functions
 mod app_sensor;     //  Declare `app_sensor.rs` as Rust module `app_sensor` for Application Sensor functions
 mod touch_sensor;   //  Declare `touch_sensor.rs` as Rust module `touch_sensor` for Touch Sensor functions
+mod gesture;        //  Declare `gesture.rs` as Rust module `gesture` for Touch Gesture Recognizer
+mod trail;          //  Declare `trail.rs` as Rust module `trail` for GPS trail buffer
 
 #[cfg(feature = "display_app")]  //  If graphics display app is enabled...
 mod display;        //  Graphics display app
@@ -41,8 +43,7 @@ mod display;        //  Graphics display app
 #[cfg(feature = "ui_app")]       //  If druid UI app is enabled...
 mod ui;             //  druid UI app
 
-#[cfg(feature = "use_float")]    //  If floating-point is enabled...
-mod gps_sensor;     //  GPS Sensor functions
+mod gps_sensor;     //  GPS Sensor functions, in fixed-point
 
 use core::panic::PanicInfo; //  Import `PanicInfo` type which is used by `panic()` below
 use cortex_m::asm::bkpt;    //  Import cortex_m assembly function to inject breakpoint
@@ -70,6 +71,10 @@ extern "C" fn main() -> ! {  //  Declare extern "C" because it will be called by
     //  app_sensor::start_sensor_listener()
     //    .expect("TMP fail");
 
+    //  Start polling the GPS every 11 seconds in the background.
+    //  gps_sensor::start_gps_listener()
+    //    .expect("GPS fail");
+
     //  Start Bluetooth Beacon.  TODO: Create a safe wrapper for starting Bluetooth LE.
     //  extern { fn start_ble() -> i32; }
     //  let rc = unsafe { start_ble() };
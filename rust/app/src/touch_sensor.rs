@@ -1,3 +1,11 @@
+//! Touchscreen driver for PineTime. Touch interrupts are processed by a dedicated Touch Task with its own
+//! Event Queue, so that touches don't wait behind sensor polls and network callouts in the Default Event Queue.
+//! The touch data is read with a non-blocking I2C transaction, so the read doesn't stall the Touch Task.
+//! Touch points are recognized as touch downs, taps, long presses and swipes by `gesture.rs`. The gestures are
+//! handled in the Default Event Queue by the main task, which runs druid: a touch down is passed to druid at once,
+//! the other gestures when recognized. Touch downs are timed from the touch interrupt to the display update by
+//! `mynewt::frame_probe`.
+use core::sync::atomic::{ AtomicBool, AtomicU32, Ordering };
 use embedded_hal::{
     self,
     blocking::delay::DelayMs,
@@ -8,13 +16,19 @@ use mynewt::{
     self,
     result::*,
     hw::hal,
+    i2c::{ self, i2c_txn },
     kernel::os::{
         self,
         os_event,
+        OS_TICKS_PER_SEC,
     },
     sys::console,
-    fill_zero,
+    frame_probe,
+    frame_time::Stage,
+    fill_zero, NULL, Ptr, Strn,
 };
+use mynewt_macros::{ init_strn };
+use crate::gesture::{ self, Gesture, GestureEngine };
 
 /// Reset Pin for touch controller. Note: NFC antenna pins must be reassigned as GPIO pins for this to work.
 const TOUCH_RESET_PIN: i32 = 10;  //  P0.10/NFC2: TP_RESET
@@ -50,8 +64,25 @@ pub fn start_touch_sensor() -> MynewtResult<()> {
         TOUCH_DELAY.delay_ms(200); TOUCH_DELAY.delay_ms(200);    
     };
 
-    //  Initialise the touch event with the callback function
+    //  Create the Event Queue for touch events, with the callout that detects the finger being lifted
+    unsafe { os::os_eventq_init(&mut TOUCH_EVENT_QUEUE) };
+    unsafe { os::os_callout_init(&mut TOUCH_RELEASE, &mut TOUCH_EVENT_QUEUE, Some( touch_release_callback ), NULL) };
+
+    //  Initialise the touch event and the gesture event with the callback functions
     unsafe { TOUCH_EVENT.ev_cb = Some( touch_event_callback ) };
+    unsafe { GESTURE_EVENT.ev_cb = Some( gesture_event_callback ) };
+
+    //  Create a task to process the touch events
+    os::task_init(                  //  Create a new task and start it...
+        unsafe { &mut TOUCH_TASK }, //  Task object will be saved here
+        &init_strn!( "touch" ),     //  Name of task
+        Some( touch_task_func ),    //  Function to execute when task starts
+        NULL,  //  Argument to be passed to above function
+        TOUCH_TASK_PRIORITY,        //  Task priority: highest is 0, lowest is 255
+        os::OS_WAIT_FOREVER as u32, //  Don't do sanity / watchdog checking
+        unsafe { &mut TOUCH_TASK_STACK }, //  Stack space for the task
+        TOUCH_TASK_STACK_SIZE as u16      //  Size of the stack (in 4-byte units)
+    ) ? ;                                 //  `?` means check for error
 
     //  Configure the touch controller interrupt (active when low) to trigger a touch event
     let rc = unsafe { hal::hal_gpio_irq_init(
@@ -68,36 +99,79 @@ pub fn start_touch_sensor() -> MynewtResult<()> {
     Ok(())
 }
 
+/// Touch Task Function. Process the touch events posted to the Touch Event Queue. When there are no events, block until one arrives.
+extern "C" fn touch_task_func(_arg: Ptr) {
+    loop {
+        //  Forever process touch events. Will call touch_event_callback() and touch_release_callback().
+        os::eventq_run(
+            unsafe { &mut TOUCH_EVENT_QUEUE }
+        ).expect("eventq fail");
+    }
+}
+
 /// Interrupt handler for the touch controller, triggered when a touch is detected
-extern "C" fn touch_interrupt_handler(arg: *mut core::ffi::c_void) {
-    //  We forward a touch event to the Default Event Queue for deferred processing.  Don't do any processing here.
-    unsafe { TOUCH_EVENT.ev_arg = arg };
-    //  Fetch the Default Event Queue. TODO: Use dedicated Event Queue for higher priority processing.
-    let queue = os::eventq_dflt_get()
-        .expect("GET fail");
-    unsafe { os::os_eventq_put(queue, &mut TOUCH_EVENT) };  //  Trigger the callback function `touch_event_callback()`
-    //console::print("touch\n"); ////
+extern "C" fn touch_interrupt_handler(_arg: *mut core::ffi::c_void) {
+    //  Start reading the touch data without waiting. The Touch Event is posted when the read is complete.
+    let now = unsafe { os::os_cputime_get32() };
+    if TOUCH_READING.swap(true, Ordering::AcqRel) {
+        //  Coalesce a burst of interrupts: read again after the read in progress, so that the latest touch data is read once
+        if !TOUCH_REREAD.swap(true, Ordering::AcqRel) { TOUCH_REREAD_TIME.store(now, Ordering::Relaxed); }
+        TOUCH_COALESCED.fetch_add(1, Ordering::Relaxed);
+        return;
+    }
+    TOUCH_IRQ_TIME.store(now, Ordering::Relaxed);
+    start_touch_read();
 }
 
-/// Callback for the touch event that is triggered when a touch is detected
+/// Start reading the touch data from the touch controller. `touch_event_callback()` will be called when complete.
+fn start_touch_read() {
+    let rc = i2c::i2c_noblock_write_read(  //  Read the range of I2C registers...
+        unsafe { &mut TOUCH_TXN },         //  With this transaction
+        TOUCH_I2C,                         //  On I2C port 1
+        TOUCH_CONTROLLER_ADDRESS,          //  From the touch controller
+        &TOUCH_START_REGISTER,             //  Starting from register 0
+        unsafe { &mut BUF },               //  Save the read data into `BUF`
+        unsafe { &mut TOUCH_EVENT_QUEUE }, //  Then trigger `touch_event_callback()`
+        unsafe { &mut TOUCH_EVENT }
+    );
+    if rc.is_err() {
+        console::print("touch read fail\n");
+        TOUCH_READING.store(false, Ordering::Release);  //  Next interrupt will try again
+    }
+}
+
+/// Callback for the touch event that is triggered when the touch data has been read
 extern "C" fn touch_event_callback(_event: *mut os_event) {
-    //  console::printhex(unsafe { os::os_time_get() } as u8); console::print(" touch\n");
-    unsafe { 
-        //  Fetch the touch data from the touch controller
-        read_touchdata(&mut TOUCH_DATA)
+    let irq_time = TOUCH_IRQ_TIME.load(Ordering::Relaxed);
+    let read_time = unsafe { os::os_cputime_get32() };
+    let now = now_ms();
+    let result = i2c::i2c_result(unsafe { &TOUCH_TXN });
+    if result.is_ok() {
+        //  Decode the touch data read from the touch controller, before `BUF` is reused by the next read
+        decode_touchdata(unsafe { &BUF }, unsafe { &mut TOUCH_DATA })
             .expect("touchdata fail");
-        //  Handle each touch data info
+    }
+    //  If interrupts arrived during the read, read the latest touch data while processing this one.
+    //  Interrupts are disabled so that an interrupt can't request a read after we decide not to read again.
+    let sr = unsafe { os::os_arch_save_sr() };
+    let reread = TOUCH_REREAD.swap(false, Ordering::AcqRel);
+    if !reread { TOUCH_READING.store(false, Ordering::Release); }
+    unsafe { os::os_arch_restore_sr(sr) };
+    if reread {
+        TOUCH_IRQ_TIME.store(TOUCH_REREAD_TIME.load(Ordering::Relaxed), Ordering::Relaxed);
+        start_touch_read();
+    }
+    if result.is_err() {
+        console::print("i2c fail\n");  //  Touch controller doesn't respond unless the screen is tapped
+        return;
+    }
+    unsafe { 
+        //  Handle each touch data info. Invalid `(0,0)` points are skipped by the gesture recognizer (see note below).
         for i in 0..TOUCH_DATA.count as usize {
             let TouchInfo{ x, y, action, .. } = TOUCH_DATA.touches[i];
-            //  Skip invalid responses (see note below)
-            if x == 0 && y == 0 { continue; }
-            //  Handle only touch down and contact actions, not touch up (see note below)
-            if action != 0 && action != 2 { continue; }
-            //  Handle the touch data in the UI        
-            druid::handle_touch(x, y);
-            //  Display the touch data
-            //  druid::show_touch(x, y).expect("show touch fail");
-
+            if let Some(gesture) = GESTURES.touch(x, y, action, now) {
+                handle_gesture(gesture);
+            }
             /* Usually we get responses like:
             touch
             count: 1, pt: 0
@@ -111,65 +185,231 @@ extern "C" fn touch_event_callback(_event: *mut os_event) {
             act: 0, fin 0, x: 0, y: 0
             act: 0, fin 0, x: 0, y: 0
             act: 0, fin 0, x: 0, y: 0 */
-        }    
+        }
+        //  The controller doesn't always report touch up, so the finger is lifted when no touch is reported for a while
+        if GESTURES.is_touching() {
+            os::os_callout_reset(&mut TOUCH_RELEASE, gesture::RELEASE_MS * OS_TICKS_PER_SEC / 1000);
+        } else {
+            os::os_callout_stop(&mut TOUCH_RELEASE);
+        }
     }
-    /* unsafe {
-        //  Disable the console output because it may interfere with touch events
-        console::print("count: "); console::printint(TOUCH_DATA.count as i32);
-        console::print(", pt: "); console::printint(TOUCH_DATA.point_num as i32); console::print("\n");
-        for i in 0..TOUCH_DATA.count as usize {
-            let TouchInfo{ x, y, action, finger, .. } = TOUCH_DATA.touches[i];
-            console::print("act: "); console::printint(action as i32); 
-            console::print(", fin "); console::printint(finger as i32); 
-            console::print(", x: "); console::printint(x as i32); 
-            console::print(", y: "); console::printint(y as i32); console::print("\n");
+    //  Update the latency from the touch interrupt
+    let stats = unsafe { &mut TOUCH_STATS };
+    let read_us     = frame_probe::cputime_to_us(read_time.wrapping_sub(irq_time));
+    let handled_us  = frame_probe::cputime_to_us(unsafe { os::os_cputime_get32() }.wrapping_sub(irq_time));
+    stats.events += 1;
+    stats.read_total_us     = stats.read_total_us.wrapping_add(read_us);
+    stats.read_max_us       = stats.read_max_us.max(read_us);
+    stats.handled_total_us  = stats.handled_total_us.wrapping_add(handled_us);
+    stats.handled_max_us    = stats.handled_max_us.max(handled_us);
+}
+
+/// Callback for the touch release callout, triggered when no touch has been reported for `gesture::RELEASE_MS`
+extern "C" fn touch_release_callback(_event: *mut os_event) {
+    let now = now_ms();
+    if let Some(gesture) = unsafe { GESTURES.release(now) } {
+        handle_gesture(gesture);
+    }
+}
+
+/// Queue a recognized gesture for the main task, with the CPU time of the touch interrupt of the last touch data.
+/// Called by the Touch Task. If the queue is full, the gesture is dropped.
+fn handle_gesture(gesture: Gesture) {
+    let irq_time = TOUCH_IRQ_TIME.load(Ordering::Relaxed);
+    let sr = unsafe { os::os_arch_save_sr() };
+    unsafe {
+        if GESTURE_COUNT < GESTURE_QUEUE_SIZE {
+            GESTURE_QUEUE[(GESTURE_HEAD + GESTURE_COUNT) % GESTURE_QUEUE_SIZE] = (gesture, irq_time);
+            GESTURE_COUNT += 1;
         }
-        console::flush();   
-    } */
+    }
+    unsafe { os::os_arch_restore_sr(sr) };
+    unsafe { os::os_eventq_put(os::os_eventq_dflt_get(), &mut GESTURE_EVENT) };
+}
+
+/// Remove the first gesture from the queue, with the CPU time of its touch interrupt
+fn next_gesture() -> Option<(Gesture, u32)> {
+    let sr = unsafe { os::os_arch_save_sr() };
+    let next = unsafe {
+        if GESTURE_COUNT == 0 { None }
+        else {
+            let next = GESTURE_QUEUE[GESTURE_HEAD];
+            GESTURE_HEAD = (GESTURE_HEAD + 1) % GESTURE_QUEUE_SIZE;
+            GESTURE_COUNT -= 1;
+            Some(next)
+        }
+    };
+    unsafe { os::os_arch_restore_sr(sr) };
+    next
+}
+
+/// Callback for the gesture event in the Default Event Queue. Handles the queued gestures in druid and the gesture handler.
+extern "C" fn gesture_event_callback(_event: *mut os_event) {
+    while let Some((gesture, irq_time)) = next_gesture() {
+        //  druid handles touch downs as touches, without waiting for the tap
+        if let Gesture::Down { x, y } = gesture {
+            //  Start timing the frame from the touch interrupt
+            frame_probe::probe_at(Stage::Touch, frame_probe::cputime_to_us(irq_time));
+            frame_probe::probe(Stage::Dispatch);
+            druid::handle_touch(x, y);
+        }
+        if let Some(handler) = unsafe { GESTURE_HANDLER } {
+            handler(&gesture);
+        }
+    }
+}
+
+/// Set the function that will be called by the main task for every gesture: touch down, tap, long press or swipe.
+/// Touch downs are also handled by druid.
+#[allow(dead_code)]
+pub fn set_gesture_handler(handler: fn(&Gesture)) {
+    unsafe { GESTURE_HANDLER = Some(handler) };
+}
+
+/// Touch latency statistics, from the touch interrupt. Times are in microseconds.
+#[derive(Clone, Copy)]
+pub struct TouchStats {
+    /// Touch events processed, each with one read of the touch controller
+    pub events:            u32,
+    /// Touch interrupts coalesced into a pending touch event
+    pub coalesced:         u32,
+    /// Total and max time from the touch interrupt to the Touch Task receiving the touch data
+    pub read_total_us:     u32,
+    pub read_max_us:       u32,
+    /// Total and max time from the touch interrupt to the gestures being queued for the main task
+    pub handled_total_us:  u32,
+    pub handled_max_us:    u32,
+}
+
+/// Return the touch latency statistics
+pub fn touch_stats() -> TouchStats {
+    TouchStats {
+        coalesced: TOUCH_COALESCED.load(Ordering::Relaxed),
+        ..unsafe { TOUCH_STATS }
+    }
+}
+
+/// Display the touch latency statistics
+#[allow(dead_code)]
+pub fn print_touch_stats() {
+    let stats = touch_stats();
+    let events = stats.events.max(1);
+    console::print("touch events: "); console::printint(stats.events as i32);
+    console::print(", coalesced: "); console::printint(stats.coalesced as i32); console::print("\n");
+    console::print("read us avg: "); console::printint((stats.read_total_us / events) as i32);
+    console::print(", max: "); console::printint(stats.read_max_us as i32); console::print("\n");
+    console::print("handled us avg: "); console::printint((stats.handled_total_us / events) as i32);
+    console::print(", max: "); console::printint(stats.handled_max_us as i32); console::print("\n");
+    console::flush();
 }
 
+/// Return the OS time in milliseconds
+fn now_ms() -> u32 {
+    unsafe { os::os_time_get() / (OS_TICKS_PER_SEC / 1000) }
+}
+
+/// Event Queue for touch events, processed by the Touch Task
+static mut TOUCH_EVENT_QUEUE: os::os_eventq = fill_zero!(os::os_eventq);
+
+/// Touch Task that processes the touch events
+static mut TOUCH_TASK: os::os_task = fill_zero!(os::os_task);
+
+/// Stack space for Touch Task, initialised to 0.
+static mut TOUCH_TASK_STACK: [os::os_stack_t; TOUCH_TASK_STACK_SIZE] = 
+    [0; TOUCH_TASK_STACK_SIZE];
+
+/// Size of the stack (in 4-byte units). The UI is updated by druid in the main task, not in this task.
+const TOUCH_TASK_STACK_SIZE: usize = 512;
+
+/// Touch Task priority: above the main task (127), so that touch data is decoded and recognized as soon as it is read.
+/// The I2C Task that reads it runs below the main task. The Touch Task doesn't touch the UI: gestures are handled
+/// by the main task in the Default Event Queue.
+const TOUCH_TASK_PRIORITY: u8 = 20;
+
+/// Callout that detects the finger being lifted when no touch is reported
+static mut TOUCH_RELEASE: os::os_callout = fill_zero!(os::os_callout);
+
+/// I2C transaction that reads the touch data
+static mut TOUCH_TXN: i2c_txn = fill_zero!(i2c_txn);
+
+/// Touch data is read from register 0 onwards
+static TOUCH_START_REGISTER: [u8; 1] = [ 0 ];
+
+/// True from the touch interrupt that starts a read until the touch data has been decoded
+static TOUCH_READING: AtomicBool = AtomicBool::new(false);
+
+/// True if touch interrupts arrived while the touch data was being read, so it must be read again
+static TOUCH_REREAD: AtomicBool = AtomicBool::new(false);
+
+/// CPU time of the touch interrupt that started the current read
+static TOUCH_IRQ_TIME: AtomicU32 = AtomicU32::new(0);
+
+/// CPU time of the first touch interrupt that arrived during the current read
+static TOUCH_REREAD_TIME: AtomicU32 = AtomicU32::new(0);
+
+/// Number of touch interrupts coalesced into a pending touch event
+static TOUCH_COALESCED: AtomicU32 = AtomicU32::new(0);
+
+/// Touch latency statistics, updated by the Touch Task
+static mut TOUCH_STATS: TouchStats = TouchStats {
+    events: 0, coalesced: 0, read_total_us: 0, read_max_us: 0, handled_total_us: 0, handled_max_us: 0,
+};
+
+/// Gesture recognizer for the touch points
+static mut GESTURES: GestureEngine = GestureEngine::new();
+
+/// Function called for every gesture
+static mut GESTURE_HANDLER: Option<fn(&Gesture)> = None;
+
+/// Max number of gestures waiting for the main task
+const GESTURE_QUEUE_SIZE: usize = 8;
+
+/// Gestures waiting for the main task, with the CPU time of their touch interrupts. Accessed with interrupts disabled.
+static mut GESTURE_QUEUE: [(Gesture, u32); GESTURE_QUEUE_SIZE] = [(Gesture::Down { x: 0, y: 0 }, 0); GESTURE_QUEUE_SIZE];
+
+/// Index of the first gesture in `GESTURE_QUEUE`, and the number of gestures
+static mut GESTURE_HEAD: usize = 0;
+static mut GESTURE_COUNT: usize = 0;
+
+/// Event posted to the Default Event Queue when gestures are queued
+static mut GESTURE_EVENT: os_event = fill_zero!(os_event);
+
 /// Touch data will be populated here
 static mut TOUCH_DATA: TouchEventInfo = fill_zero!(TouchEventInfo);
 
-/// Read touch controller data. This only works when the screen has been tapped and the touch controller wakes up.
+/// Decode the touch data read from the touch controller. The touch controller only responds when the screen has been tapped.
 /// Ported from https://github.com/lupyuen/hynitron_i2c_cst0xxse/blob/master/cst0xx_core.c#L407-L466
-fn read_touchdata(data: &mut TouchEventInfo) -> MynewtResult<()> {
-    read_register_range(           //  Read the range of I2C registers...
-        TOUCH_CONTROLLER_ADDRESS,  //  From the touch controller
-        0,                         //  Starting from register 0
-        POINT_READ_BUF as u8,      //  Number of registers to read
-        unsafe { &mut BUF }        //  Save the read data into `buf`
-    ).expect("read touchdata fail");
+fn decode_touchdata(buf: &[u8; POINT_READ_BUF], data: &mut TouchEventInfo) -> MynewtResult<()> {
     *data = fill_zero!(TouchEventInfo);
-    data.point_num = unsafe { BUF[FT_TOUCH_POINT_NUM] & 0x0F };
+    data.point_num = buf[FT_TOUCH_POINT_NUM] & 0x0F;
     data.count     = 0;
 
     //  Populate the first 5 touch points
     for i in 0..CFG_MAX_TOUCH_POINTS {
-        let pointid = unsafe { BUF[HYN_TOUCH_ID_POS + HYN_TOUCH_STEP * i] } >> 4;
+        let pointid = buf[HYN_TOUCH_ID_POS + HYN_TOUCH_STEP * i] >> 4;
         if pointid >= HYN_MAX_ID { break; }
 
         //  Compute X and Y coordinates
         data.count += 1;
-        let x_high = unsafe { BUF[HYN_TOUCH_X_H_POS + HYN_TOUCH_STEP * i] & 0x0F } as u16;
-        let x_low  = unsafe { BUF[HYN_TOUCH_X_L_POS + HYN_TOUCH_STEP * i] } as u16;
+        let x_high = (buf[HYN_TOUCH_X_H_POS + HYN_TOUCH_STEP * i] & 0x0F) as u16;
+        let x_low  = buf[HYN_TOUCH_X_L_POS + HYN_TOUCH_STEP * i] as u16;
         data.touches[i].x  = (x_high << 8) | x_low;
 
-        let y_high = unsafe { BUF[HYN_TOUCH_Y_H_POS + HYN_TOUCH_STEP * i] & 0x0F } as u16;
-        let y_low  = unsafe { BUF[HYN_TOUCH_Y_L_POS + HYN_TOUCH_STEP * i] } as u16;
+        let y_high = (buf[HYN_TOUCH_Y_H_POS + HYN_TOUCH_STEP * i] & 0x0F) as u16;
+        let y_low  = buf[HYN_TOUCH_Y_L_POS + HYN_TOUCH_STEP * i] as u16;
         data.touches[i].y  = (y_high << 8) | y_low;
 
         //  Compute touch action (0 = down, 1 = up, 2 = contact) and finger ID
         data.touches[i].action =
-            unsafe { BUF[HYN_TOUCH_EVENT_POS + HYN_TOUCH_STEP * i] } >> 6;
+            buf[HYN_TOUCH_EVENT_POS + HYN_TOUCH_STEP * i] >> 6;
         data.touches[i].finger =
-            unsafe { BUF[HYN_TOUCH_ID_POS    + HYN_TOUCH_STEP * i] } >> 4;
+            buf[HYN_TOUCH_ID_POS    + HYN_TOUCH_STEP * i] >> 4;
 
         //  Compute touch pressure and area
         data.touches[i].pressure =
-            unsafe { BUF[HYN_TOUCH_XY_POS + HYN_TOUCH_STEP * i] };  //  Can't be constant value
+            buf[HYN_TOUCH_XY_POS + HYN_TOUCH_STEP * i];  //  Can't be constant value
         data.touches[i].area =
-            unsafe { BUF[HYN_TOUCH_MISC   + HYN_TOUCH_STEP * i] } >> 4;
+            buf[HYN_TOUCH_MISC   + HYN_TOUCH_STEP * i] >> 4;
 
         //  If no more touch points, stop
         if (data.touches[i].action == 0 || data.touches[i].action == 2)  //  If touch is down or contact
@@ -183,6 +423,9 @@ fn read_touchdata(data: &mut TouchEventInfo) -> MynewtResult<()> {
 /// Buffer for raw touch data
 static mut BUF: [u8; POINT_READ_BUF] = [0; POINT_READ_BUF];
 
+/// I2C port of the touch controller and other I2C sensors
+const TOUCH_I2C: u8 = 1;
+
 /// Touch Controller I2C Address: https://github.com/lupyuen/hynitron_i2c_cst0xxse
 const TOUCH_CONTROLLER_ADDRESS: u8 = 0x15;
 
@@ -236,69 +479,18 @@ const POINT_READ_BUF: usize      = 3 + ( HYN_TOUCH_STEP * HYN_MAX_POINTS );
 /// Event that will be forwarded to the Event Queue when a touch interrupt is triggered
 static mut TOUCH_EVENT: os_event = fill_zero!(os_event);  //  Init all fields to 0 or NULL
 
-/// Read a range of I2C registers from the I2C address `addr` (7-bit address), starting at `start_register` for count `num_registers`. Save into `buffer`.
-fn read_register_range(addr: u8, start_register: u8, num_registers: u8, buffer: &mut[u8]) -> MynewtResult<()> {
-    assert!(buffer.len() >= num_registers as usize, "i2c buf");  //  Buffer too small
-    assert!(start_register + num_registers < 128, "i2c addr");   //  Not 7-bit address
-    //  Step 1: Prepare to read I2C Device Registers:
-    //    System sends Clock Signal on SCL to sync Microcontroller with I2C Device
-    //  Step 2: Transmit the I2C Address and the starting Register Number:
-    //    Send the Start Condition (High to Low SDA Transition)...
-    //    Followed by I2C Address (7 bits)...
-    //    Followed by Write Mode (1 bit, value 0)...
-    //    Followed by starting Register Number (8 bits)
-    unsafe { 
-        I2C_BUFFER[0] = start_register;  //  I2C Packet buffer contains starting Register Number (1 byte)
-        I2C_DATA.address = addr;         //  I2C Packet address (7 bits)
-        I2C_DATA.len = I2C_BUFFER.len() as u16;     //  I2C Packet data size is 1 byte
-        I2C_DATA.buffer = I2C_BUFFER.as_mut_ptr();  //  I2C Packet data points to packet buffer
-    };
-    let _rc1 = unsafe { hal::hal_i2c_master_write(1, &mut I2C_DATA, 1000, 0) };  //  No stop yet, must continue even if we hit an error
-    //  Step 3: Prepare to receive the stream of I2C Device Register values...
-    //    Send the Start Condition (High to Low SDA Transition)...
-    //    Followed by I2C Address (7 bits)...
-    //    Followed by Read Mode (1 bit, value 1)
-    unsafe { 
-        I2C_BUFFER[0] = 0x00;     //  I2C Packet buffer should be empty (provided by caller)
-        I2C_DATA.address = addr;  //  I2C Packet address (7 bits)
-        I2C_DATA.len = num_registers as u16;    //  I2C Packet data size is number of Registers to read
-        I2C_DATA.buffer = buffer.as_mut_ptr();  //  I2C Packet data points to packet buffer
-    };
-    //  Step 4: Receive the requested number of Register values from I2C Device (1 byte per register)
-    //  Step 5: Send the Stop Condition (Low to High SDA Transition)
-    let rc2 = unsafe { hal::hal_i2c_master_read(1, &mut I2C_DATA, 1000, 1) };
-    if rc2 == hal::HAL_I2C_ERR_ADDR_NACK as i32 {
-        ////assert!(false, "i2c fail");  //  I2C read failed
-        console::print("i2c fail\n"); ////
-        return Ok(());               //  TODO: Return an error
-    }
-    Ok(())
-}
-
 /// Read the I2C register for the specified I2C address (7-bit address)
 #[allow(dead_code)]
 fn read_register(addr: u8, register: u8) -> MynewtResult<()> {
     assert!(register < 128, "i2c addr");  //  Not 7-bit address
-    //  First the register number must be sent in write mode (I2C address xxxxxxx0). 
-    unsafe { 
-        I2C_BUFFER[0] = register;
-        I2C_DATA.address = addr;
-        I2C_DATA.len = I2C_BUFFER.len() as u16;
-        I2C_DATA.buffer = I2C_BUFFER.as_mut_ptr();
-    };
-    //  Then either a stop or a repeated start condition must be generated. 
-    let _rc1 = unsafe { hal::hal_i2c_master_write(1, &mut I2C_DATA, 1000, 0) };  //  No stop yet, must continue even if we hit an error
-    //  After this the slave is addressed in read mode (RW = ‘1’) at I2C address xxxxxxx1, 
-    unsafe { 
-        I2C_BUFFER[0] = 0x00;
-        I2C_DATA.address = addr;
-        I2C_DATA.len = I2C_BUFFER.len() as u16;
-        I2C_DATA.buffer = I2C_BUFFER.as_mut_ptr();
+    //  Send the register number in write mode, then read the register value after a repeated start.
+    //  Other I2C transactions are not blocked while waiting.
+    let rc = unsafe {
+        I2C_REGISTER[0] = register;
+        i2c::i2c_write_read(&mut I2C_TXN, TOUCH_I2C, addr, &I2C_REGISTER, &mut I2C_BUFFER)
     };
-    //  After which the slave sends out data from auto-incremented register addresses until a NOACKM and stop condition occurs.
-    let rc2 = unsafe { hal::hal_i2c_master_read(1, &mut I2C_DATA, 1000, 1) };
-    if rc2 == hal::HAL_I2C_ERR_ADDR_NACK as i32 {
-        return Ok(());
+    if rc.is_err() {
+        return Ok(());  //  No response
     }
     console::print("addr: 0x"); console::printhex(addr); 
     console::print(", reg: 0x"); console::printhex(register); 
@@ -307,14 +499,13 @@ fn read_register(addr: u8, register: u8) -> MynewtResult<()> {
     Ok(())
 }
 
-/// I2C packet to be sent
-static mut I2C_DATA: hal::hal_i2c_master_data = hal::hal_i2c_master_data {
-    address: 0,
-    len:     0,
-    buffer:  core::ptr::null_mut(),
-};
+/// I2C transaction for reading registers
+static mut I2C_TXN: i2c_txn = fill_zero!(i2c_txn);
+
+/// Register number to be written
+static mut I2C_REGISTER: [u8; 1] = [ 0 ];
 
-/// Buffer containing I2C read/write data
+/// Buffer containing the register value read
 static mut I2C_BUFFER: [u8; 1] =  [ 0 ];
 
 /// Probe the I2C bus to discover I2C devices
@@ -0,0 +1,247 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+//!  GPS trail buffer with online line simplification.  Fixes are simplified as they arrive
+//!  with a sliding window: a fix is dropped if the line from the last kept fix to the newest fix
+//!  passes within the tolerance of every fix in between.  The kept fixes are stored in a fixed
+//!  buffer.  When the buffer is full, the fix that deviates least from its neighbours is dropped,
+//!  so the trail degrades gracefully instead of losing its oldest part.
+//!  Coordinates are in 1e-7 degrees and all computation is in integers, so no floating-point is needed.
+//!  To test on the host: `rustc --edition 2018 --test trail.rs -o /tmp/test_trail && /tmp/test_trail`
+
+///  Maximum number of fixes kept in the trail
+pub const TRAIL_SIZE: usize = 32;
+
+///  Maximum number of fixes examined by the sliding window.  Limits the work per fix.  Must be even.
+const WINDOW_SIZE: usize = 16;
+
+///  Default simplification tolerance in metres
+pub const TRAIL_TOLERANCE: u32 = 10;
+
+///  1e-7 degrees of latitude per 100 metres
+const E7_PER_100_METRES: u32 = 8983;
+
+///  Deltas larger than this (about 100 km) are not simplified, to avoid overflow
+const MAX_DELTA: i32 = 1 << 23;
+
+///  A timestamped GPS fix
+#[derive(Clone, Copy, Default, PartialEq)]
+pub struct TrailPoint {
+    ///  Time of the fix in seconds
+    pub time: u32,
+    ///  Latitude in 1e-7 degrees
+    pub latitude: i32,
+    ///  Longitude in 1e-7 degrees
+    pub longitude: i32,
+}
+
+///  Bounded trail of simplified GPS fixes
+pub struct Trail {
+    ///  Kept fixes, oldest first.  The last kept fix is the anchor of the sliding window.
+    points: [TrailPoint; TRAIL_SIZE],
+    ///  Number of kept fixes
+    count: usize,
+    ///  Fixes after the anchor that may still be dropped.  The last one is the newest fix.
+    window: [TrailPoint; WINDOW_SIZE],
+    ///  Number of fixes in the window
+    window_count: usize,
+    ///  Tolerance in 1e-7 degrees of latitude
+    tolerance: i64,
+}
+
+impl Trail {
+    ///  Create an empty trail with the tolerance in metres
+    pub const fn new(tolerance_metres: u32) -> Trail {
+        Trail {
+            points:       [TrailPoint { time: 0, latitude: 0, longitude: 0 }; TRAIL_SIZE],
+            count:        0,
+            window:       [TrailPoint { time: 0, latitude: 0, longitude: 0 }; WINDOW_SIZE],
+            window_count: 0,
+            tolerance:    (tolerance_metres * E7_PER_100_METRES / 100) as i64,
+        }
+    }
+
+    ///  Add a fix to the trail
+    pub fn add(&mut self, point: TrailPoint) {
+        if self.count == 0 { self.keep(point); return; }
+        let anchor = self.points[self.count - 1];
+        if self.window[..self.window_count].iter()
+            .all(|p| deviation(&anchor, &point, p) <= self.tolerance) {
+            //  Line from anchor to the new fix is close to all fixes in between.  Extend the window.
+            if self.window_count == WINDOW_SIZE {
+                //  Window is full.  Thin it out by keeping every other fix, including the newest.
+                for i in 0 .. WINDOW_SIZE / 2 { self.window[i] = self.window[2 * i + 1]; }
+                self.window_count = WINDOW_SIZE / 2;
+            }
+            self.window[self.window_count] = point;
+            self.window_count += 1;
+            return;
+        }
+        //  Keep the previous fix and restart the window from there.
+        let previous = self.window[self.window_count - 1];
+        self.keep(previous);
+        self.window[0] = point;
+        self.window_count = 1;
+    }
+
+    ///  Return the simplified trail in `out`, oldest first, including the newest fix.  Return the number of fixes.
+    pub fn segment(&self, out: &mut [TrailPoint; TRAIL_SIZE + 1]) -> usize {
+        out[..self.count].copy_from_slice(&self.points[..self.count]);
+        if self.window_count == 0 { return self.count; }
+        out[self.count] = self.window[self.window_count - 1];
+        self.count + 1
+    }
+
+    ///  Called after the segment has been transmitted.  Start a new segment from the newest fix, so that segments join up.
+    pub fn restart(&mut self) {
+        if self.window_count > 0 {
+            self.points[0] = self.window[self.window_count - 1];
+        } else if self.count > 0 {
+            self.points[0] = self.points[self.count - 1];
+        } else { return; }
+        self.count = 1;
+        self.window_count = 0;
+    }
+
+    ///  Append a kept fix.  If the buffer is full, drop the interior fix that deviates least from its neighbours.
+    fn keep(&mut self, point: TrailPoint) {
+        if self.count == TRAIL_SIZE {
+            let mut drop_index = 1;
+            let mut drop_deviation = i64::max_value();
+            for i in 1 .. TRAIL_SIZE - 1 {
+                let d = deviation(&self.points[i - 1], &self.points[i + 1], &self.points[i]);
+                if d < drop_deviation { drop_deviation = d; drop_index = i; }
+            }
+            for i in drop_index .. TRAIL_SIZE - 1 { self.points[i] = self.points[i + 1]; }
+            self.count -= 1;
+        }
+        self.points[self.count] = point;
+        self.count += 1;
+    }
+}
+
+///  Return the distance of `p` from the line segment `a` to `b`, in 1e-7 degrees of latitude.
+///  Longitudes are scaled by the cosine of the latitude of `a` so that distances are the same in all directions.
+fn deviation(a: &TrailPoint, b: &TrailPoint, p: &TrailPoint) -> i64 {
+    let cos = cos_q15(a.latitude);
+    let (bx, by) = offset(a, b, cos);
+    let (px, py) = offset(a, p, cos);
+    if bx.abs() > MAX_DELTA as i64 || by.abs() > MAX_DELTA as i64
+        || px.abs() > MAX_DELTA as i64 || py.abs() > MAX_DELTA as i64 { return i64::max_value(); }
+    let len2 = bx * bx + by * by;
+    let dot = bx * px + by * py;
+    if dot <= 0 || len2 == 0 { return isqrt(px * px + py * py); }   //  Before a: Distance from a
+    if dot >= len2 {                                                 //  After b: Distance from b
+        let (qx, qy) = (px - bx, py - by);
+        return isqrt(qx * qx + qy * qy);
+    }
+    let cross = (bx * py - by * px).abs();
+    cross / isqrt(len2)                                              //  Perpendicular distance from the line
+}
+
+///  Return the position of `p` relative to `a` as (x, y) in 1e-7 degrees of latitude, given the cosine of the latitude in Q15
+fn offset(a: &TrailPoint, p: &TrailPoint, cos: i64) -> (i64, i64) {
+    let mut dlng = p.longitude as i64 - a.longitude as i64;
+    if dlng > 1_800_000_000 { dlng -= 3_600_000_000; }  //  Wrap around the date line
+    else if dlng < -1_800_000_000 { dlng += 3_600_000_000; }
+    ((dlng * cos) >> 15, p.latitude as i64 - a.latitude as i64)
+}
+
+///  Cosine of latitudes 0 to 90 degrees in steps of 5.625 degrees, in Q15
+const COS_TABLE: [u16; 17] = [
+    32768, 32610, 32138, 31357, 30274, 28899, 27246, 25330,
+    23170, 20788, 18205, 15447, 12540, 9512, 6393, 3212, 0,
+];
+
+///  Return the cosine of the latitude (1e-7 degrees) in Q15, by linear interpolation
+fn cos_q15(latitude: i32) -> i64 {
+    const STEP: u32 = 56_250_000;  //  5.625 degrees
+    let lat = (latitude as i64).abs().min(900_000_000) as u32;
+    let i = (lat / STEP) as usize;
+    if i >= COS_TABLE.len() - 1 { return 0; }
+    let frac = (lat % STEP) as i64;
+    let (c0, c1) = (COS_TABLE[i] as i64, COS_TABLE[i + 1] as i64);
+    c0 - (c0 - c1) * frac / STEP as i64
+}
+
+///  Integer square root
+fn isqrt(n: i64) -> i64 {
+    if n <= 0 { return 0; }
+    let mut x = n;
+    let mut y = (x + 1) / 2;
+    while y < x { x = y; y = (x + n / x) / 2; }
+    x
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    ///  1e-7 degrees per metre of latitude
+    const E7_PER_METRE: i32 = E7_PER_100_METRES as i32 / 100;
+
+    #[test]
+    fn square_walk_reduces_to_corners() {
+        //  Walk 800 fixes around a 400 m square, 2 m per fix, with up to 1 m of jitter.  The trail keeps the 5 corners (including the start and end).
+        let mut trail = Trail::new(TRAIL_TOLERANCE);
+        let corners = [(0, 0), (400, 0), (400, 400), (0, 400), (0, 0)];
+        let mut seed: u32 = 1;
+        let mut jitter = || {
+            seed = seed.wrapping_mul(1103515245).wrapping_add(12345);
+            ((seed >> 16) % (2 * E7_PER_METRE as u32 + 1)) as i32 - E7_PER_METRE
+        };
+        let origin = (13_000_000, 1_038_000_000);  //  Near the equator, so metres are the same in both directions
+        let mut time = 0;
+        for side in 0 .. 4 {
+            let ((x0, y0), (x1, y1)) = (corners[side], corners[side + 1]);
+            for i in 0 .. 200 {
+                let (x, y) = (x0 + (x1 - x0) * i / 200, y0 + (y1 - y0) * i / 200);
+                trail.add(TrailPoint {
+                    time,
+                    latitude:  origin.0 + y * E7_PER_METRE + jitter(),
+                    longitude: origin.1 + x * E7_PER_METRE + jitter(),
+                });
+                time += 1;
+            }
+        }
+        trail.add(TrailPoint { time, latitude: origin.0, longitude: origin.1 });
+
+        let mut out = [TrailPoint::default(); TRAIL_SIZE + 1];
+        let n = trail.segment(&mut out);
+        assert_eq!(n, 5);
+        let max_error = (TRAIL_TOLERANCE as i32 + 1) * E7_PER_METRE;  //  A corner may be kept up to the tolerance past the turn
+        for (point, corner) in out[..n].iter().zip(corners.iter()) {
+            assert!((point.latitude  - origin.0 - corner.1 * E7_PER_METRE).abs() <= max_error);
+            assert!((point.longitude - origin.1 - corner.0 * E7_PER_METRE).abs() <= max_error);
+        }
+    }
+
+    #[test]
+    fn full_buffer_keeps_newest() {
+        //  A zigzag can't be simplified.  When the buffer is full, the newest fixes are still kept.
+        let mut trail = Trail::new(TRAIL_TOLERANCE);
+        for i in 0 .. 100 {
+            trail.add(TrailPoint { time: i as u32, latitude: (i % 2) * 1000 * E7_PER_METRE, longitude: i * 100 * E7_PER_METRE });
+        }
+        let mut out = [TrailPoint::default(); TRAIL_SIZE + 1];
+        let n = trail.segment(&mut out);
+        assert_eq!(n, TRAIL_SIZE + 1);
+        assert_eq!(out[n - 1].time, 99);
+        assert_eq!(out[0].time, 0);
+    }
+}
@@ -0,0 +1,97 @@
+//! Image encoder for `image.rs`. Converts RGB565 pixels into the run-length encoded format that is decoded
+//! on PineTime straight into the display window. Images with up to 256 colours are stored with a palette,
+//! 1 byte per pixel, other images with RGB565 colours, 2 bytes per pixel.
+use std::{ collections::HashMap, fs, io };
+use crate::image::{ HEADER_SIZE, MAGIC, MAX_PACKET, ROWS_PER_INDEX };
+
+/// Encode the RGB565 pixels, row by row
+pub fn encode(width: u16, height: u16, pixels: &[u16]) -> Vec<u8> {
+    assert_eq!(pixels.len(), width as usize * height as usize);
+    //  Use a palette if there are few colours, in order of first use
+    let mut palette: Vec<u16> = Vec::new();
+    let mut indexes: HashMap<u16, u8> = HashMap::new();
+    for p in pixels {
+        if indexes.contains_key(p) { continue; }
+        if palette.len() == 256 { palette.clear(); break; }
+        indexes.insert(*p, palette.len() as u8);
+        palette.push(*p);
+    }
+    let write_pixel = |out: &mut Vec<u8>, p: u16| {
+        if palette.is_empty() { out.extend_from_slice(&p.to_be_bytes()); } else { out.push(indexes[&p]); }
+    };
+
+    //  Encode each row separately, so that the decoder can start at any row
+    let mut index = Vec::new();
+    let mut packets = Vec::new();
+    for (y, row) in pixels.chunks_exact(width as usize).enumerate() {
+        if y % ROWS_PER_INDEX as usize == 0 { index.extend_from_slice(&(packets.len() as u32).to_le_bytes()); }
+        let mut x = 0;
+        while x < row.len() {
+            let run = run_length(&row[x ..]);
+            if run >= 2 {
+                //  Repeated pixel
+                packets.push((run - 1) as u8);
+                write_pixel(&mut packets, row[x]);
+                x += run;
+                continue;
+            }
+            //  Different pixels, until a run of 3 pixels that is worth a packet of its own
+            let mut count = 1;
+            while x + count < row.len() && count < MAX_PACKET && run_length(&row[x + count ..]) < 3 { count += 1; }
+            packets.push((count + 0x7F) as u8);
+            for p in &row[x .. x + count] { write_pixel(&mut packets, *p); }
+            x += count;
+        }
+    }
+
+    let mut out = Vec::with_capacity(HEADER_SIZE + palette.len() * 2 + index.len() + packets.len());
+    out.extend_from_slice(&MAGIC);
+    for word in &[ width, height, palette.len() as u16, (index.len() / 4) as u16 ] { out.extend_from_slice(&word.to_le_bytes()); }
+    for p in &palette { out.extend_from_slice(&p.to_be_bytes()); }
+    out.extend_from_slice(&index);
+    out.extend_from_slice(&packets);
+    out
+}
+
+/// Number of times the first pixel is repeated, up to the max packet size
+fn run_length(pixels: &[u16]) -> usize {
+    pixels.iter().take(MAX_PACKET).take_while(|p| **p == pixels[0]).count()
+}
+
+/// Read a binary PPM image (P6, 8 bits per channel) as RGB565 pixels. Returns the width, height and pixels.
+pub fn read_ppm(path: &str) -> io::Result<(u16, u16, Vec<u16>)> {
+    let data = fs::read(path) ? ;
+    let invalid = || io::Error::new(io::ErrorKind::InvalidData, "not a P6 PPM image with 8 bits per channel");
+    //  Header is 4 fields separated by whitespace, with comments from '#' to the end of the line
+    let mut fields = Vec::new();
+    let mut pos = 0;
+    while fields.len() < 4 {
+        while pos < data.len() && (data[pos].is_ascii_whitespace() || data[pos] == b'#') {
+            if data[pos] == b'#' { while pos < data.len() && data[pos] != b'\n' { pos += 1; } } else { pos += 1; }
+        }
+        let start = pos;
+        while pos < data.len() && !data[pos].is_ascii_whitespace() { pos += 1; }
+        if start == pos { return Err(invalid()); }
+        fields.push(String::from_utf8_lossy(&data[start .. pos]).to_string());
+    }
+    pos += 1;  //  Single whitespace before the pixels
+    let number = |s: &String| s.parse::<usize>().map_err(|_| invalid());
+    let (width, height) = (number(&fields[1]) ?, number(&fields[2]) ?);
+    if fields[0] != "P6" || number(&fields[3]) ? != 255 || width > 0xffff || height > 0xffff ||
+        data.len() < pos + width * height * 3 { return Err(invalid()); }
+    let pixels = data[pos .. pos + width * height * 3].chunks_exact(3)
+        .map(|rgb| (rgb[0] as u16 >> 3) << 11 | (rgb[1] as u16 >> 2) << 5 | rgb[2] as u16 >> 3)
+        .collect();
+    Ok((width as u16, height as u16, pixels))
+}
+
+/// Encode a PPM image into an image file for `image.rs`. Returns the width, height and size of the image file.
+pub fn encode_file(input: &str, output: &str) -> io::Result<(u16, u16, usize)> {
+    let (width, height, pixels) = read_ppm(input) ? ;
+    if width == 0 || width > 240 || height == 0 {
+        return Err(io::Error::new(io::ErrorKind::InvalidInput, "image must be 1 to 240 pixels wide"));
+    }
+    let data = encode(width, height, &pixels);
+    fs::write(output, &data) ? ;
+    Ok((width, height, data.len()))
+}
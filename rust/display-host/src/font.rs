@@ -0,0 +1,118 @@
+//! Font source for the glyph atlas. Classic 5 x 7 font, one byte per column with the top pixel in bit 0,
+//! scaled 2 times into a 12 x 16 cell. The cell has the same size as `Font12x16` in `embedded-graphics`,
+//! but the glyphs are not the same: text drawn with `text.rs` uses these glyphs.
+//! `write_atlas()` pre-renders the glyphs into the run-length encoded atlas `rust/mynewt/src/font_atlas.rs`.
+use std::{ fs, io };
+
+/// First and last characters in the font
+pub const FIRST_CHAR: u8 = 0x20;
+pub const LAST_CHAR: u8  = 0x7e;
+
+/// Size of a glyph cell in pixels
+pub const GLYPH_WIDTH: usize  = 12;
+pub const GLYPH_HEIGHT: usize = 16;
+
+/// Columns of each glyph from `FIRST_CHAR` to `LAST_CHAR`
+const FONT_5X7: [[u8; 5]; 95] = [
+    [0x00, 0x00, 0x00, 0x00, 0x00], [0x00, 0x00, 0x5f, 0x00, 0x00], [0x00, 0x07, 0x00, 0x07, 0x00], [0x14, 0x7f, 0x14, 0x7f, 0x14],  //   ! " #
+    [0x24, 0x2a, 0x7f, 0x2a, 0x12], [0x23, 0x13, 0x08, 0x64, 0x62], [0x36, 0x49, 0x55, 0x22, 0x50], [0x00, 0x05, 0x03, 0x00, 0x00],  //  $ % & '
+    [0x00, 0x1c, 0x22, 0x41, 0x00], [0x00, 0x41, 0x22, 0x1c, 0x00], [0x08, 0x2a, 0x1c, 0x2a, 0x08], [0x08, 0x08, 0x3e, 0x08, 0x08],  //  ( ) * +
+    [0x00, 0x50, 0x30, 0x00, 0x00], [0x08, 0x08, 0x08, 0x08, 0x08], [0x00, 0x60, 0x60, 0x00, 0x00], [0x20, 0x10, 0x08, 0x04, 0x02],  //  , - . /
+    [0x3e, 0x51, 0x49, 0x45, 0x3e], [0x00, 0x42, 0x7f, 0x40, 0x00], [0x42, 0x61, 0x51, 0x49, 0x46], [0x21, 0x41, 0x45, 0x4b, 0x31],  //  0 1 2 3
+    [0x18, 0x14, 0x12, 0x7f, 0x10], [0x27, 0x45, 0x45, 0x45, 0x39], [0x3c, 0x4a, 0x49, 0x49, 0x30], [0x01, 0x71, 0x09, 0x05, 0x03],  //  4 5 6 7
+    [0x36, 0x49, 0x49, 0x49, 0x36], [0x06, 0x49, 0x49, 0x29, 0x1e], [0x00, 0x36, 0x36, 0x00, 0x00], [0x00, 0x56, 0x36, 0x00, 0x00],  //  8 9 : ;
+    [0x08, 0x14, 0x22, 0x41, 0x00], [0x14, 0x14, 0x14, 0x14, 0x14], [0x00, 0x41, 0x22, 0x14, 0x08], [0x02, 0x01, 0x51, 0x09, 0x06],  //  < = > ?
+    [0x32, 0x49, 0x79, 0x41, 0x3e], [0x7e, 0x11, 0x11, 0x11, 0x7e], [0x7f, 0x49, 0x49, 0x49, 0x36], [0x3e, 0x41, 0x41, 0x41, 0x22],  //  @ A B C
+    [0x7f, 0x41, 0x41, 0x22, 0x1c], [0x7f, 0x49, 0x49, 0x49, 0x41], [0x7f, 0x09, 0x09, 0x09, 0x01], [0x3e, 0x41, 0x49, 0x49, 0x7a],  //  D E F G
+    [0x7f, 0x08, 0x08, 0x08, 0x7f], [0x00, 0x41, 0x7f, 0x41, 0x00], [0x20, 0x40, 0x41, 0x3f, 0x01], [0x7f, 0x08, 0x14, 0x22, 0x41],  //  H I J K
+    [0x7f, 0x40, 0x40, 0x40, 0x40], [0x7f, 0x02, 0x0c, 0x02, 0x7f], [0x7f, 0x04, 0x08, 0x10, 0x7f], [0x3e, 0x41, 0x41, 0x41, 0x3e],  //  L M N O
+    [0x7f, 0x09, 0x09, 0x09, 0x06], [0x3e, 0x41, 0x51, 0x21, 0x5e], [0x7f, 0x09, 0x19, 0x29, 0x46], [0x46, 0x49, 0x49, 0x49, 0x31],  //  P Q R S
+    [0x01, 0x01, 0x7f, 0x01, 0x01], [0x3f, 0x40, 0x40, 0x40, 0x3f], [0x1f, 0x20, 0x40, 0x20, 0x1f], [0x3f, 0x40, 0x38, 0x40, 0x3f],  //  T U V W
+    [0x63, 0x14, 0x08, 0x14, 0x63], [0x07, 0x08, 0x70, 0x08, 0x07], [0x61, 0x51, 0x49, 0x45, 0x43], [0x00, 0x7f, 0x41, 0x41, 0x00],  //  X Y Z [
+    [0x02, 0x04, 0x08, 0x10, 0x20], [0x00, 0x41, 0x41, 0x7f, 0x00], [0x04, 0x02, 0x01, 0x02, 0x04], [0x40, 0x40, 0x40, 0x40, 0x40],  //  \ ] ^ _
+    [0x00, 0x01, 0x02, 0x04, 0x00], [0x20, 0x54, 0x54, 0x54, 0x78], [0x7f, 0x48, 0x44, 0x44, 0x38], [0x38, 0x44, 0x44, 0x44, 0x20],  //  ` a b c
+    [0x38, 0x44, 0x44, 0x48, 0x7f], [0x38, 0x54, 0x54, 0x54, 0x18], [0x08, 0x7e, 0x09, 0x01, 0x02], [0x0c, 0x52, 0x52, 0x52, 0x3e],  //  d e f g
+    [0x7f, 0x08, 0x04, 0x04, 0x78], [0x00, 0x44, 0x7d, 0x40, 0x00], [0x20, 0x40, 0x44, 0x3d, 0x00], [0x7f, 0x10, 0x28, 0x44, 0x00],  //  h i j k
+    [0x00, 0x41, 0x7f, 0x40, 0x00], [0x7c, 0x04, 0x18, 0x04, 0x78], [0x7c, 0x08, 0x04, 0x04, 0x78], [0x38, 0x44, 0x44, 0x44, 0x38],  //  l m n o
+    [0x7c, 0x14, 0x14, 0x14, 0x08], [0x08, 0x14, 0x14, 0x18, 0x7c], [0x7c, 0x08, 0x04, 0x04, 0x08], [0x48, 0x54, 0x54, 0x54, 0x20],  //  p q r s
+    [0x04, 0x3f, 0x44, 0x40, 0x20], [0x3c, 0x40, 0x40, 0x20, 0x7c], [0x1c, 0x20, 0x40, 0x20, 0x1c], [0x3c, 0x40, 0x30, 0x40, 0x3c],  //  t u v w
+    [0x44, 0x28, 0x10, 0x28, 0x44], [0x0c, 0x50, 0x50, 0x50, 0x3c], [0x44, 0x64, 0x54, 0x4c, 0x44], [0x00, 0x08, 0x36, 0x41, 0x00],  //  x y z {
+    [0x00, 0x00, 0x7f, 0x00, 0x00], [0x00, 0x41, 0x36, 0x08, 0x00], [0x08, 0x04, 0x08, 0x10, 0x08],                                   //  | } ~
+];
+
+/// Return true if the pixel (x, y) of the glyph cell is in the foreground. Unknown characters are shown as '?'.
+pub fn pixel(ch: u8, x: usize, y: usize) -> bool {
+    let ch = if ch < FIRST_CHAR || ch > LAST_CHAR { b'?' } else { ch };
+    //  The 10 x 14 scaled glyph is placed 1 pixel from the left and top of the cell
+    if x < 1 || x > 10 || y < 1 || y > 14 { return false; }
+    let column = FONT_5X7[(ch - FIRST_CHAR) as usize][(x - 1) / 2];
+    column & (1 << ((y - 1) / 2)) != 0
+}
+
+/// Longest run that fits into 4 bits
+const MAX_RUN: u32 = 15;
+
+/// Encode the glyph as runs of background and foreground pixels, row by row, starting with background.
+/// Runs longer than 15 pixels are split with an empty run of the other colour.
+fn encode_glyph(ch: u8, runs: &mut Vec<u8>) {
+    let mut foreground = false;
+    let mut len = 0_u32;
+    for y in 0 .. GLYPH_HEIGHT {
+        for x in 0 .. GLYPH_WIDTH {
+            if pixel(ch, x, y) != foreground {
+                push_run(runs, len);
+                foreground = !foreground;
+                len = 0;
+            }
+            len += 1;
+        }
+    }
+    push_run(runs, len);
+}
+
+fn push_run(runs: &mut Vec<u8>, mut len: u32) {
+    while len > MAX_RUN { runs.extend_from_slice(&[MAX_RUN as u8, 0]); len -= MAX_RUN; }
+    runs.push(len as u8);
+}
+
+/// Size of the atlas in bytes if the glyphs were stored as a plain bitmap, 1 bit per pixel
+pub const BITMAP_SIZE: usize = (LAST_CHAR - FIRST_CHAR + 1) as usize * GLYPH_WIDTH * GLYPH_HEIGHT / 8;
+
+/// Pre-render the glyphs into a run-length encoded atlas and save it as Rust source.
+/// Returns the size of the runs and the offsets in bytes.
+pub fn write_atlas(path: &str) -> io::Result<usize> {
+    let mut runs = Vec::new();
+    let mut offsets = Vec::new();
+    for ch in FIRST_CHAR ..= LAST_CHAR {
+        offsets.push(runs.len());
+        encode_glyph(ch, &mut runs);
+    }
+    offsets.push(runs.len());
+    //  Pack two runs per byte, high nibble first
+    let packed: Vec<u8> = runs.chunks(2).map(|pair| pair[0] << 4 | pair.get(1).unwrap_or(&0)).collect();
+
+    let mut src = String::new();
+    src.push_str("//! Glyph atlas for `text.rs`: 12 x 16 glyphs for characters 0x20 to 0x7E, 1 bit per pixel, run-length encoded.\n");
+    src.push_str("//! Each glyph is a sequence of 4-bit run lengths that alternate between background and foreground pixels,\n");
+    src.push_str("//! row by row, starting with background. Runs longer than 15 pixels are split with an empty run.\n");
+    src.push_str("//! Generated by `rust/display-host` from `src/font.rs`, do not edit:\n");
+    src.push_str("//! `cargo run --release --target $(rustc -vV | sed -n 's/host: //p') -- --gen-font ../mynewt/src/font_atlas.rs`\n\n");
+    src.push_str(&format!("/// Width of a glyph in pixels\npub const GLYPH_WIDTH: u16 = {};\n", GLYPH_WIDTH));
+    src.push_str(&format!("/// Height of a glyph in pixels\npub const GLYPH_HEIGHT: u16 = {};\n", GLYPH_HEIGHT));
+    src.push_str(&format!("/// First character in the atlas\npub const FIRST_CHAR: u8 = 0x{:02x};\n", FIRST_CHAR));
+    src.push_str(&format!("/// Last character in the atlas\npub const LAST_CHAR: u8 = 0x{:02x};\n\n", LAST_CHAR));
+    src.push_str(&format!("/// Index of the first run of each glyph in `GLYPH_RUNS`, counted in runs, followed by the end index\npub static GLYPH_OFFSETS: [u16; {}] = [", offsets.len()));
+    for (i, o) in offsets.iter().enumerate() {
+        if i % 16 == 0 { src.push_str("\n   "); }
+        src.push_str(&format!(" {},", o));
+    }
+    src.push_str("\n];\n\n");
+    src.push_str(&format!("/// Run lengths of all glyphs, two runs per byte, high nibble first\npub static GLYPH_RUNS: [u8; {}] = [", packed.len()));
+    for (i, r) in packed.iter().enumerate() {
+        if i % 16 == 0 { src.push_str("\n   "); }
+        src.push_str(&format!(" 0x{:02x},", r));
+    }
+    src.push_str("\n];\n");
+    fs::write(path, src) ? ;
+    Ok(packed.len() + offsets.len() * 2)
+}
@@ -0,0 +1,203 @@
+//! Host framebuffer display backend. Decodes the ST7789 Command Bytes and Data Bytes written through
+//! `DisplayBus` into a 240 x 240 RGB565 framebuffer, and counts the bytes, commands and windows of each frame.
+//! Like the ST7789, the frame memory has 320 rows and the displayed rows follow the vertical scroll settings.
+use std::{ fs, io::{ self, Write }, path::Path };
+use crate::{
+    result::*,
+    display::{ self, DisplayBus },
+};
+
+/// Width and height of the display in pixels
+pub const WIDTH: usize  = 240;
+pub const HEIGHT: usize = 240;
+
+/// Number of rows in the frame memory
+const MEMORY_ROWS: usize = 320;
+
+/// SPI clock of the PineTime display in kHz, see `SPI_SETTINGS` in `spi.rs`
+const SPI_KHZ: u32 = 8000;
+
+/// SPI traffic of a frame
+#[derive(Clone, Copy, Debug, Default, PartialEq)]
+pub struct FrameStats {
+    /// Command Bytes and Data Bytes written
+    pub bytes: u32,
+    /// Command Bytes written
+    pub commands: u32,
+    /// Windows written with RAMWR
+    pub windows: u32,
+    /// Pixels written
+    pub pixels: u32,
+}
+
+impl FrameStats {
+    /// Time to send the frame over SPI in milliseconds, excluding the gaps between requests
+    pub fn spi_ms(&self) -> f64 {
+        self.bytes as f64 * 8.0 / SPI_KHZ as f64
+    }
+}
+
+/// In-memory ST7789 display
+pub struct Framebuffer {
+    /// RGB565 pixels of the frame memory, row by row
+    pixels: Vec<u16>,
+    /// Last Command Byte
+    cmd: u8,
+    /// Data Bytes received for CASET, RASET, VSCRDEF and VSCSAD
+    params: [u8; 6],
+    /// Number of Data Bytes received for the last Command Byte
+    param_len: usize,
+    /// Window columns and rows, inclusive
+    columns: (u16, u16),
+    rows: (u16, u16),
+    /// Position of the next pixel
+    x: u16,
+    y: u16,
+    /// First byte of a pixel split across two `write_data()` calls
+    half: Option<u8>,
+    /// Top fixed rows and vertical scroll rows set by VSCRDEF
+    scroll_top: usize,
+    scroll_rows: usize,
+    /// Frame memory row shown at the top of the vertical scroll area, set by VSCSAD
+    scroll_start: usize,
+    /// SPI traffic of the current frame
+    stats: FrameStats,
+}
+
+impl Framebuffer {
+    /// Create a black framebuffer. The window is the whole display, as after reset.
+    pub fn new() -> Framebuffer {
+        Framebuffer {
+            pixels:    vec![0; WIDTH * MEMORY_ROWS],
+            cmd:       0,
+            params:    [0; 6],
+            param_len: 0,
+            columns:   (0, WIDTH as u16 - 1),
+            rows:      (0, HEIGHT as u16 - 1),
+            x:         0,
+            y:         0,
+            half:      None,
+            scroll_top:   0,
+            scroll_rows:  MEMORY_ROWS,
+            scroll_start: 0,
+            stats:     FrameStats::default(),
+        }
+    }
+
+    /// Return the RGB565 pixel shown at (x, y)
+    pub fn pixel(&self, x: usize, y: usize) -> u16 {
+        self.pixels[self.memory_row(y) * WIDTH + x]
+    }
+
+    /// Return the frame memory row shown at display row `y`
+    fn memory_row(&self, y: usize) -> usize {
+        let (top, rows) = (self.scroll_top, self.scroll_rows);
+        if y < top || y >= top + rows { return y; }
+        let offset = self.scroll_start as isize - top as isize + (y - top) as isize;
+        top + offset.rem_euclid(rows as isize) as usize
+    }
+
+    /// Return the RGB565 pixels shown on the display, row by row
+    fn shown(&self) -> impl Iterator<Item = u16> + '_ {
+        (0 .. HEIGHT).flat_map(move |y| {
+            let row = self.memory_row(y) * WIDTH;
+            self.pixels[row .. row + WIDTH].iter().cloned()
+        })
+    }
+
+    /// Return the SPI traffic since the last call and start counting the next frame
+    pub fn end_frame(&mut self) -> FrameStats {
+        core::mem::replace(&mut self.stats, FrameStats::default())
+    }
+
+    /// FNV-1a hash of the pixels shown, for regression tests
+    pub fn checksum(&self) -> u32 {
+        self.shown().fold(0x811c_9dc5_u32, |hash, p| {
+            let hash = (hash ^ (p >> 8) as u32).wrapping_mul(0x0100_0193);
+            (hash ^ (p & 0xff) as u32).wrapping_mul(0x0100_0193)
+        })
+    }
+
+    /// Save the pixels shown as a binary PPM image
+    pub fn write_ppm<P: AsRef<Path>>(&self, path: P) -> io::Result<()> {
+        let mut out = Vec::with_capacity(20 + WIDTH * HEIGHT * 3);
+        write!(out, "P6\n{} {}\n255\n", WIDTH, HEIGHT) ? ;
+        for p in self.shown() {
+            //  Expand RGB565 to RGB888, replicating the high bits into the low bits
+            let (r, g, b) = ((p >> 11) & 0x1f, (p >> 5) & 0x3f, p & 0x1f);
+            out.extend_from_slice(&[ (r << 3 | r >> 2) as u8, (g << 2 | g >> 4) as u8, (b << 3 | b >> 2) as u8 ]);
+        }
+        fs::write(path, out)
+    }
+
+    /// Store a pixel at the current position and advance, wrapping at the right of the window
+    fn put(&mut self, color: u16) {
+        if self.y > self.rows.1 { return; }  //  Past the end of the window. Ignored.
+        if (self.x as usize) < WIDTH && (self.y as usize) < MEMORY_ROWS {
+            self.pixels[self.y as usize * WIDTH + self.x as usize] = color;
+        }
+        self.stats.pixels += 1;
+        self.x += 1;
+        if self.x > self.columns.1 { self.x = self.columns.0; self.y += 1; }
+    }
+}
+
+impl DisplayBus for Framebuffer {
+    fn write_command(&mut self, cmd: u8) -> MynewtResult<()> {
+        self.stats.bytes += 1;
+        self.stats.commands += 1;
+        self.cmd = cmd;
+        self.param_len = 0;
+        self.half = None;
+        if cmd == display::RAMWR {
+            //  Start writing at the top left of the window
+            self.stats.windows += 1;
+            self.x = self.columns.0;
+            self.y = self.rows.0;
+        }
+        Ok(())
+    }
+
+    fn write_data(&mut self, data: &[u8]) -> MynewtResult<()> {
+        self.stats.bytes += data.len() as u32;
+        match self.cmd {
+            display::CASET | display::RASET | display::VSCRDEF | display::VSCSAD => {
+                let len = match self.cmd { display::VSCRDEF => 6, display::VSCSAD => 2, _ => 4 };
+                for b in data {
+                    if self.param_len == len { return Err(MynewtError::SYS_EINVAL); }
+                    self.params[self.param_len] = *b;
+                    self.param_len += 1;
+                }
+                if self.param_len == len {
+                    let p = &self.params;
+                    let word = |i: usize| (p[i] as u16) << 8 | p[i + 1] as u16;
+                    match self.cmd {
+                        display::CASET => self.columns = (word(0), word(2)),
+                        display::RASET => self.rows = (word(0), word(2)),
+                        display::VSCRDEF => {
+                            //  Top fixed, scroll and bottom fixed rows must add up to the frame memory rows
+                            let (top, rows, bottom) = (word(0) as usize, word(2) as usize, word(4) as usize);
+                            if top + rows + bottom != MEMORY_ROWS || rows == 0 { return Err(MynewtError::SYS_EINVAL); }
+                            self.scroll_top = top;
+                            self.scroll_rows = rows;
+                        }
+                        _ => self.scroll_start = word(0) as usize,
+                    }
+                }
+            }
+            display::RAMWR | display::RAMWRC => {
+                let mut data = data;
+                if let Some(hi) = self.half.take() {
+                    if data.len() == 0 { self.half = Some(hi); return Ok(()); }
+                    self.put((hi as u16) << 8 | data[0] as u16);
+                    data = &data[1..];
+                }
+                let mut pairs = data.chunks_exact(2);
+                for pair in &mut pairs { self.put((pair[0] as u16) << 8 | pair[1] as u16); }
+                if let [hi] = pairs.remainder() { self.half = Some(*hi); }
+            }
+            _ => {}  //  Other commands don't change the framebuffer
+        }
+        Ok(())
+    }
+}
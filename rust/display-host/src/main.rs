@@ -0,0 +1,531 @@
+//! Host display backend for benchmarking and regression-testing the PineTime rendering off-device.
+//! Renders scenes through the same `DisplayBus` interface as `spi.rs`, into a framebuffer that decodes the
+//! ST7789 commands. For each scene, prints the SPI traffic and render time, checks the pixels and saves a PPM image.
+//! Run in `rust/display-host` with the host target, since `.cargo/config` selects the Arm target:
+//! `cargo run --release --target $(rustc -vV | sed -n 's/host: //p') -- [output folder]`
+#![deny(warnings)]  //  The modules shared with PineTime must build without warnings, e.g. `static_mut_refs`
+use std::{ env, fs, time::Instant };
+
+///  Same error codes as `mynewt::result`, for the display modules compiled from `../mynewt/src`
+#[allow(dead_code, non_camel_case_types)]
+mod result {
+    pub type MynewtResult<T> = ::core::result::Result<T, MynewtError>;
+    #[derive(Debug, PartialEq)]
+    pub enum MynewtError { SYS_EOK, SYS_ENOMEM, SYS_EINVAL, SYS_EUNKNOWN }
+}
+
+#[allow(dead_code)]
+#[path = "../../mynewt/src/display.rs"]
+mod display;  //  ST7789 Display Command Interface, same as on PineTime
+#[allow(dead_code)]
+#[path = "../../mynewt/src/dirty.rs"]
+mod dirty;    //  Dirty Rectangle Tracking, same as on PineTime
+#[path = "../../mynewt/src/font_atlas.rs"]
+mod font_atlas;  //  Glyph atlas generated by `font::write_atlas()`
+#[path = "../../mynewt/src/text.rs"]
+mod text;     //  Text rendering with the glyph atlas, same as on PineTime
+#[path = "../../mynewt/src/fill.rs"]
+mod fill;     //  Fill kernels, same as on PineTime
+#[path = "../../mynewt/src/scroll.rs"]
+mod scroll;   //  Hardware Vertical Scrolling, same as on PineTime
+#[path = "../../mynewt/src/image.rs"]
+mod image;    //  Image Streaming, same as on PineTime
+#[path = "../../mynewt/src/frame_time.rs"]
+mod frame_time;  //  Frame Time Instrumentation, same as on PineTime
+#[path = "../../mynewt/src/spi_bus.rs"]
+mod spi_bus;  //  Shared SPI Bus, same as on PineTime
+mod encoder;
+mod font;
+mod framebuffer;
+mod pixels;
+mod spi_sim;
+mod timing;
+
+use crate::{
+    result::*,
+    dirty::{ DirtyRegion, Rect },
+    frame_time::{ FrameTimer, Stage },
+    framebuffer::{ Framebuffer, FrameStats, HEIGHT, WIDTH },
+    image::Image,
+    pixels::Batcher,
+    scroll::Scroller,
+    spi_bus::{ SpiBus, SpiSettings, TxnCommand, DISPLAY_DEVICE },
+    spi_sim::{ SimPort, SpiTask, Transfer },
+};
+
+/// Number of times each scene is rendered for timing
+const LOOPS: u32 = 20;
+
+/// RGB565 colours
+const BLACK: u16   = 0x0000;
+const BLUE: u16    = 0x001f;
+const MAGENTA: u16 = 0xf81f;
+const GREY: u16    = 0x8410;
+const WHITE: u16   = 0xffff;
+const YELLOW: u16  = 0xffe0;
+
+/// Whole display
+const SCREEN: Rect = Rect::new(0, 0, WIDTH as u16 - 1, HEIGHT as u16 - 1);
+
+/// Label and button of the counter app in `rust/app/src/ui.rs`
+const LABEL: Rect  = Rect::new(20, 40, 219, 70);
+const BUTTON: Rect = Rect::new(20, 150, 219, 200);
+
+/// Background, circle, square and text of `test_display()` in `rust/app/src/display.rs`, pixel by pixel like `embedded-graphics`
+fn test_display(fb: &mut Framebuffer) -> MynewtResult<()> {
+    let mut batcher = Batcher::new(fb);
+    pixels::fill_rect(&mut batcher, &SCREEN, &SCREEN, BLACK) ? ;
+    pixels::fill_circle(&mut batcher, 40, 40, 40, &SCREEN, MAGENTA) ? ;
+    pixels::fill_rect(&mut batcher, &Rect::new(60, 60, 150, 150), &SCREEN, BLUE) ? ;
+    pixels::draw_text(&mut batcher, "I AM PINETIME", 20, 16, BLACK, YELLOW) ? ;
+    batcher.finish()
+}
+
+/// Lines of a text-heavy watch face
+const WATCH_FACE: [&str; 8] = [
+    "12:34:56  Tue 17 Oct", "Steps        8,421", "Heart rate   72 bpm", "Battery      85%",
+    "Lat  1.2701 N", "Lng  103.8078 E", "Notifications: 3", "I AM PINETIME",
+];
+
+/// Draw the watch face pixel by pixel
+fn watch_face_pixels(fb: &mut Framebuffer) -> MynewtResult<()> {
+    let mut batcher = Batcher::new(fb);
+    for (i, line) in WATCH_FACE.iter().enumerate() {
+        pixels::draw_text(&mut batcher, line, 0, 20 + i as u16 * 26, WHITE, BLACK) ? ;
+    }
+    batcher.finish()
+}
+
+/// Draw the watch face with the glyph atlas
+fn watch_face_atlas(fb: &mut Framebuffer) -> MynewtResult<()> {
+    for (i, line) in WATCH_FACE.iter().enumerate() {
+        text::draw_text(fb, line, 0, 20 + i as u16 * 26, WHITE, BLACK) ? ;
+    }
+    Ok(())
+}
+
+/// `test_display()` with the fill kernels and the glyph atlas, same as `rust/app/src/display.rs`
+fn test_display_fast(fb: &mut Framebuffer) -> MynewtResult<()> {
+    fill::fill_rect(fb, &SCREEN, &SCREEN, BLACK) ? ;
+    fill::fill_circle(fb, 40, 40, 40, &SCREEN, MAGENTA) ? ;
+    fill::fill_rect(fb, &Rect::new(60, 60, 150, 150), &SCREEN, BLUE) ? ;
+    text::draw_text(fb, "I AM PINETIME", 20, 16, BLACK, YELLOW) ? ;
+    Ok(())
+}
+
+/// Height of a line in the log view, below a status bar of the same height
+const LOG_LINE: u16 = font_atlas::GLYPH_HEIGHT;
+
+/// Draw line `n` of the log view at frame memory row `top`, clearing the rest of the row
+fn draw_log_line<B: display::DisplayBus>(bus: &mut B, n: u32, top: u16) -> MynewtResult<()> {
+    let line = format!("{:05} sensor {:>4}", n, n * 37 % 1000);
+    let width = text::draw_text(bus, &line, 0, top, if n % 5 == 0 { YELLOW } else { WHITE }, BLACK) ? as u16 * font_atlas::GLYPH_WIDTH;
+    fill::fill_rect(bus, &Rect::new(width, top, WIDTH as u16 - 1, top + LOG_LINE - 1), &Rect::new(0, 0, WIDTH as u16 - 1, display::MEMORY_ROWS - 1), BLACK)
+}
+
+/// Redraw every line of the log view, ending with line `last`
+fn log_full(fb: &mut Framebuffer, last: u32) -> MynewtResult<()> {
+    let lines = (HEIGHT as u16 - LOG_LINE) / LOG_LINE;
+    for i in 0 .. lines {
+        draw_log_line(fb, last + 1 + i as u32 - lines as u32, LOG_LINE + i * LOG_LINE) ? ;
+    }
+    Ok(())
+}
+
+/// Analog watch face with few colours: dial, hour marks and hands
+fn watch_face_image() -> Vec<u16> {
+    let mut pixels = vec![BLACK; WIDTH * HEIGHT];
+    for y in 0 .. HEIGHT {
+        for x in 0 .. WIDTH {
+            let (dx, dy) = (x as f64 - 119.5, y as f64 - 119.5);
+            let (d, angle) = ((dx * dx + dy * dy).sqrt(), dy.atan2(dx));
+            //  Angle from the nearest hour mark
+            let hour = (angle / (std::f64::consts::PI / 6.0)).round() * (std::f64::consts::PI / 6.0);
+            let pixel = &mut pixels[y * WIDTH + x];
+            if d < 118.0 { *pixel = 0x10a2; }
+            if d > 96.0 && d < 112.0 && ((angle - hour) * d).abs() < 3.0 { *pixel = WHITE; }
+            let hand = |a: f64, len: f64, half: f64| (dx * a.cos() + dy * a.sin()) > 0.0 &&
+                (dx * a.cos() + dy * a.sin()) < len && (dy * a.cos() - dx * a.sin()).abs() < half;
+            if hand(-1.2, 60.0, 4.0) { *pixel = YELLOW; }
+            if hand(0.5, 90.0, 2.5) { *pixel = WHITE; }
+            if d < 6.0 { *pixel = MAGENTA; }
+        }
+    }
+    pixels
+}
+
+/// Icon with a colour gradient, too many colours for a palette
+fn gradient_image(width: usize, height: usize) -> Vec<u16> {
+    (0 .. width * height).map(|i| {
+        let (x, y) = (i % width, i / width);
+        if x < 4 || y < 4 || x >= width - 4 || y >= height - 4 { return GREY; }
+        ((x * 31 / width) << 11 | (y * 63 / height) << 5 | (x + y) / 8 % 32) as u16
+    }).collect()
+}
+
+/// Check that the framebuffer shows the pixels of the image at (left, top) inside the clip area
+fn check_image(fb: &Framebuffer, pixels: &[u16], width: usize, left: usize, top: usize, clip: &Rect) {
+    for y in clip.top as usize ..= clip.bottom as usize {
+        for x in clip.left as usize ..= clip.right as usize {
+            if x < left || y < top || x >= left + width || y >= top + pixels.len() / width { continue; }
+            assert_eq!(fb.pixel(x, y), pixels[(y - top) * width + x - left], "image pixel ({}, {}) differs", x, y);
+        }
+    }
+}
+
+/// Render into the framebuffer and return the fill rate in pixels per second, modelled from the SPI bytes at 8 MHz.
+/// The bytes include the window commands, so the rate drops as the number of windows per fill grows.
+fn fill_rate<F>(name: &str, render: F) -> (f64, FrameStats)
+where F: FnMut(&mut Framebuffer) -> MynewtResult<()> {
+    let mut fb = Framebuffer::new();
+    let stats = run(name, &mut fb, render);
+    (stats.pixels as f64 * 1000.0 / stats.spi_ms(), stats)
+}
+
+/// Paint the counter app inside the clip area. The label shows the count as a bar, the button is highlighted when pressed.
+fn paint_counter<B: display::DisplayBus>(bus: &mut B, count: u16, pressed: bool, clip: &Rect) -> MynewtResult<()> {
+    let mut batcher = Batcher::new(bus);
+    pixels::fill_rect(&mut batcher, &SCREEN, clip, BLACK) ? ;
+    pixels::fill_rect(&mut batcher, &LABEL, clip, GREY) ? ;
+    pixels::fill_rect(&mut batcher, &Rect::new(LABEL.left, LABEL.top, LABEL.left + count * 10, LABEL.bottom), clip, WHITE) ? ;
+    pixels::fill_rect(&mut batcher, &BUTTON, clip, if pressed { WHITE } else { BLUE }) ? ;
+    batcher.finish()
+}
+
+/// Colour of the counter app at (x, y), same as `paint_counter()`
+fn counter_pixel(count: u16, pressed: bool, x: u16, y: u16) -> u16 {
+    let inside = |r: &Rect| x >= r.left && x <= r.right && y >= r.top && y <= r.bottom;
+    if inside(&BUTTON) { return if pressed { WHITE } else { BLUE }; }
+    if inside(&LABEL) { return if x <= LABEL.left + count * 10 { WHITE } else { GREY }; }
+    BLACK
+}
+
+/// Paint callback for `dirty::flush()`: write exactly the pixels of the dirty area, row by row
+fn paint_counter_area<B: display::DisplayBus>(bus: &mut B, count: u16, rect: &Rect) -> MynewtResult<()> {
+    let mut row = Vec::with_capacity(WIDTH * 2);
+    for y in rect.top ..= rect.bottom {
+        row.clear();
+        for x in rect.left ..= rect.right { row.extend_from_slice(&counter_pixel(count, true, x, y).to_be_bytes()); }
+        bus.write_pixels(&row) ? ;
+    }
+    Ok(())
+}
+
+/// Render a scene `LOOPS` times, print the SPI traffic of one rendering and the time per rendering
+fn run<F>(name: &str, fb: &mut Framebuffer, mut render: F) -> FrameStats
+where F: FnMut(&mut Framebuffer) -> MynewtResult<()> {
+    let start = Instant::now();
+    for _ in 0 .. LOOPS { render(fb).expect("render failed"); }
+    let elapsed = start.elapsed().as_secs_f64() / LOOPS as f64;
+    let total = fb.end_frame();
+    let stats = FrameStats {
+        bytes:    total.bytes / LOOPS,
+        commands: total.commands / LOOPS,
+        windows:  total.windows / LOOPS,
+        pixels:   total.pixels / LOOPS,
+    };
+    println!("{:<14} {:>7} bytes {:>6} commands {:>6} windows {:>6} pixels {:>7.1} ms SPI {:>8.1} us host",
+        name, stats.bytes, stats.commands, stats.windows, stats.pixels, stats.spi_ms(), elapsed * 1e6);
+    stats
+}
+
+fn main() {
+    let args: Vec<String> = env::args().collect();
+    if args.len() == 4 && args[1] == "--encode" {
+        //  Encode a PPM image for `image.rs`
+        let (width, height, size) = encoder::encode_file(&args[2], &args[3]).expect("encode failed");
+        println!("{} x {} image: {} bytes, {:.1}% of RGB565", width, height, size, size as f64 * 50.0 / (width as f64 * height as f64));
+        return;
+    }
+    if args.len() == 3 && args[1] == "--gen-font" {
+        //  Pre-render the glyph atlas
+        let size = font::write_atlas(&args[2]).expect("write failed");
+        println!("glyph atlas: {} bytes", size);
+        return;
+    }
+    let out = args.get(1).cloned().unwrap_or("out".to_string());
+    fs::create_dir_all(&out).expect("mkdir failed");
+
+    //  test_display(): Whole screen, then circle and square drawn over it
+    let mut fb = Framebuffer::new();
+    let stats = run("test_display", &mut fb, test_display);
+    assert_eq!(stats.pixels, 240 * 240 + 5025 + 91 * 91 + 13 * 12 * 16);
+    assert_eq!(fb.pixel(40, 40), MAGENTA);
+    assert_eq!(fb.pixel(100, 100), BLUE);
+    assert_eq!(fb.pixel(200, 200), BLACK);
+    assert_eq!(fb.checksum(), 0xf0c6_e060, "test_display pixels changed");
+    fb.write_ppm(format!("{}/test_display.ppm", out)).expect("write failed");
+
+    //  test_display() with the fill kernels and glyph atlas must produce the same pixels
+    let mut fast = Framebuffer::new();
+    let fast_stats = run("test_display_k", &mut fast, test_display_fast);
+    assert_eq!(fast.checksum(), fb.checksum(), "fill kernels differ from pixel rendering");
+    println!("test_display with kernels: {:.0}x fewer commands, {:.0}% of the SPI bytes",
+        stats.commands as f64 / fast_stats.commands as f64, fast_stats.bytes as f64 * 100.0 / stats.bytes as f64);
+
+    //  Fill rate of the kernels vs pixel by pixel. Same pixels, but the rectangle needs one window instead of one per row.
+    let (pixel_rect, pixel_rect_stats) = fill_rate("rect_pixels", |fb| {
+        let mut batcher = Batcher::new(fb);
+        pixels::fill_rect(&mut batcher, &SCREEN, &SCREEN, BLUE) ? ;
+        batcher.finish()
+    });
+    let (kernel_rect, kernel_rect_stats) = fill_rate("rect_kernel", |fb| fill::fill_rect(fb, &SCREEN, &SCREEN, BLUE));
+    assert_eq!(kernel_rect_stats.pixels, pixel_rect_stats.pixels);
+    assert_eq!(kernel_rect_stats.windows, 1, "rectangle must be one window");
+    let (pixel_circle, pixel_circle_stats) = fill_rate("circle_pixels", |fb| {
+        let mut batcher = Batcher::new(fb);
+        pixels::fill_circle(&mut batcher, 120, 120, 119, &SCREEN, MAGENTA) ? ;
+        batcher.finish()
+    });
+    let (kernel_circle, kernel_circle_stats) = fill_rate("circle_kernel", |fb| fill::fill_circle(fb, 120, 120, 119, &SCREEN, MAGENTA));
+    assert_eq!(kernel_circle_stats.pixels, pixel_circle_stats.pixels);
+    assert!(kernel_circle_stats.bytes <= pixel_circle_stats.bytes, "circle spans must not add SPI bytes");
+    println!("fill rate at 8 MHz: rect {:.0} vs {:.0} pixels/s, circle {:.0} vs {:.0} pixels/s (kernel vs pixels)",
+        kernel_rect, pixel_rect, kernel_circle, pixel_circle);
+
+    //  Counter app: Repaint the whole screen after each button press
+    let mut full = Framebuffer::new();
+    let mut count = 0;
+    let full_stats = run("counter_full", &mut full, |fb| {
+        count = (count + 1) % 20;
+        paint_counter(fb, count, true, &SCREEN)
+    });
+
+    //  Counter app: Repaint only the label and the button after each button press
+    let mut partial = Framebuffer::new();
+    paint_counter(&mut partial, 0, false, &SCREEN).unwrap();
+    partial.end_frame();
+    let mut count = 0;
+    let partial_stats = run("counter_dirty", &mut partial, |fb| {
+        count = (count + 1) % 20;
+        let mut region = DirtyRegion::new();
+        region.invalidate(LABEL);
+        region.invalidate(BUTTON);
+        for rect in region.rects() { paint_counter(fb, count, true, rect) ? ; }
+        Ok(())
+    });
+    //  Partial refresh must produce the same pixels as the full refresh
+    assert_eq!(partial.checksum(), full.checksum(), "partial refresh differs from full refresh");
+    partial.write_ppm(format!("{}/counter.ppm", out)).expect("write failed");
+    println!("counter partial refresh: {:.0}% of the SPI bytes", partial_stats.bytes as f64 * 100.0 / full_stats.bytes as f64);
+
+    //  Counter app: Repaint through the dirty areas of the UI, like the button handler. Only the label and the button
+    //  are sent: 200 x 31 + 200 x 51 = 16400 of the 57600 pixels, each pixel once.
+    let mut flushed = Framebuffer::new();
+    paint_counter(&mut flushed, 0, false, &SCREEN).unwrap();
+    flushed.end_frame();
+    let mut repainted = 0;
+    let flushed_stats = run("counter_flush", &mut flushed, |fb| {
+        dirty::invalidate(BUTTON);
+        dirty::invalidate(LABEL);
+        assert!(dirty::needs_paint(&LABEL) && !dirty::needs_paint(&Rect::new(0, 0, 239, 20)), "wrong dirty areas");
+        repainted = dirty::flush(fb, |bus, rect| paint_counter_area(bus, 19, rect)) ? ;
+        Ok(())
+    });
+    assert_eq!(repainted, LABEL.area() + BUTTON.area());
+    assert_eq!(repainted, 16400);
+    assert_eq!(flushed_stats.pixels, 16400, "dirty areas must be painted once");
+    assert_eq!(flushed_stats.windows, 2, "one window per dirty area");
+    assert!(!dirty::needs_paint(&LABEL), "flush must clear the dirty areas");
+    let mut expected = Framebuffer::new();
+    paint_counter(&mut expected, 19, true, &SCREEN).unwrap();
+    assert_eq!(flushed.checksum(), expected.checksum(), "dirty flush differs from full refresh");
+    println!("counter dirty flush: {} of {} pixels", repainted, SCREEN.area());
+
+    //  Counter app: Time the stages from touch to photon, with the full and partial repaints
+    let mut timed = Framebuffer::new();
+    let summary = timing::time_frames(&mut timed, 40, |i| (i % 20) as u16, |bus, count| paint_counter(bus, *count, true, &SCREEN));
+    timing::print_summary("frame_time_full", &summary);
+    assert_eq!(summary.frames, 40);
+    let summary = timing::time_frames(&mut timed, 40, |i| {
+        let mut region = DirtyRegion::new();
+        region.invalidate(LABEL);
+        region.invalidate(BUTTON);
+        ((i % 20) as u16, region)
+    }, |bus, (count, region)| {
+        for rect in region.rects() { paint_counter(bus, *count, true, rect) ? ; }
+        Ok(())
+    });
+    timing::print_summary("frame_time_dirty", &summary);
+    let mut expected = Framebuffer::new();
+    paint_counter(&mut expected, 19, true, &SCREEN).unwrap();
+    assert_eq!(timed.checksum(), expected.checksum(), "timed rendering differs");
+
+    //  Frame timer: Unmarked stages are counted in the next stage, painted frames wait for the SPI queue to be empty
+    let mut timer = FrameTimer::new();
+    timer.mark(Stage::Touch, 100);
+    timer.mark(Stage::Dispatch, 150);
+    timer.enqueue(20);
+    timer.spi_idle(400);
+    assert_eq!(timer.last(), Some([ 50, 0, 0, 20, 0, 230, 300 ]));
+    timer.mark(Stage::Update, 500);
+    timer.enqueue(30);
+    timer.wait(10);
+    timer.mark(Stage::Paint, 600);
+    timer.mark(Stage::Touch, 610);  //  Next frame starts before the SPI transfers complete
+    timer.spi_idle(700);
+    assert_eq!(timer.last(), Some([ 0, 0, 60, 30, 10, 100, 200 ]));
+    timer.mark(Stage::Paint, 800);  //  SPI queue is already empty
+    assert_eq!(timer.last(), Some([ 0, 0, 190, 0, 0, 0, 190 ]));
+    //  Encoding for Bluetooth LE: frames, dropped, then the percentiles of each stage
+    let mut encoded = [0; frame_time::SUMMARY_SIZE];
+    assert_eq!(timer.summary().encode(&mut encoded), frame_time::SUMMARY_SIZE);
+    assert_eq!(encoded[.. 8], [ 3, 0, 0, 0, 0, 0, 0, 0 ]);
+    assert_eq!(encoded[frame_time::SUMMARY_SIZE - 4 ..], 300_u32.to_le_bytes());  //  Max total
+
+    //  Watch face: Text drawn pixel by pixel vs with the glyph atlas
+    let mut by_pixel = Framebuffer::new();
+    let pixel_stats = run("text_pixels", &mut by_pixel, watch_face_pixels);
+    let mut by_atlas = Framebuffer::new();
+    let atlas_stats = run("text_atlas", &mut by_atlas, watch_face_atlas);
+    assert_eq!(by_atlas.checksum(), by_pixel.checksum(), "glyph atlas differs from pixel rendering");
+    by_atlas.write_ppm(format!("{}/watch_face.ppm", out)).expect("write failed");
+
+    //  Every glyph of the atlas must show the pixels of the font source, and the atlas must be smaller than a bitmap
+    let mut glyphs = Framebuffer::new();
+    let chars: Vec<u8> = (font::FIRST_CHAR ..= font::LAST_CHAR).collect();
+    for (i, line) in chars.chunks(WIDTH / font::GLYPH_WIDTH).enumerate() {
+        let top = i * font::GLYPH_HEIGHT;
+        text::draw_text(&mut glyphs, std::str::from_utf8(line).unwrap(), 0, top as u16, WHITE, BLACK).unwrap();
+        for (n, &ch) in line.iter().enumerate() {
+            for y in 0 .. font::GLYPH_HEIGHT {
+                for x in 0 .. font::GLYPH_WIDTH {
+                    let expected = if font::pixel(ch, x, y) { WHITE } else { BLACK };
+                    assert_eq!(glyphs.pixel(n * font::GLYPH_WIDTH + x, top + y), expected, "glyph {:?} differs", ch as char);
+                }
+            }
+        }
+    }
+    let atlas_size = font_atlas::GLYPH_RUNS.len() + font_atlas::GLYPH_OFFSETS.len() * 2;
+    assert!(atlas_size < font::BITMAP_SIZE, "atlas is bigger than a bitmap");
+    println!("glyph atlas: {} bytes, {:.0}% of a 1-bit bitmap", atlas_size, atlas_size as f64 * 100.0 / font::BITMAP_SIZE as f64);
+    println!("text with glyph atlas: {:.1}x fewer commands, {:.0}% of the SPI bytes",
+        pixel_stats.commands as f64 / atlas_stats.commands as f64, atlas_stats.bytes as f64 * 100.0 / pixel_stats.bytes as f64);
+
+    //  Log view: Redraw all lines vs scroll the display and draw only the new line
+    let log_lines = (HEIGHT as u16 - LOG_LINE) as u32 / LOG_LINE as u32;
+    let mut redrawn = Framebuffer::new();
+    let mut last = log_lines - 1;
+    let redraw_stats = run("log_redraw", &mut redrawn, |fb| { last += 1; log_full(fb, last) });
+    let mut scrolled = Framebuffer::new();
+    let mut scroller = Scroller::new(&mut scrolled, LOG_LINE).unwrap();
+    for i in 0 .. log_lines as u16 {
+        draw_log_line(&mut scrolled, i as u32, scroller.memory_row(LOG_LINE + i * LOG_LINE)).unwrap();
+    }
+    scrolled.end_frame();
+    let mut last = log_lines - 1;
+    let scroll_stats = run("log_scroll", &mut scrolled, |fb| {
+        last += 1;
+        scroller.scroll(fb, LOG_LINE as i32, |fb, memory_top, rows, row| {
+            assert_eq!((rows, row), (LOG_LINE, HEIGHT as u16 - LOG_LINE));
+            draw_log_line(fb, last, memory_top)
+        })
+    });
+    assert_eq!(scrolled.checksum(), redrawn.checksum(), "hardware scrolling differs from redrawing");
+    //  Scroll back down by more than the hidden rows, which takes several steps
+    scroller.scroll(&mut scrolled, -5 * LOG_LINE as i32, |fb, memory_top, rows, row| {
+        assert_eq!(rows % LOG_LINE, 0);
+        for i in 0 .. rows / LOG_LINE {
+            //  Line at the top of the log view is now 5 lines before the last redraw
+            let n = last + 1 - log_lines - 5 + ((row - LOG_LINE) / LOG_LINE + i) as u32;
+            draw_log_line(fb, n, memory_top + i * LOG_LINE) ? ;
+        }
+        Ok(())
+    }).unwrap();
+    log_full(&mut redrawn, last - 5).unwrap();
+    assert_eq!(scrolled.checksum(), redrawn.checksum(), "scrolling down differs from redrawing");
+    scrolled.write_ppm(format!("{}/log.ppm", out)).expect("write failed");
+    println!("log view with hardware scrolling: {:.0}% of the SPI bytes",
+        scroll_stats.bytes as f64 * 100.0 / redraw_stats.bytes as f64);
+
+    //  Images: Encode, then decode row by row into the display window
+    let face = watch_face_image();
+    let face_data = encoder::encode(WIDTH as u16, HEIGHT as u16, &face);
+    let face_image = Image::new(&face_data).unwrap();
+    let gradient = gradient_image(120, 100);
+    let gradient_data = encoder::encode(120, 100, &gradient);
+    let gradient_image = Image::new(&gradient_data).unwrap();
+    println!("image compression: watch face {} bytes ({:.1}% of RGB565), gradient {} bytes ({:.1}%)",
+        face_data.len(), face_data.len() as f64 * 50.0 / face.len() as f64,
+        gradient_data.len(), gradient_data.len() as f64 * 50.0 / gradient.len() as f64);
+    let mut images = Framebuffer::new();
+    run("image_face", &mut images, |fb| image::draw_image(fb, &face_image, 0, 0, &SCREEN).map(|_| ()));
+    check_image(&images, &face, WIDTH, 0, 0, &SCREEN);
+    images.write_ppm(format!("{}/image_face.ppm", out)).expect("write failed");
+
+    //  Encoder tool must give the same image from the PPM file
+    encoder::encode_file(&format!("{}/image_face.ppm", out), &format!("{}/image_face.pti", out)).expect("encode failed");
+    assert_eq!(fs::read(format!("{}/image_face.pti", out)).unwrap(), face_data, "encoder tool differs");
+
+    //  Partial redraw: Only the clipped rows and columns are decoded and sent
+    let clip = Rect::new(80, 90, 159, 129);
+    let stats = run("image_clipped", &mut images, |fb| image::draw_image(fb, &gradient_image, 50, 70, &clip).map(|_| ()));
+    assert_eq!(stats.pixels, clip.area());
+    check_image(&images, &gradient, 120, 50, 70, &clip);
+    check_image(&images, &face, WIDTH, 0, 0, &Rect::new(0, 0, 239, 89));
+    check_image(&images, &face, WIDTH, 0, 0, &Rect::new(0, 130, 239, 239));
+    check_image(&images, &face, WIDTH, 0, 0, &Rect::new(0, 90, 79, 129));
+    check_image(&images, &face, WIDTH, 0, 0, &Rect::new(160, 90, 239, 129));
+    images.write_ppm(format!("{}/image_clipped.ppm", out)).expect("write failed");
+
+    //  Truncated image must fail without reading past the data
+    let truncated = Image::new(&face_data[.. face_data.len() / 2]).unwrap();
+    assert_eq!(image::draw_image(&mut images, &truncated, 0, 0, &SCREEN), Err(MynewtError::SYS_EINVAL));
+    images.end_frame();
+
+    //  Decode throughput into the framebuffer
+    fill_rate("decode_palette", |fb| image::draw_image(fb, &face_image, 0, 0, &SCREEN).map(|_| ()));
+    fill_rate("decode_rgb565", |fb| image::draw_image(fb, &gradient_image, 0, 0, &SCREEN).map(|_| ()));
+    fill_rate("decode_clipped", |fb| image::draw_image(fb, &face_image, 0, 0, &clip).map(|_| ()));
+
+    //  Shared SPI bus: The display, the SPI flash with the same settings, and a sensor with different settings
+    let display_settings = SpiSettings { data_mode: 3, data_order: 0, word_size: 0, baudrate: 8000 };
+    let mut bus = SpiBus::new();
+    assert_eq!(bus.add_device(&display_settings, spi_sim::DISPLAY_CS), Ok(DISPLAY_DEVICE));
+    let flash = bus.add_device(&display_settings, spi_sim::FLASH_CS).unwrap();
+    let sensor = bus.add_device(&SpiSettings { data_mode: 0, baudrate: 2000, ..display_settings }, 7).unwrap();
+    let contents: Vec<u8> = (0 .. 4096).map(|i| (i * 7 % 251) as u8).collect();
+    let mut spi = SpiTask::new(bus, SimPort::new(contents.clone()));
+    assert_eq!(spi.bus.select(&mut spi.port, 4), Err(MynewtError::SYS_EINVAL));
+    assert!(TxnCommand::new(&[0; spi_bus::TXN_WRITE_MAX + 1]).is_err());
+
+    //  Flash read submitted while the second display request is sent: executed before the third request
+    let frame: [&[u8]; 6] = [ &[display::CASET, 0, 0, 0, 239], &[display::RASET, 0, 0, 0, 239], &[display::RAMWR],
+        &[0x12; 64], &[0x34; 64], &[0x56; 64] ];
+    for request in frame.iter() { spi.write_display(request); }
+    let mut command = [spi_sim::FLASH_READ, 0x00, 0x01, 0x00];  //  Read at address 0x100
+    spi.submit_after(2, flash, &command, 32).unwrap();
+    command.copy_from_slice(&[0; 4]);  //  Caller reuses the buffer: the transaction has its own copy
+    spi.run();
+    let flash_at = spi.port.transfers.iter().position(|t| *t == Transfer::FlashCommand(vec![spi_sim::FLASH_READ, 0x00, 0x01, 0x00]))
+        .expect("flash command not sent");
+    assert_eq!(flash_at, 2, "flash read not interleaved after the second display request");
+    assert_eq!(spi.port.transfers[flash_at + 1], Transfer::FlashRead(32));
+    assert_eq!(spi.port.transfers.iter().filter(|t| if let Transfer::Display(_) = t { true } else { false }).count(), frame.len());
+    assert_eq!(spi.port.transfers.last(), Some(&Transfer::Display(frame[5].to_vec())), "display requests out of order");
+    assert_eq!(spi.queues.idle, 1, "frame not reported once after the display yielded the bus");
+    assert_eq!(spi.queues.done[0].read[..], contents[0x100 .. 0x120], "flash read wrong data");
+    assert_eq!(spi.port.reconfigured, 0, "port reconfigured for the same settings");
+
+    //  Sensor transaction queued with the display requests: the port is reconfigured for the sensor and back for the display
+    spi.write_display(frame[3]);
+    spi.write_display(frame[4]);
+    spi.submit(sensor, &[0x8f], 1).unwrap();
+    spi.run();
+    assert_eq!(spi.port.reconfigured, 2);
+    assert_eq!(spi.port.transfers[spi.port.transfers.len() - 4 ..], [ Transfer::Display(frame[3].to_vec()),
+        Transfer::Other(7, vec![0x8f]), Transfer::Other(7, vec![0]), Transfer::Display(frame[4].to_vec()) ]);
+    assert_eq!(spi.queues.idle, 2);
+
+    //  Flash read submitted while the last display request is sent: the display yields the bus with an empty queue,
+    //  and the frame is reported when the display event runs again
+    let sent = spi.queues.sent;
+    spi.write_display(frame[5]);
+    spi.submit_after(sent + 1, flash, &[spi_sim::FLASH_READ, 0x00, 0x02, 0x00], 4).unwrap();
+    spi.run();
+    assert_eq!(spi.port.transfers.last(), Some(&Transfer::FlashRead(4)));
+    assert_eq!(spi.queues.idle, 3, "frame not reported after the display yielded the bus");
+    println!("spi bus: flash read after {} of {} display requests, port reconfigured {} times for a sensor transaction",
+        flash_at, frame.len(), spi.port.reconfigured);
+    println!("display host tests OK");
+}
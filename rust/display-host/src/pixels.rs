@@ -0,0 +1,80 @@
+//! Pixel by pixel rendering, like `embedded-graphics` iterators feeding the batching in `piet-embedded`:
+//! each shape is iterated as single pixels, and consecutive pixels of a row are batched into one window.
+use crate::{
+    result::*,
+    display::DisplayBus,
+    dirty::Rect,
+    font,
+};
+
+/// Batches consecutive pixels of a row into one window
+pub struct Batcher<'a, B: DisplayBus> {
+    bus: &'a mut B,
+    /// Row and first column of the pending pixels
+    y: u16,
+    left: u16,
+    /// Pending RGB565 pixels, most significant byte first
+    buf: Vec<u8>,
+}
+
+impl<'a, B: DisplayBus> Batcher<'a, B> {
+    pub fn new(bus: &'a mut B) -> Batcher<'a, B> {
+        Batcher { bus, y: 0, left: 0, buf: Vec::with_capacity(480) }
+    }
+
+    /// Draw a pixel. If it doesn't follow the pending pixels, the pending pixels are written first.
+    pub fn draw(&mut self, x: u16, y: u16, color: u16) -> MynewtResult<()> {
+        let len = (self.buf.len() / 2) as u16;
+        if len > 0 && (y != self.y || x != self.left + len) { self.finish() ? ; }
+        if self.buf.len() == 0 { self.y = y; self.left = x; }
+        self.buf.extend_from_slice(&color.to_be_bytes());
+        Ok(())
+    }
+
+    /// Write the pending pixels
+    pub fn finish(&mut self) -> MynewtResult<()> {
+        if self.buf.len() == 0 { return Ok(()); }
+        let right = self.left + (self.buf.len() / 2) as u16 - 1;
+        self.bus.write_window(self.left, self.y, right, self.y) ? ;
+        self.bus.write_pixels(&self.buf) ? ;
+        self.buf.clear();
+        Ok(())
+    }
+}
+
+/// Fill the part of the rectangle inside the clip area
+pub fn fill_rect<B: DisplayBus>(batcher: &mut Batcher<B>, rect: &Rect, clip: &Rect, color: u16) -> MynewtResult<()> {
+    for y in rect.top ..= rect.bottom {
+        for x in rect.left ..= rect.right {
+            if x < clip.left || x > clip.right || y < clip.top || y > clip.bottom { continue; }
+            batcher.draw(x, y, color) ? ;
+        }
+    }
+    Ok(())
+}
+
+/// Fill the part of the circle inside the clip area. The bounding box is scanned, like `embedded-graphics` does.
+pub fn fill_circle<B: DisplayBus>(batcher: &mut Batcher<B>, cx: i32, cy: i32, r: i32, clip: &Rect, color: u16) -> MynewtResult<()> {
+    for y in cy - r ..= cy + r {
+        for x in cx - r ..= cx + r {
+            if (x - cx) * (x - cx) + (y - cy) * (y - cy) > r * r { continue; }
+            if x < clip.left as i32 || x > clip.right as i32 || y < clip.top as i32 || y > clip.bottom as i32 { continue; }
+            batcher.draw(x as u16, y as u16, color) ? ;
+        }
+    }
+    Ok(())
+}
+
+/// Draw text one character at a time, pixel by pixel, like `Font12x16::render_str()` in `embedded-graphics`
+pub fn draw_text<B: DisplayBus>(batcher: &mut Batcher<B>, text: &str, left: u16, top: u16, fg: u16, bg: u16) -> MynewtResult<()> {
+    for (i, ch) in text.bytes().enumerate() {
+        let x0 = left + (i * font::GLYPH_WIDTH) as u16;
+        for y in 0 .. font::GLYPH_HEIGHT {
+            for x in 0 .. font::GLYPH_WIDTH {
+                let color = if font::pixel(ch, x, y) { fg } else { bg };
+                batcher.draw(x0 + x as u16, top + y as u16, color) ? ;
+            }
+        }
+    }
+    Ok(())
+}
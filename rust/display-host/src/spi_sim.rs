@@ -0,0 +1,218 @@
+//! Host simulation of the shared SPI bus of `spi_bus.rs`. `SimPort` stands in for the PineTime SPI port, with the
+//! display and a SPI flash on the same bus, and `SpiTask` runs the display requests and the transactions of other
+//! devices with `SpiBus::send_display()` and `SpiBus::run_txns()`, the same code as the SPI Task in `spi.rs`:
+//! display requests from one event, transactions from another. Only the queues are simulated, by `SimQueues`.
+use std::collections::VecDeque;
+use crate::{
+    result::*,
+    spi_bus::{ SpiBus, SpiDevice, SpiPort, SpiQueues, SpiSettings, TxnCommand, DISPLAY_DEVICE },
+};
+
+/// Chip Select pins of the display and the SPI flash on PineTime
+pub const DISPLAY_CS: i32 = 25;
+pub const FLASH_CS: i32   = 5;
+
+/// SPI flash command: Read Data, followed by a 3-byte address
+pub const FLASH_READ: u8 = 0x03;
+
+/// Transfer seen by the simulated port
+#[derive(Clone, Debug, PartialEq)]
+pub enum Transfer {
+    /// Bytes written to the display
+    Display(Vec<u8>),
+    /// Command bytes written to the flash
+    FlashCommand(Vec<u8>),
+    /// Number of bytes read from the flash
+    FlashRead(usize),
+    /// Bytes written to another device
+    Other(i32, Vec<u8>),
+}
+
+/// SPI port with the display and a SPI flash. Checks that only one device is selected during each transfer.
+pub struct SimPort {
+    /// Contents of the SPI flash
+    pub flash: Vec<u8>,
+    /// Transfers in order
+    pub transfers: Vec<Transfer>,
+    /// Number of times the port was reconfigured
+    pub reconfigured: u32,
+    /// Chip Select pins that are low
+    selected: Vec<i32>,
+    /// Command bytes received by the flash since it was selected
+    flash_command: Vec<u8>,
+    /// Bytes read by the flash command so far
+    flash_offset: usize,
+}
+
+impl SimPort {
+    pub fn new(flash: Vec<u8>) -> SimPort {
+        SimPort { flash, transfers: Vec::new(), reconfigured: 0, selected: Vec::new(), flash_command: Vec::new(), flash_offset: 0 }
+    }
+}
+
+impl SpiPort for SimPort {
+    fn configure(&mut self, _settings: &SpiSettings) -> MynewtResult<()> {
+        assert!(self.selected.is_empty(), "port reconfigured while a device is selected");
+        self.reconfigured += 1;
+        Ok(())
+    }
+
+    fn set_cs(&mut self, cs_pin: i32, high: bool) {
+        if high {
+            assert!(self.selected.contains(&cs_pin), "pin {} deselected twice", cs_pin);
+            self.selected.retain(|&pin| pin != cs_pin);
+            if cs_pin == FLASH_CS { self.flash_command.clear(); self.flash_offset = 0; }  //  End of the flash command
+        } else {
+            assert!(!self.selected.contains(&cs_pin), "pin {} selected twice", cs_pin);
+            self.selected.push(cs_pin);
+        }
+    }
+
+    fn txrx(&mut self, tx: *const u8, rx: *mut u8, len: usize) -> MynewtResult<()> {
+        assert_eq!(self.selected.len(), 1, "transfer with {} devices selected", self.selected.len());
+        let cs_pin = self.selected[0];
+        let bytes = unsafe { std::slice::from_raw_parts(tx, len) }.to_vec();
+        if cs_pin == DISPLAY_CS {
+            assert!(rx.is_null(), "display is write only");
+            self.transfers.push(Transfer::Display(bytes));
+        } else if cs_pin == FLASH_CS && rx.is_null() {
+            self.flash_command.extend_from_slice(&bytes);
+            self.transfers.push(Transfer::FlashCommand(bytes));
+        } else if cs_pin == FLASH_CS {
+            //  Respond to the Read Data command with the flash contents from the address
+            assert_eq!(self.flash_command.len(), 4, "flash read without address");
+            assert_eq!(self.flash_command[0], FLASH_READ, "unknown flash command");
+            let address = (self.flash_command[1] as usize) << 16 | (self.flash_command[2] as usize) << 8 | self.flash_command[3] as usize;
+            let start = address + self.flash_offset;
+            let rx = unsafe { std::slice::from_raw_parts_mut(rx, len) };
+            rx.copy_from_slice(&self.flash[start .. start + len]);
+            self.flash_offset += len;
+            self.transfers.push(Transfer::FlashRead(len));
+        } else {
+            self.transfers.push(Transfer::Other(cs_pin, bytes));
+        }
+        Ok(())
+    }
+}
+
+/// Events of the SPI Event Queue
+#[derive(Clone, Copy, Debug, PartialEq)]
+enum Event { Display, Txn }
+
+/// Transaction queued for a device other than the display
+pub struct Txn {
+    pub device:  SpiDevice,
+    pub command: TxnCommand,
+    pub read:    Vec<u8>,
+}
+
+/// Queues of the SPI Task, like the SPI Mbuf Queue and the transaction queue of `spi.rs`
+pub struct SimQueues {
+    /// Display requests waiting to be sent
+    requests: VecDeque<Vec<u8>>,
+    /// Transactions waiting to be executed
+    txns: VecDeque<Txn>,
+    /// Completed transactions
+    pub done: Vec<Txn>,
+    /// Number of display requests sent
+    pub sent: usize,
+    /// Number of times the display queue became empty after requests were sent, like `frame_probe::spi_idle()`
+    pub idle: usize,
+    /// Transactions submitted by another task after the number of display requests has been sent
+    scheduled: Vec<(usize, Txn)>,
+    /// SPI Event Queue
+    events: VecDeque<Event>,
+}
+
+impl SimQueues {
+    /// Add the event to the SPI Event Queue, unless already queued like `os_eventq_put()`
+    fn post(&mut self, event: Event) {
+        if !self.events.contains(&event) { self.events.push_back(event); }
+    }
+}
+
+impl SpiQueues<SimPort> for SimQueues {
+    type Request = Vec<u8>;
+    type Txn = Txn;
+
+    fn next_request(&mut self) -> Option<Vec<u8>> { self.requests.pop_front() }
+
+    fn send_request(&mut self, bus: &mut SpiBus, port: &mut SimPort, request: Vec<u8>) -> MynewtResult<()> {
+        bus.select(port, DISPLAY_DEVICE) ? ;
+        port.txrx(request.as_ptr(), std::ptr::null_mut(), request.len()) ? ;
+        self.sent += 1;
+        //  Other tasks submit their transactions while the request is sent
+        let sent = self.sent;
+        while let Some(i) = self.scheduled.iter().position(|(after, _)| *after == sent) {
+            let (_, txn) = self.scheduled.remove(i);
+            self.txns.push_back(txn);
+            self.post(Event::Txn);
+        }
+        Ok(())
+    }
+
+    fn post_display(&mut self) { self.post(Event::Display); }
+
+    fn display_idle(&mut self) { self.idle += 1; }
+
+    fn txn_waiting(&self) -> bool { !self.txns.is_empty() }
+
+    fn next_txn(&mut self) -> Option<Txn> { self.txns.pop_front() }
+
+    fn txn_args(txn: &mut Txn) -> (SpiDevice, &TxnCommand, &mut [u8]) { (txn.device, &txn.command, &mut txn.read) }
+
+    fn complete_txn(&mut self, txn: Txn, result: MynewtResult<()>) {
+        result.expect("transfer failed");
+        self.done.push(txn);
+    }
+}
+
+/// SPI Task with its bus, port and queues, like `spi.rs`
+pub struct SpiTask {
+    pub bus: SpiBus,
+    pub port: SimPort,
+    pub queues: SimQueues,
+}
+
+impl SpiTask {
+    pub fn new(bus: SpiBus, port: SimPort) -> SpiTask {
+        let queues = SimQueues { requests: VecDeque::new(), txns: VecDeque::new(), done: Vec::new(), sent: 0, idle: 0,
+            scheduled: Vec::new(), events: VecDeque::new() };
+        SpiTask { bus, port, queues }
+    }
+
+    /// Queue a display request, like `spi_enqueue()`
+    pub fn write_display(&mut self, data: &[u8]) {
+        self.queues.requests.push_back(data.to_vec());
+        self.queues.post(Event::Display);
+    }
+
+    /// Queue a transaction, like `spi_submit()`: the command bytes are copied
+    pub fn submit(&mut self, device: SpiDevice, write: &[u8], read_len: usize) -> MynewtResult<()> {
+        self.submit_after(self.queues.sent, device, write, read_len)
+    }
+
+    /// Queue a transaction from another task while the display request number `sent` (from 1) is sent.
+    /// The command bytes are copied now, like `spi_submit()`.
+    pub fn submit_after(&mut self, sent: usize, device: SpiDevice, write: &[u8], read_len: usize) -> MynewtResult<()> {
+        let txn = Txn { device, command: TxnCommand::new(write) ? , read: vec![0; read_len] };
+        if sent <= self.queues.sent {
+            self.queues.txns.push_back(txn);
+            self.queues.post(Event::Txn);
+        } else {
+            self.queues.scheduled.push((sent, txn));
+        }
+        Ok(())
+    }
+
+    /// Run the events until the queues are empty, with the same callbacks as `spi.rs`
+    pub fn run(&mut self) {
+        while let Some(event) = self.queues.events.pop_front() {
+            match event {
+                Event::Display => self.bus.send_display(&mut self.port, &mut self.queues).expect("display failed"),
+                Event::Txn     => self.bus.run_txns(&mut self.port, &mut self.queues),
+            }
+        }
+        assert!(self.queues.scheduled.is_empty(), "transactions scheduled after the last display request");
+    }
+}
@@ -0,0 +1,76 @@
+//! Host mode for the frame time probes of `frame_time.rs`. Times each stage of a frame rendered into the framebuffer,
+//! with the same probes as PineTime. Writes to the framebuffer stand in for enqueueing the SPI requests, and the SPI
+//! transfer is modelled from the bytes written at the PineTime SPI clock, starting when the frame is painted.
+use std::time::Instant;
+use crate::{
+    result::*,
+    display::DisplayBus,
+    framebuffer::Framebuffer,
+    frame_time::{ FrameSummary, FrameTimer, Stage, METRICS, METRIC_NAMES },
+};
+
+/// Clock for the probes, in microseconds since the start
+pub struct Clock(Instant);
+
+impl Clock {
+    pub fn new() -> Clock { Clock(Instant::now()) }
+
+    /// Microseconds since the start, wrapping around like the PineTime clock
+    pub fn now(&self) -> u32 { self.0.elapsed().as_micros() as u32 }
+}
+
+/// Framebuffer that reports the time spent in each write as enqueue time
+pub struct TimedBus<'a> {
+    pub fb: &'a mut Framebuffer,
+    pub timer: &'a mut FrameTimer,
+    pub clock: &'a Clock,
+}
+
+impl<'a> TimedBus<'a> {
+    /// Time the write and report it to the frame timer
+    fn timed<F>(&mut self, write: F) -> MynewtResult<()>
+    where F: FnOnce(&mut Framebuffer) -> MynewtResult<()> {
+        let start = self.clock.now();
+        let result = write(self.fb);
+        self.timer.enqueue(self.clock.now().wrapping_sub(start));
+        result
+    }
+}
+
+impl<'a> DisplayBus for TimedBus<'a> {
+    fn write_command(&mut self, cmd: u8) -> MynewtResult<()> { self.timed(|fb| fb.write_command(cmd)) }
+    fn write_data(&mut self, data: &[u8]) -> MynewtResult<()> { self.timed(|fb| fb.write_data(data)) }
+    fn write_pixels(&mut self, data: &[u8]) -> MynewtResult<()> { self.timed(|fb| fb.write_pixels(data)) }
+}
+
+/// Render `frames` frames, each started by a touch. `update` is called to update the widgets and returns
+/// the state for `paint`. Returns the percentiles of the stages.
+pub fn time_frames<S, U, P>(fb: &mut Framebuffer, frames: u32, mut update: U, mut paint: P) -> FrameSummary
+where U: FnMut(u32) -> S, P: FnMut(&mut TimedBus, &S) -> MynewtResult<()> {
+    let clock = Clock::new();
+    let mut timer = FrameTimer::new();
+    for i in 0 .. frames {
+        timer.mark(Stage::Touch, clock.now());
+        timer.mark(Stage::Dispatch, clock.now());
+        let state = update(i);
+        timer.mark(Stage::Update, clock.now());
+        paint(&mut TimedBus { fb, timer: &mut timer, clock: &clock }, &state).expect("paint failed");
+        let painted = clock.now();
+        timer.mark(Stage::Paint, painted);
+        //  SPI transfers complete after the modelled transfer time of the frame
+        let spi_us = (fb.end_frame().spi_ms() * 1000.0) as u32;
+        timer.spi_idle(painted.wrapping_add(spi_us));
+        //  Stages must add up to the touch-to-photon latency
+        let times = timer.last().expect("frame not completed");
+        assert_eq!(times[.. METRICS - 1].iter().sum::<u32>(), times[METRICS - 1], "frame stages don't add up");
+    }
+    timer.summary()
+}
+
+/// Print the median, 90th percentile and max of each stage
+pub fn print_summary(name: &str, summary: &FrameSummary) {
+    println!("{}: {} frames, {} dropped (us: p50 / p90 / max)", name, summary.frames, summary.dropped);
+    for (metric, [ median, p90, max ]) in METRIC_NAMES.iter().zip(summary.percentiles.iter()) {
+        println!("  {:<10} {:>8} {:>8} {:>8}", metric, median, p90, max);
+    }
+}
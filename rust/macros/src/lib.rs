@@ -159,8 +159,8 @@ pub fn init_strn(item: TokenStream) -> TokenStream {
 ///     let encoder = COAP_CONTEXT.encoder("COAP_CONTEXT", "_map");
 ///     cbor_encode_text_string(
 ///         encoder,
-///         COAP_CONTEXT.key_to_cstr(key_with_opt_null),
-///         COAP_CONTEXT.cstr_len(key_with_opt_null));
+///         COAP_CONTEXT.str_ptr(key_with_opt_null),
+///         COAP_CONTEXT.str_len(key_with_opt_null));
 ///     cbor_encode_int(encoder, value);
 /// })
 /// ```
@@ -170,8 +170,8 @@ pub fn init_strn(item: TokenStream) -> TokenStream {
 ///     let encoder = COAP_CONTEXT.encoder("COAP_CONTEXT", "_map");
 ///     let res =
 ///         tinycbor::cbor_encode_text_string(encoder,
-///           COAP_CONTEXT.key_to_cstr(key_with_opt_null),
-///           COAP_CONTEXT.cstr_len(key_with_opt_null));
+///           COAP_CONTEXT.str_ptr(key_with_opt_null),
+///           COAP_CONTEXT.str_len(key_with_opt_null));
 ///     COAP_CONTEXT.check_result(res);
 ///     let res = tinycbor::cbor_encode_int(encoder, value);
 ///     COAP_CONTEXT.check_result(res);
@@ -0,0 +1,182 @@
+//! Dirty Rectangle Tracking for partial display refresh. Widgets invalidate the areas they need to repaint,
+//! overlapping and touching areas are merged, and `flush()` sends each merged area to the display with
+//! a single CASET / RASET window. Pixels outside the dirty areas are not sent over SPI.
+use crate::{
+    result::*,
+    display::DisplayBus,
+};
+
+/// Width and height of the PineTime display in pixels
+pub const DISPLAY_SIZE: u16 = 240;
+
+/// Max number of separate dirty areas. When exceeded, the two areas that waste the fewest pixels when merged are merged.
+const MAX_DIRTY: usize = 8;
+
+/// Rectangle in display coordinates. `right` and `bottom` are inclusive, like the CASET / RASET window.
+#[derive(Clone, Copy, Debug, Default, PartialEq)]
+pub struct Rect {
+    pub left:   u16,
+    pub top:    u16,
+    pub right:  u16,
+    pub bottom: u16,
+}
+
+impl Rect {
+    /// Create a rectangle with inclusive coordinates
+    pub const fn new(left: u16, top: u16, right: u16, bottom: u16) -> Rect {
+        Rect { left, top, right, bottom }
+    }
+
+    /// Number of pixels in the rectangle
+    pub fn area(&self) -> u32 {
+        (self.right - self.left + 1) as u32 * (self.bottom - self.top + 1) as u32
+    }
+
+    /// Smallest rectangle that contains both rectangles
+    pub fn union(&self, other: &Rect) -> Rect {
+        Rect {
+            left:   self.left.min(other.left),
+            top:    self.top.min(other.top),
+            right:  self.right.max(other.right),
+            bottom: self.bottom.max(other.bottom),
+        }
+    }
+
+    /// Return true if the rectangles overlap or share an edge, so that merging them adds no gap
+    pub fn touches(&self, other: &Rect) -> bool {
+        self.left <= other.right + 1 && other.left <= self.right + 1 &&
+        self.top <= other.bottom + 1 && other.top <= self.bottom + 1
+    }
+
+    /// Return true if the rectangles have at least one pixel in common
+    pub fn intersects(&self, other: &Rect) -> bool {
+        self.left <= other.right && other.left <= self.right &&
+        self.top <= other.bottom && other.top <= self.bottom
+    }
+}
+
+/// Set of dirty areas waiting to be repainted
+pub struct DirtyRegion {
+    /// Dirty areas. No two areas touch each other.
+    rects: [Rect; MAX_DIRTY],
+    /// Number of dirty areas
+    count: usize,
+}
+
+impl DirtyRegion {
+    /// Create an empty region
+    pub const fn new() -> DirtyRegion {
+        DirtyRegion {
+            rects: [Rect { left: 0, top: 0, right: 0, bottom: 0 }; MAX_DIRTY],
+            count: 0,
+        }
+    }
+
+    /// Mark the area as dirty. The area is clipped to the display.
+    pub fn invalidate(&mut self, rect: Rect) {
+        if rect.left > rect.right || rect.top > rect.bottom || rect.left >= DISPLAY_SIZE || rect.top >= DISPLAY_SIZE { return; }
+        let mut rect = Rect {
+            right:  rect.right.min(DISPLAY_SIZE - 1),
+            bottom: rect.bottom.min(DISPLAY_SIZE - 1),
+            ..rect
+        };
+        //  Absorb every area that touches the new area. The merged area may touch more areas, so repeat until none are left.
+        let mut i = 0;
+        while i < self.count {
+            if self.rects[i].touches(&rect) {
+                rect = rect.union(&self.rects[i]);
+                self.remove(i);
+                i = 0;
+            } else {
+                i += 1;
+            }
+        }
+        if self.count == MAX_DIRTY {
+            //  No room. Merge the new area with the area that wastes the fewest pixels, then absorb again.
+            let mut best = 0;
+            let mut best_waste = u32::max_value();
+            for i in 0 .. self.count {
+                let waste = rect.union(&self.rects[i]).area() - rect.area() - self.rects[i].area();
+                if waste < best_waste { best_waste = waste; best = i; }
+            }
+            let merged = rect.union(&self.rects[best]);
+            self.remove(best);
+            self.invalidate(merged);
+            return;
+        }
+        self.rects[self.count] = rect;
+        self.count += 1;
+    }
+
+    /// Mark the entire display as dirty
+    pub fn invalidate_all(&mut self) {
+        self.count = 0;
+        self.invalidate(Rect::new(0, 0, DISPLAY_SIZE - 1, DISPLAY_SIZE - 1));
+    }
+
+    /// Return the dirty areas
+    pub fn rects(&self) -> &[Rect] {
+        &self.rects[.. self.count]
+    }
+
+    /// Return true if the area needs to be repainted. Widgets outside the dirty areas may skip painting.
+    pub fn needs_paint(&self, rect: &Rect) -> bool {
+        self.rects().iter().any(|r| r.intersects(rect))
+    }
+
+    /// Number of pixels that will be sent for the dirty areas
+    pub fn area(&self) -> u32 {
+        self.rects().iter().map(|r| r.area()).sum()
+    }
+
+    /// Forget all dirty areas
+    pub fn clear(&mut self) {
+        self.count = 0;
+    }
+
+    /// Remove the area at the index. Order of the areas is not kept.
+    fn remove(&mut self, index: usize) {
+        self.count -= 1;
+        self.rects[index] = self.rects[self.count];
+    }
+}
+
+/// Dirty areas of the display, updated by the UI
+static mut DIRTY: DirtyRegion = DirtyRegion::new();
+
+/// Call `f` with the dirty areas. The UI runs in a single task, so there is no other reference to `DIRTY`.
+fn with_dirty<R, F: FnOnce(&mut DirtyRegion) -> R>(f: F) -> R {
+    f(unsafe { &mut *core::ptr::addr_of_mut!(DIRTY) })
+}
+
+/// Mark the area of a widget as dirty. Called when the widget's data has changed.
+pub fn invalidate(rect: Rect) {
+    with_dirty(|dirty| dirty.invalidate(rect));
+}
+
+/// Mark the entire display as dirty, e.g. when a new window is shown
+pub fn invalidate_all() {
+    with_dirty(|dirty| dirty.invalidate_all());
+}
+
+/// Return true if the area overlaps a dirty area and needs to be repainted
+pub fn needs_paint(rect: &Rect) -> bool {
+    with_dirty(|dirty| dirty.needs_paint(rect))
+}
+
+/// Repaint the dirty areas, e.g. `dirty::flush(&mut spi::SpiBus, paint)`. For each area, set the display window
+/// with CASET / RASET and call `paint`, which must write exactly the pixels of the area with `bus.write_pixels()`.
+/// Returns the number of pixels repainted.
+pub fn flush<B, F>(bus: &mut B, mut paint: F) -> MynewtResult<u32>
+where B: DisplayBus, F: FnMut(&mut B, &Rect) -> MynewtResult<()> {
+    let mut pixels = 0;
+    //  Take the areas first, so that painting may invalidate the next frame
+    let region = with_dirty(|dirty| core::mem::replace(dirty, DirtyRegion::new()));
+    for rect in region.rects() {
+        bus.write_window(rect.left, rect.top, rect.right, rect.bottom) ? ;
+        paint(bus, rect) ? ;
+        pixels += rect.area();
+    }
+    bus.flush() ? ;
+    Ok(pixels)
+}
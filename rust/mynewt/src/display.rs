@@ -0,0 +1,66 @@
+//! ST7789 Display Command Interface. Rendering code writes Command Bytes and Data Bytes through the `DisplayBus` trait,
+//! which is implemented by `spi::SpiBus` on PineTime and by a framebuffer on the host (see `rust/display-host`),
+//! so that the same rendering code may be benchmarked and regression-tested off-device.
+use crate::result::*;
+
+/// Software reset
+pub const SWRESET: u8 = 0x01;
+/// Sleep out
+pub const SLPOUT: u8  = 0x11;
+/// Display on
+pub const DISPON: u8  = 0x29;
+/// Set the column address window
+pub const CASET: u8   = 0x2A;
+/// Set the row address window
+pub const RASET: u8   = 0x2B;
+/// Write pixels into the window, starting at the top left
+pub const RAMWR: u8   = 0x2C;
+/// Define the top fixed, vertical scroll and bottom fixed areas
+pub const VSCRDEF: u8 = 0x33;
+/// Set the frame memory row shown at the top of the vertical scroll area
+pub const VSCSAD: u8  = 0x37;
+/// Write pixels into the window, continuing after the last pixel written
+pub const RAMWRC: u8  = 0x3C;
+
+/// Number of rows in the ST7789 frame memory. The PineTime display shows 240 of them, the rest are used for scrolling.
+pub const MEMORY_ROWS: u16 = 320;
+
+/// Command and data interface to the ST7789 display controller. Pixels are RGB565, most significant byte first.
+pub trait DisplayBus {
+    /// Write a Command Byte
+    fn write_command(&mut self, cmd: u8) -> MynewtResult<()>;
+
+    /// Write Data Bytes for the last Command Byte
+    fn write_data(&mut self, data: &[u8]) -> MynewtResult<()>;
+
+    /// Set the window from (left, top) to (right, bottom) inclusive and start writing pixels at the top left
+    fn write_window(&mut self, left: u16, top: u16, right: u16, bottom: u16) -> MynewtResult<()> {
+        self.write_command(CASET) ? ;
+        self.write_data(&[ (left >> 8) as u8, left as u8, (right >> 8) as u8, right as u8 ]) ? ;
+        self.write_command(RASET) ? ;
+        self.write_data(&[ (top >> 8) as u8, top as u8, (bottom >> 8) as u8, bottom as u8 ]) ? ;
+        self.write_command(RAMWR)
+    }
+
+    /// Write pixels into the window set by `write_window()`, row by row
+    fn write_pixels(&mut self, data: &[u8]) -> MynewtResult<()> {
+        self.write_data(data)
+    }
+
+    /// Write `count` pixels of the same colour into the window set by `write_window()`. `pattern` holds an even
+    /// number of bytes of pixels of the colour, and is written in blocks. A bus with DMA may repeat the colour itself.
+    fn write_repeated(&mut self, pattern: &[u8], count: u32) -> MynewtResult<()> {
+        let mut left = count as usize * 2;
+        while left > 0 {
+            let len = left.min(pattern.len());
+            self.write_pixels(&pattern[.. len]) ? ;
+            left -= len;
+        }
+        Ok(())
+    }
+
+    /// Send any pending requests to the display
+    fn flush(&mut self) -> MynewtResult<()> {
+        Ok(())
+    }
+}
@@ -12,6 +12,7 @@ pub mod json;             //  Export `json.rs` as Rust module `mynewt::encoding:
 pub mod tinycbor;         //  Export `tinycbor.rs` as Rust module `mynewt::encoding::tinycbor`
 
 pub mod coap_context;     //  Export `coap_context.rs` as Rust module `mynewt::encoding::coap_context`
+pub mod template;         //  Export `template.rs` as Rust module `mynewt::encoding::template`
 
 /// CBOR encoders defined in repos/apache-mynewt-core/net/oic/src/api/oc_rep.c
 #[link(name = "net_oic")]
@@ -5,11 +5,12 @@ use cty::*;               //  Import C types from cty library: https://crates.io
 use crate::{
     sys::console,
     encoding::{
-        //json,                   //  Mynewt JSON encoding library
+        json,                   //  Mynewt JSON encoding library
         tinycbor::CborEncoder,  //  Mynewt CBOR encoding library
+        template::PayloadWriter,
     },
     libs::mynewt_rust,          //  JSON encoding helper library
-    //libs::sensor_coap,
+    libs::sensor_coap,
     hw::sensor::SensorValueType,
     fill_zero, Strn, StrnRep,
 };
@@ -17,19 +18,10 @@ use crate::{
 /// Global instance that contains the current state of the CoAP encoder. Only 1 encoding task is supported at a time.
 pub static mut COAP_CONTEXT: CoapContext = fill_zero!(CoapContext);
 
-/// CoAP encoder state. Buffers the next key and value to be encoded.
+/// CoAP encoder state. Keys and values are passed to the Mynewt COAP encoder API as pointer and length,
+/// without copying and without null termination.
 #[derive(Default)]
-pub struct CoapContext {
-    /// Static buffer for the key to be encoded. Will be passed to Mynewt COAP encoder API.  Always null-terminated.
-    key_buffer: [u8; COAP_KEY_SIZE],
-    /// Static buffer for the string value to be encoded. Will be passed to Mynewt COAP encoder API.  Always null-terminated.
-    value_buffer: [u8; COAP_VALUE_SIZE],
-}
-
-/// Size of the static key buffer
-const COAP_KEY_SIZE: usize = 32;
-/// Size of the static value buffer
-const COAP_VALUE_SIZE: usize = 32;
+pub struct CoapContext {}
 
 /// Global CBOR root map for encoding CBOR documents
 static mut cbor_encoder0: CborEncoder = fill_zero!(CborEncoder);
@@ -39,26 +31,26 @@ impl CoapContext {
 
     ///  Encode a geolocation into the current JSON document with the specified keys:
     ///  ` key: { lat_key : 41.4121132, long_key : 2.2199454 } `
-    #[cfg(feature = "use_float")]  //  If floating-point is enabled...
+    ///  The fixed-point coordinates are encoded without floating-point.
     pub fn json_set_geolocation(&mut self, key: &Strn, lat_key: &Strn, long_key: &Strn, geo: SensorValueType) {
         if let SensorValueType::Geolocation { latitude, longitude, .. } = geo {
             let notused = self.to_void_ptr();
             let encoder = unsafe { &mut sensor_coap::coap_json_encoder };
 
             //  Encode the parent key.
-            let key_cstr = self.key_strn_to_cstr(key);
-            let rc = unsafe { json::json_encode_object_key(encoder, key_cstr as *mut u8) }; 
+            let key = key.to_bytes();
+            let rc = unsafe { sensor_coap::json_encode_object_key_n(encoder, self.str_ptr(key), self.str_len(key) as c_int) };
             assert!(rc == 0);
 
             //  Start the object.
             let rc = unsafe { json::json_encode_object_start(encoder) }; 
             assert!(rc == 0);
 
-            //  Encode the latitude and longitude.
-            let key_cstr = self.key_strn_to_cstr(lat_key);
-            unsafe { mynewt_rust::json_helper_set_float(notused, key_cstr, latitude as f32) };
-            let key_cstr = self.key_strn_to_cstr(long_key);
-            unsafe { mynewt_rust::json_helper_set_float(notused, key_cstr, longitude as f32) };
+            //  Encode the latitude and longitude, in 1e-7 degrees.
+            let lat_key = lat_key.to_bytes();
+            unsafe { mynewt_rust::json_helper_set_fixed7(notused, self.str_ptr(lat_key), self.str_len(lat_key) as c_int, latitude) };
+            let long_key = long_key.to_bytes();
+            unsafe { mynewt_rust::json_helper_set_fixed7(notused, self.str_ptr(long_key), self.str_len(long_key) as c_int, longitude) };
 
             //  Close the object.
             let rc = unsafe { json::json_encode_object_finish(encoder) }; 
@@ -66,75 +58,47 @@ impl CoapContext {
         };
     }
 
-    #[cfg(not(feature = "use_float"))]  //  If floating-point is disabled, do nothing
-    pub fn json_set_geolocation(&mut self, _key: &Strn, _lat_key: &Strn, _long_key: &Strn, _geo: SensorValueType) {}
+    ///  Encode an array of integers into the current JSON document with the specified key: ` key: [1, 2, 3] `
+    pub fn json_set_int_array(&mut self, key: &Strn, values: &[i32]) {
+        let notused = self.to_void_ptr();
+        let key = key.to_bytes();
+        unsafe {
+            mynewt_rust::json_helper_set_int_array(
+                notused,
+                self.str_ptr(key),
+                self.str_len(key) as c_int,
+                values.as_ptr(),
+                values.len() as u32
+            )
+        };
+    }
 
     ///  Encode a text value into the current JSON document with the specified key
     pub fn json_set_text_string(&mut self, key: &Strn, value: &Strn) {
         let notused = self.to_void_ptr();
-        //  Convert the key to C string.
-        let key_cstr: *const u8 = self.key_strn_to_cstr(key);
-        //  Convert the value to a C string.
-        let value_cstr: *const u8 = self.value_strn_to_cstr(value);
+        let key = key.to_bytes();
+        let value = value.to_bytes();
         //  Encode the value.
         unsafe {
             mynewt_rust::json_helper_set_text_string(
                 notused,
-                key_cstr as *const c_char,
-                value_cstr as *const c_char
+                self.str_ptr(key),
+                self.str_len(key) as c_int,
+                self.str_ptr(value),
+                self.str_len(value) as c_int
             )
         };
     }
 
-    /// Given a Strn key `key`, return a `*char` pointer that is null-terminated. Used for encoding COAP keys.
-    /// If `key` is null-terminated, return it as a pointer. Else copy `key` to the static key buffer,
-    /// append null and return the static key buffer as a pointer.
-    fn key_strn_to_cstr(&mut self, key: &Strn) -> *const u8 {
-        match key.rep {
-            StrnRep::ByteStr(bs) => { self.key_to_cstr(bs) }
-            StrnRep::CStr(cstr)  => { cstr }
-        }
-    }
-
-    /// Given a Strn value `value`, return a `*char` pointer that is null-terminated. Used for encoding COAP values.
-    /// If `value` is null-terminated, return it as a pointer. Else copy `value` to the static value buffer,
-    /// append null and return the static value buffer as a pointer.
-    fn value_strn_to_cstr(&mut self, value: &Strn) -> *const u8 {
-        match value.rep {
-            StrnRep::ByteStr(bs) => { self.value_to_cstr(bs) }
-            StrnRep::CStr(cstr)  => { cstr }
-        }
-    }
-
-    /// Given a key `s`, return a `*char` pointer that is null-terminated. Used for encoding COAP keys.
-    /// If `s` is null-terminated, return it as a pointer. Else copy `s` to the static key buffer,
-    /// append null and return the static key buffer as a pointer.
-    pub fn key_to_cstr(&mut self, s: &[u8]) -> *const u8 {                
-        //  If null-terminated, return as pointer.
-        if s.last() == Some(&0) { return s.as_ptr() as *const u8; }
-        //  Else copy into static key buffer and return pointer to buffer.
-        assert!(s.len() < COAP_KEY_SIZE, "big key");  //  Key too long
-        self.key_buffer[..s.len()].copy_from_slice(s);
-        self.key_buffer[s.len()] = 0;
-        self.key_buffer.as_ptr() as *const u8
-    }
-
-    /// Given a value `s`, return a `*char` pointer that is null-terminated. Used for encoding COAP values.
-    /// If `s` is null-terminated, return it as a pointer. Else copy `s` to the static value buffer,
-    /// append null and return the static value buffer as a pointer.
-    pub fn value_to_cstr(&mut self, s: &[u8]) -> *const u8 {
-        //  If null-terminated, return as pointer.
-        if s.last() == Some(&0) { return s.as_ptr() as *const u8; }
-        //  Else copy into static value buffer and return pointer to buffer.
-        assert!(s.len() < COAP_VALUE_SIZE, "big value");  //  Value too long
-        self.value_buffer[..s.len()].copy_from_slice(s);
-        self.value_buffer[s.len()] = 0;
-        self.value_buffer.as_ptr() as *const u8
+    /// Given a key or value `s` that may or may not be null-terminated, return a `*char` pointer to pass to
+    /// the Mynewt COAP encoder API with the length from `str_len()`. The string is not copied.
+    pub fn str_ptr(&self, s: &[u8]) -> *const c_char {
+        s.as_ptr() as *const c_char
     }
 
     /// Compute the byte length of the string in `s`.
     /// If `s` is null-terminated, return length of `s` - 1. Else return length of `s`.
-    pub fn cstr_len(&self, s: &[u8]) -> usize {
+    pub fn str_len(&self, s: &[u8]) -> usize {
         //  If null-terminated, return length - 1.
         if s.last() == Some(&0) { return s.len() - 1; }
         s.len()
@@ -187,6 +151,14 @@ impl CoapContext {
     }
 }
 
+/// Append the pre-encoded parts of the payload from the `coap!()` templates
+impl PayloadWriter for CoapContext {
+    fn append(&mut self, data: &[u8]) {
+        let rc = unsafe { sensor_coap::coap_rep_append(data.as_ptr(), data.len() as c_int) };
+        if rc != 0 { self.fail(CoapError::APPEND_FAILED); }
+    }
+}
+
 /// Error codes for COAP encoding failure
 #[derive(PartialEq)]
 pub enum CoapError {
@@ -194,6 +166,8 @@ pub enum CoapError {
     OK = 0,
     /// Encoded value is not unsigned integer
     VALUE_NOT_UINT = 1,
+    /// Payload could not be appended, e.g. out of mbufs
+    APPEND_FAILED = 2,
 }
 
 /// Implement formatted output for CoapError
@@ -248,8 +222,10 @@ impl ToBytesOptionalNull for crate::Strn {
     fn to_bytes_optional_nul(&self) -> &[u8] {
         match self.rep {
             StrnRep::ByteStr(bs) => { bs }
-            StrnRep::CStr(_cstr)  => { assert!(false, "strn bytes"); &[] }
-            //  TODO: unsafe { ::core::mem::transmute::<*const u8, &[u8]>(cstr) }
+            StrnRep::CStr(cstr)  => {
+                if cstr.is_null() { return b"\0"; }
+                unsafe { ::core::slice::from_raw_parts(cstr, self.len() + 1) }  //  Include the null
+            }
         }
     }
 }
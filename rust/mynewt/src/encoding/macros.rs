@@ -395,40 +395,27 @@ macro_rules! parse {
   
   //  JSON encoding: If we match the top level of the JSON: { ... }
   (@json { $($tt:tt)+ }) => {{
-    //  Substitute with this code...
+    //  Substitute with the payload template, serialized at compile time
     d!(begin json root);
-    $crate::coap_root!(@json COAP_CONTEXT {  //  Create the payload root
-        $crate::coap_array!(@json COAP_CONTEXT, values, {  //  Create "values" as an array of items under the root
-          //  Expand the items inside { ... } and add them to values.
-          $crate::parse!(@json @object COAP_CONTEXT () ($($tt)+) ($($tt)+));
-        });  //  Close the "values" array
-    });  //  Close the payload root
+    $crate::coap_template!(@json { $($tt)+ });
     d!(end json root);
     ()
   }};
 
   //  CBOR encoding: If we match the top level of the JSON: { ... }
   (@cbor { $($tt:tt)+ }) => {{
-    //  Substitute with this code...
+    //  Substitute with the payload template, serialized at compile time
     d!(begin cbor root);
-    $crate::coap_root!(@cbor root {  //  Create the payload root
-        $crate::coap_array!(@cbor root, values, {  //  Create "values" as an array of items under the root
-          //  Expand the items inside { ... } and add them to values.
-          $crate::parse!(@cbor @object values () ($($tt)+) ($($tt)+));
-        });  //  Close the "values" array
-    });  //  Close the payload root
+    $crate::coap_template!(@cbor { $($tt)+ });
     d!(end cbor root);
     ()
   }};
 
   //  CBOR minimal encoding: If we match the top level of the JSON: { ... }
   (@cbormin { $($tt:tt)+ }) => {{
-    //  Substitute with this code...
+    //  Substitute with the payload template, serialized at compile time
     d!(begin cbor root);
-    $crate::coap_root!(@cbormin COAP_CONTEXT {  //  Create the payload root
-        //  Expand the items inside { ... } and add them to root.
-        $crate::parse!(@cbormin @object COAP_CONTEXT () ($($tt)+) ($($tt)+));  //  TODO: Change COAP_CONTEXT to CBOR
-    });  //  Close the payload root
+    $crate::coap_template!(@cbormin { $($tt)+ });
     d!(end cbor root);
     ()
   }};
@@ -449,6 +436,92 @@ macro_rules! parse {
   };  //  Previously: $crate::to_value(&$other).unwrap()
 }
 
+///  Compose the CoAP payload from a template serialized at compile time. The constant parts of the payload
+///  (root, "values" array, item keys and punctuation) between two dynamic values are merged into one `Piece`
+///  by `const fn`, so each constant part and each dynamic value is appended to the payload in a single write.
+///  Items are `"key": value` for string values and `sensor_value` for `SensorValue` with key and integer value.
+///  See `encoding/template.rs`.
+///  This macro is a TT muncher with this state:
+///  - __Encoding__: `Encoding::Json`, `Encoding::Cbor` or `Encoding::CborMin`
+///  - __First__: `true` if no items have been appended
+///  - __Pending__: Constant part that has not been appended, as a `Piece` expression
+///  - __Remaining tokens__ to be parsed
+#[macro_export]
+macro_rules! coap_template {
+  //  JSON encoding: Set the payload format and start the root
+  (@json { $($tt:tt)+ }) => {{
+    unsafe { $crate::libs::sensor_network::prepare_post($crate::encoding::APPLICATION_JSON) ? ; }
+    $crate::coap_template!(@munch ($crate::encoding::template::Encoding::Json) true
+      ($crate::encoding::template::Piece::EMPTY.root_start($crate::encoding::template::Encoding::Json))
+      $($tt)+);
+  }};
+
+  //  CBOR encoding: Set the payload format and start the root
+  (@cbor { $($tt:tt)+ }) => {{
+    unsafe { $crate::libs::sensor_network::prepare_post($crate::encoding::APPLICATION_CBOR) ? ; }
+    $crate::coap_template!(@munch ($crate::encoding::template::Encoding::Cbor) true
+      ($crate::encoding::template::Piece::EMPTY.root_start($crate::encoding::template::Encoding::Cbor))
+      $($tt)+);
+  }};
+
+  //  CBOR minimal encoding: Set the payload format and start the root
+  (@cbormin { $($tt:tt)+ }) => {{
+    unsafe { $crate::libs::sensor_network::prepare_post($crate::encoding::APPLICATION_CBOR) ? ; }
+    $crate::coap_template!(@munch ($crate::encoding::template::Encoding::CborMin) true
+      ($crate::encoding::template::Piece::EMPTY.root_start($crate::encoding::template::Encoding::CborMin))
+      $($tt)+);
+  }};
+
+  //  Done: Append the pending constant part and end the root
+  (@munch ($enc:expr) $first:tt ($pending:expr)) => {
+    $crate::coap_template!(@flush ($pending.root_end($enc)));
+  };
+
+  //  String item: `"key": value`, with or without trailing comma
+  (@munch ($enc:expr) $first:tt ($pending:expr) $key:literal : $value:expr $(, $($rest:tt)*)?) => {
+    //  Append `{"key":"device","value":"` with the previous constant part
+    $crate::coap_template!(@flush ($pending.separator($enc, $first).str_item_start($enc, $key)));
+    //  Append the value
+    $crate::encoding::template::text(
+      unsafe { &mut $crate::encoding::coap_context::COAP_CONTEXT }, $enc, &$value);
+    //  `"}` is appended with the next constant part
+    $crate::coap_template!(@munch ($enc) false
+      ($crate::encoding::template::Piece::EMPTY.str_item_end($enc))
+      $($($rest)*)?);
+  };
+
+  //  Sensor value item: `sensor_value`, with or without trailing comma
+  (@munch ($enc:expr) $first:tt ($pending:expr) $val:expr $(, $($rest:tt)*)?) => {
+    //  Append `{"key":"` with the previous constant part
+    $crate::coap_template!(@flush ($pending.separator($enc, $first).int_item_start($enc)));
+    {
+      let writer = unsafe { &mut $crate::encoding::coap_context::COAP_CONTEXT };
+      let val = &$val;
+      if let $crate::hw::sensor::SensorValueType::Uint(value) = val.value {
+        //  Append the sensor key, `","value":`, the value and the optional geolocation
+        $crate::encoding::template::text(writer, $enc, val.key);
+        const VALUE: $crate::encoding::template::Piece = $crate::encoding::template::Piece::EMPTY.int_item_value($enc);
+        $crate::encoding::template::append_piece(writer, &VALUE);
+        $crate::encoding::template::int(writer, $enc, value as i64);
+        $crate::encoding::template::geo(writer, $enc, val.geo);
+      } else {
+        writer.fail($crate::encoding::coap_context::CoapError::VALUE_NOT_UINT);  //  Value not uint
+      }
+    }
+    //  `}` is appended with the next constant part
+    $crate::coap_template!(@munch ($enc) false
+      ($crate::encoding::template::Piece::EMPTY.int_item_end($enc))
+      $($($rest)*)?);
+  };
+
+  //  Serialize the constant part at compile time and append it
+  (@flush ($piece:expr)) => {{
+    const PIECE: $crate::encoding::template::Piece = $piece;
+    $crate::encoding::template::append_piece(
+      unsafe { &mut $crate::encoding::coap_context::COAP_CONTEXT }, &PIECE);
+  }};
+}
+
 ///  TODO: Parse the vector e.g. array items
 #[macro_export]
 macro_rules! parse_vector {
@@ -662,7 +735,8 @@ macro_rules! json_rep_set_array {
     unsafe {
       mynewt::libs::mynewt_rust::json_helper_set_array(
         $context.to_void_ptr(),
-        $context.key_to_cstr(key_with_null.as_bytes())
+        $context.str_ptr(key_with_null.as_bytes()),
+        $context.str_len(key_with_null.as_bytes()) as _
       ); 
     };
   }};
@@ -679,7 +753,8 @@ macro_rules! json_rep_set_array {
     unsafe {
       mynewt::libs::mynewt_rust::json_helper_set_array(
         $context.to_void_ptr(),
-        $context.key_to_cstr(key_with_opt_null)
+        $context.str_ptr(key_with_opt_null),
+        $context.str_len(key_with_opt_null) as _
       ); 
     };
   }};
@@ -701,7 +776,8 @@ macro_rules! json_rep_close_array {
     unsafe { 
       mynewt::libs::mynewt_rust::json_helper_close_array(
         $context.to_void_ptr(),
-        $context.key_to_cstr(key_with_null.as_bytes())
+        $context.str_ptr(key_with_null.as_bytes()),
+        $context.str_len(key_with_null.as_bytes()) as _
       ) 
     };
   }};
@@ -716,7 +792,8 @@ macro_rules! json_rep_close_array {
     unsafe { 
       mynewt::libs::mynewt_rust::json_helper_close_array(
         $context.to_void_ptr(),
-        $context.key_to_cstr(key_with_opt_null)
+        $context.str_ptr(key_with_opt_null),
+        $context.str_len(key_with_opt_null) as _
       ) 
     };
   }};
@@ -738,7 +815,7 @@ macro_rules! json_rep_object_array_start_item {
     let key_with_null: &str = $crate::stringify_null!($context);    //  TODO
     unsafe { 
       mynewt::libs::mynewt_rust::json_helper_object_array_start_item(
-        $context.key_to_cstr(key_with_null.as_bytes())
+        $context.str_ptr(key_with_null.as_bytes())
       ) 
     };
   }};
@@ -753,7 +830,7 @@ macro_rules! json_rep_object_array_start_item {
     let key_with_opt_null: &[u8] = $context.to_bytes_optional_nul();  //  TODO
     unsafe { 
       mynewt::libs::mynewt_rust::json_helper_object_array_start_item(
-        $context.key_to_cstr(key_with_opt_null)
+        $context.str_ptr(key_with_opt_null)
       ) 
     };
   }};
@@ -774,7 +851,7 @@ macro_rules! json_rep_object_array_end_item {
     let key_with_null: &str = $crate::stringify_null!($context);  //  TODO
     unsafe { 
       mynewt::libs::mynewt_rust::json_helper_object_array_end_item(
-        $context.key_to_cstr(key_with_null.as_bytes())
+        $context.str_ptr(key_with_null.as_bytes())
       ) 
     };
   }};
@@ -788,7 +865,7 @@ macro_rules! json_rep_object_array_end_item {
     let key_with_opt_null: &[u8] = $context.to_bytes_optional_nul();  //  TODO
     unsafe { 
       mynewt::libs::mynewt_rust::json_helper_object_array_end_item(
-        $context.key_to_cstr(key_with_opt_null)
+        $context.str_ptr(key_with_opt_null)
       ) 
     };
   }};
@@ -811,7 +888,8 @@ macro_rules! json_rep_set_int {
     unsafe {
       mynewt::libs::mynewt_rust::json_helper_set_int(
         $context.to_void_ptr(),
-        $context.key_to_cstr(key_with_null.as_bytes()),
+        $context.str_ptr(key_with_null.as_bytes()),
+        $context.str_len(key_with_null.as_bytes()) as _,
         value
       )
     };
@@ -831,7 +909,8 @@ macro_rules! json_rep_set_int {
     unsafe {
       mynewt::libs::mynewt_rust::json_helper_set_int(
         $context.to_void_ptr(), 
-        $context.key_to_cstr(key_with_opt_null),
+        $context.str_ptr(key_with_opt_null),
+        $context.str_len(key_with_opt_null) as _,
         value
       )
     };
@@ -868,8 +947,10 @@ macro_rules! json_rep_set_text_string {
     unsafe {
       mynewt::libs::mynewt_rust::json_helper_set_text_string(
         $context.to_void_ptr(), 
-        $context.key_to_cstr(key_with_opt_null),
-        $context.value_to_cstr(value_with_opt_null)
+        $context.str_ptr(key_with_opt_null),
+        $context.str_len(key_with_opt_null) as _,
+        $context.str_ptr(value_with_opt_null),
+        $context.str_len(value_with_opt_null) as _
       )
     };
   }};
@@ -1058,8 +1139,8 @@ macro_rules! oc_rep_set_array {
       //  Previously: g_err |= cbor_encode_text_string(&object##_map, #key, strlen(#key))
       cbor_encode_text_string(
         encoder, 
-        COAP_CONTEXT.key_to_cstr(key_with_opt_null), 
-        COAP_CONTEXT.cstr_len(key_with_opt_null)
+        COAP_CONTEXT.str_ptr(key_with_opt_null), 
+        COAP_CONTEXT.str_len(key_with_opt_null)
       );
     });
     //  Previously: oc_rep_start_array!(object##_map, key)
@@ -1144,8 +1225,8 @@ macro_rules! oc_rep_set_int {
       //  Previously: g_err |= cbor_encode_text_string(&object##_map, #key, strlen(#key))
       cbor_encode_text_string(
         encoder,
-        COAP_CONTEXT.key_to_cstr(key_with_null.as_bytes()),
-        COAP_CONTEXT.cstr_len(key_with_null.as_bytes())
+        COAP_CONTEXT.str_ptr(key_with_null.as_bytes()),
+        COAP_CONTEXT.str_len(key_with_null.as_bytes())
       );
       //  Previously: g_err |= cbor_encode_int(&object##_map, value)
       cbor_encode_int(
@@ -1173,8 +1254,8 @@ macro_rules! oc_rep_set_int {
       //  Previously: g_err |= cbor_encode_text_string(&object##_map, #key, strlen(#key))
       cbor_encode_text_string(
         encoder,
-        COAP_CONTEXT.key_to_cstr(key_with_opt_null),
-        COAP_CONTEXT.cstr_len(   key_with_opt_null)
+        COAP_CONTEXT.str_ptr(key_with_opt_null),
+        COAP_CONTEXT.str_len(   key_with_opt_null)
       );
       //  Previously: g_err |= cbor_encode_int(&object##_map, value)
       cbor_encode_int(
@@ -1207,14 +1288,14 @@ macro_rules! oc_rep_set_text_string {
       //  Previously: g_err |= cbor_encode_text_string(&object##_map, #key, strlen(#key))
       cbor_encode_text_string(
         encoder, 
-        COAP_CONTEXT.key_to_cstr(key_with_opt_null), 
-        COAP_CONTEXT.cstr_len(   key_with_opt_null)
+        COAP_CONTEXT.str_ptr(key_with_opt_null), 
+        COAP_CONTEXT.str_len(   key_with_opt_null)
       );
       //  Previously: g_err |= cbor_encode_text_string(&object##_map, value, strlen(value))
       cbor_encode_text_string(
         encoder, 
-        COAP_CONTEXT.value_to_cstr(value_with_opt_null), 
-        COAP_CONTEXT.cstr_len(     value_with_opt_null)
+        COAP_CONTEXT.str_ptr(value_with_opt_null), 
+        COAP_CONTEXT.str_len(     value_with_opt_null)
       );
     });
     d!(end oc_rep_set_text_string);
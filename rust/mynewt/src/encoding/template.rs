@@ -0,0 +1,296 @@
+//! CoAP Payload Templates for the `coap!()` macro. The constant parts of the payload (keys, punctuation and nesting)
+//! are serialized into `Piece`s by `const fn` at compile time, in JSON or CBOR. At runtime the pieces are appended
+//! as they are, and only the dynamic values (sensor keys, values and geolocation) are encoded, each with a single
+//! append. See `coap_template!()` in `macros.rs`.
+//!
+//! JSON is written without whitespace. Integer sensor values are encoded like `{"key":"t","value":1715}`, with
+//! the geolocation attached as `"geo":{"lat":1.2345678,"long":103.8765432}` in JSON only.
+
+use crate::{
+    hw::sensor::SensorValueType,
+    Strn,
+};
+
+/// Encoding of the payload
+#[derive(Clone, Copy, PartialEq)]
+pub enum Encoding {
+    /// JSON for thethings.io: `{"values":[{"key":...,"value":...}, ...]}`
+    Json,
+    /// CBOR for thethings.io, same structure as JSON
+    Cbor,
+    /// CBOR minimal key-value encoding: `{key: value, ...}`
+    CborMin,
+}
+
+/// Destination of the payload, e.g. the CoAP message being composed
+pub trait PayloadWriter {
+    /// Append the bytes to the payload
+    fn append(&mut self, data: &[u8]);
+}
+
+/// String value that may be spliced into a payload
+pub trait PayloadStr {
+    /// Return the bytes of the string, without the terminating null
+    fn payload_bytes(&self) -> &[u8];
+}
+
+impl PayloadStr for Strn {
+    fn payload_bytes(&self) -> &[u8] { self.to_bytes() }
+}
+
+impl PayloadStr for str {
+    fn payload_bytes(&self) -> &[u8] { self.as_bytes() }
+}
+
+impl<T: PayloadStr + ?Sized> PayloadStr for &T {
+    fn payload_bytes(&self) -> &[u8] { (**self).payload_bytes() }
+}
+
+/// Max size of a piece. Pieces built at compile time fail to compile if larger.
+pub const PIECE_SIZE: usize = 64;
+
+/// CBOR major types
+const CBOR_UINT: u8 = 0x00;
+const CBOR_NINT: u8 = 0x20;
+const CBOR_TEXT: u8 = 0x60;
+/// CBOR headers for indefinite-length containers and their end
+const CBOR_ARRAY_START: u8 = 0x9f;
+const CBOR_MAP_START: u8   = 0xbf;
+const CBOR_BREAK: u8       = 0xff;
+
+const HEX: &[u8; 16] = b"0123456789abcdef";
+
+/// Part of a payload, serialized at compile time for the constant parts, or at runtime for a dynamic value.
+#[derive(Clone, Copy)]
+pub struct Piece {
+    bytes: [u8; PIECE_SIZE],
+    len:   usize,
+}
+
+impl Piece {
+    /// Piece with no bytes
+    pub const EMPTY: Piece = Piece { bytes: [0; PIECE_SIZE], len: 0 };
+
+    /// Return the serialized bytes
+    pub fn as_bytes(&self) -> &[u8] { &self.bytes[.. self.len] }
+
+    /// Return true if there are no bytes
+    pub const fn is_empty(&self) -> bool { self.len == 0 }
+
+    /// Append raw bytes, e.g. JSON punctuation
+    pub const fn raw(self, data: &[u8]) -> Piece {
+        let mut piece = self;
+        let mut i = 0;
+        while i < data.len() {
+            piece.bytes[piece.len] = data[i];
+            piece.len += 1;
+            i += 1;
+        }
+        piece
+    }
+
+    /// Append a JSON string in quotes
+    pub const fn json_str(self, s: &str) -> Piece {
+        let data = s.as_bytes();
+        let mut piece = self.raw(b"\"");
+        let mut i = 0;
+        while i < data.len() {
+            piece = piece.json_char(data[i]);
+            i += 1;
+        }
+        piece.raw(b"\"")
+    }
+
+    /// Append a character of a JSON string, escaped if necessary
+    const fn json_char(self, c: u8) -> Piece {
+        match c {
+            b'"'  => self.raw(b"\\\""),
+            b'\\' => self.raw(b"\\\\"),
+            0 ..= 0x1f => self.raw(&[ b'\\', b'u', b'0', b'0', HEX[(c >> 4) as usize], HEX[(c & 0xf) as usize] ]),
+            _ => self.raw(&[ c ]),
+        }
+    }
+
+    /// Append an unsigned integer in decimal
+    pub const fn decimal(self, value: u64) -> Piece {
+        let mut digits = [0u8; 20];
+        let mut count = 0;
+        let mut v = value;
+        loop {
+            digits[count] = b'0' + (v % 10) as u8;
+            count += 1;
+            v /= 10;
+            if v == 0 { break; }
+        }
+        let mut piece = self;
+        while count > 0 {
+            count -= 1;
+            piece = piece.raw(&[ digits[count] ]);
+        }
+        piece
+    }
+
+    /// Append a fixed-point value with 7 decimal places, e.g. 1e-7 degrees, like `json_helper_set_fixed7()`
+    pub const fn fixed7(self, value: i32) -> Piece {
+        let piece = if value < 0 { self.raw(b"-") } else { self };
+        let abs = (value as i64).abs() as u64;
+        let mut piece = piece.decimal(abs / 10_000_000).raw(b".");
+        //  Pad the fraction with leading zeros
+        let fraction = abs % 10_000_000;
+        let mut scale = 1_000_000;
+        while scale > 1 && fraction < scale {
+            piece = piece.raw(b"0");
+            scale /= 10;
+        }
+        piece.decimal(fraction)
+    }
+
+    /// Append a CBOR header with the major type and the length or value
+    pub const fn cbor_head(self, major: u8, value: u64) -> Piece {
+        if value < 24 {
+            self.raw(&[ major | value as u8 ])
+        } else if value <= 0xff {
+            self.raw(&[ major | 24, value as u8 ])
+        } else if value <= 0xffff {
+            self.raw(&[ major | 25, (value >> 8) as u8, value as u8 ])
+        } else if value <= 0xffff_ffff {
+            self.raw(&[ major | 26, (value >> 24) as u8, (value >> 16) as u8, (value >> 8) as u8, value as u8 ])
+        } else {
+            self.raw(&[ major | 27, (value >> 56) as u8, (value >> 48) as u8, (value >> 40) as u8, (value >> 32) as u8,
+                (value >> 24) as u8, (value >> 16) as u8, (value >> 8) as u8, value as u8 ])
+        }
+    }
+
+    /// Append a CBOR text string
+    pub const fn cbor_text(self, s: &str) -> Piece {
+        self.cbor_head(CBOR_TEXT, s.len() as u64).raw(s.as_bytes())
+    }
+
+    /// Start the payload root: `{"values":[` for JSON
+    pub const fn root_start(self, enc: Encoding) -> Piece {
+        match enc {
+            Encoding::Json    => self.raw(b"{\"values\":["),
+            Encoding::Cbor    => self.raw(&[ CBOR_MAP_START ]).cbor_text("values").raw(&[ CBOR_ARRAY_START ]),
+            Encoding::CborMin => self.raw(&[ CBOR_MAP_START ]),
+        }
+    }
+
+    /// End the payload root: `]}` for JSON
+    pub const fn root_end(self, enc: Encoding) -> Piece {
+        match enc {
+            Encoding::Json    => self.raw(b"]}"),
+            Encoding::Cbor    => self.raw(&[ CBOR_BREAK, CBOR_BREAK ]),
+            Encoding::CborMin => self.raw(&[ CBOR_BREAK ]),
+        }
+    }
+
+    /// Separate the item from the previous item: `,` for JSON
+    pub const fn separator(self, enc: Encoding, first: bool) -> Piece {
+        match enc {
+            Encoding::Json if !first => self.raw(b","),
+            _ => self,
+        }
+    }
+
+    /// Start a string item with a constant key, up to the value: `{"key":"device","value":"` for JSON
+    pub const fn str_item_start(self, enc: Encoding, key: &str) -> Piece {
+        match enc {
+            Encoding::Json    => self.raw(b"{\"key\":").json_str(key).raw(b",\"value\":\""),
+            Encoding::Cbor    => self.raw(&[ CBOR_MAP_START ]).cbor_text("key").cbor_text(key).cbor_text("value"),
+            Encoding::CborMin => self.cbor_text(key),
+        }
+    }
+
+    /// End a string item: `"}` for JSON
+    pub const fn str_item_end(self, enc: Encoding) -> Piece {
+        match enc {
+            Encoding::Json    => self.raw(b"\"}"),
+            Encoding::Cbor    => self.raw(&[ CBOR_BREAK ]),
+            Encoding::CborMin => self,
+        }
+    }
+
+    /// Start a sensor value item, up to the sensor key: `{"key":"` for JSON
+    pub const fn int_item_start(self, enc: Encoding) -> Piece {
+        match enc {
+            Encoding::Json    => self.raw(b"{\"key\":\""),
+            Encoding::Cbor    => self.raw(&[ CBOR_MAP_START ]).cbor_text("key"),
+            Encoding::CborMin => self,
+        }
+    }
+
+    /// Continue a sensor value item from the sensor key to the value: `","value":` for JSON
+    pub const fn int_item_value(self, enc: Encoding) -> Piece {
+        match enc {
+            Encoding::Json    => self.raw(b"\",\"value\":"),
+            Encoding::Cbor    => self.cbor_text("value"),
+            Encoding::CborMin => self,
+        }
+    }
+
+    /// End a sensor value item: `}` for JSON
+    pub const fn int_item_end(self, enc: Encoding) -> Piece {
+        match enc {
+            Encoding::Json    => self.raw(b"}"),
+            Encoding::Cbor    => self.raw(&[ CBOR_BREAK ]),
+            Encoding::CborMin => self,
+        }
+    }
+}
+
+/// Append a constant piece, unless empty
+pub fn append_piece<W: PayloadWriter>(writer: &mut W, piece: &Piece) {
+    if !piece.is_empty() { writer.append(piece.as_bytes()); }
+}
+
+/// Splice a string value: escaped without quotes for JSON (the quotes are in the template), CBOR text string for CBOR
+pub fn text<W: PayloadWriter, S: PayloadStr + ?Sized>(writer: &mut W, enc: Encoding, value: &S) {
+    let data = value.payload_bytes();
+    match enc {
+        Encoding::Json => {
+            //  Escape into pieces. Each piece has room for the longest escape sequence.
+            let mut piece = Piece::EMPTY;
+            for c in data {
+                piece = piece.json_char(*c);
+                if piece.len > PIECE_SIZE - 6 {
+                    writer.append(piece.as_bytes());
+                    piece = Piece::EMPTY;
+                }
+            }
+            append_piece(writer, &piece);
+        }
+        _ => {
+            let head = Piece::EMPTY.cbor_head(CBOR_TEXT, data.len() as u64);
+            if data.len() <= PIECE_SIZE - head.len {
+                writer.append(head.raw(data).as_bytes());
+            } else {
+                writer.append(head.as_bytes());
+                writer.append(data);
+            }
+        }
+    }
+}
+
+/// Splice an integer value
+pub fn int<W: PayloadWriter>(writer: &mut W, enc: Encoding, value: i64) {
+    let piece = match enc {
+        Encoding::Json if value < 0 => Piece::EMPTY.raw(b"-").decimal((value as i128).abs() as u64),
+        Encoding::Json              => Piece::EMPTY.decimal(value as u64),
+        _ if value < 0              => Piece::EMPTY.cbor_head(CBOR_NINT, !(value as u64)),
+        _                           => Piece::EMPTY.cbor_head(CBOR_UINT, value as u64),
+    };
+    writer.append(piece.as_bytes());
+}
+
+/// Splice the geolocation of a sensor value item, if any: `,"geo":{"lat":1.2345678,"long":103.8765432}`.
+/// JSON only: geolocation is not encoded in CBOR.
+pub fn geo<W: PayloadWriter>(writer: &mut W, enc: Encoding, geo: SensorValueType) {
+    if enc != Encoding::Json { return; }
+    if let SensorValueType::Geolocation { latitude, longitude, .. } = geo {
+        let piece = Piece::EMPTY
+            .raw(b",\"geo\":{\"lat\":").fixed7(latitude)
+            .raw(b",\"long\":").fixed7(longitude)
+            .raw(b"}");
+        writer.append(piece.as_bytes());
+    }
+}
@@ -0,0 +1,329 @@
+//! Async Executor for Mynewt Event Queues. Runs a Rust `Future` on the Event Queue of the calling task, so that
+//! independent I/O (SPI writes, I2C reads, sensor reads, CoAP posts) can overlap in one task without dedicated
+//! tasks and stacks. No heap is needed: `block_on()` polls a single future, and concurrent I/O is composed with `join()`.
+//!
+//! Wakers post the executor's event to its Event Queue, so they may be called from any task or interrupt handler.
+//! While the future is pending, the task processes the other events on its Event Queue as usual.
+//!
+//! Wakers are hooked to Mynewt as follows:
+//! - Interrupt handlers and HAL completion callbacks call `Signal::signal()`, which the future awaits with `Signal::wait()`
+//! - Delays use `delay_ms()`, which starts an `os_callout`
+//! - Blocking Mynewt APIs (e.g. `sensor_read()`) run on another task's Event Queue with `run_deferred()`
+//!
+//! ```
+//! static mut EXECUTOR: Executor = Executor::new();
+//! let (temp, _) = unsafe { EXECUTOR.block_on(os::os_eventq_dflt_get(), join(read_temp(), spi_async_write(cmd, data))) };
+//! ```
+use core::{
+    cell::UnsafeCell,
+    future::Future,
+    marker::PhantomPinned,
+    pin::Pin,
+    sync::atomic::{ AtomicBool, Ordering },
+    task::{ Context, Poll, RawWaker, RawWakerVTable, Waker },
+};
+use crate::{
+    result::*,
+    kernel::os,
+    Ptr,
+};
+
+/// Executor that polls a future on a Mynewt Event Queue. Must be static, because the wakers refer to it.
+pub struct Executor {
+    /// Event posted to the Event Queue to wake the executor
+    event:  os::os_event,
+    /// Event Queue of the task running the executor
+    eventq: *mut os::os_eventq,
+    /// True if the future should be polled
+    woken:  AtomicBool,
+}
+
+impl Executor {
+    /// Create an executor. Call `block_on()` to run a future.
+    pub const fn new() -> Executor {
+        Executor {
+            event:  fill_zero!(os::os_event),
+            eventq: core::ptr::null_mut(),
+            woken:  AtomicBool::new(false),
+        }
+    }
+
+    /// Run the future to completion on the Event Queue and return its output. Other events on the Event Queue are
+    /// processed while the future is pending. Must be called by the task that owns the Event Queue.
+    pub fn block_on<F: Future>(&'static mut self, eventq: *mut os::os_eventq, future: F) -> F::Output {
+        assert!(!eventq.is_null(), "no eventq");
+        let exec: *mut Executor = self;
+        unsafe {
+            (*exec).eventq = eventq;
+            (*exec).event.ev_cb  = Some(executor_event_callback);
+            (*exec).event.ev_arg = exec as Ptr;
+            (*exec).woken.store(true, Ordering::Release);  //  Poll the future once to start it
+        }
+        let waker = unsafe { Waker::from_raw(RawWaker::new(exec as *const (), &WAKER_VTABLE)) };
+        let mut context = Context::from_waker(&waker);
+        let mut future = future;
+        //  Future is not moved until it is dropped at the end of this function
+        let mut future = unsafe { Pin::new_unchecked(&mut future) };
+        loop {
+            if unsafe { (*exec).woken.swap(false, Ordering::AcqRel) } {
+                if let Poll::Ready(output) = future.as_mut().poll(&mut context) { return output; }
+            }
+            //  Process events until one of them wakes the future
+            os::eventq_run(eventq).expect("eventq fail");
+        }
+    }
+}
+
+/// Waker functions for `Executor`. The waker data points to the static executor, so cloning and dropping do nothing.
+static WAKER_VTABLE: RawWakerVTable = RawWakerVTable::new(waker_clone, waker_wake, waker_wake, waker_drop);
+
+unsafe fn waker_clone(data: *const ()) -> RawWaker { RawWaker::new(data, &WAKER_VTABLE) }
+
+/// Post the executor's event to its Event Queue. Does nothing if the event is already queued. Safe to call from
+/// interrupt handlers.
+unsafe fn waker_wake(data: *const ()) {
+    let exec = data as *mut Executor;
+    if (*exec).eventq.is_null() { return; }
+    (*exec).woken.store(true, Ordering::Release);
+    os::os_eventq_put((*exec).eventq, &mut (*exec).event);
+}
+
+unsafe fn waker_drop(_data: *const ()) {}
+
+/// Callback for the executor's event. The future is polled by `block_on()` after the callback returns.
+extern "C" fn executor_event_callback(event: *mut os::os_event) {
+    let exec = unsafe { (*event).ev_arg } as *mut Executor;
+    unsafe { (*exec).woken.store(true, Ordering::Release) };
+}
+
+/// Signal that wakes the future waiting for it. `signal()` may be called from any task, interrupt handler or
+/// HAL callback. Only one future may wait for the signal at a time.
+pub struct Signal {
+    /// True if signalled and not yet consumed by `wait()`
+    flag:  AtomicBool,
+    /// Waker of the waiting future. Accessed with interrupts disabled.
+    waker: UnsafeCell<Option<Waker>>,
+}
+
+unsafe impl Sync for Signal {}
+
+impl Signal {
+    /// Create a signal that is not signalled
+    pub const fn new() -> Signal {
+        Signal { flag: AtomicBool::new(false), waker: UnsafeCell::new(None) }
+    }
+
+    /// Set the signal and wake the waiting future
+    pub fn signal(&self) {
+        self.flag.store(true, Ordering::Release);
+        let sr = unsafe { os::os_arch_save_sr() };
+        let waker = unsafe { (*self.waker.get()).take() };
+        unsafe { os::os_arch_restore_sr(sr) };
+        if let Some(waker) = waker { waker.wake(); }
+    }
+
+    /// Clear the signal, e.g. before starting the I/O that will set it
+    pub fn reset(&self) {
+        self.flag.store(false, Ordering::Release);
+    }
+
+    /// Return a future that completes when the signal is set, and clears the signal
+    pub fn wait(&self) -> SignalWait<'_> {
+        SignalWait { signal: self }
+    }
+
+    /// Poll the signal: clear it and return `Ready` if set, else save the waker and return `Pending`
+    fn poll_signal(&self, context: &mut Context) -> Poll<()> {
+        if self.flag.swap(false, Ordering::AcqRel) { return Poll::Ready(()); }
+        let sr = unsafe { os::os_arch_save_sr() };
+        unsafe { *self.waker.get() = Some(context.waker().clone()) };
+        unsafe { os::os_arch_restore_sr(sr) };
+        //  Signal may have been set before the waker was saved
+        if self.flag.swap(false, Ordering::AcqRel) { return Poll::Ready(()); }
+        Poll::Pending
+    }
+}
+
+/// Future returned by `Signal::wait()`
+pub struct SignalWait<'a> {
+    signal: &'a Signal,
+}
+
+impl<'a> Future for SignalWait<'a> {
+    type Output = ();
+    fn poll(self: Pin<&mut Self>, context: &mut Context) -> Poll<()> {
+        self.signal.poll_signal(context)
+    }
+}
+
+/// Future returned by `delay_ms()`. Starts a callout on the default Event Queue when first polled.
+pub struct Sleep {
+    /// Callout that sets `done` when it expires
+    callout: os::os_callout,
+    /// Number of OS ticks to sleep
+    ticks:   os::os_time_t,
+    /// True if the callout has been started
+    started: bool,
+    /// Set when the callout expires
+    done:    Signal,
+    /// The callout refers to this future, so it must not move once started
+    _pin:    PhantomPinned,
+}
+
+/// Return a future that completes after `ms` milliseconds, e.g. to pace periodic I/O
+pub fn delay_ms(ms: u32) -> Sleep {
+    Sleep {
+        callout: fill_zero!(os::os_callout),
+        ticks:   ms * os::OS_TICKS_PER_SEC / 1000,
+        started: false,
+        done:    Signal::new(),
+        _pin:    PhantomPinned,
+    }
+}
+
+impl Future for Sleep {
+    type Output = ();
+    fn poll(self: Pin<&mut Self>, context: &mut Context) -> Poll<()> {
+        let sleep = unsafe { self.get_unchecked_mut() };
+        if !sleep.started {
+            sleep.started = true;
+            let arg = sleep as *mut Sleep as Ptr;
+            unsafe { os::os_callout_init(&mut sleep.callout, os::os_eventq_dflt_get(), Some(sleep_callback), arg) };
+            let rc = unsafe { os::os_callout_reset(&mut sleep.callout, sleep.ticks) };
+            assert_eq!(rc, 0, "callout fail");
+        }
+        sleep.done.poll_signal(context)
+    }
+}
+
+impl Drop for Sleep {
+    /// Stop the callout if the future is dropped before it expires
+    fn drop(&mut self) {
+        if self.started { unsafe { os::os_callout_stop(&mut self.callout) }; }
+    }
+}
+
+/// Callback for the `Sleep` callout
+extern "C" fn sleep_callback(event: *mut os::os_event) {
+    let sleep = unsafe { (*event).ev_arg } as *const Sleep;
+    unsafe { (*sleep).done.signal() };
+}
+
+/// Return a future that polls both futures concurrently and completes with both outputs
+pub fn join<A: Future, B: Future>(a: A, b: B) -> Join<A, B> {
+    Join { a: MaybeDone::Pending(a), b: MaybeDone::Pending(b) }
+}
+
+/// Future returned by `join()`
+pub struct Join<A: Future, B: Future> {
+    a: MaybeDone<A>,
+    b: MaybeDone<B>,
+}
+
+impl<A: Future, B: Future> Future for Join<A, B> {
+    type Output = (A::Output, B::Output);
+    fn poll(self: Pin<&mut Self>, context: &mut Context) -> Poll<Self::Output> {
+        //  Futures are pinned inside `Join`, which is pinned
+        let join = unsafe { self.get_unchecked_mut() };
+        let a_done = unsafe { Pin::new_unchecked(&mut join.a) }.poll_done(context);
+        let b_done = unsafe { Pin::new_unchecked(&mut join.b) }.poll_done(context);
+        if !(a_done && b_done) { return Poll::Pending; }
+        Poll::Ready((join.a.take(), join.b.take()))
+    }
+}
+
+/// Future that keeps its output until it is taken
+enum MaybeDone<F: Future> {
+    Pending(F),
+    Done(F::Output),
+    Taken,
+}
+
+impl<F: Future> MaybeDone<F> {
+    /// Poll the future if pending. Return true if it has completed.
+    fn poll_done(self: Pin<&mut Self>, context: &mut Context) -> bool {
+        let this = unsafe { self.get_unchecked_mut() };
+        if let MaybeDone::Pending(future) = this {
+            match unsafe { Pin::new_unchecked(future) }.poll(context) {
+                Poll::Ready(output) => *this = MaybeDone::Done(output),
+                Poll::Pending => return false,
+            }
+        }
+        true
+    }
+
+    /// Take the output of the completed future
+    fn take(&mut self) -> F::Output {
+        match core::mem::replace(self, MaybeDone::Taken) {
+            MaybeDone::Done(output) => output,
+            _ => panic!("not done"),
+        }
+    }
+}
+
+/// Blocking function run by `run_deferred()`
+pub type DeferredFunc = fn(arg: Ptr) -> MynewtResult<()>;
+
+/// Blocking call that runs on another task's Event Queue, so that the waiting task continues to run other futures
+pub struct Deferred {
+    /// Event posted to the other task's Event Queue
+    event:  os::os_event,
+    /// Blocking function to run and its argument
+    func:   Option<DeferredFunc>,
+    arg:    Ptr,
+    /// Result of the function
+    result: Option<MynewtResult<()>>,
+    /// Set when the function returns
+    done:   Signal,
+    /// True while the function is queued or running
+    busy:   AtomicBool,
+}
+
+impl Deferred {
+    /// Create a deferred call. Must be static, because the other task refers to it.
+    pub const fn new() -> Deferred {
+        Deferred {
+            event:  fill_zero!(os::os_event),
+            func:   None,
+            arg:    core::ptr::null_mut(),
+            result: None,
+            done:   Signal::new(),
+            busy:   AtomicBool::new(false),
+        }
+    }
+
+    /// Return true while the function is queued or running
+    pub fn is_busy(&self) -> bool {
+        self.busy.load(Ordering::Acquire)
+    }
+}
+
+/// Run the blocking function `func(arg)` on the Event Queue `eventq` of another task (e.g. the Sensor Manager)
+/// and complete with its result. Returns `SYS_EBUSY` if the deferred call is still running. If the future is dropped
+/// before completion, the function still runs to completion on the other task.
+pub async fn run_deferred(deferred: &'static mut Deferred, eventq: *mut os::os_eventq, func: DeferredFunc, arg: Ptr)
+    -> MynewtResult<()> {
+    if eventq.is_null() { return Err(MynewtError::SYS_EINVAL); }
+    if deferred.busy.swap(true, Ordering::AcqRel) { return Err(MynewtError::SYS_EBUSY); }
+    deferred.func   = Some(func);
+    deferred.arg    = arg;
+    deferred.result = None;
+    deferred.done.reset();
+    deferred.event.ev_cb  = Some(deferred_event_callback);
+    deferred.event.ev_arg = deferred as *mut Deferred as Ptr;
+    unsafe { os::os_eventq_put(eventq, &mut deferred.event) };
+    deferred.done.wait().await;
+    deferred.result.take().unwrap_or(Err(MynewtError::SYS_EUNKNOWN))
+}
+
+/// Callback for the deferred event. Runs the blocking function in the other task and signals the result.
+extern "C" fn deferred_event_callback(event: *mut os::os_event) {
+    let deferred = unsafe { &mut *((*event).ev_arg as *mut Deferred) };
+    let result = match deferred.func {
+        Some(func) => func(deferred.arg),
+        None       => Err(MynewtError::SYS_EINVAL),
+    };
+    deferred.result = Some(result);
+    deferred.busy.store(false, Ordering::Release);
+    deferred.done.signal();
+}
@@ -0,0 +1,64 @@
+//! Fill kernels for the common primitives. Instead of iterating single pixels, a solid rectangle is written as one
+//! window of a repeated colour, and a filled circle as one horizontal span per row. The repeated colour is prepared
+//! with 32-bit stores (two RGB565 pixels per word) and passed to `DisplayBus::write_repeated()`: the host framebuffer
+//! writes it in blocks, while `spi.rs` queues only the colour and repeats it by DMA.
+use crate::{
+    result::*,
+    display::DisplayBus,
+    dirty::{ Rect, DISPLAY_SIZE },
+};
+
+/// Number of 32-bit words in the colour pattern: one row of the display
+const PATTERN_WORDS: usize = DISPLAY_SIZE as usize / 2;
+
+/// Row of pixels of the same colour, two pixels per word, most significant byte first
+struct Pattern {
+    words: [u32; PATTERN_WORDS],
+}
+
+impl Pattern {
+    /// Fill the pattern with the RGB565 colour
+    fn new(color: u16) -> Pattern {
+        let [hi, lo] = color.to_be_bytes();
+        let word = u32::from_ne_bytes([ hi, lo, hi, lo ]);  //  Same byte order on any endianness
+        Pattern { words: [word; PATTERN_WORDS] }
+    }
+
+    /// Return the pattern as bytes
+    fn bytes(&self) -> &[u8] {
+        unsafe { core::slice::from_raw_parts(self.words.as_ptr() as *const u8, PATTERN_WORDS * 4) }
+    }
+}
+
+/// Fill the part of the rectangle inside the clip area with the RGB565 colour, as one window
+pub fn fill_rect<B: DisplayBus>(bus: &mut B, rect: &Rect, clip: &Rect, color: u16) -> MynewtResult<()> {
+    if !rect.intersects(clip) { return Ok(()); }
+    let r = Rect::new(rect.left.max(clip.left), rect.top.max(clip.top), rect.right.min(clip.right), rect.bottom.min(clip.bottom));
+    bus.write_window(r.left, r.top, r.right, r.bottom) ? ;
+    bus.write_repeated(Pattern::new(color).bytes(), r.area())
+}
+
+/// Fill the part of the circle inside the clip area with the RGB565 colour, as one horizontal span per row.
+/// Same pixels as testing every pixel of the bounding box for (x - cx)^2 + (y - cy)^2 <= r^2.
+pub fn fill_circle<B: DisplayBus>(bus: &mut B, cx: i32, cy: i32, r: i32, clip: &Rect, color: u16) -> MynewtResult<()> {
+    if r < 0 { return Ok(()); }
+    let pattern = Pattern::new(color);
+    let r2 = r * r;
+    let mut half = r;  //  Half width of the span, decreases as the row moves away from the centre
+    for dy in 0 ..= r {
+        while half * half + dy * dy > r2 { half -= 1; }
+        fill_span(bus, &pattern, cx - half, cx + half, cy + dy, clip) ? ;
+        if dy > 0 { fill_span(bus, &pattern, cx - half, cx + half, cy - dy, clip) ? ; }
+    }
+    Ok(())
+}
+
+/// Fill the part of the row from left to right inside the clip area with the pattern
+fn fill_span<B: DisplayBus>(bus: &mut B, pattern: &Pattern, left: i32, right: i32, y: i32, clip: &Rect) -> MynewtResult<()> {
+    if y < clip.top as i32 || y > clip.bottom as i32 { return Ok(()); }
+    let left = left.max(clip.left as i32);
+    let right = right.min(clip.right as i32);
+    if left > right { return Ok(()); }
+    bus.write_window(left as u16, y as u16, right as u16, y as u16) ? ;
+    bus.write_repeated(pattern.bytes(), (right - left + 1) as u32)
+}
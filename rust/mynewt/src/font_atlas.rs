@@ -0,0 +1,143 @@
+//! Glyph atlas for `text.rs`: 12 x 16 glyphs for characters 0x20 to 0x7E, 1 bit per pixel, run-length encoded.
+//! Each glyph is a sequence of 4-bit run lengths that alternate between background and foreground pixels,
+//! row by row, starting with background. Runs longer than 15 pixels are split with an empty run.
+//! Generated by `rust/display-host` from `src/font.rs`, do not edit:
+//! `cargo run --release --target $(rustc -vV | sed -n 's/host: //p') -- --gen-font ../mynewt/src/font_atlas.rs`
+
+/// Width of a glyph in pixels
+pub const GLYPH_WIDTH: u16 = 12;
+/// Height of a glyph in pixels
+pub const GLYPH_HEIGHT: u16 = 16;
+/// First character in the atlas
+pub const FIRST_CHAR: u8 = 0x20;
+/// Last character in the atlas
+pub const LAST_CHAR: u8 = 0x7e;
+
+/// Index of the first run of each glyph in `GLYPH_RUNS`, counted in runs, followed by the end index
+pub static GLYPH_OFFSETS: [u16; 96] = [
+    0, 25, 58, 97, 146, 187, 224, 277, 304, 335, 366, 403, 432, 461, 486, 513,
+    542, 595, 626, 659, 692, 731, 764, 803, 834, 879, 918, 947, 978, 1009, 1036, 1067,
+    1102, 1155, 1204, 1249, 1286, 1337, 1366, 1397, 1442, 1495, 1524, 1561, 1614, 1643, 1708, 1769,
+    1818, 1857, 1914, 1963, 1992, 2023, 2076, 2131, 2200, 2253, 2300, 2329, 2358, 2387, 2416, 2453,
+    2478, 2505, 2538, 2583, 2616, 2663, 2696, 2733, 2770, 2819, 2850, 2887, 2932, 2961, 3018, 3067,
+    3108, 3143, 3180, 3219, 3248, 3281, 3330, 3377, 3434, 3479, 3516, 3545, 3576, 3609, 3640, 3677,
+];
+
+/// Run lengths of all glyphs, two runs per byte, high nibble first
+pub static GLYPH_RUNS: [u8; 1839] = [
+    0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0xcf, 0x02, 0x2a, 0x2a,
+    0x2a, 0x2a, 0x2a, 0x2a, 0x2a, 0x2a, 0x2a, 0x2f, 0x0f, 0x04, 0x2a, 0x2f, 0x02, 0xf2, 0x22, 0x62,
+    0x22, 0x62, 0x22, 0x62, 0x22, 0x62, 0x22, 0x62, 0x22, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0,
+    0x6f, 0x22, 0x26, 0x22, 0x26, 0x22, 0x26, 0x22, 0x24, 0xa2, 0xa4, 0x22, 0x26, 0x22, 0x24, 0xa2,
+    0xa4, 0x22, 0x26, 0x22, 0x26, 0x22, 0x26, 0x22, 0x2f, 0xf0, 0x22, 0xa2, 0x88, 0x48, 0x22, 0x22,
+    0x62, 0x22, 0x86, 0x66, 0x82, 0x22, 0x62, 0x22, 0x28, 0x48, 0x82, 0xa2, 0xf0, 0x2d, 0x48, 0x48,
+    0x44, 0x22, 0x44, 0x28, 0x2a, 0x28, 0x2a, 0x28, 0x2a, 0x28, 0x24, 0x42, 0x24, 0x48, 0x48, 0x4d,
+    0xf4, 0x84, 0x62, 0x42, 0x42, 0x42, 0x42, 0x22, 0x62, 0x22, 0x82, 0xa2, 0x82, 0x22, 0x22, 0x22,
+    0x22, 0x22, 0x22, 0x42, 0x42, 0x42, 0x64, 0x22, 0x44, 0x22, 0xdf, 0x48, 0x4a, 0x2a, 0x28, 0x2a,
+    0x2f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0a, 0xf0, 0x42, 0xa2, 0x82, 0xa2, 0x82, 0xa2, 0xa2,
+    0xa2, 0xa2, 0xa2, 0xc2, 0xa2, 0xc2, 0xa2, 0xff, 0x2a, 0x2c, 0x2a, 0x2c, 0x2a, 0x2a, 0x2a, 0x2a,
+    0x2a, 0x28, 0x2a, 0x28, 0x2a, 0x2f, 0x04, 0xf0, 0xf0, 0x92, 0x22, 0x62, 0x22, 0x82, 0xa2, 0x6a,
+    0x2a, 0x62, 0xa2, 0x82, 0x22, 0x62, 0x22, 0xf0, 0xf0, 0x9f, 0x0f, 0x0b, 0x2a, 0x2a, 0x2a, 0x26,
+    0xa2, 0xa6, 0x2a, 0x2a, 0x2a, 0x2f, 0x0f, 0x0b, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0x64,
+    0x84, 0xa2, 0xa2, 0x82, 0xa2, 0xf0, 0x4f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0a, 0xa2, 0xaf, 0x0f, 0x0f,
+    0x0f, 0x0f, 0x0a, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0xf4, 0x84, 0x84, 0x84, 0xf0,
+    0x2f, 0x0f, 0x0f, 0x2a, 0x28, 0x2a, 0x28, 0x2a, 0x28, 0x2a, 0x28, 0x2a, 0x2f, 0x0f, 0x0f, 0xf6,
+    0x66, 0x42, 0x62, 0x22, 0x62, 0x22, 0x44, 0x22, 0x44, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x24,
+    0x42, 0x24, 0x42, 0x22, 0x62, 0x22, 0x62, 0x46, 0x66, 0xff, 0x02, 0x2a, 0x28, 0x48, 0x4a, 0x2a,
+    0x2a, 0x2a, 0x2a, 0x2a, 0x2a, 0x2a, 0x28, 0x66, 0x6f, 0xf6, 0x66, 0x42, 0x62, 0x22, 0x62, 0xa2,
+    0xa2, 0x82, 0xa2, 0x82, 0xa2, 0x82, 0xa2, 0x8a, 0x2a, 0xdd, 0xa2, 0xa8, 0x2a, 0x28, 0x2a, 0x2c,
+    0x2a, 0x2c, 0x2a, 0x22, 0x26, 0x22, 0x26, 0x24, 0x66, 0x6f, 0xf0, 0x42, 0xa2, 0x84, 0x84, 0x62,
+    0x22, 0x62, 0x22, 0x42, 0x42, 0x42, 0x42, 0x4a, 0x2a, 0x82, 0xa2, 0xa2, 0xa2, 0xfd, 0xa2, 0xa2,
+    0x2a, 0x2a, 0x84, 0x8c, 0x2a, 0x2a, 0x2a, 0x22, 0x26, 0x22, 0x26, 0x24, 0x66, 0x6f, 0xf0, 0x24,
+    0x84, 0x62, 0xa2, 0x82, 0xa2, 0xa8, 0x48, 0x42, 0x62, 0x22, 0x62, 0x22, 0x62, 0x22, 0x62, 0x46,
+    0x66, 0xfd, 0xa2, 0xaa, 0x2a, 0x28, 0x2a, 0x28, 0x2a, 0x28, 0x2a, 0x2a, 0x2a, 0x2a, 0x2a, 0x2f,
+    0x04, 0xf6, 0x66, 0x42, 0x62, 0x22, 0x62, 0x22, 0x62, 0x22, 0x62, 0x46, 0x66, 0x42, 0x62, 0x22,
+    0x62, 0x22, 0x62, 0x22, 0x62, 0x46, 0x66, 0xff, 0x66, 0x64, 0x26, 0x22, 0x26, 0x22, 0x26, 0x22,
+    0x26, 0x24, 0x84, 0x8a, 0x2a, 0x28, 0x2a, 0x26, 0x48, 0x4f, 0x02, 0xf0, 0xf0, 0x94, 0x84, 0x84,
+    0x84, 0xf0, 0xf0, 0x24, 0x84, 0x84, 0x84, 0xf0, 0xf0, 0xbf, 0x0f, 0x09, 0x48, 0x48, 0x48, 0x4f,
+    0x0f, 0x02, 0x48, 0x4a, 0x2a, 0x28, 0x2a, 0x2f, 0x04, 0xf0, 0x42, 0xa2, 0x82, 0xa2, 0x82, 0xa2,
+    0x82, 0xa2, 0xc2, 0xa2, 0xc2, 0xa2, 0xc2, 0xa2, 0xff, 0x0f, 0x0f, 0x0f, 0x01, 0xa2, 0xaf, 0x0b,
+    0xa2, 0xaf, 0x0f, 0x0f, 0x0f, 0x01, 0xf2, 0xa2, 0xc2, 0xa2, 0xc2, 0xa2, 0xc2, 0xa2, 0x82, 0xa2,
+    0x82, 0xa2, 0x82, 0xa2, 0xf0, 0x4f, 0x66, 0x64, 0x26, 0x22, 0x26, 0x2a, 0x2a, 0x28, 0x2a, 0x28,
+    0x2a, 0x2f, 0x0f, 0x04, 0x2a, 0x2f, 0x02, 0xf6, 0x66, 0x42, 0x62, 0x22, 0x62, 0xa2, 0xa2, 0x44,
+    0x22, 0x44, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x46,
+    0x66, 0xff, 0x66, 0x64, 0x26, 0x22, 0x26, 0x22, 0x26, 0x22, 0x26, 0x22, 0x26, 0x22, 0x26, 0x22,
+    0xa2, 0xa2, 0x26, 0x22, 0x26, 0x22, 0x26, 0x22, 0x26, 0x2d, 0xd8, 0x48, 0x42, 0x62, 0x22, 0x62,
+    0x22, 0x62, 0x22, 0x62, 0x28, 0x48, 0x42, 0x62, 0x22, 0x62, 0x22, 0x62, 0x22, 0x62, 0x28, 0x48,
+    0xff, 0x66, 0x64, 0x26, 0x22, 0x26, 0x22, 0x2a, 0x2a, 0x2a, 0x2a, 0x2a, 0x2a, 0x26, 0x22, 0x26,
+    0x24, 0x66, 0x6f, 0xd6, 0x66, 0x62, 0x42, 0x42, 0x42, 0x42, 0x62, 0x22, 0x62, 0x22, 0x62, 0x22,
+    0x62, 0x22, 0x62, 0x22, 0x62, 0x22, 0x42, 0x42, 0x42, 0x46, 0x66, 0xf0, 0x2d, 0xa2, 0xa2, 0x2a,
+    0x2a, 0x2a, 0x2a, 0x84, 0x84, 0x2a, 0x2a, 0x2a, 0x2a, 0xa2, 0xad, 0xda, 0x2a, 0x22, 0xa2, 0xa2,
+    0xa2, 0xa8, 0x48, 0x42, 0xa2, 0xa2, 0xa2, 0xa2, 0xa2, 0xf0, 0x6f, 0x66, 0x64, 0x26, 0x22, 0x26,
+    0x22, 0x2a, 0x2a, 0x22, 0x62, 0x22, 0x62, 0x26, 0x22, 0x26, 0x22, 0x26, 0x22, 0x26, 0x24, 0x84,
+    0x8d, 0xd2, 0x62, 0x22, 0x62, 0x22, 0x62, 0x22, 0x62, 0x22, 0x62, 0x22, 0x62, 0x2a, 0x2a, 0x22,
+    0x62, 0x22, 0x62, 0x22, 0x62, 0x22, 0x62, 0x22, 0x62, 0x22, 0x62, 0xdf, 0x66, 0x68, 0x2a, 0x2a,
+    0x2a, 0x2a, 0x2a, 0x2a, 0x2a, 0x2a, 0x2a, 0x28, 0x66, 0x6f, 0xf0, 0x26, 0x66, 0x82, 0xa2, 0xa2,
+    0xa2, 0xa2, 0xa2, 0xa2, 0xa2, 0x42, 0x42, 0x42, 0x42, 0x64, 0x84, 0xf0, 0x2d, 0x26, 0x22, 0x26,
+    0x22, 0x24, 0x24, 0x24, 0x24, 0x22, 0x26, 0x22, 0x26, 0x48, 0x48, 0x22, 0x26, 0x22, 0x26, 0x24,
+    0x24, 0x24, 0x24, 0x26, 0x22, 0x26, 0x2d, 0xd2, 0xa2, 0xa2, 0xa2, 0xa2, 0xa2, 0xa2, 0xa2, 0xa2,
+    0xa2, 0xa2, 0xa2, 0xaa, 0x2a, 0xdd, 0x26, 0x22, 0x26, 0x22, 0x42, 0x42, 0x42, 0x42, 0x22, 0x22,
+    0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x26, 0x22, 0x26, 0x22, 0x26, 0x22,
+    0x26, 0x22, 0x26, 0x22, 0x26, 0x2d, 0xd2, 0x62, 0x22, 0x62, 0x22, 0x62, 0x22, 0x62, 0x24, 0x42,
+    0x24, 0x42, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x44, 0x22, 0x44, 0x22, 0x62, 0x22, 0x62,
+    0x22, 0x62, 0x22, 0x62, 0xdf, 0x66, 0x64, 0x26, 0x22, 0x26, 0x22, 0x26, 0x22, 0x26, 0x22, 0x26,
+    0x22, 0x26, 0x22, 0x26, 0x22, 0x26, 0x22, 0x26, 0x22, 0x26, 0x24, 0x66, 0x6f, 0xd8, 0x48, 0x42,
+    0x62, 0x22, 0x62, 0x22, 0x62, 0x22, 0x62, 0x28, 0x48, 0x42, 0xa2, 0xa2, 0xa2, 0xa2, 0xa2, 0xf0,
+    0x6f, 0x66, 0x64, 0x26, 0x22, 0x26, 0x22, 0x26, 0x22, 0x26, 0x22, 0x26, 0x22, 0x26, 0x22, 0x22,
+    0x22, 0x22, 0x22, 0x22, 0x22, 0x24, 0x24, 0x24, 0x26, 0x42, 0x24, 0x42, 0x2d, 0xd8, 0x48, 0x42,
+    0x62, 0x22, 0x62, 0x22, 0x62, 0x22, 0x62, 0x28, 0x48, 0x42, 0x22, 0x62, 0x22, 0x62, 0x42, 0x42,
+    0x42, 0x42, 0x62, 0x22, 0x62, 0xdf, 0x84, 0x82, 0x2a, 0x2a, 0x2a, 0x2c, 0x66, 0x6c, 0x2a, 0x2a,
+    0x2a, 0x22, 0x84, 0x8f, 0xda, 0x2a, 0x62, 0xa2, 0xa2, 0xa2, 0xa2, 0xa2, 0xa2, 0xa2, 0xa2, 0xa2,
+    0xa2, 0xa2, 0xf0, 0x2d, 0x26, 0x22, 0x26, 0x22, 0x26, 0x22, 0x26, 0x22, 0x26, 0x22, 0x26, 0x22,
+    0x26, 0x22, 0x26, 0x22, 0x26, 0x22, 0x26, 0x22, 0x26, 0x22, 0x26, 0x24, 0x66, 0x6f, 0xd2, 0x62,
+    0x22, 0x62, 0x22, 0x62, 0x22, 0x62, 0x22, 0x62, 0x22, 0x62, 0x22, 0x62, 0x22, 0x62, 0x22, 0x62,
+    0x22, 0x62, 0x42, 0x22, 0x62, 0x22, 0x82, 0xa2, 0xf0, 0x2d, 0x26, 0x22, 0x26, 0x22, 0x26, 0x22,
+    0x26, 0x22, 0x26, 0x22, 0x26, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22,
+    0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x24, 0x22, 0x26, 0x22, 0x2f, 0xd2, 0x62, 0x22, 0x62,
+    0x22, 0x62, 0x22, 0x62, 0x42, 0x22, 0x62, 0x22, 0x82, 0xa2, 0x82, 0x22, 0x62, 0x22, 0x42, 0x62,
+    0x22, 0x62, 0x22, 0x62, 0x22, 0x62, 0xdd, 0x26, 0x22, 0x26, 0x22, 0x26, 0x22, 0x26, 0x22, 0x26,
+    0x22, 0x26, 0x24, 0x22, 0x26, 0x22, 0x28, 0x2a, 0x2a, 0x2a, 0x2a, 0x2a, 0x2f, 0x02, 0xda, 0x2a,
+    0xa2, 0xa2, 0x82, 0xa2, 0x82, 0xa2, 0x82, 0xa2, 0x82, 0xa2, 0xaa, 0x2a, 0xdf, 0x66, 0x66, 0x2a,
+    0x2a, 0x2a, 0x2a, 0x2a, 0x2a, 0x2a, 0x2a, 0x2a, 0x2a, 0x66, 0x6f, 0xf0, 0xf0, 0x72, 0xa2, 0xc2,
+    0xa2, 0xc2, 0xa2, 0xc2, 0xa2, 0xc2, 0xa2, 0xf0, 0xf0, 0x7f, 0x66, 0x6a, 0x2a, 0x2a, 0x2a, 0x2a,
+    0x2a, 0x2a, 0x2a, 0x2a, 0x2a, 0x26, 0x66, 0x6f, 0xf0, 0x22, 0xa2, 0x82, 0x22, 0x62, 0x22, 0x42,
+    0x62, 0x22, 0x62, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0xf0, 0x4f, 0x0f, 0x0f, 0x0f, 0x0f, 0x0f,
+    0x0f, 0x0f, 0x0f, 0x0f, 0x07, 0xa2, 0xad, 0xf2, 0xa2, 0xc2, 0xa2, 0xc2, 0xa2, 0xf0, 0xf0, 0xf0,
+    0xf0, 0xf0, 0xf0, 0xf0, 0x6f, 0x0f, 0x0f, 0x0f, 0x03, 0x66, 0x6c, 0x2a, 0x24, 0x84, 0x82, 0x26,
+    0x22, 0x26, 0x24, 0x84, 0x8d, 0xd2, 0xa2, 0xa2, 0xa2, 0xa2, 0x24, 0x42, 0x24, 0x44, 0x42, 0x24,
+    0x42, 0x22, 0x62, 0x22, 0x62, 0x22, 0x62, 0x22, 0x62, 0x28, 0x48, 0xff, 0x0f, 0x0f, 0x0f, 0x03,
+    0x66, 0x64, 0x2a, 0x2a, 0x2a, 0x2a, 0x26, 0x22, 0x26, 0x24, 0x66, 0x6f, 0xf0, 0x62, 0xa2, 0xa2,
+    0xa2, 0x44, 0x22, 0x44, 0x22, 0x22, 0x44, 0x22, 0x44, 0x22, 0x62, 0x22, 0x62, 0x22, 0x62, 0x22,
+    0x62, 0x48, 0x48, 0xdf, 0x0f, 0x0f, 0x0f, 0x03, 0x66, 0x64, 0x26, 0x22, 0x26, 0x22, 0xa2, 0xa2,
+    0x2a, 0x2c, 0x66, 0x6f, 0xf0, 0x24, 0x84, 0x62, 0x42, 0x42, 0x42, 0x42, 0xa2, 0x86, 0x66, 0x82,
+    0xa2, 0xa2, 0xa2, 0xa2, 0xa2, 0xf0, 0x4f, 0x0f, 0x09, 0x84, 0x82, 0x26, 0x22, 0x26, 0x22, 0x26,
+    0x22, 0x26, 0x24, 0x84, 0x8a, 0x2a, 0x24, 0x66, 0x6f, 0xd2, 0xa2, 0xa2, 0xa2, 0xa2, 0x24, 0x42,
+    0x24, 0x44, 0x42, 0x24, 0x42, 0x22, 0x62, 0x22, 0x62, 0x22, 0x62, 0x22, 0x62, 0x22, 0x62, 0x22,
+    0x62, 0xdf, 0x02, 0x2a, 0x2f, 0x0f, 0x02, 0x48, 0x4a, 0x2a, 0x2a, 0x2a, 0x2a, 0x2a, 0x28, 0x66,
+    0x6f, 0xf0, 0x42, 0xa2, 0xf0, 0xf0, 0x24, 0x84, 0xa2, 0xa2, 0xa2, 0xa2, 0x42, 0x42, 0x42, 0x42,
+    0x64, 0x84, 0xf0, 0x2d, 0x2a, 0x2a, 0x2a, 0x2a, 0x24, 0x24, 0x24, 0x24, 0x22, 0x26, 0x22, 0x26,
+    0x48, 0x48, 0x22, 0x26, 0x22, 0x26, 0x24, 0x24, 0x24, 0x2f, 0xf4, 0x84, 0xa2, 0xa2, 0xa2, 0xa2,
+    0xa2, 0xa2, 0xa2, 0xa2, 0xa2, 0xa2, 0x86, 0x66, 0xff, 0x0f, 0x0f, 0x0f, 0x01, 0x42, 0x24, 0x42,
+    0x24, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x26, 0x22, 0x26,
+    0x22, 0x26, 0x22, 0x26, 0x2d, 0xf0, 0xf0, 0xf0, 0xf0, 0x12, 0x24, 0x42, 0x24, 0x44, 0x42, 0x24,
+    0x42, 0x22, 0x62, 0x22, 0x62, 0x22, 0x62, 0x22, 0x62, 0x22, 0x62, 0x22, 0x62, 0xdf, 0x0f, 0x0f,
+    0x0f, 0x03, 0x66, 0x64, 0x26, 0x22, 0x26, 0x22, 0x26, 0x22, 0x26, 0x22, 0x26, 0x22, 0x26, 0x24,
+    0x66, 0x6f, 0xf0, 0xf0, 0xf0, 0xf0, 0x18, 0x48, 0x42, 0x62, 0x22, 0x62, 0x28, 0x48, 0x42, 0xa2,
+    0xa2, 0xa2, 0xf0, 0x6f, 0x0f, 0x0f, 0x0f, 0x03, 0x42, 0x24, 0x42, 0x22, 0x24, 0x42, 0x24, 0x44,
+    0x84, 0x8a, 0x2a, 0x2a, 0x2a, 0x2d, 0xf0, 0xf0, 0xf0, 0xf0, 0x12, 0x24, 0x42, 0x24, 0x44, 0x42,
+    0x24, 0x42, 0x22, 0xa2, 0xa2, 0xa2, 0xa2, 0xa2, 0xf0, 0x6f, 0x0f, 0x0f, 0x0f, 0x03, 0x66, 0x64,
+    0x2a, 0x2c, 0x66, 0x6c, 0x2a, 0x22, 0x84, 0x8f, 0xf2, 0xa2, 0xa2, 0xa2, 0x86, 0x66, 0x82, 0xa2,
+    0xa2, 0xa2, 0xa2, 0x42, 0x42, 0x42, 0x64, 0x84, 0xff, 0x0f, 0x0f, 0x0f, 0x01, 0x26, 0x22, 0x26,
+    0x22, 0x26, 0x22, 0x26, 0x22, 0x26, 0x22, 0x26, 0x22, 0x24, 0x42, 0x24, 0x44, 0x42, 0x24, 0x42,
+    0x2d, 0xf0, 0xf0, 0xf0, 0xf0, 0x12, 0x62, 0x22, 0x62, 0x22, 0x62, 0x22, 0x62, 0x22, 0x62, 0x22,
+    0x62, 0x42, 0x22, 0x62, 0x22, 0x82, 0xa2, 0xf0, 0x2f, 0x0f, 0x0f, 0x0f, 0x01, 0x26, 0x22, 0x26,
+    0x22, 0x26, 0x22, 0x26, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22,
+    0x24, 0x22, 0x26, 0x22, 0x2f, 0xf0, 0xf0, 0xf0, 0xf0, 0x12, 0x62, 0x22, 0x62, 0x42, 0x22, 0x62,
+    0x22, 0x82, 0xa2, 0x82, 0x22, 0x62, 0x22, 0x42, 0x62, 0x22, 0x62, 0xdf, 0x0f, 0x0f, 0x0f, 0x01,
+    0x26, 0x22, 0x26, 0x22, 0x26, 0x22, 0x26, 0x24, 0x84, 0x8a, 0x2a, 0x24, 0x66, 0x6f, 0xf0, 0xf0,
+    0xf0, 0xf0, 0x1a, 0x2a, 0x82, 0xa2, 0x82, 0xa2, 0x82, 0xa2, 0x8a, 0x2a, 0xdf, 0x04, 0x2a, 0x28,
+    0x2a, 0x2a, 0x2a, 0x28, 0x2a, 0x2c, 0x2a, 0x2a, 0x2a, 0x2c, 0x2a, 0x2f, 0xf0, 0x22, 0xa2, 0xa2,
+    0xa2, 0xa2, 0xa2, 0xa2, 0xa2, 0xa2, 0xa2, 0xa2, 0xa2, 0xa2, 0xa2, 0xf0, 0x2f, 0x2a, 0x2c, 0x2a,
+    0x2a, 0x2a, 0x2c, 0x2a, 0x28, 0x2a, 0x2a, 0x2a, 0x28, 0x2a, 0x2f, 0x04, 0xf0, 0xf0, 0xf0, 0xf0,
+    0x32, 0xa2, 0x82, 0x22, 0x22, 0x22, 0x22, 0x22, 0x82, 0xa2, 0xf0, 0xf0, 0xf0, 0xf0, 0x30,
+];
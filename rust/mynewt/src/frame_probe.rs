@@ -0,0 +1,106 @@
+//! Frame Time Probes for PineTime. Timestamps the stages of each UI frame with the CPU timer and collects them
+//! in a `frame_time::FrameTimer`. The touch driver marks the touch interrupt and the dispatch, the UI marks the
+//! widget update and paint, and `spi.rs` reports the time spent enqueueing SPI requests, the time spent waiting for
+//! the SPI queue and the completion of the last SPI transfer. The stage timings are printed with `print_frame_stats()`
+//! or read over Bluetooth LE.
+use core::sync::atomic::{ AtomicU32, Ordering };
+use crate::{
+    frame_time::{ self, FrameSummary, FrameTimer, Stage, HISTORY, METRICS, METRIC_NAMES, SUMMARY_SIZE },
+    kernel::os,
+    sys::console,
+};
+
+/// Probes and timings of the frames. Updated from the UI, touch and SPI tasks with interrupts disabled.
+static mut FRAME_TIMER: FrameTimer = FrameTimer::new();
+
+/// Number of SPI requests enqueued, time spent enqueueing them and time spent waiting for the SPI queue, not yet
+/// added to `FRAME_TIMER`. Updated by `spi.rs` without disabling interrupts, added by the next `with_timer()`.
+static ENQUEUED: AtomicU32    = AtomicU32::new(0);
+static ENQUEUE_US: AtomicU32  = AtomicU32::new(0);
+static SPI_WAIT_US: AtomicU32 = AtomicU32::new(0);
+
+/// Mark the end of the stage of the current frame now
+pub fn probe(stage: Stage) {
+    probe_at(stage, now_us());
+}
+
+/// Mark the end of the stage of the current frame at the time returned by `now_us()`, e.g. saved by an interrupt handler
+pub fn probe_at(stage: Stage, time_us: u32) {
+    with_timer(|timer| timer.mark(stage, time_us));
+}
+
+/// Add the time spent enqueueing an SPI request to the current frame. Called by `spi.rs`.
+pub fn enqueue_time(duration_us: u32) {
+    //  Count the request first, so that the SPI queue is never seen idle after a request without its count
+    ENQUEUED.fetch_add(1, Ordering::Relaxed);
+    ENQUEUE_US.fetch_add(duration_us, Ordering::Relaxed);
+}
+
+/// Add the time spent waiting for the SPI queue to have space to the current frame. Called by `spi.rs`.
+pub fn spi_wait_time(duration_us: u32) {
+    SPI_WAIT_US.fetch_add(duration_us, Ordering::Relaxed);
+}
+
+/// Complete the painted frames when the last SPI transfer completed at `time_us`. Called by `spi.rs`.
+pub fn spi_idle(time_us: u32) {
+    with_timer(|timer| timer.spi_idle(time_us));
+}
+
+/// Return the median, 90th percentile and max of each stage over the recent frames. The values of each stage are
+/// copied with interrupts disabled, then sorted with interrupts enabled.
+pub fn frame_stats() -> FrameSummary {
+    let mut summary = with_timer(|timer| timer.counts());
+    for metric in 0 .. METRICS {
+        let mut values = [0_u32; HISTORY];
+        let count = with_timer(|timer| timer.values(metric, &mut values));
+        summary.percentiles[metric] = frame_time::percentiles(&mut values[.. count]);
+    }
+    summary
+}
+
+/// Print the frame count and the median, 90th percentile and max of each stage in microseconds
+pub fn print_frame_stats() {
+    let summary = frame_stats();
+    console::print("frames: "); console::printint(summary.frames as i32);
+    console::print(", dropped: "); console::printint(summary.dropped as i32); console::print("\n");
+    for metric in 0 .. METRICS {
+        let [ median, p90, max ] = summary.percentiles[metric];
+        console::print(METRIC_NAMES[metric]);
+        console::print(" us p50: "); console::printint(median as i32);
+        console::print(", p90: ");   console::printint(p90 as i32);
+        console::print(", max: ");   console::printint(max as i32); console::print("\n");
+    }
+    console::flush();
+}
+
+/// Current time in microseconds. Wraps around every 71 minutes, the resolution is about 31 microseconds.
+pub fn now_us() -> u32 {
+    cputime_to_us(unsafe { os::os_cputime_get32() })
+}
+
+/// Convert CPU timer ticks to microseconds at the `OS_CPUTIME_FREQ` configured in Mynewt
+pub fn cputime_to_us(ticks: u32) -> u32 {
+    unsafe { os::os_cputime_ticks_to_usecs(ticks) }
+}
+
+/// Call the function with the frame timer, with interrupts disabled. The SPI requests enqueued and the SPI wait
+/// since the last call are added to the frame in progress first.
+fn with_timer<T>(f: impl FnOnce(&mut FrameTimer) -> T) -> T {
+    let sr = unsafe { os::os_arch_save_sr() };
+    let timer = unsafe { &mut FRAME_TIMER };
+    let requests = ENQUEUED.swap(0, Ordering::Relaxed);
+    timer.enqueue_many(requests, ENQUEUE_US.swap(0, Ordering::Relaxed));
+    timer.wait(SPI_WAIT_US.swap(0, Ordering::Relaxed));
+    let result = f(timer);
+    unsafe { os::os_arch_restore_sr(sr) };
+    result
+}
+
+/// Encode the frame stats for the Bluetooth LE characteristic in `apps/my_sensor_app/src/ble.c`,
+/// see `FrameSummary::encode()`. Returns the number of bytes written, or -1 if the buffer is too small.
+#[no_mangle]
+extern "C" fn frame_stats_read(buf: *mut u8, len: u16) -> i32 {
+    if buf.is_null() || (len as usize) < SUMMARY_SIZE { return -1; }
+    let buf = unsafe { core::slice::from_raw_parts_mut(buf, len as usize) };
+    frame_stats().encode(buf) as i32
+}
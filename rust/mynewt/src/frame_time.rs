@@ -0,0 +1,250 @@
+//! Frame Time Instrumentation. Probes mark the end of each stage of a UI frame, from the touch interrupt to the
+//! completion of the last SPI transfer of the frame (touch-to-photon latency). `FrameTimer` turns the marks into
+//! per-frame stage timings and keeps the last `HISTORY` frames for percentiles. Times are in microseconds, passed
+//! in by the caller, so that the same code runs on PineTime (see `frame_probe.rs`) and on the host (see `display-host`).
+//!
+//! A stage that is not marked is counted in the next stage that is marked, e.g. without the widget update and paint
+//! probes, layout and rasterization are counted in the SPI stage. Time spent enqueueing SPI requests
+//! (mbuf allocation and copying in `spi_noblock_write()`) and time spent waiting for the SPI queue to have space
+//! are accumulated separately and subtracted from the paint stage.
+
+/// Stages of a frame, in order. Each probe marks the end of the stage.
+#[derive(Clone, Copy, Debug, PartialEq)]
+pub enum Stage {
+    /// Touch interrupt. Starts a frame triggered by a touch.
+    Touch    = 0,
+    /// Touch event dispatched to the UI
+    Dispatch = 1,
+    /// Widgets updated and laid out
+    Update   = 2,
+    /// Widgets painted and every SPI request of the frame enqueued
+    Paint    = 3,
+}
+
+/// Number of stages that are marked by probes
+const STAGES: usize = 4;
+
+/// Metrics of a frame, in the order of `FrameTimes`
+pub const METRICS: usize = 7;
+
+/// Names of the metrics, for printing
+pub const METRIC_NAMES: [&str; METRICS] = [ "dispatch", "update", "paint", "enqueue", "spi_wait", "spi", "total" ];
+
+/// Number of frames kept for percentiles
+pub const HISTORY: usize = 32;
+
+/// Max number of painted frames waiting for the SPI transfers to complete
+const FLUSHING: usize = 2;
+
+/// Durations of a completed frame in microseconds, in the order of `METRIC_NAMES`:
+/// touch to dispatch, dispatch to update, update to paint (excluding enqueue and SPI wait), enqueue, SPI wait,
+/// paint to SPI complete, total
+pub type FrameTimes = [u32; METRICS];
+
+/// Percentiles of each metric over the last `HISTORY` frames
+#[derive(Clone, Copy, Debug, Default)]
+pub struct FrameSummary {
+    /// Number of frames completed
+    pub frames: u32,
+    /// Number of painted frames dropped because too many were waiting for the SPI transfers
+    pub dropped: u32,
+    /// Median, 90th percentile and max of each metric in microseconds
+    pub percentiles: [[u32; 3]; METRICS],
+}
+
+/// Size of `FrameSummary::encode()`
+pub const SUMMARY_SIZE: usize = 8 + METRICS * 3 * 4;
+
+impl FrameSummary {
+    /// Encode the summary as little-endian `u32`: frames, dropped, then median, 90th percentile and max of each metric.
+    /// Returns the number of bytes written, 0 if the buffer is too small.
+    pub fn encode(&self, buf: &mut [u8]) -> usize {
+        if buf.len() < SUMMARY_SIZE { return 0; }
+        let mut pos = 0;
+        let mut put = |value: u32| {
+            buf[pos .. pos + 4].copy_from_slice(&value.to_le_bytes());
+            pos += 4;
+        };
+        put(self.frames);
+        put(self.dropped);
+        for metric in &self.percentiles {
+            for value in metric { put(*value); }
+        }
+        SUMMARY_SIZE
+    }
+}
+
+/// Marks of a frame in progress
+#[derive(Clone, Copy)]
+struct Frame {
+    /// Time at the end of each stage, if marked
+    marks: [Option<u32>; STAGES],
+    /// Number of SPI requests enqueued
+    requests: u32,
+    /// Time spent enqueueing SPI requests
+    enqueue: u32,
+    /// Time spent waiting for the SPI queue to have space
+    wait: u32,
+}
+
+impl Frame {
+    const EMPTY: Frame = Frame { marks: [None; STAGES], requests: 0, enqueue: 0, wait: 0 };
+
+    /// Return true if no stage has been marked
+    fn is_empty(&self) -> bool {
+        self.marks.iter().all(|m| m.is_none())
+    }
+}
+
+/// Collects the probes of each frame and the timings of the last `HISTORY` frames
+pub struct FrameTimer {
+    /// Frame being dispatched, updated or painted
+    open: Frame,
+    /// Painted frames waiting for the SPI transfers to complete, oldest first
+    flushing: [Frame; FLUSHING],
+    /// Number of frames in `flushing`
+    flushing_len: usize,
+    /// True if SPI requests have been enqueued since the SPI queue was last empty
+    spi_busy: bool,
+    /// Timings of the last `HISTORY` frames, as a ring buffer
+    history: [FrameTimes; HISTORY],
+    /// Number of frames completed
+    frames: u32,
+    /// Number of painted frames dropped
+    dropped: u32,
+}
+
+impl FrameTimer {
+    /// Create a frame timer with no frames
+    pub const fn new() -> FrameTimer {
+        FrameTimer {
+            open:         Frame::EMPTY,
+            flushing:     [Frame::EMPTY; FLUSHING],
+            flushing_len: 0,
+            spi_busy:     false,
+            history:      [[0; METRICS]; HISTORY],
+            frames:       0,
+            dropped:      0,
+        }
+    }
+
+    /// Mark the end of the stage at time `now`. The first mark starts a frame, discarding any requests enqueued
+    /// before it. If the stage or a later stage has already been marked, the frame in progress was not painted
+    /// (e.g. a touch that is not a tap) and a new frame is started.
+    pub fn mark(&mut self, stage: Stage, now: u32) {
+        let i = stage as usize;
+        if self.open.is_empty() || self.open.marks[i ..].iter().any(|m| m.is_some()) { self.open = Frame::EMPTY; }
+        self.open.marks[i] = Some(now);
+        if stage != Stage::Paint { return; }
+        //  Frame is painted, wait for the SPI transfers to complete
+        if self.flushing_len == FLUSHING {
+            self.flushing.copy_within(1 .., 0);
+            self.flushing_len -= 1;
+            self.dropped += 1;
+        }
+        self.flushing[self.flushing_len] = self.open;
+        self.flushing_len += 1;
+        self.open = Frame::EMPTY;
+        //  If the SPI transfers completed before the paint probe, the frame is complete
+        if !self.spi_busy { self.spi_idle(now); }
+    }
+
+    /// Add the time spent enqueueing an SPI request to the frame in progress. Must be called before the request
+    /// is added to the SPI queue, so that `spi_idle()` for the request is called afterwards.
+    pub fn enqueue(&mut self, duration: u32) {
+        self.enqueue_many(1, duration);
+    }
+
+    /// Add the time spent enqueueing some SPI requests to the frame in progress, same as `enqueue()` for each request
+    pub fn enqueue_many(&mut self, requests: u32, duration: u32) {
+        if requests == 0 { return; }
+        self.spi_busy = true;
+        self.open.requests = self.open.requests.wrapping_add(requests);
+        self.open.enqueue  = self.open.enqueue.wrapping_add(duration);
+    }
+
+    /// Add the time spent waiting for the SPI queue to have space to the frame in progress
+    pub fn wait(&mut self, duration: u32) {
+        self.open.wait = self.open.wait.wrapping_add(duration);
+    }
+
+    /// Called at time `now` when the SPI queue is empty and the last transfer is complete. Completes the painted
+    /// frames. If the paint stage is not marked, the frame in progress is completed once it has enqueued requests.
+    pub fn spi_idle(&mut self, now: u32) {
+        self.spi_busy = false;
+        for i in 0 .. self.flushing_len {
+            let frame = self.flushing[i];
+            self.complete(&frame, now);
+        }
+        self.flushing_len = 0;
+        if self.open.is_empty() {
+            self.open = Frame::EMPTY;  //  Requests enqueued outside a frame are not timed
+        } else if self.open.marks[Stage::Update as usize].is_none() && self.open.requests > 0 {
+            let frame = self.open;
+            self.complete(&frame, now);
+            self.open = Frame::EMPTY;
+        }
+    }
+
+    /// Compute the timings of the frame and save them into the history
+    fn complete(&mut self, frame: &Frame, now: u32) {
+        let mut times = [0; METRICS];
+        let mut start = None;
+        let mut last = None;
+        for (i, mark) in frame.marks.iter().enumerate() {
+            if let Some(time) = mark {
+                //  Stage `i` ends metric `i - 1`, the touch interrupt only starts the frame
+                if let Some(prev) = last { times[i - 1] = time.wrapping_sub(prev); }
+                if start.is_none() { start = Some(*time); }
+                last = Some(*time);
+            }
+        }
+        let (start, last) = match (start, last) { (Some(s), Some(l)) => (s, l), _ => return };
+        //  Enqueue and SPI wait time is spent while painting, or before the SPI stage if the paint stage is not marked
+        times[3] = frame.enqueue;
+        times[4] = frame.wait;
+        times[5] = now.wrapping_sub(last);
+        let painted = if frame.marks[Stage::Paint as usize].is_some() { 2 } else { 5 };
+        times[painted] = times[painted].saturating_sub(frame.enqueue.wrapping_add(frame.wait));
+        times[6] = now.wrapping_sub(start);
+        self.history[self.frames as usize % HISTORY] = times;
+        self.frames = self.frames.wrapping_add(1);
+    }
+
+    /// Return the timings of the last completed frame, if any
+    pub fn last(&self) -> Option<FrameTimes> {
+        if self.frames == 0 { return None; }
+        Some(self.history[(self.frames as usize + HISTORY - 1) % HISTORY])
+    }
+
+    /// Return the median, 90th percentile and max of each metric over the last `HISTORY` frames
+    pub fn summary(&self) -> FrameSummary {
+        let mut summary = self.counts();
+        for metric in 0 .. METRICS {
+            let mut values = [0_u32; HISTORY];
+            let count = self.values(metric, &mut values);
+            summary.percentiles[metric] = percentiles(&mut values[.. count]);
+        }
+        summary
+    }
+
+    /// Return the number of frames completed and dropped, without percentiles
+    pub fn counts(&self) -> FrameSummary {
+        FrameSummary { frames: self.frames, dropped: self.dropped, percentiles: [[0; 3]; METRICS] }
+    }
+
+    /// Copy the values of the metric over the last `HISTORY` frames. Returns the number of values copied.
+    pub fn values(&self, metric: usize, values: &mut [u32; HISTORY]) -> usize {
+        let count = (self.frames as usize).min(HISTORY);
+        for (value, times) in values.iter_mut().zip(self.history[.. count].iter()) { *value = times[metric]; }
+        count
+    }
+}
+
+/// Sort the values and return the median, 90th percentile and max, or zeroes if there are no values
+pub fn percentiles(values: &mut [u32]) -> [u32; 3] {
+    let count = values.len();
+    if count == 0 { return [0; 3]; }
+    values.sort_unstable();
+    [ values[(count - 1) / 2], values[(count - 1) * 9 / 10], values[count - 1] ]
+}
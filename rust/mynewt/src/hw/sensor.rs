@@ -21,7 +21,8 @@ mod bindings;  //  Import `bindings.rs` containing the bindings
 pub use self::bindings::*;
 
 ///  Convert the sensor data received from Mynewt into a `SensorValue` for transmission, which includes the sensor data key. 
-///  `sensor_type` indicates the type of data in `sensor_data`.
+///  `sensor_type` indicates the type of data in `sensor_data`. The data is decoded in place in Rust, without calling the
+///  C helpers, so a multi-value record is unpacked without crossing the FFI for each value.
 #[allow(non_snake_case, unused_variables)]
 fn convert_sensor_data(sensor_data: sensor_data_ptr, sensor_key: &'static Strn, sensor_type: sensor_type_t) -> SensorValue {
     //  Construct and return a new `SensorValue` (without semicolon)
@@ -29,34 +30,10 @@ fn convert_sensor_data(sensor_data: sensor_data_ptr, sensor_key: &'static Strn,
         key: sensor_key,
         geo: SensorValueType::None,
         value: match sensor_type {
-            SENSOR_TYPE_AMBIENT_TEMPERATURE_RAW => {  //  If this is raw temperature...
-                //  Interpret the sensor data as a `sensor_temp_raw_data` struct that contains raw temp.
-                let mut rawtempdata = fill_zero!(sensor_temp_raw_data);
-                let rc = unsafe { get_temp_raw_data(sensor_data, &mut rawtempdata) };
-                assert_eq!(rc, 0, "rawtmp fail");
-                //  Check that the raw temperature data is valid.
-                assert_ne!(rawtempdata.strd_temp_raw_is_valid, 0, "bad rawtmp");                
-                //  Raw temperature data is valid.  Return it.
-                SensorValueType::Uint(rawtempdata.strd_temp_raw)  //  Raw Temperature in integer (0 to 4095)
-            }
-            #[cfg(feature = "use_float")]  //  If floating-point is enabled...
-            SENSOR_TYPE_GEOLOCATION => {   //  If sensor data is GPS geolocation...
-                //  Interpret the sensor data as a `sensor_geolocation_data` struct that contains GPS geolocation.
-                let mut geolocation = fill_zero!(sensor_geolocation_data);
-                let rc = unsafe { get_geolocation_data(sensor_data, &mut geolocation) };
-                assert_eq!(rc, 0, "geodata fail");
-                //  Check that the geolocation data is valid.
-                if  geolocation.sgd_latitude_is_valid  != 0 &&
-                    geolocation.sgd_longitude_is_valid != 0 &&
-                    geolocation.sgd_altitude_is_valid  != 0 {
-                    //  Geolocation data is valid.  Return it.
-                    SensorValueType::Geolocation {
-                        latitude:  geolocation.sgd_latitude,
-                        longitude: geolocation.sgd_longitude,
-                        altitude:  geolocation.sgd_altitude,
-                    }
-                } else { SensorValueType::None }  //  Geolocation data is invalid.  Maybe GPS is not ready.                 
-            }
+            //  If this is raw temperature: Integer from 0 to 4095, or `None` if not valid
+            SENSOR_TYPE_AMBIENT_TEMPERATURE_RAW => RawTemperature::decode(sensor_data),
+            //  If sensor data is GPS geolocation: Fixed-point coordinates, or `None` if GPS is not ready
+            SENSOR_TYPE_GEOLOCATION => Geolocation::decode(sensor_data),
             //  TODO: Convert other sensor types
             _ => { assert!(false, "sensor type"); SensorValueType::None }  //  Unknown type of sensor value
         }
@@ -121,8 +98,9 @@ pub fn new_sensor_listener(
     }
     assert!(arg < MAX_SENSOR_LISTENERS, "increase MAX_SENSOR_LISTENERS");  //  Too many listeners registered. Increase MAX_SENSOR_LISTENERS
     //  Create a Mynewt `sensor_listener` that wraps the allocated `sensor_listener_info`
+    //  Also listen for multi-value records, in case the driver returns several values per read
     let listener = sensor_listener {
-        sl_sensor_type: sensor_type,
+        sl_sensor_type: sensor_type | SENSOR_TYPE_MULTI,
         sl_func:        Some(wrap_sensor_listener),
         sl_arg:         arg as *mut c_void,
         ..fill_zero!(sensor_listener)
@@ -138,7 +116,8 @@ pub fn new_sensor_listener(
     Ok(listener)
 }
 
-///  Wrapped Sensor Listener that converts Mynewt `sensor_data` into our `sensor_value` format and calls the application's Listener Function
+///  Wrapped Sensor Listener that converts Mynewt `sensor_data` into our `sensor_value` format and calls the application's Listener Function.
+///  If `sensor_data` is a multi-value record (`SENSOR_TYPE_MULTI`), the Listener Function is called for each matching value in the record.
 extern "C" fn wrap_sensor_listener(
     sensor:        sensor_ptr,
     arg:           sensor_arg,
@@ -155,6 +134,28 @@ extern "C" fn wrap_sensor_listener(
     if sensor_data.is_null() { return SYS_EINVAL }  //  Exit if data is missing
     assert!(!sensor.is_null(), "null sensor");
 
+    //  If this is a single sensor value, convert and handle it
+    if sensor_type != SENSOR_TYPE_MULTI {
+        return call_sensor_value_func(&info, sensor_data, sensor_type);
+    }
+    //  Else handle each value in the multi-value record that matches the listener's sensor type
+    let multi = unsafe { &*(sensor_data as *const sensor_multi_data) };
+    let count = (multi.smd_count as usize).min(SENSOR_MULTI_MAX_VALUES);
+    let mut rc = 0;
+    for value in &multi.smd_values[..count] {
+        if value.smv_type & info.sensor_type == 0 || value.smv_data.is_null() { continue }  //  Skip values not requested by the listener
+        let res = call_sensor_value_func(&info, value.smv_data, value.smv_type);
+        if res != 0 { rc = res }  //  Remember the error but continue with the other values
+    }
+    rc
+}
+
+///  Convert the sensor data to sensor value and call the unwrapped listener function. Return 0 if successful.
+fn call_sensor_value_func(
+    info:          &sensor_listener_info,
+    sensor_data:   sensor_data_ptr,
+    sensor_type:   sensor_type_t
+) -> i32 {
     //  Convert the sensor data to sensor value
     let sensor_value = convert_sensor_data(sensor_data, info.sensor_key, sensor_type);
     if let SensorValueType::None = sensor_value.value { 
@@ -172,6 +173,209 @@ extern "C" fn wrap_sensor_listener(
     }
 }
 
+///  Sensor data type that is decoded in Rust, e.g. `RawTemperature`. Used by `static_sensor_listener()` to
+///  select the decoder at compile time.
+pub trait SensorDataType {
+    ///  Mynewt sensor type of the data, e.g. `SENSOR_TYPE_AMBIENT_TEMPERATURE_RAW`
+    const SENSOR_TYPE: sensor_type_t;
+    ///  Decode the sensor data returned by the driver. Return `SensorValueType::None` if the data is not valid.
+    fn decode(sensor_data: sensor_data_ptr) -> SensorValueType;
+}
+
+///  Raw temperature (integer from 0 to 4095) in a `sensor_temp_raw_data` struct
+pub struct RawTemperature;
+
+impl SensorDataType for RawTemperature {
+    const SENSOR_TYPE: sensor_type_t = SENSOR_TYPE_AMBIENT_TEMPERATURE_RAW;
+    fn decode(sensor_data: sensor_data_ptr) -> SensorValueType {
+        //  Read the packed struct in place instead of copying it with the C helper `get_temp_raw_data()`
+        let data = unsafe { core::ptr::read_unaligned(sensor_data as *const sensor_temp_raw_data) };
+        if data.strd_temp_raw_is_valid == 0 { return SensorValueType::None; }
+        SensorValueType::Uint(data.strd_temp_raw)
+    }
+}
+
+///  GPS geolocation in fixed-point in a `sensor_geolocation_data` struct
+pub struct Geolocation;
+
+impl SensorDataType for Geolocation {
+    const SENSOR_TYPE: sensor_type_t = SENSOR_TYPE_GEOLOCATION;
+    fn decode(sensor_data: sensor_data_ptr) -> SensorValueType {
+        //  Read the packed struct in place instead of copying it with the C helper `get_geolocation_data()`
+        let data = unsafe { core::ptr::read_unaligned(sensor_data as *const sensor_geolocation_data) };
+        if data.sgd_latitude_is_valid  == 0 ||
+           data.sgd_longitude_is_valid == 0 ||
+           data.sgd_altitude_is_valid  == 0 { return SensorValueType::None; }  //  Maybe GPS is not ready
+        SensorValueType::Geolocation {
+            latitude:  data.sgd_latitude_e7,
+            longitude: data.sgd_longitude_e7,
+            altitude:  data.sgd_altitude_cm,
+        }
+    }
+}
+
+///  Sensor listener that is dispatched at compile time. Unlike `new_sensor_listener()`, each listener gets its own
+///  Mynewt callback, so there is no lookup of `SENSOR_LISTENERS` for each reading.
+pub trait SensorListener {
+    ///  Type of sensor data to listen for
+    type Data: SensorDataType;
+    ///  Key (field name) of the sensor value for transmission, e.g. `t`
+    const SENSOR_KEY: &'static Strn;
+    ///  Handle the sensor value
+    fn handle(sensor_value: &SensorValue) -> MynewtResult<()>;
+}
+
+///  Return a new `sensor_listener` that decodes the sensor data with `L::Data` and calls `L::handle()`.
+///  Register it with `register_static_listener()`.
+pub fn static_sensor_listener<L: SensorListener>() -> sensor_listener {
+    assert!(!L::SENSOR_KEY.is_empty(), "missing sensor key");
+    //  Also listen for multi-value records, in case the driver returns several values per read
+    sensor_listener {
+        sl_sensor_type: <L::Data as SensorDataType>::SENSOR_TYPE | SENSOR_TYPE_MULTI,
+        sl_func:        Some(static_listener_func::<L>),
+        sl_arg:         core::ptr::null_mut(),
+        ..fill_zero!(sensor_listener)
+    }
+}
+
+///  Register a listener created by `static_sensor_listener()`. Mynewt keeps a pointer to the listener,
+///  so it must be static.
+pub fn register_static_listener(sensor: *mut sensor, listener: &'static mut sensor_listener) -> MynewtResult<()> {
+    assert!(!sensor.is_null(), "null sensor");
+    let rc = unsafe { sensor_register_listener(sensor, listener) };
+    if rc != 0 { return Err(MynewtError::from(rc)); }
+    Ok(())
+}
+
+///  Mynewt callback for the listener `L`. Decodes each value of type `L::Data` and calls `L::handle()`.
+extern "C" fn static_listener_func<L: SensorListener>(
+    sensor:        sensor_ptr,
+    _arg:          sensor_arg,
+    sensor_data:   sensor_data_ptr,
+    sensor_type:   sensor_type_t
+) -> i32 {
+    if sensor_data.is_null() { return SYS_EINVAL }  //  Exit if data is missing
+    assert!(!sensor.is_null(), "null sensor");
+    let data_type = <L::Data as SensorDataType>::SENSOR_TYPE;
+    //  If this is a single sensor value, decode and handle it
+    if sensor_type != SENSOR_TYPE_MULTI {
+        if sensor_type & data_type == 0 { return SYS_EINVAL }
+        return handle_static::<L>(sensor_data);
+    }
+    //  Else handle each value in the multi-value record that matches the listener's sensor type
+    let multi = unsafe { &*(sensor_data as *const sensor_multi_data) };
+    let count = (multi.smd_count as usize).min(SENSOR_MULTI_MAX_VALUES);
+    let mut rc = 0;
+    for value in &multi.smd_values[..count] {
+        if value.smv_type & data_type == 0 || value.smv_data.is_null() { continue }  //  Skip values not requested
+        let res = handle_static::<L>(value.smv_data);
+        if res != 0 { rc = res }  //  Remember the error but continue with the other values
+    }
+    rc
+}
+
+///  Decode the sensor data with `L::Data` and call `L::handle()`. Return 0 if successful.
+fn handle_static<L: SensorListener>(sensor_data: sensor_data_ptr) -> i32 {
+    let sensor_value = SensorValue {
+        key:   L::SENSOR_KEY,
+        geo:   SensorValueType::None,
+        value: <L::Data as SensorDataType>::decode(sensor_data),
+    };
+    if let SensorValueType::None = sensor_value.value { return SYS_EINVAL }  //  Exit if sensor is not ready
+    match L::handle(&sensor_value) {
+        Ok(()) => 0,
+        Err(_) => SYS_EINVAL,
+    }
+}
+
+///  Request for reading a sensor with `read_sensor_async()`. Must be static, because the Sensor Manager refers to it.
+pub struct SensorReadRequest {
+    ///  Runs the blocking `sensor_read()` in the Sensor Manager task
+    deferred:    crate::executor::Deferred,
+    ///  Sensor to be read
+    sensor:      sensor_ptr,
+    ///  Key of the sensor value, e.g. `t` for raw temperature
+    sensor_key:  Option<&'static Strn>,
+    ///  Type of the sensor value, e.g. `SENSOR_TYPE_AMBIENT_TEMPERATURE_RAW`
+    sensor_type: sensor_type_t,
+    ///  Sensor value read
+    value:       Option<SensorValue>,
+}
+
+impl SensorReadRequest {
+    ///  Create a sensor read request
+    pub const fn new() -> SensorReadRequest {
+        SensorReadRequest {
+            deferred:    crate::executor::Deferred::new(),
+            sensor:      core::ptr::null_mut(),
+            sensor_key:  None,
+            sensor_type: 0,
+            value:       None,
+        }
+    }
+}
+
+///  Read the sensor and complete with the sensor value, for use with `executor.rs`. `sensor_read()` blocks
+///  until the driver returns the data, so it runs in the Sensor Manager task while other futures continue to run.
+///  Returns `SYS_EBUSY` if the request is still running, `SYS_EAGAIN` if the sensor is not ready.
+pub async fn read_sensor_async(
+    request:     &'static mut SensorReadRequest,
+    sensor:      sensor_ptr,
+    sensor_key:  &'static Strn,
+    sensor_type: sensor_type_t
+) -> MynewtResult<SensorValue> {
+    assert!(!sensor.is_null(), "null sensor");
+    if request.deferred.is_busy() { return Err(MynewtError::SYS_EBUSY); }
+    request.sensor      = sensor;
+    request.sensor_key  = Some(sensor_key);
+    request.sensor_type = sensor_type;
+    request.value       = None;
+    //  The deferred call and the sensor data function refer to the request
+    let arg = request as *mut SensorReadRequest as Ptr;
+    let deferred = unsafe { &mut (*(arg as *mut SensorReadRequest)).deferred };
+    crate::executor::run_deferred(deferred, unsafe { sensor_mgr_evq_get() }, read_sensor_deferred, arg).await ? ;
+    request.value.take().ok_or(MynewtError::SYS_EAGAIN)
+}
+
+///  Read the sensor in the Sensor Manager task. Called by `read_sensor_async()`.
+fn read_sensor_deferred(arg: Ptr) -> MynewtResult<()> {
+    let request = unsafe { &mut *(arg as *mut SensorReadRequest) };
+    let timeout = 10_000;  //  Milliseconds
+    let rc = unsafe { sensor_read(request.sensor, request.sensor_type | SENSOR_TYPE_MULTI, Some(read_sensor_data), arg, timeout) };
+    if rc != 0 { return Err(MynewtError::SYS_EIO); }
+    Ok(())
+}
+
+///  Sensor data function for `read_sensor_deferred()`. Converts the first value of the requested type into a sensor value.
+extern "C" fn read_sensor_data(
+    sensor:        sensor_ptr,
+    arg:           sensor_arg,
+    sensor_data:   sensor_data_ptr,
+    sensor_type:   sensor_type_t
+) -> i32 {
+    let request = unsafe { &mut *(arg as *mut SensorReadRequest) };
+    let sensor_key = request.sensor_key.expect("missing sensor key");
+    if sensor_data.is_null() || request.value.is_some() { return SYS_EINVAL }
+    assert!(!sensor.is_null(), "null sensor");
+    //  Find the sensor data, which may be in a multi-value record
+    let (data, data_type) =
+        if sensor_type != SENSOR_TYPE_MULTI { (sensor_data, sensor_type) }
+        else {
+            let multi = unsafe { &*(sensor_data as *const sensor_multi_data) };
+            let count = (multi.smd_count as usize).min(SENSOR_MULTI_MAX_VALUES);
+            match multi.smd_values[..count].iter()
+                .find(|value| value.smv_type & request.sensor_type != 0 && !value.smv_data.is_null()) {
+                Some(value) => (value.smv_data, value.smv_type),
+                None => return SYS_EINVAL,  //  Requested type not in the record
+            }
+        };
+    //  Convert the sensor data to sensor value, unless the sensor is not ready
+    let sensor_value = convert_sensor_data(data, sensor_key, data_type);
+    if let SensorValueType::None = sensor_value.value { return SYS_EINVAL }
+    request.value = Some(sensor_value);
+    0
+}
+
 ///  Define the info needed for converting sensor data into sensor value and calling a listener function
 #[derive(Clone, Copy)]
 struct sensor_listener_info {
@@ -258,6 +462,23 @@ pub const SENSOR_TYPE_AMBIENT_TEMPERATURE_RAW: sensor_type_t =
     crate::libs::mynewt_rust::sensor_type_t_SENSOR_TYPE_USER_DEFINED_1;
 pub const SENSOR_TYPE_GEOLOCATION: sensor_type_t =
     crate::libs::mynewt_rust::sensor_type_t_SENSOR_TYPE_USER_DEFINED_2;
+///  Sensor type for multi-value records, which contain several sensor values returned by a single read.
+///  Must sync with libs/custom_sensor/include/custom_sensor/custom_sensor.h
+pub const SENSOR_TYPE_MULTI: sensor_type_t =
+    crate::libs::mynewt_rust::sensor_type_t_SENSOR_TYPE_USER_DEFINED_3;
+///  Sensor type for GPS satellites and HDOP.
+pub const SENSOR_TYPE_GPS_SATELLITES: sensor_type_t =
+    crate::libs::mynewt_rust::sensor_type_t_SENSOR_TYPE_USER_DEFINED_4;
+///  Sensor type for step count and wrist tilt from the accelerometer.
+pub const SENSOR_TYPE_ACTIVITY: sensor_type_t =
+    crate::libs::mynewt_rust::sensor_type_t_SENSOR_TYPE_USER_DEFINED_5;
+///  Sensor type for heart rate computed from the optical sensor.
+pub const SENSOR_TYPE_HEART_RATE: sensor_type_t =
+    crate::libs::mynewt_rust::sensor_type_t_SENSOR_TYPE_USER_DEFINED_6;
+
+///  Max number of sensor values in a multi-value record.
+///  Must sync with libs/custom_sensor/include/custom_sensor/custom_sensor.h
+pub const SENSOR_MULTI_MAX_VALUES: usize = 4;
 
 ///  Represents a decoded sensor data value. Since temperature may be integer (raw)
 ///  or float (computed), we use the struct to return both integer and float values.
@@ -293,9 +514,8 @@ pub enum SensorValueType {
     ///  32-bit float. For computed temp, contains the computed temp float value
     #[cfg(feature = "use_float")]  //  If floating-point is enabled...
     Float(f32),
-    ///  Geolocation
-    #[cfg(feature = "use_float")]  //  If floating-point is enabled...
-    Geolocation { latitude: f64, longitude: f64, altitude: f64 },
+    ///  Geolocation in fixed-point: latitude and longitude in 1e-7 degrees, altitude in centimetres
+    Geolocation { latitude: i32, longitude: i32, altitude: i32 },
 }
 
 ///  Represents a single temperature sensor raw value.
@@ -308,16 +528,16 @@ pub struct sensor_temp_raw_data {
     pub strd_temp_raw_is_valid: u8,  
 }
 
-///  Represents a GPS Geolocation.
+///  Represents a GPS Geolocation in fixed-point.
 ///  TODO: Must sync with libs/custom_sensor/include/custom_sensor/custom_sensor.h
 #[repr(C, packed)]  //  Common to C and Rust. Declare as packed because the C struct is packed.
 pub struct sensor_geolocation_data {   
-    ///  Latitude (degrees)
-    pub sgd_latitude: f64,
-    ///  Longitude (degrees)
-    pub sgd_longitude: f64,
-    ///  Altitude (metres)
-    pub sgd_altitude: f64,
+    ///  Latitude (1e-7 degrees)
+    pub sgd_latitude_e7: i32,
+    ///  Longitude (1e-7 degrees)
+    pub sgd_longitude_e7: i32,
+    ///  Altitude (centimetres)
+    pub sgd_altitude_cm: i32,
 
     ///  1 if latitude is valid
     pub sgd_latitude_is_valid: u8,
@@ -327,6 +547,26 @@ pub struct sensor_geolocation_data {
     pub sgd_altitude_is_valid: u8, 
 }
 
+///  Represents one sensor value in a multi-value record.
+///  Must sync with libs/custom_sensor/include/custom_sensor/custom_sensor.h
+#[repr(C)]  //  Common to C and Rust
+pub struct sensor_multi_value {
+    ///  Sensor type of the value, e.g. `SENSOR_TYPE_GEOLOCATION`
+    pub smv_type: sensor_type_t,
+    ///  Sensor data for the sensor type, e.g. `sensor_geolocation_data`
+    pub smv_data: sensor_data_ptr,
+}
+
+///  Represents a multi-value record passed to listeners with sensor type `SENSOR_TYPE_MULTI`.
+///  Must sync with libs/custom_sensor/include/custom_sensor/custom_sensor.h
+#[repr(C)]  //  Common to C and Rust
+pub struct sensor_multi_data {
+    ///  Number of values in `smd_values`
+    pub smd_count: u32,
+    ///  Sensor values
+    pub smd_values: [sensor_multi_value; SENSOR_MULTI_MAX_VALUES],
+}
+
 /// Points to a `sensor`.  Needed because `sensor` also refers to a namespace.
 pub type sensor_ptr = *mut sensor;
 /// Points to sensor arg passed by Mynewt to sensor listener
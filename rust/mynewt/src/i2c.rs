@@ -0,0 +1,123 @@
+//! Non-Blocking I2C Transaction API. Rust interface to `libs/i2c_queue`: transactions are submitted without waiting
+//! and executed one at a time by the I2C Task, which posts an event to the caller's Event Queue when each transaction
+//! is complete. A transaction writes some bytes (e.g. the register number) then reads some bytes after a repeated start.
+use crate::{
+    result::*,
+    executor::Signal,
+    hw::hal,
+    kernel::os,
+    Ptr,
+};
+
+/// I2C transaction, same as `struct i2c_txn` in `libs/i2c_queue/include/i2c_queue/i2c_queue.h`.
+/// Initialise with `fill_zero!(i2c_txn)`.
+#[repr(C)]
+#[allow(non_camel_case_types)]
+pub struct i2c_txn {
+    /// Internal: event posted to the I2C Task
+    pub ev:         os::os_event,
+    /// I2C interface number, e.g. 1
+    pub i2c_num:    u8,
+    /// 7-bit I2C address
+    pub address:    u8,
+    /// Number of bytes to write
+    pub write_len:  u16,
+    /// Number of bytes to read
+    pub read_len:   u16,
+    /// Timeout for each of the write and the read
+    pub timeout_ms: u16,
+    /// Bytes to write
+    pub write_buf:  *const u8,
+    /// Buffer for the bytes read
+    pub read_buf:   *mut u8,
+    /// If not null, called in the I2C Task when complete
+    pub cb:         Option<extern "C" fn(txn: *mut i2c_txn, arg: Ptr)>,
+    /// Argument for the callback
+    pub cb_arg:     Ptr,
+    /// If not null, `done_ev` is posted to this Event Queue when complete
+    pub done_evq:   *mut os::os_eventq,
+    /// Event to be posted when complete
+    pub done_ev:    *mut os::os_event,
+    /// Result: 0 if successful, else the HAL I2C error
+    pub rc:         i32,
+    /// 1 while the transaction is queued or executing
+    pub busy:       u8,
+}
+
+extern "C" {
+    fn i2c_txn_init(txn: *mut i2c_txn, i2c_num: u8, address: u8,
+        write_buf: *const u8, write_len: u16, read_buf: *mut u8, read_len: u16);
+    fn i2c_queue_submit(txn: *mut i2c_txn) -> i32;
+    fn i2c_queue_transfer(txn: *mut i2c_txn) -> i32;
+}
+
+/// Submit a transaction that writes `write` then reads into `read` from the I2C device at the 7-bit address.
+/// Returns without waiting. When the transaction is complete, `done_ev` is posted to `done_evq`: check the result
+/// with `i2c_result()`. Returns `SYS_EBUSY` if the transaction is still queued or executing.
+pub fn i2c_noblock_write_read(txn: &'static mut i2c_txn, i2c_num: u8, address: u8, write: &'static [u8], read: &'static mut [u8],
+    done_evq: &'static mut os::os_eventq, done_ev: &'static mut os::os_event) -> MynewtResult<()> {
+    if txn.busy != 0 { return Err(MynewtError::SYS_EBUSY); }
+    init_txn(txn, i2c_num, address, write, read) ? ;
+    txn.done_evq = done_evq;
+    txn.done_ev  = done_ev;
+    let rc = unsafe { i2c_queue_submit(txn) };
+    if rc != 0 { return Err(MynewtError::from(rc)); }
+    Ok(())
+}
+
+/// Submit a transaction that writes `write` then reads into `read`, and wait until it is complete.
+/// Other transactions continue to run while waiting. Must not be called from an interrupt handler.
+/// If the wait times out, the transaction is still queued, so the transaction and buffers must be static.
+pub fn i2c_write_read(txn: &'static mut i2c_txn, i2c_num: u8, address: u8, write: &'static [u8], read: &'static mut [u8]) -> MynewtResult<()> {
+    if txn.busy != 0 { return Err(MynewtError::SYS_EBUSY); }
+    init_txn(txn, i2c_num, address, write, read) ? ;
+    let rc = unsafe { i2c_queue_transfer(txn) };
+    if rc == os::SYS_ETIMEOUT { return Err(MynewtError::SYS_ETIMEOUT); }
+    if rc != 0 { return Err(hal_error(rc)); }
+    Ok(())
+}
+
+/// Submit a transaction that writes `write` then reads into `read`, and complete when the transaction is complete.
+/// For use with `executor.rs`: `done` is signalled by the I2C Task, so other futures continue to run while waiting.
+/// Returns `SYS_EBUSY` if the transaction is still queued or executing.
+pub async fn i2c_write_read_async(txn: &'static mut i2c_txn, i2c_num: u8, address: u8, write: &'static [u8],
+    read: &'static mut [u8], done: &'static Signal) -> MynewtResult<()> {
+    if txn.busy != 0 { return Err(MynewtError::SYS_EBUSY); }
+    init_txn(txn, i2c_num, address, write, read) ? ;
+    done.reset();
+    txn.cb     = Some(signal_done);
+    txn.cb_arg = done as *const Signal as Ptr;
+    let rc = unsafe { i2c_queue_submit(txn) };
+    if rc != 0 { return Err(MynewtError::from(rc)); }
+    done.wait().await;
+    i2c_result(txn)
+}
+
+/// Callback for `i2c_write_read_async()`, called in the I2C Task when the transaction is complete
+extern "C" fn signal_done(_txn: *mut i2c_txn, arg: Ptr) {
+    let done = arg as *const Signal;
+    unsafe { (*done).signal() };
+}
+
+/// Return the result of the completed transaction
+pub fn i2c_result(txn: &i2c_txn) -> MynewtResult<()> {
+    if txn.rc != 0 { return Err(hal_error(txn.rc)); }
+    Ok(())
+}
+
+/// Set up the transaction. The buffers must remain valid until it is complete.
+fn init_txn(txn: &mut i2c_txn, i2c_num: u8, address: u8, write: &[u8], read: &mut [u8]) -> MynewtResult<()> {
+    if address >= 128 || write.len() > u16::max_value() as usize || read.len() > u16::max_value() as usize ||
+        write.len() + read.len() == 0 { return Err(MynewtError::SYS_EINVAL); }
+    unsafe { i2c_txn_init(txn, i2c_num, address, write.as_ptr(), write.len() as u16, read.as_mut_ptr(), read.len() as u16) };
+    Ok(())
+}
+
+/// Convert a HAL I2C error (positive) or Mynewt error (negative) to `MynewtError`
+fn hal_error(rc: i32) -> MynewtError {
+    match rc as u32 {
+        hal::HAL_I2C_ERR_TIMEOUT => MynewtError::SYS_ETIMEOUT,
+        1 ..= 0xff => MynewtError::SYS_EIO,  //  Other HAL I2C errors, e.g. NACK
+        _ => MynewtError::from(rc),
+    }
+}
@@ -0,0 +1,131 @@
+//! Image Streaming from flash. Images are stored in flash in a compact run-length encoded format, created by the
+//! encoder in `display-host`, and decoded one row at a time straight into the display window. There is no frame buffer:
+//! only one row of pixels is kept in RAM. Images may be clipped, so that a partial redraw decodes only the rows it needs.
+//!
+//! Format, little-endian: `"PTI1"`, width (u16), height (u16), palette size (u16), index size (u16),
+//! palette (RGB565 colours, most significant byte first), index (u32 offset of the packets of every `ROWS_PER_INDEX`
+//! rows, from the end of the index), then the packets of each row. Packets don't cross rows. Packet header `n < 0x80`:
+//! the next pixel is repeated `n + 1` times. Packet header `n >= 0x80`: `n - 0x7F` different pixels follow.
+//! A pixel is a palette index (1 byte) if the image has a palette, else an RGB565 colour (2 bytes, most significant byte first).
+use crate::{
+    result::*,
+    display::DisplayBus,
+    dirty::{ Rect, DISPLAY_SIZE },
+};
+
+/// First 4 bytes of an image
+pub const MAGIC: [u8; 4] = *b"PTI1";
+
+/// Size of the header before the palette
+pub const HEADER_SIZE: usize = 12;
+
+/// Number of rows between index entries. The decoder skips at most `ROWS_PER_INDEX - 1` rows to reach a clipped row.
+pub const ROWS_PER_INDEX: u16 = 8;
+
+/// Max number of pixels in a packet
+pub const MAX_PACKET: usize = 128;
+
+/// Image stored in flash
+pub struct Image<'a> {
+    /// Width in pixels, up to the display width
+    pub width: u16,
+    /// Height in pixels
+    pub height: u16,
+    /// RGB565 colours, 2 bytes each. Empty if the pixels are RGB565 colours.
+    palette: &'a [u8],
+    /// Offsets of the rows in `packets`, 4 bytes each
+    index: &'a [u8],
+    /// Packets of the rows
+    packets: &'a [u8],
+}
+
+impl<'a> Image<'a> {
+    /// Validate the header of the image data, e.g. `Image::new(include_bytes!("watch_face.pti"))`
+    pub fn new(data: &'a [u8]) -> MynewtResult<Image<'a>> {
+        if data.len() < HEADER_SIZE || data[.. 4] != MAGIC { return Err(MynewtError::SYS_EINVAL); }
+        let word = |i: usize| u16::from_le_bytes([ data[i], data[i + 1] ]);
+        let (width, height, palette_size, index_size) = (word(4), word(6), word(8) as usize, word(10) as usize);
+        if width == 0 || width > DISPLAY_SIZE || height == 0 || palette_size > 256 ||
+            index_size != ((height + ROWS_PER_INDEX - 1) / ROWS_PER_INDEX) as usize { return Err(MynewtError::SYS_EINVAL); }
+        let palette_end = HEADER_SIZE + palette_size * 2;
+        let index_end = palette_end + index_size * 4;
+        if data.len() < index_end { return Err(MynewtError::SYS_EINVAL); }
+        Ok(Image {
+            width,
+            height,
+            palette: &data[HEADER_SIZE .. palette_end],
+            index:   &data[palette_end .. index_end],
+            packets: &data[index_end ..],
+        })
+    }
+
+    /// Return the offset of the packets of the row
+    fn row_offset(&self, row: u16) -> MynewtResult<usize> {
+        let i = (row / ROWS_PER_INDEX) as usize * 4;
+        let mut pos = u32::from_le_bytes([ self.index[i], self.index[i + 1], self.index[i + 2], self.index[i + 3] ]) as usize;
+        //  Skip the rows after the indexed row
+        for _ in 0 .. row % ROWS_PER_INDEX {
+            pos = self.decode_row(pos, 0, &mut []) ? ;
+        }
+        Ok(pos)
+    }
+
+    /// Decode the pixels of the row from column `left` into `out`, 2 bytes per pixel, most significant byte first.
+    /// The packets of the row start at offset `pos`. Returns the offset of the next row.
+    fn decode_row(&self, mut pos: usize, left: u16, out: &mut [u8]) -> MynewtResult<usize> {
+        let pixel_size = if self.palette.is_empty() { 2 } else { 1 };
+        let start = left as usize;
+        let end = start + out.len() / 2;
+        let mut x = 0;
+        while x < self.width as usize {
+            let header = *self.packets.get(pos).ok_or(MynewtError::SYS_EINVAL) ? as usize;
+            let (count, size) = if header < 0x80 { (header + 1, pixel_size) } else { (header - 0x7F, (header - 0x7F) * pixel_size) };
+            let pixels = self.packets.get(pos + 1 .. pos + 1 + size).ok_or(MynewtError::SYS_EINVAL) ? ;
+            //  Copy only the pixels inside the clipped columns
+            let (from, to) = (x.max(start), (x + count).min(end));
+            if from < to {
+                let out = &mut out[(from - start) * 2 .. (to - start) * 2];
+                if header < 0x80 {
+                    let color = self.color(pixels) ? ;
+                    for pixel in out.chunks_exact_mut(2) { pixel.copy_from_slice(&color); }
+                } else {
+                    let pixels = &pixels[(from - x) * pixel_size .. (to - x) * pixel_size];
+                    for (pixel, src) in out.chunks_exact_mut(2).zip(pixels.chunks_exact(pixel_size)) {
+                        pixel.copy_from_slice(&self.color(src) ?);
+                    }
+                }
+            }
+            x += count;
+            pos += 1 + size;
+        }
+        if x != self.width as usize { return Err(MynewtError::SYS_EINVAL); }  //  Packet crosses the row
+        Ok(pos)
+    }
+
+    /// Return the RGB565 colour of the pixel, most significant byte first
+    fn color(&self, pixel: &[u8]) -> MynewtResult<[u8; 2]> {
+        if self.palette.is_empty() { return Ok([ pixel[0], pixel[1] ]); }
+        let i = pixel[0] as usize * 2;
+        match self.palette.get(i .. i + 2) {
+            Some(color) => Ok([ color[0], color[1] ]),
+            None => Err(MynewtError::SYS_EINVAL),
+        }
+    }
+}
+
+/// Draw the part of the image inside the clip area with the top left at (left, top), as one window
+/// written one row at a time. Returns the number of pixels drawn.
+pub fn draw_image<B: DisplayBus>(bus: &mut B, image: &Image, left: u16, top: u16, clip: &Rect) -> MynewtResult<u32> {
+    let rect = Rect::new(left, top, left.saturating_add(image.width - 1), top.saturating_add(image.height - 1));
+    if !rect.intersects(clip) { return Ok(0); }
+    let r = Rect::new(rect.left.max(clip.left), rect.top.max(clip.top), rect.right.min(clip.right), rect.bottom.min(clip.bottom));
+    let columns = (r.right - r.left + 1) as usize;
+    let mut row = [0_u8; DISPLAY_SIZE as usize * 2];
+    let mut pos = image.row_offset(r.top - top) ? ;
+    bus.write_window(r.left, r.top, r.right, r.bottom) ? ;
+    for _ in r.top ..= r.bottom {
+        pos = image.decode_row(pos, r.left - left, &mut row[.. columns * 2]) ? ;
+        bus.write_pixels(&row[.. columns * 2]) ? ;
+    }
+    Ok(r.area())
+}
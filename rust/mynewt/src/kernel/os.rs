@@ -681,6 +681,14 @@ impl Default for hal_timer {
     #[doc = " Return: uint32_t The number of nanoseconds corresponding to 'ticks'"]
     pub fn os_cputime_ticks_to_nsecs(ticks: u32) -> u32;
 }
+#[mynewt_macros::safe_wrap(attr)] extern "C" {
+    #[doc = " Convert the given number of ticks into microseconds."]
+    #[doc = ""]
+    #[doc = " - __`ticks`__: The number of ticks to convert to microseconds."]
+    #[doc = ""]
+    #[doc = " Return: uint32_t The number of microseconds corresponding to 'ticks'"]
+    pub fn os_cputime_ticks_to_usecs(ticks: u32) -> u32;
+}
 #[mynewt_macros::safe_wrap(attr)] extern "C" {
     #[doc = " Wait until 'nsecs' nanoseconds has elapsed. This is a blocking delay."]
     #[doc = " Not defined if OS_CPUTIME_FREQ_PWR2 is defined."]
@@ -35,7 +35,19 @@ pub mod libs;                     //  Mynewt Custom API. Export folder `libs` as
 mod hal;                            //  Import module `hal` for Embedded HAL functions but don't export it
 pub use hal::{ Delay, GPIO, SPI };  //  Export `hal` types GPIO and SPI
 
-pub mod spi;  //  Export Non-Blocking SPI API
+pub mod display;  //  Export ST7789 Display Command Interface
+pub mod spi;      //  Export Non-Blocking SPI API
+pub mod spi_bus;  //  Export Shared SPI Bus for the display and other SPI devices
+pub mod i2c;      //  Export Non-Blocking I2C API
+pub mod executor; //  Export Async Executor for Mynewt Event Queues
+pub mod dirty;    //  Export Dirty Rectangle Tracking for partial display refresh
+pub mod fill;     //  Export Fill Kernels for rectangles and circles
+pub mod text;     //  Export Text Rendering with the glyph atlas
+pub mod font_atlas;  //  Export Glyph Atlas generated by `display-host`
+pub mod scroll;   //  Export Hardware Vertical Scrolling for list and log views
+pub mod image;    //  Export Image Streaming from flash
+pub mod frame_time;   //  Export Frame Time Instrumentation
+pub mod frame_probe;  //  Export Frame Time Probes for PineTime
 
 ///  Initialise the Mynewt system.  Start the Mynewt drivers and libraries.  Equivalent to `sysinit()` macro in C.
 pub fn sysinit() {
@@ -212,6 +224,17 @@ impl Strn {
         }
     }
 
+    /// Return the bytes of the string, excluding the terminating null.
+    pub fn to_bytes(&self) -> &[u8] {
+        match self.rep {
+            StrnRep::ByteStr(bs) => { &bs[.. self.len()] }
+            StrnRep::CStr(cstr)  => {
+                if cstr.is_null() { return &[]; }
+                unsafe { core::slice::from_raw_parts(cstr, self.len()) }
+            }
+        }
+    }
+
     /// Fail if the last byte is not zero.
     pub fn validate(&self) {
         match self.rep {
@@ -521,14 +521,22 @@ impl sensor_temp_raw_data {
     #[doc = "  ```"]
     #[doc = "  {a:b --> {a:b, key:["]
     #[doc = "  ```"]
-    pub fn json_helper_set_array(object: *mut ::cty::c_void, key: *const ::cty::c_char);
+    pub fn json_helper_set_array(
+        object: *mut ::cty::c_void,
+        key: *const ::cty::c_char,
+        key_len: ::cty::c_int,
+    );
 }
 #[mynewt_macros::safe_wrap(attr)] extern "C" {
     #[doc = "  End the child array and resume writing the parent object."]
     #[doc = "  ```"]
     #[doc = "  {a:b, key:[... --> {a:b, key:[...]"]
     #[doc = "  ```"]
-    pub fn json_helper_close_array(object: *mut ::cty::c_void, key: *const ::cty::c_char);
+    pub fn json_helper_close_array(
+        object: *mut ::cty::c_void,
+        key: *const ::cty::c_char,
+        key_len: ::cty::c_int,
+    );
 }
 #[mynewt_macros::safe_wrap(attr)] extern "C" {
     #[doc = "  Assume we have called `set_array`.  Start an array item, assumed to be an object."]
@@ -546,21 +554,57 @@ impl sensor_temp_raw_data {
 }
 #[mynewt_macros::safe_wrap(attr)] extern "C" {
     #[doc = "  Encode an int value into the current JSON encoding value `coap_json_value`"]
-    pub fn json_helper_set_int(object: *mut ::cty::c_void, key: *const ::cty::c_char, value: u64);
+    pub fn json_helper_set_int(
+        object: *mut ::cty::c_void,
+        key: *const ::cty::c_char,
+        key_len: ::cty::c_int,
+        value: u64,
+    );
 }
 #[mynewt_macros::safe_wrap(attr)] extern "C" {
     #[doc = "  Encode an unsigned int value into the current JSON encoding value `coap_json_value`"]
-    pub fn json_helper_set_uint(object: *mut ::cty::c_void, key: *const ::cty::c_char, value: u64);
+    pub fn json_helper_set_uint(
+        object: *mut ::cty::c_void,
+        key: *const ::cty::c_char,
+        key_len: ::cty::c_int,
+        value: u64,
+    );
 }
 #[mynewt_macros::safe_wrap(attr)] extern "C" {
     #[doc = "  Encode a float value into the current JSON encoding value `coap_json_value`"]
-    pub fn json_helper_set_float(object: *mut ::cty::c_void, key: *const ::cty::c_char, value: f32);
+    pub fn json_helper_set_float(
+        object: *mut ::cty::c_void,
+        key: *const ::cty::c_char,
+        key_len: ::cty::c_int,
+        value: f32,
+    );
+}
+#[mynewt_macros::safe_wrap(attr)] extern "C" {
+    #[doc = "  Encode a fixed-point value with 7 decimal places (e.g. 1e-7 degrees) into the current JSON encoding value `coap_json_value`"]
+    pub fn json_helper_set_fixed7(
+        object: *mut ::cty::c_void,
+        key: *const ::cty::c_char,
+        key_len: ::cty::c_int,
+        value: i32,
+    );
+}
+#[mynewt_macros::safe_wrap(attr)] extern "C" {
+    #[doc = "  Encode an array of `count` integers into the current JSON object with the specified key: `key: [1, 2, 3]`"]
+    pub fn json_helper_set_int_array(
+        object: *mut ::cty::c_void,
+        key: *const ::cty::c_char,
+        key_len: ::cty::c_int,
+        values: *const i32,
+        count: u32,
+    );
 }
 #[mynewt_macros::safe_wrap(attr)] extern "C" {
     #[doc = "  Encode a text value into the current JSON encoding value `coap_json_value`"]
     pub fn json_helper_set_text_string(
         object: *mut ::cty::c_void,
         key: *const ::cty::c_char,
+        key_len: ::cty::c_int,
         value: *const ::cty::c_char,
+        value_len: ::cty::c_int,
     );
 }
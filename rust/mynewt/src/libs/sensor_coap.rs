@@ -406,6 +406,16 @@ impl Default for sensor_value {
 #[mynewt_macros::safe_wrap(attr)] extern "C" {
     pub fn do_sensor_post() -> bool;
 }
+#[mynewt_macros::safe_wrap(attr)] extern "C" {
+    pub fn coap_rep_append(data: *const u8, len: ::cty::c_int) -> ::cty::c_int;
+}
+#[mynewt_macros::safe_wrap(attr)] extern "C" {
+    pub fn json_encode_object_key_n(
+        encoder: *mut json_encoder,
+        key: *const ::cty::c_char,
+        key_len: ::cty::c_int,
+    ) -> ::cty::c_int;
+}
 #[repr(C)]
 pub struct json_value__bindgen_ty_1 {
     pub u: __BindgenUnionField<u64>,
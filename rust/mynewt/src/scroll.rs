@@ -0,0 +1,84 @@
+//! Hardware Vertical Scrolling for list and log views. The ST7789 frame memory has 320 rows but the PineTime display
+//! shows 240, so the scroll area is a ring of frame memory rows of which 80 are hidden. To scroll, the newly exposed
+//! rows are drawn into the hidden rows, then the start of the ring is moved with VSCSAD. Only the new rows are sent.
+use crate::{
+    result::*,
+    display::{ self, DisplayBus, MEMORY_ROWS },
+    dirty::DISPLAY_SIZE,
+};
+
+/// Vertical scroll area below a fixed area at the top of the display, e.g. a status bar
+pub struct Scroller {
+    /// Number of fixed rows at the top
+    top: u16,
+    /// Number of frame memory rows in the scroll area, shown and hidden
+    rows: u16,
+    /// Position in the scroll area of the row shown at the top of the scroll area
+    start: u16,
+}
+
+impl Scroller {
+    /// Define the scroll area below `top` fixed rows. Frame memory row `top + n` is shown at display row `top + n`.
+    pub fn new<B: DisplayBus>(bus: &mut B, top: u16) -> MynewtResult<Scroller> {
+        if top >= DISPLAY_SIZE { return Err(MynewtError::SYS_EINVAL); }
+        let rows = MEMORY_ROWS - top;
+        bus.write_command(display::VSCRDEF) ? ;
+        bus.write_data(&[ (top >> 8) as u8, top as u8, (rows >> 8) as u8, rows as u8, 0, 0 ]) ? ;
+        let scroller = Scroller { top, rows, start: 0 };
+        scroller.write_start(bus) ? ;
+        Ok(scroller)
+    }
+
+    /// Number of display rows in the scroll area
+    pub fn visible(&self) -> u16 {
+        DISPLAY_SIZE - self.top
+    }
+
+    /// Return the frame memory row that is shown at the display row. Use this to draw into the scroll area.
+    pub fn memory_row(&self, row: u16) -> u16 {
+        if row < self.top { return row; }
+        self.top + (self.start + row - self.top) % self.rows
+    }
+
+    /// Scroll the content up by `lines` rows (down if negative). For each band of newly exposed rows, `paint` is called
+    /// with the first frame memory row of the band, the number of rows, and the display row where the band will appear.
+    /// `paint` must draw the band into the frame memory rows, which are hidden until the scroll is done.
+    pub fn scroll<B, F>(&mut self, bus: &mut B, lines: i32, mut paint: F) -> MynewtResult<()>
+    where B: DisplayBus, F: FnMut(&mut B, u16, u16, u16) -> MynewtResult<()> {
+        let hidden = self.rows - self.visible();
+        let mut left = lines.abs() as u16;
+        while left > 0 {
+            //  Scroll at most the hidden rows at a time, so that the visible rows are never overwritten
+            let n = left.min(hidden);
+            if lines > 0 {
+                //  New rows appear at the bottom, after the last visible row of the ring
+                self.paint_band(bus, self.start + self.visible(), n, DISPLAY_SIZE - n, &mut paint) ? ;
+                self.start = (self.start + n) % self.rows;
+            } else {
+                //  New rows appear at the top, before the first visible row of the ring
+                self.paint_band(bus, self.start + self.rows - n, n, self.top, &mut paint) ? ;
+                self.start = (self.start + self.rows - n) % self.rows;
+            }
+            self.write_start(bus) ? ;
+            left -= n;
+        }
+        Ok(())
+    }
+
+    /// Call `paint` for `n` rows of the ring from `position`, split in two if the rows wrap around the end of the ring
+    fn paint_band<B, F>(&self, bus: &mut B, position: u16, n: u16, row: u16, paint: &mut F) -> MynewtResult<()>
+    where B: DisplayBus, F: FnMut(&mut B, u16, u16, u16) -> MynewtResult<()> {
+        let position = position % self.rows;
+        let first = n.min(self.rows - position);
+        paint(bus, self.top + position, first, row) ? ;
+        if first < n { paint(bus, self.top, n - first, row + first) ? ; }
+        Ok(())
+    }
+
+    /// Show the ring from `start` at the top of the scroll area
+    fn write_start<B: DisplayBus>(&self, bus: &mut B) -> MynewtResult<()> {
+        let address = self.top + self.start;
+        bus.write_command(display::VSCSAD) ? ;
+        bus.write_data(&[ (address >> 8) as u8, address as u8 ])
+    }
+}
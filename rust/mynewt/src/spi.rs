@@ -1,28 +1,39 @@
 //! Experimental Non-Blocking SPI Transfer API. Uses a background task to send SPI requests sequentially.
-//! Request data is copied into Mbuf Queues before transmitting. 
+//! Request data is copied into Mbuf Queues before transmitting. Pixels of a repeated colour are not copied:
+//! the request holds the colour and the number of pixels, and the SPI Task sends them by DMA from a row of the colour.
+//! The SPI Task owns the SPI port, which is shared by the ST7789 display and other devices added with `spi_add_device()`,
+//! e.g. the external SPI flash. Each device has its own SPI settings and Chip Select pin. Transactions for other devices
+//! are queued with `spi_transfer()` or `spi_async_transfer()` and interleaved with the display requests, see `spi_bus.rs`.
+//! The time spent enqueueing and the completion of the SPI transfers are reported to `frame_probe.rs`.
+//! `spi_async_write()` enqueues requests from futures running on `executor.rs`.
+use core::sync::atomic::{ AtomicBool, AtomicU32, Ordering };
 use crate::{
     self as mynewt,
     result::*,
+    display::{ self, DisplayBus },
+    executor::Signal,
+    frame_probe,
     hw::hal,
     kernel::os,
+    spi_bus::{ self, SpiPort, SpiQueues, SpiSettings, TxnCommand },
     NULL, Ptr, Strn,
 };
+pub use crate::spi_bus::{ SpiDevice, DISPLAY_DEVICE, TXN_WRITE_MAX };
 use mynewt_macros::{
     init_strn,
 };
 
-//  TODO: Remove SPI settings for ST7789 display controller
+//  SPI settings for ST7789 display controller
 const DISPLAY_SPI: i32  =  0;  //  Mynewt SPI port 0
 const DISPLAY_CS: i32   = 25;  //  LCD_CS (P0.25): Chip select
 const DISPLAY_DC: i32   = 18;  //  LCD_RS (P0.18): Clock/data pin (CD)
 //  const DISPLAY_RST: i32  = 26;  //  LCD_RESET (P0.26): Display reset
 //  const DISPLAY_HIGH: i32 = 23;  //  LCD_BACKLIGHT_{LOW,MID,HIGH} (P0.14, 22, 23): Backlight (active low)
 
-const SPI_NUM: i32    = DISPLAY_SPI;
-const SPI_SS_PIN: i32 = DISPLAY_CS;
-const SPI_DC_PIN: i32 = DISPLAY_DC;
+/// SPI port shared by all devices. On PineTime the external SPI flash (CS on P0.05) is on the same port as the display.
+const SPI_NUM: i32 = DISPLAY_SPI;
 
-/// TODO: Remove SPI settings for ST7789 display controller
+/// SPI settings for ST7789 display controller
 static mut SPI_SETTINGS: hal::hal_spi_settings = hal::hal_spi_settings {
     data_order: hal::HAL_SPI_MSB_FIRST as u8,
     data_mode:  hal::HAL_SPI_MODE3 as u8,  //  SPI must be used in mode 3. Mode 0 (the default) won't work.
@@ -46,6 +57,9 @@ static mut SPI_SEM: os::os_sem = fill_zero!(os::os_sem);
 /// Semaphore that throttles the number of queued SPI requests
 static mut SPI_THROTTLE_SEM: os::os_sem = fill_zero!(os::os_sem);
 
+/// Signalled when the SPI Task releases the throttle semaphore, to wake `spi_async_write()`
+static SPI_SPACE: Signal = Signal::new();
+
 /// Mbuf Queue that contains the SPI data packets to be sent. Why use Mbuf Queue? 
 /// Because it's a Mynewt OS low-level buffer that allows packets of various sizes to be copied efficiently.
 static mut SPI_DATA_QUEUE: os::os_mqueue = fill_zero!(os::os_mqueue);
@@ -65,6 +79,51 @@ const SPI_TASK_STACK_SIZE: usize = 256;
 //  TODO: Get this constant from Mynewt
 const OS_TICKS_PER_SEC: u32 = 1000;
 
+/// CPU time when the last SPI transfer completed
+static SPI_DONE_TIME: AtomicU32 = AtomicU32::new(0);
+
+/// Number of 32-bit words in `FILL_ROW`: one row of the display, two RGB565 pixels per word
+const FILL_ROW_WORDS: usize = 120;
+
+/// Row of pixels of the repeated colour, sent by DMA for each block of a repeated colour request. Only accessed by the SPI Task.
+static mut FILL_ROW: [u32; FILL_ROW_WORDS] = [0; FILL_ROW_WORDS];
+
+/// Devices on the shared SPI bus. The display is added by `spi_noblock_init()`, and its requests are sent with
+/// `spi_noblock_write_command()` etc. Devices are added during startup, after that only accessed by the SPI Task.
+static mut BUS: spi_bus::SpiBus = spi_bus::SpiBus::new();
+
+/// SPI transaction for a device added by `spi_add_device()`: writes some bytes (e.g. a flash command and address)
+/// then reads some bytes, with Chip Select low for the whole transaction. Initialise with `fill_zero!(SpiTxn)`.
+pub struct SpiTxn {
+    /// Device to be selected
+    device:    SpiDevice,
+    /// Bytes to write, copied from the caller
+    command:   TxnCommand,
+    /// Buffer for the bytes read
+    read:      *mut u8,
+    /// Number of bytes to read
+    read_len:  usize,
+    /// If not null, signalled when complete. Else `sem` is released.
+    done:      *const Signal,
+    /// Released when complete, for `spi_transfer()`
+    sem:       os::os_sem,
+    /// Result: 0 if successful, else `MynewtError`
+    rc:        i32,
+    /// True while the transaction is queued or executing
+    busy:      AtomicBool,
+    /// Next transaction in the queue
+    next:      *mut SpiTxn,
+}
+
+/// First transaction queued for the SPI Task. Accessed with interrupts disabled.
+static mut TXN_HEAD: *mut SpiTxn = core::ptr::null_mut();
+
+/// Last transaction queued for the SPI Task. Accessed with interrupts disabled.
+static mut TXN_TAIL: *mut SpiTxn = core::ptr::null_mut();
+
+/// Event posted to the SPI Event Queue when transactions are queued
+static mut SPI_TXN_EVENT: os::os_event = fill_zero!(os::os_event);
+
 /// Non-blocking SPI transfer callback parameter (not used)
 struct SpiCallback {}
 
@@ -88,8 +147,12 @@ pub fn spi_noblock_init() -> MynewtResult<()> {
 
     //  Enable SPI port and set SS to high to disable SPI device
     let rc = unsafe { hal::hal_spi_enable(SPI_NUM) }; assert_eq!(rc, 0, "spi enable fail");  //  TODO: Map to MynewtResult
-    let rc = unsafe { hal::hal_gpio_init_out(SPI_SS_PIN, 1) }; assert_eq!(rc, 0, "gpio fail");  //  TODO: Map to MynewtResult
-    let rc = unsafe { hal::hal_gpio_init_out(SPI_DC_PIN, 1) }; assert_eq!(rc, 0, "gpio fail");  //  TODO: Map to MynewtResult
+    let rc = unsafe { hal::hal_gpio_init_out(DISPLAY_DC, 1) }; assert_eq!(rc, 0, "gpio fail");  //  TODO: Map to MynewtResult
+
+    //  The display is the first device on the bus, and the port is configured for the display.
+    let settings = unsafe { &SPI_SETTINGS };
+    let display = spi_add_device(settings, DISPLAY_CS) ? ;
+    assert_eq!(display, DISPLAY_DEVICE, "spi dev fail");
 
     //  Create Event Queue and Mbuf (Data) Queue that will store the SPI requests
     unsafe { os::os_eventq_init(&mut SPI_EVENT_QUEUE) };
@@ -99,6 +162,7 @@ pub fn spi_noblock_init() -> MynewtResult<()> {
         NULL
     ) };
     assert_eq!(rc, 0, "mqueue fail");  //  TODO: Map to MynewtResult
+    unsafe { SPI_TXN_EVENT.ev_cb = Some(spi_txn_callback) };
 
     //  Create the Semaphore that will signal whether the SPI request has completed
     let rc = unsafe { os::os_sem_init(&mut SPI_SEM, 0) };  //  Init to 0 tokens, so caller will block until SPI request is completed.
@@ -154,6 +218,57 @@ pub fn spi_noblock_write_data(data: &[u8]) -> MynewtResult<()> {
     Ok(())
 }
 
+/// Set pending request to write pixels into the display window from (left, top) to (right, bottom) inclusive.
+/// Follow with `spi_noblock_write_pixels()` to write the pixels of the window, row by row.
+pub fn spi_noblock_write_window(left: u16, top: u16, right: u16, bottom: u16) -> MynewtResult<()> {
+    SpiBus.write_window(left, top, right, bottom)
+}
+
+/// Set pending request to write pixels after `spi_noblock_write_window()`. Returns without waiting for write to complete.
+/// If the pixels don't fit into the pending Data Bytes, the pending request is enqueued and the rest is written with RAMWRC.
+pub fn spi_noblock_write_pixels(data: &[u8]) -> MynewtResult<()> {
+    let mut data = data;
+    while data.len() > 0 {
+        let space = unsafe { PENDING_DATA.capacity() - PENDING_DATA.len() };
+        if space == 0 {
+            //  Pending Data Bytes are full. Enqueue them and continue writing from the last pixel.
+            spi_noblock_write_command(display::RAMWRC) ? ;
+            continue;
+        }
+        let len = data.len().min(space);
+        spi_noblock_write_data(&data[.. len]) ? ;
+        data = &data[len ..];
+    }
+    Ok(())
+}
+
+/// Enqueue request to write `count` pixels of the RGB565 colour after `spi_noblock_write_window()`. Returns without
+/// waiting for write to complete. Only the colour is queued: the SPI Task repeats it by DMA from `FILL_ROW`.
+pub fn spi_noblock_write_repeated(color: u16, count: u32) -> MynewtResult<()> {
+    if count == 0 { return Ok(()); }
+    assert!(unsafe { PENDING_CMD.len() } > 0);  //  Must have Command Byte before Data Bytes
+    //  Send the pixels with the pending RAMWR, or if it already has pixels, continue after them with RAMWRC.
+    let cmd =
+        if unsafe { PENDING_DATA.len() } == 0 { unsafe { PENDING_CMD[0] } }
+        else { spi_noblock_write_flush() ? ; display::RAMWRC };
+    unsafe { PENDING_CMD.clear() };
+    spi_throttle();
+    spi_enqueue(cmd, &color.to_be_bytes(), count)
+}
+
+/// ST7789 display on the non-blocking SPI port. Requests are queued and sent by the SPI Task.
+pub struct SpiBus;
+
+impl DisplayBus for SpiBus {
+    fn write_command(&mut self, cmd: u8) -> MynewtResult<()> { spi_noblock_write_command(cmd) }
+    fn write_data(&mut self, data: &[u8]) -> MynewtResult<()> { spi_noblock_write_data(data) }
+    fn write_pixels(&mut self, data: &[u8]) -> MynewtResult<()> { spi_noblock_write_pixels(data) }
+    fn write_repeated(&mut self, pattern: &[u8], count: u32) -> MynewtResult<()> {
+        spi_noblock_write_repeated(u16::from_be_bytes([ pattern[0], pattern[1] ]), count)
+    }
+    fn flush(&mut self) -> MynewtResult<()> { spi_noblock_write_flush() }
+}
+
 /// Enqueue any pending request for non-blocking SPI write for Command Byte and Data Bytes. Returns without waiting for write to complete.
 pub fn spi_noblock_write_flush() -> MynewtResult<()> {
     //  If no pending request, quit.
@@ -187,16 +302,75 @@ fn spi_noblock_write(cmd: u8, data: &[u8]) -> MynewtResult<()> {
     console::flush(); */
 
     //  Throttle the number of queued SPI requests.
+    spi_throttle();
+
+    //  Enqueue the request now that the queue has space.
+    spi_enqueue(cmd, data, 0)
+}
+
+/// Wait for the SPI queue to have space for the next request, and take the throttle semaphore
+fn spi_throttle() {
+    let wait_start = frame_probe::now_us();
     let timeout = 30_000;
     unsafe { os::os_sem_pend(&mut SPI_THROTTLE_SEM, timeout * OS_TICKS_PER_SEC / 1000) };
+    frame_probe::spi_wait_time(frame_probe::now_us().wrapping_sub(wait_start));
+}
+
+/// Enqueue any pending request for SPI write, for use with `executor.rs`. Same as `spi_noblock_write_flush()`, except
+/// that while the SPI queue is full, other futures continue to run instead of blocking the task.
+pub async fn spi_async_flush() -> MynewtResult<()> {
+    //  If no pending request, quit.
+    if unsafe { PENDING_CMD.len() } == 0 &&
+        unsafe { PENDING_DATA.len() } == 0 {
+        return Ok(());
+    }
+    //  Wait for the queue to have space, then enqueue the pending SPI request and clear it.
+    spi_async_throttle().await;
+    let result = spi_enqueue(
+        unsafe { PENDING_CMD[0] },  //  Command Byte
+        unsafe { &PENDING_DATA },   //  Data Bytes
+        0
+    );
+    unsafe { PENDING_CMD.clear() };
+    unsafe { PENDING_DATA.clear() };
+    result
+}
+
+/// Enqueue request for SPI write, for use with `executor.rs`. Any pending request is enqueued first.
+/// While the SPI queue is full, other futures continue to run instead of blocking the task.
+pub async fn spi_async_write(cmd: u8, data: &[u8]) -> MynewtResult<()> {
+    spi_async_flush().await ? ;
+    spi_async_throttle().await;
+    spi_enqueue(cmd, data, 0)
+}
+
+/// Take the throttle semaphore without blocking the task: while the SPI queue is full, wait for the SPI Task
+/// to signal that a request has been sent.
+async fn spi_async_throttle() {
+    let wait_start = frame_probe::now_us();
+    while unsafe { os::os_sem_pend(&mut SPI_THROTTLE_SEM, 0) } != 0 {
+        SPI_SPACE.wait().await;
+    }
+    frame_probe::spi_wait_time(frame_probe::now_us().wrapping_sub(wait_start));
+}
+
+/// Copy the request into a new mbuf chain and add it to the SPI Mbuf Queue. The caller must have taken
+/// the throttle semaphore, which is released if the request can't be enqueued. If `repeat` is non-zero,
+/// the Data Bytes are one RGB565 pixel, to be sent `repeat` times. The count is stored in the user header.
+fn spi_enqueue(cmd: u8, data: &[u8], repeat: u32) -> MynewtResult<()> {
+    let start = frame_probe::now_us();
 
     //  Allocate a new mbuf chain to copy the data to be sent.
     let len = data.len() as u16 + 1;  //  1 Command Byte + Multiple Data Bytes
-    let mbuf = unsafe { os::os_msys_get_pkthdr(len, 0) };
+    let user_hdr_len = if repeat > 0 { REPEAT_HDR_LEN } else { 0 };
+    let mbuf = unsafe { os::os_msys_get_pkthdr(len, user_hdr_len) };
     if mbuf.is_null() {  //  If out of memory, quit.
         unsafe { os::os_sem_release(&mut SPI_THROTTLE_SEM) };  //  Release the throttle
         return Err(MynewtError::SYS_ENOMEM); 
     }
+    if repeat > 0 {
+        unsafe { core::ptr::write_unaligned(repeat_hdr(mbuf), repeat) };
+    }
 
     //  Append the Command Byte to the mbuf chain.
     let rc = unsafe { os::os_mbuf_append(
@@ -222,6 +396,9 @@ fn spi_noblock_write(cmd: u8, data: &[u8]) -> MynewtResult<()> {
         return Err(MynewtError::SYS_ENOMEM); 
     }
 
+    //  Report the time spent allocating and copying the mbuf chain, before the SPI Task can send it.
+    frame_probe::enqueue_time(frame_probe::now_us().wrapping_sub(start));
+
     //  Add the mbuf to the SPI Mbuf Queue and trigger an event in the SPI Event Queue.
     let rc = unsafe { os::os_mqueue_put(
         &mut SPI_DATA_QUEUE, 
@@ -236,13 +413,153 @@ fn spi_noblock_write(cmd: u8, data: &[u8]) -> MynewtResult<()> {
     Ok(())
 }
 
-/// Callback for the event that is triggered when an SPI request is added to the queue.
+/// Length of the user header of a repeated colour request: the number of pixels
+const REPEAT_HDR_LEN: u16 = 4;
+
+/// Return the user header of the request, after the packet header, like `OS_MBUF_USRHDR()`
+fn repeat_hdr(om: *mut os::os_mbuf) -> *mut u32 {
+    unsafe { (om as *mut u8).add(core::mem::size_of::<os::os_mbuf>() + core::mem::size_of::<os::os_mbuf_pkthdr>()) as *mut u32 }
+}
+
+/// Return the number of times the pixel of the request is sent, or 0 if the request is not a repeated colour
+fn repeat_count(om: *mut os::os_mbuf) -> u32 {
+    let user_hdr_len = unsafe { (*om).om_pkthdr_len } as usize - core::mem::size_of::<os::os_mbuf_pkthdr>();
+    if user_hdr_len < REPEAT_HDR_LEN as usize { return 0; }
+    unsafe { core::ptr::read_unaligned(repeat_hdr(om)) }
+}
+
+/// Send `count` pixels of the RGB565 colour to the display, by DMA from `FILL_ROW`. The row is filled with 32-bit stores.
+fn send_repeated(bus: &mut spi_bus::SpiBus, port: &mut HalPort, color: &[u8], count: u32) -> MynewtResult<()> {
+    let word = u32::from_ne_bytes([ color[0], color[1], color[0], color[1] ]);  //  Same byte order on any endianness
+    let row = unsafe { &mut *core::ptr::addr_of_mut!(FILL_ROW) };
+    for w in row.iter_mut() { *w = word; }
+    let mut left = count as usize * 2;
+    while left > 0 {
+        let len = left.min(FILL_ROW_WORDS * 4);
+        internal_spi_noblock_write(bus, port, unsafe { &*(row.as_ptr() as *const u8) }, len as i32, false) ? ;
+        left -= len;
+    }
+    Ok(())
+}
+
+/// Add a device on the shared SPI bus, with its own SPI settings and SS Pin. Call during startup, after `spi_noblock_init()`.
+/// For devices that support the display settings (SPI mode 3 at 8 MHz, e.g. the PineTime SPI flash), use the display
+/// settings so that the SPI port is never reconfigured when switching between the display and the device.
+pub fn spi_add_device(settings: &hal::hal_spi_settings, cs_pin: i32) -> MynewtResult<SpiDevice> {
+    let rc = unsafe { hal::hal_gpio_init_out(cs_pin, 1) };  //  Set SS to high to disable the device
+    if rc != 0 { return Err(MynewtError::SYS_EINVAL); }
+    let settings = SpiSettings {
+        data_mode:  settings.data_mode,
+        data_order: settings.data_order,
+        word_size:  settings.word_size,
+        baudrate:   settings.baudrate,
+    };
+    unsafe { BUS.add_device(&settings, cs_pin) }
+}
+
+/// Queue a transaction that writes `write` then reads into `read` with the device, and wait until it is complete.
+/// `write` is copied into the transaction (max `TXN_WRITE_MAX` bytes), so it may be a literal stored in flash.
+/// Display requests in the queue are interleaved, so the display is not stalled. Must not be called from an
+/// interrupt handler. If the wait times out, the transaction is still queued, so the transaction and buffer must be static.
+pub fn spi_transfer(txn: &'static mut SpiTxn, device: SpiDevice, write: &[u8], read: &'static mut [u8]) -> MynewtResult<()> {
+    if txn.busy.load(Ordering::Acquire) { return Err(MynewtError::SYS_EBUSY); }
+    let rc = unsafe { os::os_sem_init(&mut txn.sem, 0) };
+    if rc != 0 { return Err(MynewtError::SYS_EINVAL); }
+    let txn = spi_submit(txn, device, write, read, core::ptr::null()) ? ;
+    let timeout = 30_000;
+    let rc = unsafe { os::os_sem_pend(&mut txn.sem, timeout * OS_TICKS_PER_SEC / 1000) };
+    if rc != 0 { return Err(MynewtError::SYS_ETIMEOUT); }
+    spi_result(txn)
+}
+
+/// Queue a transaction that writes `write` then reads into `read` with the device, and complete when the transaction is complete.
+/// `write` is copied into the transaction, like `spi_transfer()`. For use with `executor.rs`: `done` is signalled by the
+/// SPI Task, so other futures continue to run while waiting, e.g. a future that sends the previous block read from the
+/// SPI flash to the display.
+pub async fn spi_async_transfer(txn: &'static mut SpiTxn, device: SpiDevice, write: &[u8],
+    read: &'static mut [u8], done: &'static Signal) -> MynewtResult<()> {
+    done.reset();
+    let txn = spi_submit(txn, device, write, read, done as *const Signal) ? ;
+    done.wait().await;
+    spi_result(txn)
+}
+
+/// Return the result of the completed transaction
+pub fn spi_result(txn: &SpiTxn) -> MynewtResult<()> {
+    if txn.rc != 0 { return Err(MynewtError::from(txn.rc)); }
+    Ok(())
+}
+
+/// Add the transaction to the queue of the SPI Task. The read buffer must remain valid until it is complete.
+/// Returns `SYS_EBUSY` if the transaction is still queued or executing.
+fn spi_submit(txn: &'static mut SpiTxn, device: SpiDevice, write: &[u8], read: &'static mut [u8],
+    done: *const Signal) -> MynewtResult<&'static mut SpiTxn> {
+    //  Display requests need the DC Pin, so they are sent with spi_noblock_write_command() etc.
+    if device == DISPLAY_DEVICE || unsafe { !BUS.has_device(device) } ||
+        read.len() > i32::max_value() as usize || write.len() + read.len() == 0 { return Err(MynewtError::SYS_EINVAL); }
+    //  Copy the command bytes, since EasyDMA can't send them from flash.
+    let command = TxnCommand::new(write) ? ;
+    if txn.busy.swap(true, Ordering::Acquire) { return Err(MynewtError::SYS_EBUSY); }
+    txn.device    = device;
+    txn.command   = command;
+    txn.read      = read.as_mut_ptr();
+    txn.read_len  = read.len();
+    txn.done      = done;
+    txn.rc        = 0;
+    txn.next      = core::ptr::null_mut();
+
+    //  Append to the queue and wake the SPI Task.
+    let ptr = txn as *mut SpiTxn;
+    let sr = unsafe { os::os_arch_save_sr() };
+    unsafe {
+        if TXN_TAIL.is_null() { TXN_HEAD = ptr; }
+        else { (*TXN_TAIL).next = ptr; }
+        TXN_TAIL = ptr;
+    }
+    unsafe { os::os_arch_restore_sr(sr) };
+    unsafe { os::os_eventq_put(&mut SPI_EVENT_QUEUE, &mut SPI_TXN_EVENT) };
+    Ok(txn)
+}
+
+/// Remove the first transaction from the queue, or return null if none
+fn spi_dequeue() -> *mut SpiTxn {
+    let sr = unsafe { os::os_arch_save_sr() };
+    let txn = unsafe { TXN_HEAD };
+    if !txn.is_null() {
+        unsafe { TXN_HEAD = (*txn).next };
+        if unsafe { TXN_HEAD.is_null() } { unsafe { TXN_TAIL = core::ptr::null_mut() }; }
+    }
+    unsafe { os::os_arch_restore_sr(sr) };
+    txn
+}
+
+/// Callback for the event that is triggered when transactions are queued. Executes all the queued transactions.
+extern "C" fn spi_txn_callback(_event: *mut os::os_event) {
+    unsafe { BUS.run_txns(&mut HalPort, &mut HalQueues) };
+}
+
+/// Callback for the event that is triggered when an SPI request is added to the queue. Sends the queued requests.
 extern "C" fn spi_event_callback(_event: *mut os::os_event) {    
-    loop {  //  For each mbuf chain found...
+    unsafe { BUS.send_display(&mut HalPort, &mut HalQueues) }.expect("int spi fail");
+}
+
+/// CPU time when the last display request was sent, reported by `display_idle()`
+static DISPLAY_DONE_TIME: AtomicU32 = AtomicU32::new(0);
+
+/// Queues of the SPI Task on PineTime: the SPI Mbuf Queue for the display, and the transaction queue
+struct HalQueues;
+
+impl SpiQueues<HalPort> for HalQueues {
+    type Request = *mut os::os_mbuf;
+    type Txn = &'static mut SpiTxn;
+
+    fn next_request(&mut self) -> Option<Self::Request> {
         //  Get the next SPI request, stored as an mbuf chain.
         let om = unsafe { os::os_mqueue_get(&mut SPI_DATA_QUEUE) };
-        if om.is_null() { break; }
+        if om.is_null() { None } else { Some(om) }
+    }
 
+    fn send_request(&mut self, bus: &mut spi_bus::SpiBus, port: &mut HalPort, om: Self::Request) -> MynewtResult<()> {
         //  Send the mbuf chain.
         let mut m = om;
         let mut first_byte = true;
@@ -253,92 +570,178 @@ extern "C" fn spi_event_callback(_event: *mut os::os_event) {
                 first_byte = false;
                 //  Write the Command Byte.
                 internal_spi_noblock_write(
+                    bus, port,
                     unsafe { core::mem::transmute(data) }, 
                     1 as i32,          //  Write 1 Command Byte
                     true
-                ).expect("int spi fail");
+                ) ? ;
 
                 //  These commands require a delay. TODO: Move to caller
-                if  unsafe { *data } == 0x01 || //  SWRESET
-                    unsafe { *data } == 0x11 || //  SLPOUT
-                    unsafe { *data } == 0x29 {  //  DISPON
+                if  unsafe { *data } == display::SWRESET ||
+                    unsafe { *data } == display::SLPOUT ||
+                    unsafe { *data } == display::DISPON {
                     delay_ms(200);
                 }
 
-                //  Then write the Data Bytes.
-                internal_spi_noblock_write(
-                    unsafe { core::mem::transmute(data.add(1)) }, 
-                    (len - 1) as i32,  //  Then write 0 or more Data Bytes
-                    false
-                ).expect("int spi fail");
+                //  Then write the Data Bytes, or repeat the pixel.
+                let repeat = repeat_count(om);
+                if repeat > 0 {
+                    let color = unsafe { core::slice::from_raw_parts(data.add(1), 2) };
+                    send_repeated(bus, port, color, repeat) ? ;
+                } else {
+                    internal_spi_noblock_write(
+                        bus, port,
+                        unsafe { core::mem::transmute(data.add(1)) }, 
+                        (len - 1) as i32,  //  Then write 0 or more Data Bytes
+                        false
+                    ) ? ;
+                }
 
             } else {  //  Second and subsequently mbufs in the chain are all Data Bytes
                 //  Write the Data Bytes.
                 internal_spi_noblock_write(
+                    bus, port,
                     unsafe { core::mem::transmute(data) }, 
                     len as i32,  //  Write all Data Bytes
                     false
-                ).expect("int spi fail");
+                ) ? ;
             }
             m = unsafe { (*m).om_next.sle_next };  //  Fetch next mbuf in the chain.
         }
+        DISPLAY_DONE_TIME.store(SPI_DONE_TIME.load(Ordering::Relaxed), Ordering::Relaxed);
+
         //  Free the entire mbuf chain.
         unsafe { os::os_mbuf_free_chain(om) };
 
         //  Release the throttle semaphore to allow next request to be queued.
         let rc = unsafe { os::os_sem_release(&mut SPI_THROTTLE_SEM) };
         assert_eq!(rc, 0, "sem fail");    
+        SPI_SPACE.signal();
+        Ok(())
+    }
+
+    fn post_display(&mut self) {
+        unsafe { os::os_eventq_put(&mut SPI_EVENT_QUEUE, &mut SPI_DATA_QUEUE.mq_ev) };
+    }
+
+    fn display_idle(&mut self) {
+        //  Complete the frames whose requests have been sent, including those sent before yielding the bus.
+        frame_probe::spi_idle(frame_probe::cputime_to_us(DISPLAY_DONE_TIME.load(Ordering::Relaxed)));
+    }
+
+    fn txn_waiting(&self) -> bool {
+        unsafe { !TXN_HEAD.is_null() }
+    }
+
+    fn next_txn(&mut self) -> Option<Self::Txn> {
+        let txn = spi_dequeue();
+        if txn.is_null() { None } else { Some(unsafe { &mut *txn }) }
+    }
+
+    fn txn_args(txn: &mut Self::Txn) -> (SpiDevice, &TxnCommand, &mut [u8]) {
+        //  SS Pin stays low for the write and the read, then goes high to end the command.
+        let read = unsafe { core::slice::from_raw_parts_mut(txn.read, txn.read_len) };
+        (txn.device, &txn.command, read)
+    }
+
+    fn complete_txn(&mut self, txn: Self::Txn, result: MynewtResult<()>) {
+        //  Report the result and wake the caller. Clear `busy` last: a caller that timed out may then
+        //  initialise the semaphore for another transfer, which must not be released by this one.
+        txn.rc = match result { Ok(()) => 0, Err(e) => e.into() };
+        let done = txn.done;
+        if done.is_null() { unsafe { os::os_sem_release(&mut txn.sem) }; }
+        else              { unsafe { (*done).signal() }; }
+        txn.busy.store(false, Ordering::Release);
     }
 }
 
-/// Perform non-blocking SPI write in Mynewt OS.  Blocks until SPI write completes.
-fn internal_spi_noblock_write(buf: &'static u8, len: i32, is_command: bool) -> MynewtResult<()> {
+/// Perform non-blocking SPI write to the display in Mynewt OS.  Blocks until SPI write completes.
+/// The display remains selected until the SPI queue is empty.
+fn internal_spi_noblock_write(bus: &mut spi_bus::SpiBus, port: &mut HalPort, buf: &'static u8, len: i32,
+    is_command: bool) -> MynewtResult<()> {
     if len == 0 { return Ok(()); }
     assert!(len > 0, "bad spi len");
 
     //  If this is a Command Byte, set DC Pin to low, else set DC Pin to high.
     unsafe { hal::hal_gpio_write(
-        SPI_DC_PIN,
+        DISPLAY_DC,
         if is_command { 0 }
         else { 1 }
     ) };
 
-    //  Set the SS Pin to low to start the transfer.
-    unsafe { hal::hal_gpio_write(SPI_SS_PIN, 0) };
+    //  Set the SS Pin to low to start the transfer, if not already low.
+    bus.select(port, DISPLAY_DEVICE) ? ;
+    let rc = internal_spi_txrx(buf as *const u8, core::ptr::null_mut(), len);
+    assert!(rc.is_ok(), "spi fail");  //  TODO: Map to MynewtResult
+    Ok(())
+}
 
-    if len == 1 {  //  If writing only 1 byte...
+/// Transfer `len` bytes with the selected device: write from `tx` and, if `rx` is not null, read into `rx`.
+/// Blocks until the transfer completes.
+fn internal_spi_txrx(tx: *const u8, rx: *mut u8, len: i32) -> MynewtResult<()> {
+    if len == 1 {  //  If transferring only 1 byte...
         //  From https://github.com/apache/mynewt-core/blob/master/hw/mcu/nordic/nrf52xxx/src/hal_spi.c#L1106-L1118
         //  There is a known issue in nRF52832 with sending 1 byte in SPIM mode that
         //  it clocks out additional byte. For this reason, let us use SPI mode for such a write.
-        //  Write the SPI byte the blocking way.
+        //  Transfer the SPI byte the blocking way.
         let rc = unsafe { hal::hal_spi_txrx(
             SPI_NUM, 
-            core::mem::transmute(buf), //  TX Buffer
-            NULL,     //  RX Buffer (don't receive)        
+            tx as Ptr,  //  TX Buffer
+            rx as Ptr,  //  RX Buffer, or null to not receive
             len) };
-        assert_eq!(rc, 0, "spi fail");  //  TODO: Map to MynewtResult
+        if rc != 0 { return Err(MynewtError::SYS_EIO); }
+        SPI_DONE_TIME.store(unsafe { os::os_cputime_get32() }, Ordering::Relaxed);
 
-    } else {  //  If writing more than 1 byte...
-        //  Write the SPI data the non-blocking way.  Will call spi_noblock_handler() after writing.
+    } else {  //  If transferring more than 1 byte...
+        //  Transfer the SPI data the non-blocking way.  Will call spi_noblock_handler() after transferring.
         let rc = unsafe { hal::hal_spi_txrx_noblock(
             SPI_NUM, 
-            core::mem::transmute(buf), //  TX Buffer
-            NULL,     //  RX Buffer (don't receive)        
+            tx as Ptr,  //  TX Buffer
+            rx as Ptr,  //  RX Buffer, or null to not receive
             len) };
-        assert_eq!(rc, 0, "spi fail");  //  TODO: Map to MynewtResult
+        if rc != 0 { return Err(MynewtError::SYS_EIO); }
 
         //  Wait for spi_noblock_handler() to signal that SPI request has been completed. Timeout in 30 seconds.
         let timeout = 30_000;
-        unsafe { os::os_sem_pend(&mut SPI_SEM, timeout * OS_TICKS_PER_SEC / 1000) };
+        let rc = unsafe { os::os_sem_pend(&mut SPI_SEM, timeout * OS_TICKS_PER_SEC / 1000) };
+        if rc != 0 { return Err(MynewtError::SYS_ETIMEOUT); }
     }
-
-    //  Set SS Pin to high to stop the transfer.
-    unsafe { hal::hal_gpio_write(SPI_SS_PIN, 1) };
     Ok(())
 }
 
+/// SPI port and SS Pins of PineTime, for the shared SPI bus
+struct HalPort;
+
+impl SpiPort for HalPort {
+    fn configure(&mut self, settings: &SpiSettings) -> MynewtResult<()> {
+        let mut settings = hal::hal_spi_settings {
+            data_mode:  settings.data_mode,
+            data_order: settings.data_order,
+            word_size:  settings.word_size,
+            baudrate:   settings.baudrate,
+        };
+        //  Port must be disabled to change the settings.
+        unsafe { hal::hal_spi_disable(SPI_NUM) };
+        let rc = unsafe { hal::hal_spi_config(SPI_NUM, &mut settings) };
+        if rc != 0 { return Err(MynewtError::SYS_EINVAL); }
+        let rc = unsafe { hal::hal_spi_enable(SPI_NUM) };
+        if rc != 0 { return Err(MynewtError::SYS_EIO); }
+        Ok(())
+    }
+
+    fn set_cs(&mut self, cs_pin: i32, high: bool) {
+        unsafe { hal::hal_gpio_write(cs_pin, if high { 1 } else { 0 }) };
+    }
+
+    fn txrx(&mut self, tx: *const u8, rx: *mut u8, len: usize) -> MynewtResult<()> {
+        internal_spi_txrx(tx, rx, len as i32)
+    }
+}
+
 /// Called by interrupt handler after Non-blocking SPI transfer has completed
 extern "C" fn spi_noblock_handler(_arg: Ptr, _len: i32) {
+    //  Timestamp the completion for the frame time probes
+    SPI_DONE_TIME.store(unsafe { os::os_cputime_get32() }, Ordering::Relaxed);
     //  Signal to internal_spi_noblock_write() that SPI request has been completed.
     let rc = unsafe { os::os_sem_release(&mut SPI_SEM) };
     assert_eq!(rc, 0, "sem fail");
@@ -0,0 +1,222 @@
+//! Shared SPI Bus for `spi.rs`. Keeps the devices on the bus with their SPI settings and Chip Select pins, selects
+//! one device at a time, reconfigures the SPI port only when the settings change, and decides when the display
+//! gives up the bus to the transactions of other devices. The SPI port is accessed through the `SpiPort` trait,
+//! so that the same code runs on PineTime (see `spi.rs`) and on the host with a simulated port (see `display-host`).
+//!
+//! The SPI Task sends the display requests and executes the transactions with `SpiBus::send_display()` and
+//! `SpiBus::run_txns()`. The queues are accessed through the `SpiQueues` trait: the Mbuf Queue and transaction list
+//! of `spi.rs` on PineTime, and simulated queues on the host, so the host runs the same order of requests.
+//!
+//! On nRF52, SPI transfers of more than 1 byte use EasyDMA, which can only read RAM. The command bytes of a transaction
+//! are copied into `TxnCommand`, so that callers may pass literals like `&[0x03, a2, a1, a0]`, which are stored in flash.
+use crate::result::*;
+
+/// Device on the shared SPI bus, returned by `SpiBus::add_device()`
+pub type SpiDevice = usize;
+
+/// ST7789 display, the first device added to the bus
+pub const DISPLAY_DEVICE: SpiDevice = 0;
+
+/// No device selected
+const NO_DEVICE: SpiDevice = usize::max_value();
+
+/// Max number of devices on the shared SPI bus
+const MAX_DEVICES: usize = 4;
+
+/// Max number of command bytes written by a transaction, e.g. a flash command, 4 address bytes and a dummy byte
+pub const TXN_WRITE_MAX: usize = 8;
+
+/// SPI mode, bit order, word size and clock (in kHz) of a device, same as `hal_spi_settings`
+#[derive(Clone, Copy, Debug, PartialEq)]
+pub struct SpiSettings {
+    pub data_mode:  u8,
+    pub data_order: u8,
+    pub word_size:  u8,
+    pub baudrate:   u32,
+}
+
+/// SPI port and Chip Select pins of the shared bus
+pub trait SpiPort {
+    /// Disable the SPI port, change the settings and enable the port
+    fn configure(&mut self, settings: &SpiSettings) -> MynewtResult<()>;
+    /// Set the Chip Select pin high (device deselected) or low (device selected)
+    fn set_cs(&mut self, cs_pin: i32, high: bool);
+    /// Transfer `len` bytes with the selected device: write from `tx` and, if `rx` is not null, read into `rx`.
+    /// `tx` and `rx` may be the same buffer. Blocks until the transfer completes.
+    fn txrx(&mut self, tx: *const u8, rx: *mut u8, len: usize) -> MynewtResult<()>;
+}
+
+/// Queues of the SPI Task: display requests, which are sent with the DC Pin, and transactions for other devices
+pub trait SpiQueues<P: SpiPort> {
+    /// Display request, e.g. an mbuf chain
+    type Request;
+    /// Transaction for a device other than the display
+    type Txn;
+    /// Remove the next display request from the queue, or return `None` if the queue is empty
+    fn next_request(&mut self) -> Option<Self::Request>;
+    /// Select the display with `bus`, send the request and free it
+    fn send_request(&mut self, bus: &mut SpiBus, port: &mut P, request: Self::Request) -> MynewtResult<()>;
+    /// Post the display event again, to send the remaining display requests after the transactions
+    fn post_display(&mut self);
+    /// Called when the display queue is empty and all requests sent since the last call are complete
+    fn display_idle(&mut self);
+    /// Return true if transactions are waiting
+    fn txn_waiting(&self) -> bool;
+    /// Remove the next transaction from the queue, or return `None` if the queue is empty
+    fn next_txn(&mut self) -> Option<Self::Txn>;
+    /// Return the device, the command and the read buffer of the transaction
+    fn txn_args(txn: &mut Self::Txn) -> (SpiDevice, &TxnCommand, &mut [u8]);
+    /// Save the result of the transaction and wake the caller
+    fn complete_txn(&mut self, txn: Self::Txn, result: MynewtResult<()>);
+}
+
+/// SPI settings and Chip Select pin of a device
+#[derive(Clone, Copy)]
+struct DeviceConfig {
+    settings: SpiSettings,
+    cs_pin:   i32,
+}
+
+/// Devices on the shared SPI bus and the device selected
+pub struct SpiBus {
+    /// Devices on the bus, indexed by `SpiDevice`
+    devices:    [DeviceConfig; MAX_DEVICES],
+    /// Number of devices on the bus
+    count:      usize,
+    /// Device whose settings are configured in the SPI port
+    configured: SpiDevice,
+    /// Device whose Chip Select pin is low, or `NO_DEVICE`
+    selected:   SpiDevice,
+    /// True if display requests have been sent since the display queue was last empty
+    display_busy: bool,
+}
+
+impl SpiBus {
+    /// Create a bus without devices
+    pub const fn new() -> SpiBus {
+        const EMPTY: DeviceConfig = DeviceConfig {
+            settings: SpiSettings { data_mode: 0, data_order: 0, word_size: 0, baudrate: 0 },
+            cs_pin:   -1,
+        };
+        SpiBus { devices: [EMPTY; MAX_DEVICES], count: 0, configured: DISPLAY_DEVICE, selected: NO_DEVICE,
+            display_busy: false }
+    }
+
+    /// Add a device with its SPI settings and Chip Select pin. The first device is the display, whose settings
+    /// must already be configured in the SPI port. The Chip Select pin must be high.
+    pub fn add_device(&mut self, settings: &SpiSettings, cs_pin: i32) -> MynewtResult<SpiDevice> {
+        if self.count == MAX_DEVICES { return Err(MynewtError::SYS_ENOMEM); }  //  Too many devices
+        self.devices[self.count] = DeviceConfig { settings: *settings, cs_pin };
+        self.count += 1;
+        Ok(self.count - 1)
+    }
+
+    /// Return true if the device has been added
+    pub fn has_device(&self, device: SpiDevice) -> bool {
+        device < self.count
+    }
+
+    /// Select the device for the next transfers and set its Chip Select pin to low. The SPI port is reconfigured
+    /// only if the device has different settings from the last device, so devices with the same settings switch
+    /// without stopping the port.
+    pub fn select<P: SpiPort>(&mut self, port: &mut P, device: SpiDevice) -> MynewtResult<()> {
+        if !self.has_device(device) { return Err(MynewtError::SYS_EINVAL); }
+        if self.selected == device { return Ok(()); }  //  Already selected, e.g. the next display request in the queue
+        self.deselect(port);
+        let config = self.devices[device];
+        if config.settings != self.devices[self.configured].settings {
+            port.configure(&config.settings) ? ;
+            self.configured = device;
+        }
+        port.set_cs(config.cs_pin, false);
+        self.selected = device;
+        Ok(())
+    }
+
+    /// Set the Chip Select pin of the selected device to high to stop the transfers
+    pub fn deselect<P: SpiPort>(&mut self, port: &mut P) {
+        if self.selected == NO_DEVICE { return; }
+        port.set_cs(self.devices[self.selected].cs_pin, true);
+        self.selected = NO_DEVICE;
+    }
+
+    /// Execute a transaction with the device: write the command, then read into `read`. The Chip Select pin stays low
+    /// for the write and the read, then goes high to end the command. The bytes clocked out while reading are ignored,
+    /// so the read buffer is also the TX buffer.
+    pub fn transfer<P: SpiPort>(&mut self, port: &mut P, device: SpiDevice, command: &TxnCommand, read: &mut [u8]) -> MynewtResult<()> {
+        self.select(port, device) ? ;
+        let mut result = Ok(());
+        if command.len > 0 {
+            result = port.txrx(command.bytes.as_ptr(), core::ptr::null_mut(), command.len);
+        }
+        if result.is_ok() && read.len() > 0 {
+            result = port.txrx(read.as_ptr(), read.as_mut_ptr(), read.len());
+        }
+        self.deselect(port);
+        result
+    }
+
+    /// Send the queued display requests. Called by the display event of the SPI Task. The display stays selected for
+    /// all the queued requests, unless transactions for other devices are waiting: then the display event is posted
+    /// again and the remaining requests are sent after the transactions. When the queue is empty, `display_idle()`
+    /// reports the requests sent, including those sent before the display gave up the bus.
+    pub fn send_display<P: SpiPort, Q: SpiQueues<P>>(&mut self, port: &mut P, queues: &mut Q) -> MynewtResult<()> {
+        let mut sent = false;
+        loop {
+            //  If other devices are waiting, let them use the bus after this request. Continue after their transactions.
+            if sent && self.yield_display(port, queues.txn_waiting()) {
+                queues.post_display();
+                return Ok(());
+            }
+            let request = match queues.next_request() { Some(request) => request, None => break };
+            sent = true;
+            self.display_busy = true;
+            queues.send_request(self, port, request) ? ;
+        }
+        //  Display queue is empty. Report the requests sent.
+        self.deselect(port);
+        if self.display_busy {
+            self.display_busy = false;
+            queues.display_idle();
+        }
+        Ok(())
+    }
+
+    /// Execute the queued transactions. Called by the transaction event of the SPI Task. Consecutive transactions
+    /// for devices with the same settings don't reconfigure the SPI port.
+    pub fn run_txns<P: SpiPort, Q: SpiQueues<P>>(&mut self, port: &mut P, queues: &mut Q) {
+        while let Some(mut txn) = queues.next_txn() {
+            let result = {
+                let (device, command, read) = Q::txn_args(&mut txn);
+                self.transfer(port, device, command, read)
+            };
+            queues.complete_txn(txn, result);
+        }
+    }
+
+    /// Called after each display request. If transactions for other devices are waiting, deselect the display
+    /// and return true: the remaining display requests are sent after the transactions. Else the display stays
+    /// selected for the next request.
+    pub fn yield_display<P: SpiPort>(&mut self, port: &mut P, txn_waiting: bool) -> bool {
+        if !txn_waiting { return false; }
+        self.deselect(port);
+        true
+    }
+}
+
+/// Command bytes written by a transaction, copied into RAM. Zero bytes when initialised with `fill_zero!`.
+#[derive(Clone, Copy)]
+pub struct TxnCommand {
+    bytes: [u8; TXN_WRITE_MAX],
+    len:   usize,
+}
+
+impl TxnCommand {
+    /// Copy the command bytes. Returns `SYS_EINVAL` if there are more than `TXN_WRITE_MAX` bytes.
+    pub fn new(write: &[u8]) -> MynewtResult<TxnCommand> {
+        if write.len() > TXN_WRITE_MAX { return Err(MynewtError::SYS_EINVAL); }
+        let mut command = TxnCommand { bytes: [0; TXN_WRITE_MAX], len: write.len() };
+        command.bytes[.. write.len()].copy_from_slice(write);
+        Ok(command)
+    }
+}
@@ -0,0 +1,78 @@
+//! Text rendering with the pre-rendered glyph atlas in `font_atlas.rs`. A line of text is written as a single window,
+//! row by row: each glyph row is expanded from its runs into the foreground and background colours, so there is
+//! no per-pixel drawing and only one CASET / RASET / RAMWR per line.
+use crate::{
+    result::*,
+    display::{ DisplayBus, MEMORY_ROWS },
+    dirty::DISPLAY_SIZE,
+    font_atlas::*,
+};
+
+/// Max number of characters in a line
+const MAX_CHARS: usize = (DISPLAY_SIZE / GLYPH_WIDTH) as usize;
+
+/// Position in the runs of a glyph
+#[derive(Clone, Copy, Default)]
+struct Cursor {
+    /// Index of the current run in `GLYPH_RUNS`, counted in runs
+    index: usize,
+    /// Pixels left in the current run
+    remaining: u8,
+    /// True if the current run is foreground
+    foreground: bool,
+}
+
+/// Draw a line of text with the top left at (left, top), in the RGB565 foreground and background colours.
+/// Characters outside 0x20 to 0x7E are shown as '?'. The text is clipped to the display width and the frame memory
+/// rows, so that lines may be drawn into the hidden rows for scrolling.
+/// Returns the number of characters drawn.
+pub fn draw_text<B: DisplayBus>(bus: &mut B, text: &str, left: u16, top: u16, fg: u16, bg: u16) -> MynewtResult<usize> {
+    if left >= DISPLAY_SIZE || top >= MEMORY_ROWS { return Ok(0); }
+    let count = text.len().min(((DISPLAY_SIZE - left) / GLYPH_WIDTH) as usize).min(MAX_CHARS);
+    if count == 0 { return Ok(0); }
+    let rows = GLYPH_HEIGHT.min(MEMORY_ROWS - top);
+
+    //  Start each character at the first run of its glyph
+    let mut cursors = [Cursor::default(); MAX_CHARS];
+    for (cursor, ch) in cursors.iter_mut().zip(text.bytes()) {
+        let ch = if ch < FIRST_CHAR || ch > LAST_CHAR { b'?' } else { ch };
+        let index = GLYPH_OFFSETS[(ch - FIRST_CHAR) as usize] as usize;
+        *cursor = Cursor { index, remaining: run(index), foreground: false };
+    }
+
+    //  Write the whole line as one window, one row of pixels at a time
+    bus.write_window(left, top, left + count as u16 * GLYPH_WIDTH - 1, top + rows - 1) ? ;
+    let fg = fg.to_be_bytes();
+    let bg = bg.to_be_bytes();
+    let mut row = [0_u8; MAX_CHARS * GLYPH_WIDTH as usize * 2];
+    for _ in 0 .. rows {
+        let mut pos = 0;
+        for cursor in cursors[.. count].iter_mut() {
+            let mut needed = GLYPH_WIDTH as u8;
+            while needed > 0 {
+                //  Skip to the next non-empty run, switching colours
+                while cursor.remaining == 0 {
+                    cursor.index += 1;
+                    cursor.remaining = run(cursor.index);
+                    cursor.foreground = !cursor.foreground;
+                }
+                let len = needed.min(cursor.remaining);
+                let color = if cursor.foreground { fg } else { bg };
+                for pixel in row[pos .. pos + len as usize * 2].chunks_exact_mut(2) {
+                    pixel.copy_from_slice(&color);
+                }
+                pos += len as usize * 2;
+                cursor.remaining -= len;
+                needed -= len;
+            }
+        }
+        bus.write_pixels(&row[.. pos]) ? ;
+    }
+    Ok(count)
+}
+
+/// Return the run at the index in `GLYPH_RUNS`, which packs two 4-bit runs per byte, high nibble first
+fn run(index: usize) -> u8 {
+    let byte = GLYPH_RUNS[index / 2];
+    if index % 2 == 0 { byte >> 4 } else { byte & 0x0f }
+}